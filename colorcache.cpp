@@ -0,0 +1,72 @@
+#include "colorcache.h"
+
+#include <QColor>
+#include <QPixmap>
+
+#include "rectformat.h"
+
+/**
+ * @details
+ * QCache::object() одновременно ищет элемент и поднимает его в начало LRU-списка.
+ * При вставке QCache забирает владение указателем и может сразу удалить его
+ * (если ёмкость 0), поэтому результат копируется до insert().
+ */
+QIcon ColorCache::icon(QRgb rgba)
+{
+    if (const QIcon* cached = m_icons.object(rgba))
+    {
+        ++m_iconHits;
+        return *cached;
+    }
+
+    ++m_iconMisses;
+
+    QPixmap px(kIconSize, kIconSize);
+    px.fill(QColor::fromRgba(rgba));
+
+    const QIcon result(px);
+    m_icons.insert(rgba, new QIcon(result));
+    return result;
+}
+
+/**
+ * @details
+ * При попадании возвращается копия разделяемой QString — без выделения памяти.
+ */
+QString ColorCache::name(QRgb rgba)
+{
+    const QRgb key = rgba & RGB_MASK;
+
+    if (const QString* cached = m_names.object(key))
+        return *cached;
+
+    const QString result = RectFormat::colorName(key);
+    m_names.insert(key, new QString(result));
+    return result;
+}
+
+void ColorCache::setIconCapacity(int capacity)
+{
+    m_icons.setMaxCost(qMax(0, capacity));
+}
+
+int ColorCache::iconCapacity() const
+{
+    return m_icons.maxCost();
+}
+
+quint64 ColorCache::iconHits() const
+{
+    return m_iconHits;
+}
+
+quint64 ColorCache::iconMisses() const
+{
+    return m_iconMisses;
+}
+
+void ColorCache::resetIconStats()
+{
+    m_iconHits = 0;
+    m_iconMisses = 0;
+}
@@ -0,0 +1,78 @@
+#ifndef COLORCACHE_H
+#define COLORCACHE_H
+
+#include <QCache>
+#include <QIcon>
+#include <QRgb>
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * @brief Кэши иконок и имён цветов для DecorationRole/DisplayRole столбца PenColor.
+ *
+ * @details
+ * Общий для MyModel и MappedRectModel: путь отрисовки таблицы не создаёт
+ * QPixmap/QString на каждый вызов data().
+ * - icon() — LRU-кэш QIcon по ключу QRgb (с альфой) ограниченной ёмкости,
+ *   со счётчиками попаданий/промахов;
+ * - name() — кэш строк "#rrggbb" по RGB без альфы.
+ *
+ * Повторные запросы одного цвета возвращают implicitly shared копии
+ * закэшированных объектов. Методы не const: владелец держит кэш как
+ * mutable-член и заполняет его из data().
+ */
+class ColorCache
+{
+public:
+    /// Сторона пиксмапа иконки цвета (в пикселях).
+    static constexpr int kIconSize = 32;
+
+    /// Ёмкость кэша иконок по умолчанию (число различных цветов).
+    static constexpr int kDefaultIconCapacity = 256;
+
+    /// Ёмкость кэша имён цветов (число различных цветов).
+    static constexpr int kNameCapacity = 256;
+
+    /**
+     * @brief Иконка-заливка цвета @p rgba (kIconSize x kIconSize).
+     */
+    QIcon icon(QRgb rgba);
+
+    /**
+     * @brief Имя цвета "#rrggbb" (альфа не участвует, как и в QColor::name()).
+     */
+    QString name(QRgb rgba);
+
+    /**
+     * @brief Задаёт ёмкость кэша иконок.
+     *
+     * @details
+     * При уменьшении давно не использованные иконки вытесняются сразу;
+     * 0 отключает кэширование, отрицательное трактуется как 0.
+     */
+    void setIconCapacity(int capacity);
+
+    /// Текущая ёмкость кэша иконок.
+    int iconCapacity() const;
+
+    /// Число запросов icon(), обслуженных из кэша.
+    quint64 iconHits() const;
+
+    /// Число запросов icon(), для которых иконку пришлось создать.
+    quint64 iconMisses() const;
+
+    /// Обнуляет счётчики попаданий/промахов (содержимое кэша сохраняется).
+    void resetIconStats();
+
+private:
+    /// LRU-кэш иконок (ключ — QRgb, стоимость элемента — 1).
+    QCache<QRgb, QIcon> m_icons { kDefaultIconCapacity };
+
+    quint64 m_iconHits = 0;
+    quint64 m_iconMisses = 0;
+
+    /// Кэш строк "#rrggbb" (ключ — RGB без альфы).
+    QCache<QRgb, QString> m_names { kNameCapacity };
+};
+
+#endif // COLORCACHE_H
@@ -0,0 +1,248 @@
+#include "edithistory.h"
+
+#include <utility>
+
+// -------------------- entries --------------------
+
+qint64 EditHistory::Entry::bytes() const
+{
+    return qint64(sizeof(Entry))
+           + qint64(cells.size()) * qint64(sizeof(CellDiff))
+           + qint64(rows.size()) * qint64(sizeof(PackedRect));
+}
+
+EditHistory::Entry EditHistory::cells(QVector<CellDiff> diffs)
+{
+    Entry e;
+    e.kind = Kind::Cells;
+    e.cells = std::move(diffs);
+    return e;
+}
+
+EditHistory::Entry EditHistory::insert(int row, int count)
+{
+    Entry e;
+    e.kind = Kind::Insert;
+    e.row = row;
+    e.count = count;
+    return e;
+}
+
+EditHistory::Entry EditHistory::remove(int row, RectStore removed)
+{
+    Entry e;
+    e.kind = Kind::Remove;
+    e.row = row;
+    e.count = removed.size();
+    e.rows = std::move(removed);
+    return e;
+}
+
+EditHistory::Entry EditHistory::move(int sourceRow, int count, int destinationRow)
+{
+    Entry e;
+    e.kind = Kind::Move;
+    e.row = sourceRow;
+    e.count = count;
+    e.destination = destinationRow;
+    return e;
+}
+
+EditHistory::Entry EditHistory::replace(RectStore previous)
+{
+    Entry e;
+    e.kind = Kind::Replace;
+    e.rows = std::move(previous);
+    return e;
+}
+
+// -------------------- recording --------------------
+
+void EditHistory::record(Entry entry)
+{
+    if (m_openDepth > 0)
+    {
+        m_open.append(std::move(entry));
+        return;
+    }
+
+    const bool single = entry.kind == Kind::Cells && entry.cells.size() == 1;
+
+    clearRedo();
+
+    Step step;
+    step.append(std::move(entry));
+    pushUndo(std::move(step));
+
+    m_mergeable = single && canUndo();
+}
+
+bool EditHistory::mergeCell(int row, int column, quint32 after)
+{
+    if (!m_mergeable || m_openDepth > 0 || m_undo.isEmpty())
+        return false;
+
+    Step& top = m_undo.last();
+    CellDiff& diff = top.first().cells.first();
+    if (diff.row != row || diff.column != column)
+        return false;
+
+    clearRedo();
+
+    diff.after = after;
+    if (diff.before == after)
+    {
+        // Ячейка вернулась к исходному значению: шаг больше ничего не меняет
+        m_usage -= stepBytes(top);
+        m_undo.removeLast();
+        m_mergeable = false;
+    }
+    return true;
+}
+
+void EditHistory::beginStep()
+{
+    ++m_openDepth;
+}
+
+void EditHistory::endStep()
+{
+    if (m_openDepth == 0 || --m_openDepth > 0)
+        return;
+
+    Step step = std::move(m_open);
+    m_open.clear();
+    if (step.isEmpty())
+        return;
+
+    clearRedo();
+    pushUndo(std::move(step));
+}
+
+int EditHistory::openEntryCount() const
+{
+    return m_open.size();
+}
+
+void EditHistory::truncateOpen(int count)
+{
+    if (count >= 0 && count < m_open.size())
+        m_open.resize(count);
+}
+
+// -------------------- undo / redo --------------------
+
+bool EditHistory::canUndo() const
+{
+    return !m_undo.isEmpty();
+}
+
+bool EditHistory::canRedo() const
+{
+    return !m_redo.isEmpty();
+}
+
+int EditHistory::undoCount() const
+{
+    return m_undo.size();
+}
+
+int EditHistory::redoCount() const
+{
+    return m_redo.size();
+}
+
+EditHistory::Step EditHistory::takeUndo()
+{
+    m_mergeable = false;
+    if (m_undo.isEmpty())
+        return {};
+
+    Step step = m_undo.takeLast();
+    m_usage -= stepBytes(step);
+    return step;
+}
+
+EditHistory::Step EditHistory::takeRedo()
+{
+    m_mergeable = false;
+    if (m_redo.isEmpty())
+        return {};
+
+    Step step = m_redo.takeLast();
+    m_usage -= stepBytes(step);
+    return step;
+}
+
+void EditHistory::pushUndo(Step step)
+{
+    m_mergeable = false;
+    m_usage += stepBytes(step);
+    m_undo.append(std::move(step));
+    evict();
+}
+
+void EditHistory::pushRedo(Step step)
+{
+    m_mergeable = false;
+    m_usage += stepBytes(step);
+    m_redo.append(std::move(step));
+    evict();
+}
+
+// -------------------- memory --------------------
+
+void EditHistory::clear()
+{
+    m_undo.clear();
+    m_redo.clear();
+    m_open.clear();
+    m_mergeable = false;
+    m_usage = 0;
+}
+
+void EditHistory::setMemoryBudget(qint64 bytes)
+{
+    m_budget = qMax<qint64>(0, bytes);
+    evict();
+}
+
+qint64 EditHistory::memoryBudget() const
+{
+    return m_budget;
+}
+
+qint64 EditHistory::memoryUsage() const
+{
+    return m_usage;
+}
+
+qint64 EditHistory::stepBytes(const Step& step)
+{
+    qint64 bytes = 0;
+    for (const Entry& e : step)
+        bytes += e.bytes();
+    return bytes;
+}
+
+void EditHistory::clearRedo()
+{
+    for (const Step& step : m_redo)
+        m_usage -= stepBytes(step);
+    m_redo.clear();
+}
+
+/**
+ * @details
+ * Сначала выбрасываются самые старые шаги отмены. Если их не осталось,
+ * а бюджет всё ещё превышен (один шаг больше бюджета), выбрасываются
+ * и шаги повтора — начиная с самого дальнего от текущего состояния.
+ */
+void EditHistory::evict()
+{
+    while (m_usage > m_budget && !m_undo.isEmpty())
+        m_usage -= stepBytes(m_undo.takeFirst());
+
+    while (m_usage > m_budget && !m_redo.isEmpty())
+        m_usage -= stepBytes(m_redo.takeFirst());
+}
@@ -0,0 +1,184 @@
+#ifndef EDITHISTORY_H
+#define EDITHISTORY_H
+
+#include <QList>
+#include <QVector>
+#include <QtGlobal>
+
+#include "rectstore.h"
+
+/**
+ * @brief История правок MyModel для отмены/повтора (undo/redo).
+ *
+ * @details
+ * # Что хранится
+ * Не снимки таблицы, а компактные разности:
+ * - Kind::Cells — правки ячеек: строка, столбец и битовые значения поля
+ *   до/после (CellDiff, 16 байт на ячейку);
+ * - Kind::Insert — вставка [row, row + count): строки сохраняются только
+ *   при отмене (чтобы повтор вернул их содержимое);
+ * - Kind::Remove — удаление [row, row + count) вместе с удалёнными строками;
+ * - Kind::Move — перенос блока (как RectStore::move());
+ * - Kind::Replace — подмена всей таблицы (загрузка): хранится "другая"
+ *   таблица, отмена и повтор меняют её местами с текущей без копирования.
+ *
+ * Шаг (Step) — записи, которые отменяются и повторяются вместе
+ * (beginStep()/endStep(): пакетная правка, удаление набора диапазонов).
+ * Записи шага хранятся в порядке применения; отмена идёт с конца.
+ *
+ * # Память
+ * Размер каждого шага оценивается по его данным (Entry::bytes()). Когда сумма
+ * по отменяемым и повторяемым шагам превышает memoryBudget(), самые старые
+ * шаги отмены выбрасываются; шаг больше всего бюджета не сохраняется вовсе.
+ *
+ * # Слияние
+ * Правка ячейки сразу после правки той же ячейки (mergeCell()) не создаёт
+ * новый шаг, а обновляет значение "после" у предыдущего: набор числа
+ * по одной цифре отменяется одним Ctrl+Z. Любой другой шаг, отмена и повтор
+ * прерывают цепочку слияния.
+ *
+ * Класс ничего не знает о модели: применяет записи MyModel.
+ */
+class EditHistory
+{
+public:
+    /// Бюджет памяти по умолчанию (байт).
+    static constexpr qint64 kDefaultMemoryBudget = 64 * 1024 * 1024;
+
+    /// Вид записи.
+    enum class Kind : quint8
+    {
+        Cells,    ///< Правки отдельных ячеек.
+        Insert,   ///< Вставка строк.
+        Remove,   ///< Удаление строк.
+        Move,     ///< Перенос блока строк.
+        Replace   ///< Подмена всей таблицы.
+    };
+
+    /// Правка одной ячейки: битовое представление поля до и после.
+    struct CellDiff
+    {
+        qint32 row = 0;
+        quint8 column = 0;
+        quint32 before = 0;
+        quint32 after = 0;
+    };
+
+    /// Запись истории.
+    struct Entry
+    {
+        Kind kind = Kind::Cells;
+        int row = 0;           ///< Insert/Remove: первая строка; Move: исходная строка.
+        int count = 0;         ///< Insert/Remove/Move: число строк.
+        int destination = 0;   ///< Move: строка назначения (нумерация до переноса).
+        QVector<CellDiff> cells;
+        RectStore rows;        ///< Remove: удалённые строки; Insert: строки после отмены; Replace: другая таблица.
+
+        /// Оценка занимаемой памяти (байт).
+        qint64 bytes() const;
+    };
+
+    /// Записи, отменяемые/повторяемые вместе (в порядке применения).
+    using Step = QVector<Entry>;
+
+    /**
+     * @name Конструкторы записей
+     * @{
+     */
+    static Entry cells(QVector<CellDiff> diffs);
+    static Entry insert(int row, int count);
+    static Entry remove(int row, RectStore removed);
+    static Entry move(int sourceRow, int count, int destinationRow);
+    static Entry replace(RectStore previous);
+    /** @} */
+
+    /**
+     * @brief Добавляет запись: в открытый шаг или отдельным шагом.
+     *
+     * @details
+     * Очищает стек повтора (новая ветка правок) и прерывает цепочку слияния.
+     */
+    void record(Entry entry);
+
+    /**
+     * @brief Сливает правку ячейки с предыдущим шагом, если это правка той же ячейки.
+     *
+     * @details
+     * Если после слияния значение ячейки совпало с исходным, шаг удаляется
+     * целиком: отменять нечего.
+     *
+     * @return true, если слияние выполнено (record() не нужен); стек повтора при этом очищается.
+     */
+    bool mergeCell(int row, int column, quint32 after);
+
+    /**
+     * @brief Открывает шаг: записи до endStep() отменяются одним undo (вложенные вызовы допустимы).
+     */
+    void beginStep();
+
+    /**
+     * @brief Закрывает шаг; пустой шаг не сохраняется.
+     */
+    void endStep();
+
+    /// Число записей в открытом шаге.
+    int openEntryCount() const;
+
+    /**
+     * @brief Отбрасывает записи открытого шага, начиная с @p count-й (откат части шага).
+     */
+    void truncateOpen(int count);
+
+    /**
+     * @name Отмена/повтор
+     * @details take*() забирает верхний шаг, push*() кладёт применённый шаг
+     *          на противоположный стек.
+     * @{
+     */
+    bool canUndo() const;
+    bool canRedo() const;
+    int undoCount() const;
+    int redoCount() const;
+    Step takeUndo();
+    Step takeRedo();
+    void pushUndo(Step step);
+    void pushRedo(Step step);
+    /** @} */
+
+    /// Удаляет всю историю.
+    void clear();
+
+    /**
+     * @brief Задаёт бюджет памяти (байт, не меньше 0) и сразу выбрасывает лишнее.
+     */
+    void setMemoryBudget(qint64 bytes);
+
+    /// Текущий бюджет памяти.
+    qint64 memoryBudget() const;
+
+    /// Оценка памяти, занятой историей (байт).
+    qint64 memoryUsage() const;
+
+private:
+    /// Оценка памяти шага.
+    static qint64 stepBytes(const Step& step);
+
+    /// Очищает стек повтора.
+    void clearRedo();
+
+    /// Выбрасывает старые шаги, пока история не уложится в бюджет.
+    void evict();
+
+    QList<Step> m_undo;   ///< Старые шаги в начале, верхний — в конце.
+    QList<Step> m_redo;   ///< Верхний (ближайший к текущему состоянию) — в конце.
+
+    Step m_open;          ///< Открытый шаг (beginStep()).
+    int m_openDepth = 0;
+
+    bool m_mergeable = false;  ///< Верхний шаг — одиночная правка ячейки, доступная для слияния.
+
+    qint64 m_budget = kDefaultMemoryBudget;
+    qint64 m_usage = 0;
+};
+
+#endif // EDITHISTORY_H
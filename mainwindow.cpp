@@ -6,6 +6,9 @@
 #include <QMenu>
 #include <QMenuBar>
 #include <QMessageBox>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QStatusBar>
 
 /**
  * @brief Конструктор MainWindow.
@@ -15,8 +18,9 @@
  * - Создаёт модель и привязывает к tableView.
  * - Устанавливает делегат (редактирование стиля/цвета).
  * - Заполняет тестовыми данными (можно убрать, когда начнёшь работать с файлами).
- * - Настраивает растягивание столбцов.
- * - Создаёт меню "File" и связывает действия со слотами.
+ * - Настраивает растягивание столбцов и перенос строк перетаскиванием.
+ * - Создаёт меню "File" и "Правка" и связывает действия со слотами.
+ * - Добавляет в строку состояния индикатор фоновой загрузки/сохранения.
  */
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -32,14 +36,27 @@ MainWindow::MainWindow(QWidget* parent)
     // Родитель = tableView, чтобы делегат жил столько же, сколько и таблица.
     ui->tableView->setItemDelegate(new MyDelegate(ui->tableView));
 
-    // 3) Тестовые данные (по желанию можно отключить)
+    // 3) Тестовые данные (по желанию можно отключить); их добавление не отменяется
     m_model->test();
+    m_model->clearHistory();
 
     // 4) Отображение
     ui->tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
-    // 5) Меню "File" / "Файл"
+    // Перенос строк перетаскиванием внутри таблицы (MyModel::dropMimeData)
+    ui->tableView->setDragDropMode(QAbstractItemView::InternalMove);
+    ui->tableView->setDefaultDropAction(Qt::MoveAction);
+
+    // 5) Меню "File" / "Файл" и "Правка"
     setupFileMenu();
+    setupEditMenu();
+
+    // 6) Прогресс фоновых операций
+    setupStatusBar();
+
+    connect(m_model, &MyModel::ioProgress, this, &MainWindow::slotIoProgress);
+    connect(m_model, &MyModel::loadFinished, this, &MainWindow::slotLoadFinished);
+    connect(m_model, &MyModel::saveFinished, this, &MainWindow::slotSaveFinished);
 }
 
 /**
@@ -63,15 +80,69 @@ void MainWindow::setupFileMenu()
     // Можно "File", можно "Файл" — как тебе требуется по лабораторной.
     QMenu* fileMenu = menuBar()->addMenu("Файл");
 
-    QAction* actOpen = fileMenu->addAction("Открыть...");
-    QAction* actSave = fileMenu->addAction("Сохранить...");
+    m_actOpen = fileMenu->addAction("Открыть...");
+    m_actOpenIncremental = fileMenu->addAction("Открыть постепенно...");
+    m_actSave = fileMenu->addAction("Сохранить...");
 
     // Горячие клавиши (опционально)
-    actOpen->setShortcut(QKeySequence::Open);
-    actSave->setShortcut(QKeySequence::Save);
+    m_actOpen->setShortcut(QKeySequence::Open);
+    m_actSave->setShortcut(QKeySequence::Save);
+
+    connect(m_actOpen, &QAction::triggered, this, &MainWindow::slotLoadFromFile);
+    connect(m_actOpenIncremental, &QAction::triggered, this, &MainWindow::slotLoadIncremental);
+    connect(m_actSave, &QAction::triggered, this, &MainWindow::slotSaveToFile);
+}
+
+/**
+ * @brief Меню "Правка": отмена/повтор по истории модели.
+ */
+void MainWindow::setupEditMenu()
+{
+    QMenu* editMenu = menuBar()->addMenu("Правка");
 
-    connect(actOpen, &QAction::triggered, this, &MainWindow::slotLoadFromFile);
-    connect(actSave, &QAction::triggered, this, &MainWindow::slotSaveToFile);
+    m_actUndo = editMenu->addAction("Отменить");
+    m_actRedo = editMenu->addAction("Повторить");
+
+    m_actUndo->setShortcut(QKeySequence::Undo);
+    m_actRedo->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_Y));
+
+    slotUndoStateChanged(m_model->canUndo(), m_model->canRedo());
+
+    connect(m_actUndo, &QAction::triggered, m_model, &MyModel::undo);
+    connect(m_actRedo, &QAction::triggered, m_model, &MyModel::redo);
+    connect(m_model, &MyModel::undoStateChanged, this, &MainWindow::slotUndoStateChanged);
+}
+
+/**
+ * @brief Индикатор прогресса и кнопка отмены в строке состояния (из .ui).
+ */
+void MainWindow::setupStatusBar()
+{
+    m_ioProgress = new QProgressBar(this);
+    m_ioProgress->setObjectName("ioProgressBar");
+    m_ioProgress->setRange(0, 100);
+    m_ioProgress->setMaximumWidth(200);
+    m_ioProgress->hide();
+
+    m_ioCancel = new QPushButton("Отмена", this);
+    m_ioCancel->setObjectName("ioCancelButton");
+    m_ioCancel->hide();
+
+    statusBar()->addPermanentWidget(m_ioProgress);
+    statusBar()->addPermanentWidget(m_ioCancel);
+
+    connect(m_ioCancel, &QPushButton::clicked, m_model, &MyModel::cancelAsyncOperation);
+}
+
+void MainWindow::setIoBusy(bool busy)
+{
+    m_actOpen->setEnabled(!busy);
+    m_actOpenIncremental->setEnabled(!busy);
+    m_actSave->setEnabled(!busy);
+
+    m_ioProgress->setValue(0);
+    m_ioProgress->setVisible(busy);
+    m_ioCancel->setVisible(busy);
 }
 
 /**
@@ -89,10 +160,10 @@ void MainWindow::slotSaveToFile()
     if (fileName.isEmpty())
         return;
 
-    QString error;
-    if (!m_model->saveToTsv(fileName, &error))
+    if (m_model->saveToTsvAsync(fileName))
     {
-        QMessageBox::critical(this, tr("Save failed"), error);
+        setIoBusy(true);
+        statusBar()->showMessage("Сохранение...");
     }
 }
 
@@ -108,12 +179,92 @@ void MainWindow::slotLoadFromFile()
         tr("TSV files (*.tsv);;Text files (*.txt);;All files (*.*)")
     );
 
+    if (fileName.isEmpty())
+        return;
+
+    if (m_model->loadFromTsvAsync(fileName))
+    {
+        setIoBusy(true);
+        statusBar()->showMessage("Загрузка...");
+    }
+}
+
+/**
+ * @brief Открытие TSV-файла с подгрузкой по мере прокрутки.
+ */
+void MainWindow::slotLoadIncremental()
+{
+    const QString fileName = QFileDialog::getOpenFileName(
+        this,
+        tr("Open data"),
+        QString(),
+        tr("TSV files (*.tsv);;Text files (*.txt);;All files (*.*)")
+    );
+
     if (fileName.isEmpty())
         return;
 
     QString error;
-    if (!m_model->loadFromTsv(fileName, &error))
+    if (!m_model->openTsvIncremental(fileName, &error))
+        QMessageBox::critical(this, tr("Open failed"), error);
+}
+
+/**
+ * @brief Прогресс фоновой операции.
+ */
+void MainWindow::slotIoProgress(qint64 bytesDone, qint64 bytesTotal, int rowsDone, int rowsTotal)
+{
+    int percent = 0;
+    if (bytesTotal > 0)
+        percent = static_cast<int>(bytesDone * 100 / bytesTotal);
+    else if (rowsTotal > 0)
+        percent = static_cast<int>(qint64(rowsDone) * 100 / rowsTotal);
+
+    m_ioProgress->setValue(qBound(0, percent, 100));
+    statusBar()->showMessage(QString("Строк: %1").arg(rowsDone));
+}
+
+/**
+ * @brief Окончание фоновой загрузки.
+ */
+void MainWindow::slotLoadFinished(bool ok, bool canceled, const QString& error)
+{
+    setIoBusy(false);
+
+    if (ok)
+        statusBar()->showMessage(QString("Загружено строк: %1").arg(m_model->rowCount()), 5000);
+    else if (canceled)
+        statusBar()->showMessage("Загрузка отменена", 5000);
+    else
     {
+        statusBar()->clearMessage();
         QMessageBox::critical(this, tr("Open failed"), error);
     }
 }
+
+/**
+ * @brief Окончание фонового сохранения.
+ */
+void MainWindow::slotSaveFinished(bool ok, bool canceled, const QString& error)
+{
+    setIoBusy(false);
+
+    if (ok)
+        statusBar()->showMessage("Сохранено", 5000);
+    else if (canceled)
+        statusBar()->showMessage("Сохранение отменено", 5000);
+    else
+    {
+        statusBar()->clearMessage();
+        QMessageBox::critical(this, tr("Save failed"), error);
+    }
+}
+
+/**
+ * @brief Доступность отмены/повтора.
+ */
+void MainWindow::slotUndoStateChanged(bool canUndo, bool canRedo)
+{
+    m_actUndo->setEnabled(canUndo);
+    m_actRedo->setEnabled(canRedo);
+}
@@ -6,6 +6,10 @@
 #include "mymodel.h"     // модель
 #include "mydelegate.h"  // делегат
 
+class QAction;
+class QProgressBar;
+class QPushButton;
+
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
 QT_END_NAMESPACE
@@ -18,8 +22,13 @@ QT_END_NAMESPACE
  * - Создаёт делегат MyDelegate и устанавливает его в QTableView.
  * - Создаёт меню "File" (или "Файл") с пунктами:
  *     - Open...  -> загрузка модели из TSV
+ *     - "Открыть постепенно..." -> подгрузка строк TSV по мере прокрутки
  *     - Save...  -> сохранение модели в TSV
+ * - Создаёт меню "Правка" с пунктами "Отменить" (Ctrl+Z) и "Повторить" (Ctrl+Y)
+ *   поверх истории правок модели (MyModel::undo()/redo()).
  * - Для выбора имени файла использует стандартные диалоги QFileDialog.
+ * - Загрузка/сохранение выполняются в фоне (MyModel::loadFromTsvAsync()/saveToTsvAsync()):
+ *   окно не замирает, в строке состояния показываются прогресс и кнопка "Отмена".
  */
 class MainWindow final : public QMainWindow
 {
@@ -35,8 +44,8 @@ private slots:
      *
      * @details
      * - Открывает диалог выбора имени файла (QFileDialog::getSaveFileName()).
-     * - Если имя выбрано — вызывает MyModel::saveToTsv().
-     * - При ошибке показывает QMessageBox.
+     * - Если имя выбрано — запускает MyModel::saveToTsvAsync().
+     * - Результат обрабатывается в slotSaveFinished().
      */
     void slotSaveToFile();
 
@@ -45,11 +54,44 @@ private slots:
      *
      * @details
      * - Открывает диалог выбора файла (QFileDialog::getOpenFileName()).
-     * - Если файл выбран — вызывает MyModel::loadFromTsv().
-     * - При ошибке показывает QMessageBox.
+     * - Если файл выбран — запускает MyModel::loadFromTsvAsync().
+     * - Результат обрабатывается в slotLoadFinished().
      */
     void slotLoadFromFile();
 
+    /**
+     * @brief Слот: открыть TSV-файл с подгрузкой строк по мере прокрутки.
+     *
+     * @details
+     * Запускает MyModel::openTsvIncremental(): строки добавляет сама таблица
+     * (canFetchMore()/fetchMore()), окончание или ошибка приходят в slotLoadFinished().
+     */
+    void slotLoadIncremental();
+
+    /**
+     * @brief Слот: прогресс фоновой операции -> индикатор в строке состояния.
+     *
+     * @details
+     * Процент считается по байтам, если известен размер файла (загрузка),
+     * иначе по строкам (сохранение).
+     */
+    void slotIoProgress(qint64 bytesDone, qint64 bytesTotal, int rowsDone, int rowsTotal);
+
+    /**
+     * @brief Слот: фоновая загрузка завершена (при ошибке — QMessageBox).
+     */
+    void slotLoadFinished(bool ok, bool canceled, const QString& error);
+
+    /**
+     * @brief Слот: фоновое сохранение завершено (при ошибке — QMessageBox).
+     */
+    void slotSaveFinished(bool ok, bool canceled, const QString& error);
+
+    /**
+     * @brief Слот: доступность отмены/повтора -> пункты меню "Правка".
+     */
+    void slotUndoStateChanged(bool canUndo, bool canRedo);
+
 private:
     /**
      * @brief Настраивает меню и действия (QAction).
@@ -59,9 +101,37 @@ private:
      */
     void setupFileMenu();
 
+    /**
+     * @brief Настраивает меню "Правка" (отмена/повтор).
+     */
+    void setupEditMenu();
+
+    /**
+     * @brief Добавляет в строку состояния индикатор прогресса и кнопку отмены (скрыты).
+     */
+    void setupStatusBar();
+
+    /**
+     * @brief Переключает окно в режим фоновой операции и обратно.
+     *
+     * @details
+     * На время операции пункты "Открыть..."/"Сохранить..." недоступны,
+     * индикатор прогресса и кнопка "Отмена" показаны.
+     */
+    void setIoBusy(bool busy);
+
 private:
     Ui::MainWindow* ui = nullptr;
     MyModel* m_model = nullptr;
+
+    QAction* m_actOpen = nullptr;
+    QAction* m_actOpenIncremental = nullptr;
+    QAction* m_actSave = nullptr;
+    QAction* m_actUndo = nullptr;
+    QAction* m_actRedo = nullptr;
+
+    QProgressBar* m_ioProgress = nullptr;
+    QPushButton* m_ioCancel = nullptr;
 };
 
 #endif // MAINWINDOW_H
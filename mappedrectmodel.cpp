@@ -0,0 +1,209 @@
+#include "mappedrectmodel.h"
+
+#include <QColor>
+
+#include "rectbinary.h"
+#include "rectformat.h"
+
+namespace {
+
+using RectColumns::kColCountInt;
+using RectColumns::kColumns;
+
+} // namespace
+
+MappedRectModel::MappedRectModel(QObject* parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+MappedRectModel::~MappedRectModel() = default;
+
+/**
+ * @details
+ * Новый файл открывается и проверяется отдельно и только после успеха
+ * заменяет текущий — при ошибке открытый снимок остаётся доступен.
+ * Отображение освобождается вместе с QFile (деструктор снимает map()).
+ */
+bool MappedRectModel::open(const QString& fileName, QString* error)
+{
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        if (error) *error = file->errorString();
+        return false;
+    }
+
+    const qint64 size = file->size();
+    if (size < RectBinary::kHeaderSize)
+    {
+        if (error) *error = "Двоичный файл обрезан (нет заголовка)";
+        return false;
+    }
+
+    uchar* map = file->map(0, size);
+    if (!map)
+    {
+        if (error) *error = QString("Не удалось отобразить файл в память: %1").arg(file->errorString());
+        return false;
+    }
+
+    const char* data = reinterpret_cast<const char*>(map);
+    RectBinary::Header header;
+    if (!RectBinary::parseHeader(data, size, &header, error))
+        return false;
+
+    if (size - header.headerSize < header.rowCount * RectBinary::kRecordSize)
+    {
+        if (error) *error = "Двоичный файл обрезан";
+        return false;
+    }
+
+    beginResetModel();
+    m_file = std::move(file);
+    m_records = data + header.headerSize;
+    m_rows = int(header.rowCount);
+    endResetModel();
+
+    return true;
+}
+
+void MappedRectModel::close()
+{
+    if (!m_file)
+        return;
+
+    beginResetModel();
+    m_file.reset();
+    m_records = nullptr;
+    m_rows = 0;
+    endResetModel();
+}
+
+bool MappedRectModel::isOpen() const
+{
+    return m_file != nullptr;
+}
+
+QString MappedRectModel::fileName() const
+{
+    return m_file ? m_file->fileName() : QString();
+}
+
+int MappedRectModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_rows;
+}
+
+int MappedRectModel::columnCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return kColCountInt;
+}
+
+QVariant MappedRectModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return {};
+
+    if (orientation == Qt::Horizontal)
+    {
+        if (section < 0 || section >= kColCountInt)
+            return {};
+        return QLatin1String(kColumns[static_cast<std::size_t>(section)].header);
+    }
+
+    return section + 1;
+}
+
+Qt::ItemFlags MappedRectModel::flags(const QModelIndex& index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+
+    return QAbstractTableModel::flags(index);
+}
+
+PackedRect MappedRectModel::record(int row) const
+{
+    return RectBinary::decodeRecord(m_records + qint64(row) * RectBinary::kRecordSize);
+}
+
+MyRect MappedRectModel::rectAt(int row) const
+{
+    if (row < 0 || row >= m_rows)
+        return MyRect{};
+    return record(row).toRect();
+}
+
+QVariant MappedRectModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return {};
+
+    const int row = index.row();
+    const int col = index.column();
+
+    if (row < 0 || row >= m_rows)
+        return {};
+    if (col < 0 || col >= kColCountInt)
+        return {};
+
+    if (role != Qt::EditRole && role != Qt::DisplayRole && role != Qt::DecorationRole)
+        return {};
+
+    const Column column = kColumns[static_cast<std::size_t>(col)].col;
+    const PackedRect r = record(row);
+
+    auto intValue = [&r](Column c) -> int {
+        switch (c)
+        {
+        case Column::PenWidth: return r.penWidth;
+        case Column::Left:     return r.left;
+        case Column::Top:      return r.top;
+        case Column::Width:    return r.width;
+        case Column::Height:   return r.height;
+        default:               return 0;
+        }
+    };
+
+    if (role == Qt::EditRole)
+    {
+        switch (column)
+        {
+        case Column::PenColor:  return QColor::fromRgba(r.penColor);
+        case Column::PenStyle:  return static_cast<int>(r.penStyle);
+        case Column::PenWidth:
+        case Column::Left:
+        case Column::Top:
+        case Column::Width:
+        case Column::Height:    return intValue(column);
+        case Column::Count:     break;
+        }
+        return {};
+    }
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (column)
+        {
+        case Column::PenColor:  return m_colorCache.name(r.penColor);
+        case Column::PenStyle:  return RectFormat::penStyleName(r.style());
+        case Column::PenWidth:
+        case Column::Left:
+        case Column::Top:
+        case Column::Width:
+        case Column::Height:    return intValue(column);
+        case Column::Count:     break;
+        }
+        return {};
+    }
+
+    if (column == Column::PenColor)
+        return m_colorCache.icon(r.penColor);
+
+    return {};
+}
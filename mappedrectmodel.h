@@ -0,0 +1,122 @@
+#ifndef MAPPEDRECTMODEL_H
+#define MAPPEDRECTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QFile>
+#include <QString>
+#include <QVariant>
+#include <QtGlobal>
+
+#include <memory>
+
+#include "colorcache.h"
+#include "myrect.h"
+#include "packedrect.h"
+#include "rectcolumns.h"
+
+/**
+ * @brief Модель только для чтения поверх двоичного снимка, отображённого в память.
+ *
+ * @details
+ * Родственник MyModel для просмотра больших архивных наборов, которые не
+ * редактируются: те же столбцы (RectColumns::kColumns), заголовки и роли
+ * (DisplayRole / EditRole / DecorationRole), но строки не копируются в память
+ * процесса. Файл формата RectBinary (см. MyModel::saveToBinary()) целиком
+ * отображается через QFile::map(), и data() декодирует запись прямо из
+ * отображения (RectBinary::decodeRecord()).
+ *
+ * Поэтому open() не зависит от размера файла: проверяются только заголовок
+ * и длина файла. В памяти оказываются лишь страницы, к которым обратилось
+ * представление; вытеснять их при нехватке памяти может ОС.
+ *
+ * Содержимое записей при открытии не проверяется (это потребовало бы
+ * прочитать весь файл): стиль пера вне 0..Qt::MPenStyle показывается как
+ * "Qt::PenStyle(N)" — так же, как его вывел бы RectFormat::penStyleName().
+ *
+ * Редактирование не поддерживается: flags() не содержит Qt::ItemIsEditable,
+ * setData() возвращает false.
+ */
+class MappedRectModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    using Column = RectColumns::Column;
+
+    explicit MappedRectModel(QObject* parent = nullptr);
+    ~MappedRectModel() override;
+
+    /**
+     * @brief Открывает снимок и отображает его в память.
+     *
+     * @details
+     * При успехе прежний файл закрывается, модель сбрасывается одним
+     * beginResetModel/endResetModel. При ошибке (нет файла, неверный
+     * заголовок, файл короче заявленного числа записей, map() не удался)
+     * модель не меняется.
+     *
+     * @param fileName Путь к файлу снимка.
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе.
+     */
+    bool open(const QString& fileName, QString* error = nullptr);
+
+    /**
+     * @brief Закрывает снимок (модель становится пустой).
+     */
+    void close();
+
+    /**
+     * @brief Открыт ли снимок.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Путь к открытому снимку (пусто, если не открыт).
+     */
+    QString fileName() const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+
+    /**
+     * @brief Данные ячейки: те же роли и значения, что у MyModel::data().
+     */
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+    /**
+     * @brief Флаги: выбираемо, но не редактируемо.
+     */
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+
+    /**
+     * @brief Строка целиком (граница API, как MyModel::rectAt()).
+     *
+     * @param row Номер строки (0..rowCount()-1).
+     * @return MyRect{} для строки вне диапазона.
+     */
+    MyRect rectAt(int row) const;
+
+private:
+    /**
+     * @brief Запись строки @p row, декодированная из отображения.
+     */
+    PackedRect record(int row) const;
+
+    /// Открытый файл снимка (держит отображение; nullptr — снимок не открыт).
+    std::unique_ptr<QFile> m_file;
+
+    /// Начало записей в отображении.
+    const char* m_records = nullptr;
+
+    /// Число записей.
+    int m_rows = 0;
+
+    /// Кэши иконок и имён цветов, как у MyModel (mutable — заполняются из data()).
+    mutable ColorCache m_colorCache;
+};
+
+#endif // MAPPEDRECTMODEL_H
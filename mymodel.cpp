@@ -2,126 +2,133 @@
 #include "mymodel.h"
 
 #include <QColor>
+#include <QDataStream>
 #include <QFile>
 #include <QIcon>
-#include <QPixmap>
-#include <QTextStream>
+#include <QMimeData>
 #include <QIODevice>
+#include <QMetaObject>
+#include <QSaveFile>
+#include <QThread>
 #include <QtGlobal>
 
+#include <algorithm>
+
+#include "rectbinary.h"
+#include "rectformat.h"
+#include "tsvindex.h"
+#include "tsvreader.h"
+#include "tsvwriter.h"
+
 /**
- * @name Вспомогательные функции: Qt::PenStyle <-> строка
+ * @name Вспомогательные функции
  * @{
  */
 
 /**
- * @brief Преобразует Qt::PenStyle в человекочитаемую строку.
+ * @brief Возвращает роли, которые следует указать в dataChanged для данного столбца.
  *
  * @details
- * Используется для:
- * - отображения (Qt::DisplayRole), чтобы в таблице было "Qt::DotLine", а не "3";
- * - сохранения в TSV, чтобы файл был читаем человеком.
+ * - Для PenColor меняется и отображаемый текст (DisplayRole), и редактируемое значение (EditRole),
+ *   и иконка (DecorationRole).
+ * - Для остальных столбцов достаточно DisplayRole + EditRole.
  *
- * @param style Значение Qt::PenStyle.
- * @return Строка вида "Qt::DotLine" или "Qt::PenStyle(N)" для неизвестных значений.
+ * @param c Семантический столбец.
+ * @return QVector<int> с Qt::ItemDataRole значениями (один экземпляр на набор ролей).
  */
-QString MyModel::penStyleToString(Qt::PenStyle style)
+const QVector<int>& MyModel::changedRolesForColumn(Column c)
 {
-    switch (style)
-    {
-    case Qt::NoPen:          return "Qt::NoPen";
-    case Qt::SolidLine:      return "Qt::SolidLine";
-    case Qt::DashLine:       return "Qt::DashLine";
-    case Qt::DotLine:        return "Qt::DotLine";
-    case Qt::DashDotLine:    return "Qt::DashDotLine";
-    case Qt::DashDotDotLine: return "Qt::DashDotDotLine";
-    default:
-        return QString("Qt::PenStyle(%1)").arg(static_cast<int>(style));
-    }
+    // Один экземпляр на набор ролей: dataChanged получает разделяемый вектор
+    static const QVector<int> colorRoles { Qt::DisplayRole, Qt::EditRole, Qt::DecorationRole };
+    static const QVector<int> valueRoles { Qt::DisplayRole, Qt::EditRole };
+
+    return c == Column::PenColor ? colorRoles : valueRoles;
 }
 
+namespace {
+
 /**
- * @brief Разбирает Qt::PenStyle из строки.
- *
- * @details
- * Поддерживаем устойчивый парсинг:
- * 1) число ("3")
- * 2) "Qt::PenStyle(3)"
- * 3) полное имя ("Qt::DotLine")
- *
- * @param s Входная строка.
- * @param ok Если не nullptr, сюда пишется успешность парсинга.
- * @return Значение Qt::PenStyle. Если парсинг не удался — возвращается Qt::SolidLine как fallback.
+ * @brief Битовое представление поля строки (журнал транзакции).
  */
-Qt::PenStyle MyModel::penStyleFromString(const QString& s, bool* ok)
+quint32 cellBits(const RectStore& items, int row, RectColumns::Column c)
 {
-    const QString t = s.trimmed();
-
-    // (1) число
-    bool numOk = false;
-    const int asInt = t.toInt(&numOk);
-    if (numOk)
-    {
-        if (ok) *ok = true;
-        return static_cast<Qt::PenStyle>(asInt);
-    }
-
-    // (2) "Qt::PenStyle(3)"
-    if (t.startsWith("Qt::PenStyle(") && t.endsWith(')'))
+    switch (c)
     {
-        const int prefixLen = QString("Qt::PenStyle(").size();
-        const QString inside = t.mid(prefixLen, t.size() - prefixLen - 1);
-        const int v = inside.toInt(&numOk);
-        if (numOk)
-        {
-            if (ok) *ok = true;
-            return static_cast<Qt::PenStyle>(v);
-        }
+    case RectColumns::Column::PenColor: return items.penColor(row);
+    case RectColumns::Column::PenStyle: return items.penStyle(row);
+    default:                            return static_cast<quint32>(items.intValue(row, c));
     }
+}
 
-    // (3) имена
-    struct MapItem { const char* name; Qt::PenStyle style; };
-    static const MapItem kMap[] = {
-        {"Qt::NoPen",          Qt::NoPen},
-        {"Qt::SolidLine",      Qt::SolidLine},
-        {"Qt::DashLine",       Qt::DashLine},
-        {"Qt::DotLine",        Qt::DotLine},
-        {"Qt::DashDotLine",    Qt::DashDotLine},
-        {"Qt::DashDotDotLine", Qt::DashDotDotLine},
-    };
-
-    for (const auto& it : kMap)
+/**
+ * @brief Записывает поле строки из битового представления (откат транзакции).
+ */
+void setCellBits(RectStore& items, int row, RectColumns::Column c, quint32 bits)
+{
+    switch (c)
     {
-        if (t == QLatin1String(it.name))
-        {
-            if (ok) *ok = true;
-            return it.style;
-        }
+    case RectColumns::Column::PenColor: items.setPenColor(row, bits); break;
+    case RectColumns::Column::PenStyle: items.setPenStyle(row, static_cast<quint8>(bits)); break;
+    default:                            items.setIntValue(row, c, static_cast<qint32>(bits)); break;
     }
+}
 
-    if (ok) *ok = false;
-    return Qt::SolidLine;
+/// Ключ ячейки в журнале транзакции.
+quint64 cellKey(int row, int col)
+{
+    return (quint64(row) << 8) | quint64(col);
 }
 
+/// Прямоугольник ячеек [firstRow..lastRow] x [firstCol..lastCol] для dataChanged.
+struct CellSpan
+{
+    int firstRow;
+    int lastRow;
+    int firstCol;
+    int lastCol;
+};
+
 /**
- * @brief Возвращает роли, которые следует указать в dataChanged для данного столбца.
+ * @brief Сливает ячейки в прямоугольники: ячейки соседних (или одной) строк — в один.
  *
  * @details
- * - Для PenColor меняется и отображаемый текст (DisplayRole), и редактируемое значение (EditRole),
- *   и иконка (DecorationRole).
- * - Для остальных столбцов достаточно DisplayRole + EditRole.
- *
- * @param c Семантический столбец.
- * @return QVector<int> с Qt::ItemDataRole значениями.
+ * Столбцы прямоугольника — от минимального до максимального затронутого
+ * в его строках. Если прямоугольников больше @p maxSpans, возвращается
+ * один охватывающий все ячейки.
  */
-QVector<int> MyModel::changedRolesForColumn(Column c)
+QVector<CellSpan> coalesceCells(QVector<QPair<int, int>> cells, int maxSpans)
 {
-    if (c == Column::PenColor)
-        return { Qt::DisplayRole, Qt::EditRole, Qt::DecorationRole };
+    std::sort(cells.begin(), cells.end());
+
+    QVector<CellSpan> spans;
+    for (const auto& cell : cells)
+    {
+        if (!spans.isEmpty() && cell.first <= spans.last().lastRow + 1)
+        {
+            CellSpan& span = spans.last();
+            span.lastRow = cell.first;
+            span.firstCol = qMin(span.firstCol, cell.second);
+            span.lastCol = qMax(span.lastCol, cell.second);
+            continue;
+        }
+        spans.append(CellSpan{cell.first, cell.first, cell.second, cell.second});
+    }
 
-    return { Qt::DisplayRole, Qt::EditRole };
+    if (spans.size() <= maxSpans)
+        return spans;
+
+    CellSpan bounds = spans.first();
+    for (const CellSpan& span : spans)
+    {
+        bounds.lastRow = span.lastRow;
+        bounds.firstCol = qMin(bounds.firstCol, span.firstCol);
+        bounds.lastCol = qMax(bounds.lastCol, span.lastCol);
+    }
+    return {bounds};
 }
 
+} // namespace
+
 /** @} */
 
 // -------------------- ctor / basic --------------------
@@ -141,6 +148,21 @@ MyModel::MyModel(QObject* parent)
     static_assert(kColumns.size() == kColCount, "kColumns must match Column::Count");
 }
 
+/**
+ * @brief Деструктор модели.
+ *
+ * @details
+ * Рабочий поток обращается к модели (postIoProgress(), завершение операции),
+ * поэтому он обязан завершиться раньше модели. Уже поставленные в очередь
+ * события для удаляемой модели Qt отбрасывает сам.
+ */
+MyModel::~MyModel()
+{
+    cancelAsyncOperation();
+    if (m_ioThread)
+        joinIoThread();
+}
+
 /**
  * @brief Количество строк.
  */
@@ -198,7 +220,8 @@ Qt::ItemFlags MyModel::flags(const QModelIndex& index) const
     if (!index.isValid())
         return Qt::NoItemFlags;
 
-    return QAbstractTableModel::flags(index) | Qt::ItemIsEditable;
+    return QAbstractTableModel::flags(index) | Qt::ItemIsEditable
+           | Qt::ItemIsDragEnabled | Qt::ItemIsDropEnabled;
 }
 
 /**
@@ -212,13 +235,270 @@ bool MyModel::insertRows(int row, int count, const QModelIndex& parent)
     if (row < 0) row = 0;
     if (row > m_items.size()) row = m_items.size();
 
+    // Журнал транзакции хранит номера строк: сдвигать их нельзя
+    if (m_batchDepth > 0 && row < m_items.size())
+        return false;
+
     beginInsertRows(QModelIndex(), row, row + count - 1);
-    m_items.insert(row, count, MyRect{});
+    m_items.insert(row, count, PackedRect{});
+    if (m_spatialValid)
+        m_spatial.insertRows(m_items, row, count);
     endInsertRows();
 
+    recordHistory(EditHistory::insert(row, count));
+    return true;
+}
+
+/**
+ * @brief Удаление строк.
+ */
+bool MyModel::removeRows(int row, int count, const QModelIndex& parent)
+{
+    if (parent.isValid() || count <= 0 || row < 0 || row > m_items.size() - count)
+        return false;
+    if (m_batchDepth > 0)
+        return false;
+
+    recordHistory(EditHistory::remove(row, m_items.mid(row, count)));
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    if (m_spatialValid)
+        m_spatial.removeRows(m_items, row, count);
+    m_items.remove(row, count);
+    endRemoveRows();
+
+    return true;
+}
+
+/**
+ * @brief Пакетное удаление строк по номерам.
+ */
+int MyModel::removeRowsAt(const QVector<int>& rows)
+{
+    if (m_batchDepth > 0)
+        return 0;
+
+    const QVector<RectStore::Range> ranges = RectStore::toRanges(rows, m_items.size());
+
+    // Один шаг истории: диапазоны с конца, как они и удаляются
+    int removed = 0;
+    m_history.beginStep();
+    for (auto it = ranges.crbegin(); it != ranges.crend(); ++it)
+    {
+        m_history.record(EditHistory::remove(it->first, m_items.mid(it->first, it->count)));
+        removed += it->count;
+    }
+    m_history.endStep();
+    notifyUndoState();
+
+    if (ranges.size() <= kMaxRemoveNotifications)
+    {
+        for (auto it = ranges.crbegin(); it != ranges.crend(); ++it)
+        {
+            beginRemoveRows(QModelIndex(), it->first, it->first + it->count - 1);
+            if (m_spatialValid)
+                m_spatial.removeRows(m_items, it->first, it->count);
+            m_items.remove(it->first, it->count);
+            endRemoveRows();
+        }
+        return removed;
+    }
+
+    beginResetModel();
+    m_items.removeRanges(ranges);
+    invalidateSpatialIndex();
+    endResetModel();
+
+    return removed;
+}
+
+/**
+ * @brief Перенос блока строк.
+ */
+bool MyModel::moveRows(const QModelIndex& sourceParent,
+                       int sourceRow,
+                       int count,
+                       const QModelIndex& destinationParent,
+                       int destinationChild)
+{
+    const int size = m_items.size();
+    if (sourceParent.isValid() || destinationParent.isValid() || count <= 0
+        || sourceRow < 0 || sourceRow > size - count
+        || destinationChild < 0 || destinationChild > size)
+        return false;
+    if (m_batchDepth > 0)
+        return false;
+
+    // beginMoveRows() сам отклоняет перенос внутрь исходного диапазона
+    if (!beginMoveRows(QModelIndex(), sourceRow, sourceRow + count - 1, QModelIndex(), destinationChild))
+        return false;
+    m_items.move(sourceRow, count, destinationChild);
+    if (m_spatialValid)
+        m_spatial.moveRows(sourceRow, count, destinationChild);
+    endMoveRows();
+
+    recordHistory(EditHistory::move(sourceRow, count, destinationChild));
+    return true;
+}
+
+/**
+ * @brief Сборка строк в блок перед destinationRow.
+ */
+int MyModel::moveRowsTo(const QVector<int>& rows, int destinationRow)
+{
+    if (destinationRow < 0 || destinationRow > m_items.size() || m_batchDepth > 0)
+        return 0;
+
+    // Диапазоны выше места назначения и ниже него (пересекающий — делится)
+    QVector<RectStore::Range> above;
+    QVector<RectStore::Range> below;
+    for (const RectStore::Range& r : RectStore::toRanges(rows, m_items.size()))
+    {
+        const int end = r.first + r.count;
+        if (end <= destinationRow)
+            above.append(r);
+        else if (r.first >= destinationRow)
+            below.append(r);
+        else
+        {
+            above.append(RectStore::Range{r.first, destinationRow - r.first});
+            below.append(RectStore::Range{destinationRow, end - destinationRow});
+        }
+    }
+
+    int moved = 0;
+    m_history.beginStep();
+
+    // Снизу вверх: блок растёт вверх от destinationRow
+    int insertAt = destinationRow;
+    for (auto it = above.crbegin(); it != above.crend(); ++it)
+    {
+        if (it->first + it->count != insertAt)
+            moveRows(QModelIndex(), it->first, it->count, QModelIndex(), insertAt);
+        insertAt -= it->count;
+        moved += it->count;
+    }
+
+    // Сверху вниз: блок растёт вниз от destinationRow
+    insertAt = destinationRow;
+    for (const RectStore::Range& r : below)
+    {
+        if (r.first != insertAt)
+            moveRows(QModelIndex(), r.first, r.count, QModelIndex(), insertAt);
+        insertAt += r.count;
+        moved += r.count;
+    }
+
+    m_history.endStep();
+    notifyUndoState();
+    return moved;
+}
+
+// -------------------- drag-and-drop --------------------
+
+Qt::DropActions MyModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
+
+QStringList MyModel::mimeTypes() const
+{
+    return {QString::fromLatin1(kRowsMimeType)};
+}
+
+/**
+ * @brief Номера строк перетаскиваемых ячеек.
+ */
+QMimeData* MyModel::mimeData(const QModelIndexList& indexes) const
+{
+    QVector<int> rows;
+    rows.reserve(indexes.size());
+    for (const QModelIndex& index : indexes)
+    {
+        if (index.isValid())
+            rows.append(index.row());
+    }
+
+    QVector<int> unique;
+    for (const RectStore::Range& r : RectStore::toRanges(rows, m_items.size()))
+    {
+        for (int row = r.first; row < r.first + r.count; ++row)
+            unique.append(row);
+    }
+
+    QByteArray encoded;
+    QDataStream out(&encoded, QIODevice::WriteOnly);
+    out << quint64(reinterpret_cast<quintptr>(this)) << unique;
+
+    auto* data = new QMimeData;
+    data->setData(QString::fromLatin1(kRowsMimeType), encoded);
+    return data;
+}
+
+namespace {
+
+/**
+ * @brief Номера строк из MIME-данных, если они упакованы моделью @p model.
+ */
+bool decodeRows(const QMimeData* data, const MyModel* model, QVector<int>* rows)
+{
+    if (!data || !data->hasFormat(QString::fromLatin1(MyModel::kRowsMimeType)))
+        return false;
+
+    QDataStream in(data->data(QString::fromLatin1(MyModel::kRowsMimeType)));
+    quint64 source = 0;
+    in >> source;
+    if (in.status() != QDataStream::Ok || source != quint64(reinterpret_cast<quintptr>(model)))
+        return false;
+
+    if (rows)
+    {
+        in >> *rows;
+        if (in.status() != QDataStream::Ok)
+            return false;
+    }
     return true;
 }
 
+} // namespace
+
+bool MyModel::canDropMimeData(const QMimeData* data,
+                              Qt::DropAction action,
+                              int /*row*/,
+                              int /*column*/,
+                              const QModelIndex& /*parent*/) const
+{
+    return action == Qt::MoveAction && decodeRows(data, this, nullptr);
+}
+
+/**
+ * @brief Бросок перетащенных строк.
+ */
+bool MyModel::dropMimeData(const QMimeData* data,
+                           Qt::DropAction action,
+                           int row,
+                           int /*column*/,
+                           const QModelIndex& parent)
+{
+    if (action != Qt::MoveAction)
+        return false;
+
+    QVector<int> rows;
+    if (!decodeRows(data, this, &rows))
+        return false;
+
+    int destination = m_items.size();
+    if (parent.isValid())
+        destination = parent.row();
+    else if (row >= 0)
+        destination = row;
+
+    moveRowsTo(rows, destination);
+
+    // Строки уже перенесены: false не даёт представлению удалить "исходные"
+    return false;
+}
+
 // -------------------- data / setData --------------------
 
 /**
@@ -237,20 +517,19 @@ QVariant MyModel::data(const QModelIndex& index, int role) const
     if (col < 0 || col >= kColCountInt)
         return {};
 
-    const MyRect& r = m_items[row];
     const Column column = kColumns[static_cast<std::size_t>(col)].col;
 
     if (role == Qt::EditRole)
     {
         switch (column)
         {
-        case Column::PenColor:  return r.penColor;
-        case Column::PenStyle:  return static_cast<int>(r.penStyle);
-        case Column::PenWidth:  return r.penWidth;
-        case Column::Left:      return r.left;
-        case Column::Top:       return r.top;
-        case Column::Width:     return r.width;
-        case Column::Height:    return r.height;
+        case Column::PenColor:  return QColor::fromRgba(m_items.penColor(row));
+        case Column::PenStyle:  return static_cast<int>(m_items.penStyle(row));
+        case Column::PenWidth:
+        case Column::Left:
+        case Column::Top:
+        case Column::Width:
+        case Column::Height:    return m_items.intValue(row, column);
         case Column::Count:     break;
         }
         return {};
@@ -260,24 +539,20 @@ QVariant MyModel::data(const QModelIndex& index, int role) const
     {
         switch (column)
         {
-        case Column::PenColor:  return r.penColor.name();
-        case Column::PenStyle:  return penStyleToString(r.penStyle);
-        case Column::PenWidth:  return r.penWidth;
-        case Column::Left:      return r.left;
-        case Column::Top:       return r.top;
-        case Column::Width:     return r.width;
-        case Column::Height:    return r.height;
+        case Column::PenColor:  return m_colorCache.name(m_items.penColor(row));
+        case Column::PenStyle:  return RectFormat::penStyleName(static_cast<Qt::PenStyle>(m_items.penStyle(row)));
+        case Column::PenWidth:
+        case Column::Left:
+        case Column::Top:
+        case Column::Width:
+        case Column::Height:    return m_items.intValue(row, column);
         case Column::Count:     break;
         }
         return {};
     }
 
     if (role == Qt::DecorationRole && column == Column::PenColor)
-    {
-        QPixmap px(32, 32);
-        px.fill(r.penColor);
-        return QIcon(px);
-    }
+        return m_colorCache.icon(m_items.penColor(row));
 
     return {};
 }
@@ -288,18 +563,18 @@ QVariant MyModel::data(const QModelIndex& index, int role) const
 bool MyModel::setData(const QModelIndex& index, const QVariant& value, int role)
 {
     if (!index.isValid() || role != Qt::EditRole)
-        return false;
+        return rejectEdit();
 
     const int row = index.row();
     const int col = index.column();
 
     if (row < 0 || row >= m_items.size())
-        return false;
+        return rejectEdit();
     if (col < 0 || col >= kColCountInt)
-        return false;
+        return rejectEdit();
 
-    MyRect& r = m_items[row];
     const Column column = kColumns[static_cast<std::size_t>(col)].col;
+    const quint32 before = cellBits(m_items, row, column);
 
     bool changed = false;
 
@@ -314,131 +589,444 @@ bool MyModel::setData(const QModelIndex& index, const QVariant& value, int role)
             c = QColor(value.toString().trimmed());
 
         if (!c.isValid())
-            return false;
+            return rejectEdit();
 
-        if (r.penColor != c)
+        const QRgb rgba = c.rgba();
+        if (m_items.penColor(row) != rgba)
         {
-            r.penColor = c;
+            m_items.setPenColor(row, rgba);
             changed = true;
         }
         break;
     }
     case Column::PenStyle:
     {
-        const Qt::PenStyle style = static_cast<Qt::PenStyle>(value.toInt());
-        if (r.penStyle != style)
+        const int style = value.toInt();
+        if (!PackedRect::isValidPenStyle(style))
+            return rejectEdit();
+
+        if (m_items.penStyle(row) != style)
         {
-            r.penStyle = style;
+            m_items.setPenStyle(row, static_cast<quint8>(style));
             changed = true;
         }
         break;
     }
     case Column::PenWidth:
-    {
-        const int v = value.toInt();
-        if (r.penWidth != v)
-        {
-            r.penWidth = v;
-            changed = true;
-        }
-        break;
-    }
     case Column::Left:
-    {
-        const int v = value.toInt();
-        if (r.left != v)
-        {
-            r.left = v;
-            changed = true;
-        }
-        break;
-    }
     case Column::Top:
-    {
-        const int v = value.toInt();
-        if (r.top != v)
-        {
-            r.top = v;
-            changed = true;
-        }
-        break;
-    }
     case Column::Width:
-    {
-        const int v = value.toInt();
-        if (r.width != v)
-        {
-            r.width = v;
-            changed = true;
-        }
-        break;
-    }
     case Column::Height:
     {
         const int v = value.toInt();
-        if (r.height != v)
+        if (m_items.intValue(row, column) != v)
         {
-            r.height = v;
+            m_items.setIntValue(row, column, v);
             changed = true;
         }
         break;
     }
     case Column::Count:
-        return false;
+        return rejectEdit();
     }
 
     if (!changed)
         return true;
 
+    updateSpatialCell(row, column, before);
+
+    if (m_batchDepth > 0)
+    {
+        // Запоминается только значение до транзакции (первая правка ячейки)
+        const quint64 key = cellKey(row, col);
+        if (!m_batchOld.contains(key))
+            m_batchOld.insert(key, before);
+        return true;
+    }
+
+    const quint32 after = cellBits(m_items, row, column);
+    if (!m_history.mergeCell(row, col, after))
+        m_history.record(EditHistory::cells({EditHistory::CellDiff{row, static_cast<quint8>(col), before, after}}));
+    notifyUndoState();
+
     emit dataChanged(index, index, changedRolesForColumn(column));
     return true;
 }
 
-// -------------------- slotAddData / test --------------------
-
-/**
- * @brief Добавление строки в конец модели.
- */
-void MyModel::slotAddData(const MyRect& rect)
+bool MyModel::rejectEdit()
 {
-    const int row = m_items.size();
+    if (m_batchDepth > 0)
+        m_batchFailed = true;
+    return false;
+}
 
-    if (!insertRows(row, 1))
-        return;
+// -------------------- batch edit --------------------
+
+void MyModel::beginBatchEdit()
+{
+    // Зафиксированная транзакция — один шаг истории
+    if (m_batchDepth++ == 0)
+    {
+        m_history.beginStep();
+        markBatchStart();
+    }
+}
 
-    m_items[row] = rect;
+void MyModel::markBatchStart()
+{
+    m_batchRows = m_items.size();
+    m_batchHistoryMark = m_history.openEntryCount();
+}
 
-    const QModelIndex leftTop = index(row, 0);
-    const QModelIndex rightBottom = index(row, kColCountInt - 1);
+bool MyModel::commitBatchEdit()
+{
+    if (m_batchDepth == 0)
+        return false;
 
-    emit dataChanged(leftTop, rightBottom,
-                     {Qt::DisplayRole, Qt::EditRole, Qt::DecorationRole});
+    const bool ok = !m_batchFailed;
+    if (--m_batchDepth == 0)
+        finishBatchEdit(m_batchFailed);
+    return ok;
 }
 
-/**
- * @brief Тестовые данные.
- */
-void MyModel::test()
+void MyModel::rollbackBatchEdit()
 {
-    slotAddData(MyRect(QColor(Qt::red),   Qt::SolidLine, 2, 100, 100, 100, 100));
-    slotAddData(MyRect(QColor(Qt::green), Qt::DotLine,   3,  10,  10, 100, 200));
+    if (m_batchDepth == 0)
+        return;
+
+    m_batchFailed = true;
+    if (--m_batchDepth == 0)
+        finishBatchEdit(true);
 }
 
-// -------------------- save/load wrappers by filename --------------------
+bool MyModel::isBatchEditActive() const
+{
+    return m_batchDepth > 0;
+}
 
 /**
- * @brief Сохранение TSV по имени файла.
+ * @brief Фиксация или откат журнала транзакции.
+ *
+ * @details
+ * Журнал забирается до отката/сигналов: обработчик dataChanged может
+ * сразу открыть новую транзакцию. При откате строки, добавленные в конец
+ * внутри транзакции, удаляются, а их записи выбрасываются из открытого
+ * шага истории — восстанавливать ячейки в них незачем.
  */
-bool MyModel::saveToTsv(const QString& fileName, QString* error) const
+void MyModel::finishBatchEdit(bool rollback)
 {
-    QFile file(fileName);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    const QHash<quint64, quint32> journal = std::move(m_batchOld);
+    m_batchOld.clear();
+    m_batchFailed = false;
+
+    // Ячейки, значение которых отличается от исходного
+    QVector<QPair<int, int>> changed;
+    QVector<EditHistory::CellDiff> diffs;
+    for (auto it = journal.cbegin(); it != journal.cend(); ++it)
     {
-        if (error) *error = file.errorString();
-        return false;
-    }
-    return saveToTsv(static_cast<QIODevice&>(file), error);
-}
+        const int row = static_cast<int>(it.key() >> 8);
+        const int col = static_cast<int>(it.key() & 0xff);
+        const Column column = kColumns[static_cast<std::size_t>(col)].col;
+        if (rollback && row >= m_batchRows)
+            continue;
+
+        const quint32 current = cellBits(m_items, row, column);
+        if (current == it.value())
+            continue;
+
+        if (rollback)
+        {
+            setCellBits(m_items, row, column, it.value());
+            updateSpatialCell(row, column, current);
+        }
+        else
+            diffs.append(EditHistory::CellDiff{row, static_cast<quint8>(col), it.value(), current});
+
+        changed.append(qMakePair(row, col));
+    }
+
+    if (rollback && m_items.size() > m_batchRows)
+    {
+        beginRemoveRows(QModelIndex(), m_batchRows, m_items.size() - 1);
+        if (m_spatialValid)
+            m_spatial.removeRows(m_items, m_batchRows, m_items.size() - m_batchRows);
+        m_items.remove(m_batchRows, m_items.size() - m_batchRows);
+        endRemoveRows();
+    }
+    if (rollback)
+        m_history.truncateOpen(m_batchHistoryMark);
+
+    if (!diffs.isEmpty())
+        m_history.record(EditHistory::cells(std::move(diffs)));
+    m_history.endStep();
+    notifyUndoState();
+
+    emitCellsChanged(changed);
+}
+
+/**
+ * @brief Объединённые dataChanged по наборам ролей.
+ */
+void MyModel::emitCellsChanged(const QVector<QPair<int, int>>& cells)
+{
+    QVector<QPair<int, int>> colorCells;
+    QVector<QPair<int, int>> valueCells;
+    for (const auto& cell : cells)
+    {
+        const Column column = kColumns[static_cast<std::size_t>(cell.second)].col;
+        (column == Column::PenColor ? colorCells : valueCells).append(cell);
+    }
+
+    for (const CellSpan& span : coalesceCells(colorCells, kMaxEditNotifications))
+    {
+        emit dataChanged(index(span.firstRow, span.firstCol), index(span.lastRow, span.lastCol),
+                         changedRolesForColumn(Column::PenColor));
+    }
+    for (const CellSpan& span : coalesceCells(valueCells, kMaxEditNotifications))
+    {
+        emit dataChanged(index(span.firstRow, span.firstCol), index(span.lastRow, span.lastCol),
+                         changedRolesForColumn(Column::Left));
+    }
+}
+
+// -------------------- storage layout / column scans --------------------
+
+/**
+ * @brief Переключение раскладки хранилища.
+ */
+void MyModel::setStorageLayout(StorageLayout layout)
+{
+    m_items.setLayout(layout);
+}
+
+MyModel::StorageLayout MyModel::storageLayout() const
+{
+    return m_items.layout();
+}
+
+void MyModel::setTsvLoadMode(TsvLoadMode mode)
+{
+    m_tsvLoadMode = mode;
+}
+
+MyModel::TsvLoadMode MyModel::tsvLoadMode() const
+{
+    return m_tsvLoadMode;
+}
+
+void MyModel::setTsvParseThreads(int threads)
+{
+    m_tsvParseThreads = qMax(0, threads);
+}
+
+int MyModel::tsvParseThreads() const
+{
+    return m_tsvParseThreads;
+}
+
+void MyModel::setTsvSaveThreads(int threads)
+{
+    m_tsvSaveThreads = qMax(0, threads);
+}
+
+int MyModel::tsvSaveThreads() const
+{
+    return m_tsvSaveThreads;
+}
+
+qint64 MyModel::totalArea() const
+{
+    return m_items.totalArea();
+}
+
+QVector<int> MyModel::rowsInRange(int column, qint64 min, qint64 max) const
+{
+    if (column < 0 || column >= kColCountInt)
+        return {};
+    return m_items.rowsInRange(kColumns[static_cast<std::size_t>(column)].col, min, max);
+}
+
+QVector<int> MyModel::rowOrderBy(int column) const
+{
+    if (column < 0 || column >= kColCountInt)
+        return {};
+    return m_items.rowOrderBy(kColumns[static_cast<std::size_t>(column)].col);
+}
+
+// -------------------- spatial queries --------------------
+
+QVector<int> MyModel::rowsAt(const QPoint& point) const
+{
+    return spatialIndex().rowsAt(m_items, point);
+}
+
+QVector<int> MyModel::rowsIntersecting(const QRect& area) const
+{
+    return spatialIndex().rowsIntersecting(m_items, area);
+}
+
+QVector<int> MyModel::nearestRows(const QPoint& point, int k) const
+{
+    return spatialIndex().nearestRows(m_items, point, k);
+}
+
+const RectSpatialIndex& MyModel::spatialIndex() const
+{
+    if (!m_spatialValid)
+    {
+        m_spatial.rebuild(m_items);
+        m_spatialValid = true;
+    }
+    return m_spatial;
+}
+
+void MyModel::invalidateSpatialIndex()
+{
+    m_spatial.clear();
+    m_spatialValid = false;
+}
+
+/**
+ * @details
+ * Прежний прямоугольник собирается из текущей строки и прежнего значения поля.
+ */
+void MyModel::updateSpatialCell(int row, Column column, quint32 before)
+{
+    if (!m_spatialValid || !RectSpatialIndex::isGeometryColumn(column))
+        return;
+
+    const PackedRect after = m_items.at(row);
+    PackedRect old = after;
+    switch (column)
+    {
+    case Column::Left:   old.left   = static_cast<qint32>(before); break;
+    case Column::Top:    old.top    = static_cast<qint32>(before); break;
+    case Column::Width:  old.width  = static_cast<qint32>(before); break;
+    case Column::Height: old.height = static_cast<qint32>(before); break;
+    default:             break;
+    }
+    m_spatial.updateRow(row, old, after);
+}
+
+// -------------------- icon cache --------------------
+
+void MyModel::setIconCacheCapacity(int capacity)
+{
+    m_colorCache.setIconCapacity(capacity);
+}
+
+int MyModel::iconCacheCapacity() const
+{
+    return m_colorCache.iconCapacity();
+}
+
+quint64 MyModel::iconCacheHits() const
+{
+    return m_colorCache.iconHits();
+}
+
+quint64 MyModel::iconCacheMisses() const
+{
+    return m_colorCache.iconMisses();
+}
+
+void MyModel::resetIconCacheStats()
+{
+    m_colorCache.resetIconStats();
+}
+
+// -------------------- slotAddData / test --------------------
+
+/**
+ * @brief Добавление строки в конец модели.
+ */
+void MyModel::slotAddData(const MyRect& rect)
+{
+    const int row = m_items.size();
+
+    if (!insertRows(row, 1))
+        return;
+
+    m_items.set(row, PackedRect::fromRect(rect));
+    if (m_spatialValid)
+        m_spatial.updateRow(row, PackedRect{}, m_items.at(row));
+
+    const QModelIndex leftTop = index(row, 0);
+    const QModelIndex rightBottom = index(row, kColCountInt - 1);
+
+    emit dataChanged(leftTop, rightBottom,
+                     {Qt::DisplayRole, Qt::EditRole, Qt::DecorationRole});
+}
+
+/**
+ * @brief Пакетное добавление строк в конец модели.
+ *
+ * @details
+ * Строки упаковываются прямо в хранилище между begin/endInsertRows;
+ * рост хранилища геометрический (append), поэтому частые небольшие пачки
+ * не приводят к перераспределению всего массива на каждом вызове.
+ */
+void MyModel::appendRects(const MyRect* rects, int count)
+{
+    if (!rects || count <= 0)
+        return;
+
+    const int first = m_items.size();
+
+    beginInsertRows(QModelIndex(), first, first + count - 1);
+    for (int i = 0; i < count; ++i)
+        m_items.append(PackedRect::fromRect(rects[i]));
+    if (m_spatialValid)
+        m_spatial.insertRows(m_items, first, count);
+    endInsertRows();
+
+    recordHistory(EditHistory::insert(first, count));
+}
+
+void MyModel::appendRects(const QVector<MyRect>& rects)
+{
+    appendRects(rects.constData(), rects.size());
+}
+
+/**
+ * @brief Строка модели как MyRect.
+ */
+MyRect MyModel::rectAt(int row) const
+{
+    if (row < 0 || row >= m_items.size())
+        return MyRect{};
+    return m_items.at(row).toRect();
+}
+
+RectSnapshot MyModel::snapshot() const
+{
+    return RectSnapshot(m_items);
+}
+
+/**
+ * @brief Тестовые данные.
+ */
+void MyModel::test()
+{
+    slotAddData(MyRect(QColor(Qt::red),   Qt::SolidLine, 2, 100, 100, 100, 100));
+    slotAddData(MyRect(QColor(Qt::green), Qt::DotLine,   3,  10,  10, 100, 200));
+}
+
+// -------------------- save/load wrappers by filename --------------------
+
+/**
+ * @brief Сохранение TSV по имени файла.
+ */
+bool MyModel::saveToTsv(const QString& fileName, QString* error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return saveToTsv(static_cast<QIODevice&>(file), error);
+}
 
 /**
  * @brief Загрузка TSV по имени файла.
@@ -467,37 +1055,105 @@ bool MyModel::saveToTsv(QIODevice& out, QString* error) const
         return false;
     }
 
-    QTextStream stream(&out);
+    TsvWriter writer(out);
+    writer.setThreads(m_tsvSaveThreads);
+    return writer.write(m_items, 0, m_items.size(), error);
+}
 
-    for (const MyRect& r : m_items)
+/**
+ * @brief Загрузка TSV из произвольного устройства ввода.
+ */
+bool MyModel::loadFromTsv(QIODevice& in, QString* error)
+{
+    if (!in.isOpen() || !(in.openMode() & QIODevice::ReadOnly))
     {
-        QStringList fields;
-        fields.reserve(kColCountInt);
+        if (error) *error = "Устройство ввода не открыто на чтение";
+        return false;
+    }
+
+    RectStore tmp(m_items.layout());
 
-        fields << r.penColor.name();
-        fields << penStyleToString(r.penStyle);
-        fields << QString::number(r.penWidth);
-        fields << QString::number(r.left);
-        fields << QString::number(r.top);
-        fields << QString::number(r.width);
-        fields << QString::number(r.height);
+    bool inPlace = false;
+    if (m_tsvLoadMode == TsvLoadMode::MemoryMap)
+    {
+        if (!TsvReader::readMapped(in, tmp, &inPlace, error, m_tsvParseThreads))
+            return false;
+        if (!inPlace && !TsvReader::readBuffer(in, tmp, &inPlace, error, m_tsvParseThreads))
+            return false;
+    }
 
-        stream << fields.join('\t') << '\n';
+    if (!inPlace)
+    {
+        TsvReader reader(in);
+        if (!reader.read(tmp, 0, error))
+            return false;
     }
 
-    if (stream.status() != QTextStream::Ok)
+    replaceItems(std::move(tmp));
+
+    return true;
+}
+
+// -------------------- TSV window via row index --------------------
+
+bool MyModel::loadFromTsvRange(const QString& fileName, qint64 firstRow, int count, QString* error)
+{
+    TsvIndex index;
+    if (!index.open(fileName, error))
+        return false;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
     {
-        if (error) *error = "Ошибка записи TSV-потока";
+        if (error) *error = file.errorString();
         return false;
     }
 
+    RectStore tmp(m_items.layout());
+    if (!index.readRows(file, firstRow, count, tmp, error))
+        return false;
+
+    replaceItems(std::move(tmp));
+
     return true;
 }
 
-/**
- * @brief Загрузка TSV из произвольного устройства ввода.
- */
-bool MyModel::loadFromTsv(QIODevice& in, QString* error)
+// -------------------- binary snapshot --------------------
+
+bool MyModel::saveToBinary(const QString& fileName, QString* error) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return saveToBinary(static_cast<QIODevice&>(file), error);
+}
+
+bool MyModel::loadFromBinary(const QString& fileName, QString* error)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return loadFromBinary(static_cast<QIODevice&>(file), error);
+}
+
+bool MyModel::saveToBinary(QIODevice& out, QString* error) const
+{
+    if (!out.isOpen() || !(out.openMode() & QIODevice::WriteOnly))
+    {
+        if (error) *error = "Устройство вывода не открыто на запись";
+        return false;
+    }
+
+    return RectBinary::write(out, m_items, error);
+}
+
+bool MyModel::loadFromBinary(QIODevice& in, QString* error)
 {
     if (!in.isOpen() || !(in.openMode() & QIODevice::ReadOnly))
     {
@@ -505,78 +1161,465 @@ bool MyModel::loadFromTsv(QIODevice& in, QString* error)
         return false;
     }
 
-    QTextStream stream(&in);
+    RectStore tmp(m_items.layout());
+    if (!RectBinary::read(in, tmp, error))
+        return false;
+
+    replaceItems(std::move(tmp));
+
+    return true;
+}
 
-    QVector<MyRect> tmp;
-    int lineNo = 0;
+// -------------------- incremental load (fetchMore) --------------------
 
-    while (!stream.atEnd())
+/**
+ * @brief Открытие файла для постепенной загрузки.
+ *
+ * @details
+ * Читатель создаётся до endResetModel(): View после сброса сразу спрашивает
+ * canFetchMore() и должен получить true.
+ */
+bool MyModel::openTsvIncremental(const QString& fileName, QString* error)
+{
+    auto file = std::make_unique<QFile>(fileName);
+    if (!file->open(QIODevice::ReadOnly))
     {
-        const QString line = stream.readLine();
-        ++lineNo;
+        if (error) *error = file->errorString();
+        return false;
+    }
 
-        if (line.trimmed().isEmpty())
-            continue;
+    beginResetModel();
+    stopIncrementalLoad();
+    m_batchOld.clear();
+    m_fetchFile = std::move(file);
+    m_fetchReader = std::make_unique<TsvReader>(*m_fetchFile);
+    const RectStore::Layout layout = m_items.layout();
+    m_history.record(EditHistory::replace(std::move(m_items)));
+    m_items = RectStore(layout);
+    markBatchStart();
+    invalidateSpatialIndex();
+    endResetModel();
+
+    notifyUndoState();
+
+    return true;
+}
+
+bool MyModel::isIncrementalLoadActive() const
+{
+    return m_fetchReader != nullptr;
+}
+
+bool MyModel::canFetchMore(const QModelIndex& parent) const
+{
+    // Прочитанную порцию откат транзакции удалил бы, а файл назад не перемотать
+    return !parent.isValid() && m_batchDepth == 0 && m_fetchReader && !m_fetchReader->atEnd();
+}
+
+/**
+ * @brief Очередная порция постепенной загрузки.
+ *
+ * @details
+ * Порция читается во временное хранилище, чтобы заранее знать число строк
+ * для beginInsertRows(). Файл закрывается до вставки: если View во время
+ * endInsertRows() снова спросит canFetchMore(), он получит уже false.
+ */
+void MyModel::fetchMore(const QModelIndex& parent)
+{
+    if (!canFetchMore(parent))
+        return;
+
+    RectStore batch(m_items.layout());
+    QString error;
+    const bool ok = m_fetchReader->read(batch, kFetchBatchRows, &error);
+
+    const bool done = !ok || m_fetchReader->atEnd();
+    if (done)
+        stopIncrementalLoad();
+
+    if (!batch.isEmpty())
+    {
+        const int first = m_items.size();
+        beginInsertRows(QModelIndex(), first, first + batch.size() - 1);
+        m_items.append(batch);
+        if (m_spatialValid)
+            m_spatial.insertRows(m_items, first, batch.size());
+        endInsertRows();
+    }
+
+    if (done)
+        emit loadFinished(ok, false, error);
+}
+
+void MyModel::stopIncrementalLoad()
+{
+    m_fetchReader.reset();
+    m_fetchFile.reset();
+}
+
+void MyModel::replaceItems(RectStore&& items)
+{
+    beginResetModel();
+    stopIncrementalLoad();
+    m_batchOld.clear();
+    m_history.record(EditHistory::replace(std::move(m_items)));
+    m_items = std::move(items);
+    markBatchStart();
+    invalidateSpatialIndex();
+    endResetModel();
+
+    notifyUndoState();
+}
+
+// -------------------- undo / redo --------------------
+
+bool MyModel::undo()
+{
+    if (m_batchDepth > 0 || !m_history.canUndo())
+        return false;
+
+    EditHistory::Step step = m_history.takeUndo();
+    applyHistoryStep(step, true);
+    m_history.pushRedo(std::move(step));
+    notifyUndoState();
+    return true;
+}
+
+bool MyModel::redo()
+{
+    if (m_batchDepth > 0 || !m_history.canRedo())
+        return false;
+
+    EditHistory::Step step = m_history.takeRedo();
+    applyHistoryStep(step, false);
+    m_history.pushUndo(std::move(step));
+    notifyUndoState();
+    return true;
+}
+
+bool MyModel::canUndo() const
+{
+    return m_history.canUndo();
+}
+
+bool MyModel::canRedo() const
+{
+    return m_history.canRedo();
+}
+
+void MyModel::clearHistory()
+{
+    m_history.clear();
+    notifyUndoState();
+}
+
+void MyModel::setUndoMemoryBudget(qint64 bytes)
+{
+    m_history.setMemoryBudget(bytes);
+    notifyUndoState();
+}
+
+qint64 MyModel::undoMemoryBudget() const
+{
+    return m_history.memoryBudget();
+}
+
+qint64 MyModel::undoMemoryUsage() const
+{
+    return m_history.memoryUsage();
+}
+
+void MyModel::recordHistory(EditHistory::Entry entry)
+{
+    m_history.record(std::move(entry));
+    notifyUndoState();
+}
+
+void MyModel::notifyUndoState()
+{
+    const bool undoable = m_history.canUndo();
+    const bool redoable = m_history.canRedo();
+    if (undoable == m_canUndo && redoable == m_canRedo)
+        return;
+
+    m_canUndo = undoable;
+    m_canRedo = redoable;
+    emit undoStateChanged(undoable, redoable);
+}
+
+/**
+ * @details
+ * Шаг из многих записей (удаление сотен диапазонов) применяется под одним
+ * modelReset — как в removeRowsAt().
+ */
+void MyModel::applyHistoryStep(EditHistory::Step& step, bool undo)
+{
+    const bool reset = step.size() > kMaxRemoveNotifications;
+    if (reset)
+        beginResetModel();
+
+    if (undo)
+    {
+        for (int i = step.size() - 1; i >= 0; --i)
+            applyHistoryEntry(step[i], true, !reset);
+    }
+    else
+    {
+        for (EditHistory::Entry& entry : step)
+            applyHistoryEntry(entry, false, !reset);
+    }
 
-        const QStringList parts = line.split('\t', Qt::KeepEmptyParts);
-        if (parts.size() != kColCountInt)
+    if (reset)
+        endResetModel();
+}
+
+/**
+ * @details
+ * Вставка и удаление — одна операция в разные стороны: "убрать блок"
+ * запоминает строки в записи, "вернуть блок" вставляет их и освобождает
+ * запись. Поэтому вставленная и отменённая строка при повторе возвращается
+ * с тем содержимым, что было на момент отмены.
+ */
+void MyModel::applyHistoryEntry(EditHistory::Entry& entry, bool undo, bool notify)
+{
+    using Kind = EditHistory::Kind;
+
+    const auto takeBlock = [&]()
+    {
+        entry.rows = m_items.mid(entry.row, entry.count);
+        if (notify) beginRemoveRows(QModelIndex(), entry.row, entry.row + entry.count - 1);
+        if (m_spatialValid)
+            m_spatial.removeRows(m_items, entry.row, entry.count);
+        m_items.remove(entry.row, entry.count);
+        if (notify) endRemoveRows();
+    };
+    const auto putBlock = [&]()
+    {
+        if (notify) beginInsertRows(QModelIndex(), entry.row, entry.row + entry.count - 1);
+        if (entry.rows.size() == entry.count)
+            m_items.insert(entry.row, entry.rows);
+        else
+            m_items.insert(entry.row, entry.count, PackedRect{});
+        entry.rows = RectStore(m_items.layout());
+        if (m_spatialValid)
+            m_spatial.insertRows(m_items, entry.row, entry.count);
+        if (notify) endInsertRows();
+    };
+
+    switch (entry.kind)
+    {
+    case Kind::Cells:
+    {
+        QVector<QPair<int, int>> cells;
+        cells.reserve(entry.cells.size());
+        for (int i = 0; i < entry.cells.size(); ++i)
         {
-            if (error)
-            {
-                *error = QString("Строка %1: ожидалось %2 полей, получено %3")
-                             .arg(lineNo)
-                             .arg(kColCountInt)
-                             .arg(parts.size());
-            }
-            return false;
+            const EditHistory::CellDiff& d = entry.cells.at(undo ? entry.cells.size() - 1 - i : i);
+            const Column column = kColumns[static_cast<std::size_t>(d.column)].col;
+            setCellBits(m_items, d.row, column, undo ? d.before : d.after);
+            updateSpatialCell(d.row, column, undo ? d.after : d.before);
+            cells.append(qMakePair(int(d.row), int(d.column)));
         }
-
-        const QColor color(parts[0].trimmed());
-        if (!color.isValid())
+        if (notify)
+            emitCellsChanged(cells);
+        break;
+    }
+    case Kind::Insert:
+        if (undo) takeBlock(); else putBlock();
+        break;
+    case Kind::Remove:
+        if (undo) putBlock(); else takeBlock();
+        break;
+    case Kind::Move:
+    {
+        // Обратный перенос: блок стоит перед destination (вниз) или начиная с него (вверх)
+        int source = entry.row;
+        int destination = entry.destination;
+        if (undo)
         {
-            if (error) *error = QString("Строка %1: некорректный цвет '%2'").arg(lineNo).arg(parts[0]);
-            return false;
+            source = entry.destination > entry.row ? entry.destination - entry.count : entry.destination;
+            destination = entry.destination > entry.row ? entry.row : entry.row + entry.count;
         }
+        if (notify) beginMoveRows(QModelIndex(), source, source + entry.count - 1, QModelIndex(), destination);
+        m_items.move(source, entry.count, destination);
+        if (m_spatialValid)
+            m_spatial.moveRows(source, entry.count, destination);
+        if (notify) endMoveRows();
+        break;
+    }
+    case Kind::Replace:
+        entry.rows.setLayout(m_items.layout());
+        if (notify) beginResetModel();
+        stopIncrementalLoad();
+        std::swap(m_items, entry.rows);
+        invalidateSpatialIndex();
+        if (notify) endResetModel();
+        break;
+    }
+}
 
-        bool styleOk = false;
-        const Qt::PenStyle style = penStyleFromString(parts[1], &styleOk);
-        if (!styleOk)
+// -------------------- async load/save --------------------
+
+/**
+ * @brief Фоновая загрузка.
+ *
+ * @details
+ * Рабочий поток только читает файл и заполняет собственный RectStore;
+ * модель (m_items, сигналы) трогается лишь в потоке модели — через
+ * QMetaObject::invokeMethod(..., Qt::QueuedConnection).
+ */
+bool MyModel::loadFromTsvAsync(const QString& fileName)
+{
+    if (m_ioThread)
+        return false;
+
+    m_ioCancel.store(false);
+    const RectStore::Layout layout = m_items.layout();
+
+    m_ioThread = QThread::create([this, fileName, layout] {
+        RectStore rows(layout);
+        QString error;
+        bool ok = false;
+
+        QFile file(fileName);
+        if (!file.open(QIODevice::ReadOnly))
         {
-            if (error) *error = QString("Строка %1: некорректный стиль пера '%2'").arg(lineNo).arg(parts[1]);
-            return false;
+            error = file.errorString();
+        }
+        else
+        {
+            const qint64 total = file.size();
+            TsvReader reader(file);
+            ok = true;
+            while (ok && !reader.atEnd() && !m_ioCancel.load())
+            {
+                ok = reader.read(rows, kAsyncBatchRows, &error);
+                postIoProgress(reader.bytesConsumed(), total, rows.size(), -1);
+            }
         }
 
-        auto parseInt = [&](const QString& s, const char* fieldName, int& outVal) -> bool
+        QMetaObject::invokeMethod(this, [this, ok, error, rows] {
+            finishAsyncLoad(ok, error, rows);
+        }, Qt::QueuedConnection);
+    });
+
+    m_ioThread->start();
+    return true;
+}
+
+/**
+ * @brief Фоновое сохранение.
+ *
+ * @details
+ * Снимок m_items разделяет данные с моделью; если модель правят во время
+ * сохранения, её массивы отделяются (copy-on-write), а снимок остаётся прежним.
+ */
+bool MyModel::saveToTsvAsync(const QString& fileName)
+{
+    if (m_ioThread)
+        return false;
+
+    m_ioCancel.store(false);
+    const RectStore rows = m_items;
+    const int threads = m_tsvSaveThreads;
+
+    m_ioThread = QThread::create([this, fileName, rows, threads] {
+        QString error;
+        bool ok = false;
+        bool canceled = false;
+
+        QSaveFile file(fileName);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
         {
-            bool ok = false;
-            outVal = s.trimmed().toInt(&ok);
-            if (!ok)
+            error = file.errorString();
+        }
+        else
+        {
+            TsvWriter writer(file);
+            writer.setThreads(threads);
+            const int batchRows = kAsyncBatchRows * (threads > 0 ? threads : QThread::idealThreadCount());
+
+            const int total = rows.size();
+            ok = true;
+            for (int first = 0; ok && first < total && !m_ioCancel.load(); first += batchRows)
             {
-                if (error)
-                {
-                    *error = QString("Строка %1: некорректное поле %2 '%3'")
-                                 .arg(lineNo)
-                                 .arg(fieldName)
-                                 .arg(s);
-                }
-                return false;
+                const int count = qMin(batchRows, total - first);
+                ok = writer.write(rows, first, count, &error);
+                postIoProgress(file.pos(), -1, first + count, total);
             }
-            return true;
-        };
 
-        int penWidth = 0, left = 0, top = 0, width = 0, height = 0;
-        if (!parseInt(parts[2], "PenWidth", penWidth)) return false;
-        if (!parseInt(parts[3], "Left",     left))     return false;
-        if (!parseInt(parts[4], "Top",      top))      return false;
-        if (!parseInt(parts[5], "Width",    width))    return false;
-        if (!parseInt(parts[6], "Height",   height))   return false;
+            canceled = ok && m_ioCancel.load();
+            if (!ok || canceled)
+            {
+                file.cancelWriting();
+                ok = false;
+            }
+            else if (!file.commit())
+            {
+                error = file.errorString();
+                ok = false;
+            }
+        }
+
+        QMetaObject::invokeMethod(this, [this, ok, canceled, error] {
+            finishAsyncSave(ok, canceled, error);
+        }, Qt::QueuedConnection);
+    });
+
+    m_ioThread->start();
+    return true;
+}
+
+void MyModel::cancelAsyncOperation()
+{
+    m_ioCancel.store(true);
+}
+
+bool MyModel::isAsyncOperationRunning() const
+{
+    return m_ioThread != nullptr;
+}
+
+void MyModel::postIoProgress(qint64 bytesDone, qint64 bytesTotal, int rowsDone, int rowsTotal)
+{
+    QMetaObject::invokeMethod(this, [this, bytesDone, bytesTotal, rowsDone, rowsTotal] {
+        emit ioProgress(bytesDone, bytesTotal, rowsDone, rowsTotal);
+    }, Qt::QueuedConnection);
+}
+
+void MyModel::joinIoThread()
+{
+    m_ioThread->wait();
+    delete m_ioThread;
+    m_ioThread = nullptr;
+}
 
-        tmp.push_back(MyRect(color, style, penWidth, left, top, width, height));
+/**
+ * @brief Применение результата фоновой загрузки.
+ *
+ * @details
+ * Отмена проверяется здесь, в потоке модели: запрос, поданный до применения
+ * результата, гарантированно оставляет модель без изменений. Если раскладку
+ * хранения сменили во время загрузки, результат приводится к текущей.
+ */
+void MyModel::finishAsyncLoad(bool ok, const QString& error, const RectStore& rows)
+{
+    joinIoThread();
+
+    const bool canceled = m_ioCancel.load();
+    if (ok && !canceled)
+    {
+        RectStore loaded = rows;
+        loaded.setLayout(m_items.layout());
+
+        replaceItems(std::move(loaded));
     }
 
-    beginResetModel();
-    m_items = std::move(tmp);
-    endResetModel();
+    emit loadFinished(ok && !canceled, canceled, canceled ? QString() : error);
+}
 
-    return true;
+void MyModel::finishAsyncSave(bool ok, bool canceled, const QString& error)
+{
+    joinIoThread();
+    emit saveFinished(ok, canceled, error);
 }
@@ -3,16 +3,35 @@
 #define MYMODEL_H
 
 #include <QAbstractTableModel>
+#include <QHash>
+#include <QColor>
+#include <QIcon>
+#include <QPoint>
+#include <QRect>
 #include <QVector>
 #include <QString>
 #include <QVariant>
+#include <QtGlobal>
 
 #include <array>
+#include <atomic>
 #include <cstddef> // std::size_t
+#include <memory>
 
+#include "colorcache.h"
+#include "edithistory.h"
 #include "myrect.h"
+#include "packedrect.h"
+#include "rectcolumns.h"
+#include "rectsnapshot.h"
+#include "rectspatialindex.h"
+#include "rectstore.h"
+
+class QFile;
+class QThread;
 
 class QIODevice;
+class TsvReader;
 
 /**
  * @brief Табличная модель Qt (QAbstractTableModel) для хранения/редактирования списка MyRect.
@@ -70,6 +89,62 @@ class QIODevice;
  * - PenColor  сохраняется как "#RRGGBB" (QColor::name()).
  * - PenStyle  сохраняется как "Qt::DotLine" и т.п.
  * - Остальные поля — целые числа.
+ *
+ * # Двоичный снимок
+ * saveToBinary/loadFromBinary — те же две группы методов для двоичного формата
+ * @ref RectBinary (заголовок с версией и раскладкой столбцов + записи фиксированной
+ * длины). Загрузка сводится к копированию блоков памяти, без разбора текста.
+ *
+ * # Окно большого TSV
+ * loadFromTsvRange() загружает произвольный диапазон строк файла, переходя
+ * к нему по индексу смещений (@ref TsvIndex), сохранённому рядом с файлом.
+ *
+ * # Постепенная загрузка (fetchMore)
+ * openTsvIncremental() не читает файл целиком: модель становится пустой,
+ * а строки подгружаются порциями по @ref kFetchBatchRows через
+ * canFetchMore()/fetchMore() — QTableView запрашивает их сам по мере прокрутки.
+ * Время до первой отрисовки не зависит от размера файла.
+ *
+ * # Пакетное редактирование
+ * Между beginBatchEdit() и commitBatchEdit() setData() не эмитит dataChanged
+ * на каждую ячейку: при фиксации изменённые ячейки сливаются в несколько
+ * прямоугольников на набор ролей. Отказ любого setData() внутри транзакции
+ * откатывает её целиком.
+ *
+ * # Отмена и повтор
+ * undo()/redo() работают по истории компактных разностей (@ref EditHistory):
+ * правки ячеек, вставки, удаления, переносы и загрузки, с бюджетом памяти
+ * (setUndoMemoryBudget()) и слиянием подряд идущих правок одной ячейки.
+ *
+ * # Внутреннее хранение
+ * Строки хранятся в упакованном виде @ref PackedRect (цвет — QRgb, стиль — байт),
+ * MyRect используется только на границе API. Раскладка в памяти выбирается
+ * через setStorageLayout(): массив строк, по массиву на столбец или блоками (@ref RectStore).
+ *
+ * # Снимки для других потоков
+ * snapshot() возвращает неизменяемую копию строк (@ref RectSnapshot), которую
+ * рабочие потоки читают без блокировок, пока GUI продолжает редактирование.
+ * В раскладке StorageLayout::Chunks правка после снимка копирует только
+ * затронутый блок строк.
+ *
+ * # Пространственные запросы
+ * rowsAt(), rowsIntersecting() и nearestRows() отвечают по сетке
+ * @ref RectSpatialIndex над Left/Top/Width/Height, а не полным проходом.
+ * Индекс строится при первом запросе и дальше поддерживается правками
+ * (setData(), вставки, удаления, переносы, undo/redo) без перестроения;
+ * загрузка сбрасывает его, и он строится заново при следующем запросе.
+ *
+ * # Кэш иконок DecorationRole
+ * Иконка цвета для PenColor не создаётся заново на каждый вызов data():
+ * модель держит ограниченный LRU-кэш QIcon по ключу QRgb (см. @ref ColorCache).
+ * Одинаковые цвета получают одну и ту же implicitly shared иконку,
+ * а счётчики попаданий/промахов доступны через iconCacheHits()/iconCacheMisses().
+ *
+ * # Строки DisplayRole без выделения памяти
+ * - имена Qt::PenStyle берутся из интернированной таблицы (см. RectFormat::penStyleName());
+ * - имена цветов "#rrggbb" кэшируются по QRgb (см. ColorCache::name()).
+ *
+ * Таким образом путь отрисовки таблицы возвращает разделяемые QString.
  */
 class MyModel final : public QAbstractTableModel
 {
@@ -87,6 +162,11 @@ public:
      */
     explicit MyModel(QObject* parent = nullptr);
 
+    /**
+     * @brief Деструктор: отменяет фоновую операцию и дожидается её потока.
+     */
+    ~MyModel() override;
+
     /**
      * @brief Возвращает количество строк.
      *
@@ -148,13 +228,15 @@ public:
      *   - принимает QColor или строку "#RRGGBB";
      *   - при невалидном цвете возвращает false.
      * - PenStyle:
-     *   - принимает int, интерпретируемый как Qt::PenStyle.
+     *   - принимает int, интерпретируемый как Qt::PenStyle;
+     *   - значения вне 0..Qt::MPenStyle отвергаются (false).
      * - остальные поля:
      *   - принимают int (через QVariant::toInt()).
      *
      * При фактическом изменении значения:
      * - эмитится dataChanged(index, index, roles),
-     *   где roles вычисляется через @ref changedRolesForColumn().
+     *   где roles вычисляется через @ref changedRolesForColumn();
+     * - внутри транзакции (beginBatchEdit()) сигнал откладывается до commitBatchEdit().
      *
      * Если новое значение совпадает со старым — возвращаем true без сигналов.
      *
@@ -167,6 +249,125 @@ public:
                  const QVariant& value,
                  int role = Qt::EditRole) override;
 
+    /**
+     * @name Пакетное редактирование (транзакция)
+     * @{
+     */
+
+    /**
+     * @brief Сколько диапазонов на набор ролей commitBatchEdit() уведомляет отдельно.
+     *
+     * @details
+     * При большем числе диапазонов набор ролей уведомляется одним dataChanged
+     * по охватывающему прямоугольнику всех изменённых ячеек.
+     */
+    static constexpr int kMaxEditNotifications = 32;
+
+    /**
+     * @brief Открывает транзакцию: setData() меняет данные сразу, но dataChanged откладывается.
+     *
+     * @details
+     * Для каждой изменённой ячейки запоминается значение до транзакции
+     * (один раз, повторные правки той же ячейки журнал не растят).
+     * data() внутри транзакции видит новые значения.
+     *
+     * Транзакции вкладываются: изменения фиксируются/откатываются, когда
+     * закрывается внешняя. Пока транзакция открыта, операции, сдвигающие номера
+     * существующих строк (insertRows() не в конец, removeRows(), moveRows(),
+     * removeRowsAt(), moveRowsTo()), отказывают: журнал хранит номера строк.
+     * Строки, добавленные в конец (insertRows() в конец, appendRects(),
+     * slotAddData()), при откате удаляются вместе с их записями истории;
+     * fetchMore() внутри транзакции не читает файл (canFetchMore() == false).
+     * Загрузка данных (loadFrom*, openTsvIncremental()) очищает журнал —
+     * откатывать после неё нечего, кроме строк, добавленных уже после загрузки.
+     */
+    void beginBatchEdit();
+
+    /**
+     * @brief Закрывает транзакцию, открытую beginBatchEdit().
+     *
+     * @details
+     * При закрытии внешней транзакции:
+     * - если ни один setData() внутри не вернул false (и не было rollbackBatchEdit()) —
+     *   эмитятся объединённые dataChanged: изменённые ячейки группируются по набору
+     *   ролей (changedRolesForColumn()), соседние по строкам — в один прямоугольник;
+     *   ячейки, вернувшиеся к исходному значению, не уведомляются;
+     * - иначе — все изменения откатываются (см. rollbackBatchEdit()).
+     *
+     * @return false, если транзакция откачена; без открытой транзакции — false.
+     */
+    bool commitBatchEdit();
+
+    /**
+     * @brief Откатывает транзакцию: все ячейки получают значения до beginBatchEdit().
+     *
+     * @details
+     * Строки, добавленные в конец внутри транзакции, удаляются (одна пара
+     * beginRemoveRows/endRemoveRows) и в историю не попадают.
+     * Во вложенной транзакции только помечает внешнюю как неудачную
+     * (откат выполнится при её закрытии). Для восстановленных ячеек эмитятся
+     * те же объединённые dataChanged, что и при фиксации: представление могло
+     * успеть перерисовать промежуточные значения.
+     */
+    void rollbackBatchEdit();
+
+    /// Открыта ли транзакция пакетного редактирования.
+    bool isBatchEditActive() const;
+    /** @} */
+
+    /**
+     * @name Отмена/повтор (undo/redo)
+     * @{
+     */
+
+    /**
+     * @brief Отменяет последний шаг истории.
+     *
+     * @details
+     * Шаг — одна правка setData() (подряд идущие правки одной ячейки сливаются),
+     * зафиксированная транзакция beginBatchEdit()/commitBatchEdit(), вставка
+     * (insertRows(), appendRects()), удаление (removeRows(), removeRowsAt()),
+     * перенос (moveRows(), moveRowsTo()) или загрузка данных. Уведомления —
+     * те же, что при прямой операции (dataChanged/rowsInserted/rowsRemoved/
+     * rowsMoved/modelReset).
+     *
+     * @return false, если отменять нечего или открыта транзакция.
+     */
+    bool undo();
+
+    /**
+     * @brief Повторяет последний отменённый шаг.
+     *
+     * @details
+     * Любая новая правка очищает стек повтора.
+     *
+     * @return false, если повторять нечего или открыта транзакция.
+     */
+    bool redo();
+
+    bool canUndo() const;
+    bool canRedo() const;
+
+    /// Удаляет всю историю правок.
+    void clearHistory();
+
+    /**
+     * @brief Задаёт бюджет памяти истории (байт; по умолчанию EditHistory::kDefaultMemoryBudget).
+     *
+     * @details
+     * История хранит разности, а не снимки: правка ячейки — 16 байт, удалённые
+     * строки — их упакованные данные, загрузка — прежняя таблица. При превышении
+     * бюджета самые старые шаги выбрасываются (загрузка большой таблицы может
+     * сразу оказаться неотменяемой).
+     */
+    void setUndoMemoryBudget(qint64 bytes);
+
+    qint64 undoMemoryBudget() const;
+
+    /// Оценка памяти, занятой историей (байт).
+    qint64 undoMemoryUsage() const;
+    /** @} */
+
     /**
      * @brief Заголовки столбцов/строк.
      *
@@ -216,6 +417,82 @@ public:
                     int count,
                     const QModelIndex& parent = QModelIndex()) override;
 
+    /**
+     * @brief Удаляет строки [@p row, @p row + @p count).
+     *
+     * @details
+     * Одна пара beginRemoveRows/endRemoveRows, хвост хранилища сдвигается один раз.
+     *
+     * @return false, если @p parent валиден, @p count <= 0 или диапазон выходит за таблицу.
+     */
+    bool removeRows(int row,
+                    int count,
+                    const QModelIndex& parent = QModelIndex()) override;
+
+    /**
+     * @brief Сколько диапазонов removeRowsAt() удаляет с отдельными уведомлениями.
+     *
+     * @details
+     * Каждая пара beginRemoveRows/endRemoveRows требует согласованной модели,
+     * т.е. отдельного сдвига хвоста хранилища. При большем числе диапазонов
+     * строки удаляются за один проход под одним beginResetModel/endResetModel.
+     */
+    static constexpr int kMaxRemoveNotifications = 32;
+
+    /**
+     * @brief Удаляет строки с указанными номерами (в любом порядке).
+     *
+     * @details
+     * Номера сортируются и сливаются в непрерывные диапазоны
+     * (RectStore::toRanges()); повторы и номера вне таблицы игнорируются.
+     * - до kMaxRemoveNotifications диапазонов: по одной паре
+     *   beginRemoveRows/endRemoveRows на диапазон (с конца таблицы к началу,
+     *   чтобы номера ещё не обработанных диапазонов не сдвигались);
+     * - больше: один проход уплотнения хранилища (RectStore::removeRanges(), O(n))
+     *   и один modelReset — вместо сотен тысяч сдвигов хвоста и уведомлений.
+     *
+     * @param rows Номера удаляемых строк.
+     * @return Число фактически удалённых строк.
+     */
+    int removeRowsAt(const QVector<int>& rows);
+
+    /**
+     * @brief Переносит строки [@p sourceRow, @p sourceRow + @p count) перед строкой @p destinationChild.
+     *
+     * @details
+     * Одна пара beginMoveRows/endMoveRows; хранилище меняется поворотом на месте
+     * (RectStore::move()): сдвигаются только строки между блоком и местом
+     * назначения, без копии таблицы и без modelReset — выделение и позиция
+     * прокрутки представления сохраняются.
+     *
+     * @param destinationChild Номер строки назначения в нумерации до переноса (как у beginMoveRows()).
+     * @return false, если родитель валиден, диапазон выходит за таблицу
+     *         или @p destinationChild лежит внутри [sourceRow, sourceRow + count].
+     */
+    bool moveRows(const QModelIndex& sourceParent,
+                  int sourceRow,
+                  int count,
+                  const QModelIndex& destinationParent,
+                  int destinationChild) override;
+
+    /**
+     * @brief Собирает строки с указанными номерами в один блок перед строкой @p destinationRow.
+     *
+     * @details
+     * Номера сливаются в диапазоны (RectStore::toRanges()); взаимный порядок
+     * переносимых строк сохраняется. Каждый диапазон переносится одним moveRows():
+     * диапазоны выше места назначения — снизу вверх, ниже — сверху вниз, так что
+     * номера ещё не обработанных диапазонов не сдвигаются. Диапазон, содержащий
+     * @p destinationRow, делится на две части. Уже стоящие на месте диапазоны
+     * не трогаются.
+     *
+     * @param rows Номера строк в любом порядке (повторы и номера вне таблицы игнорируются).
+     * @param destinationRow Номер строки назначения в нумерации до переноса,
+     *        в [0, rowCount()]; иначе ничего не переносится.
+     * @return Число перенесённых строк (включая уже стоявшие на месте).
+     */
+    int moveRowsTo(const QVector<int>& rows, int destinationRow);
+
     /**
      * @brief Возвращает флаги для элемента.
      *
@@ -223,13 +500,107 @@ public:
      * Все валидные элементы:
      * - доступны,
      * - выделяемы,
-     * - редактируемы (Qt::ItemIsEditable).
+     * - редактируемы (Qt::ItemIsEditable),
+     * - перетаскиваемы и принимают бросок (перенос строк, см. dropMimeData()).
      *
      * @param index Индекс ячейки.
      * @return Qt::ItemFlags.
      */
     Qt::ItemFlags flags(const QModelIndex& index) const override;
 
+    /**
+     * @name Перетаскивание строк (drag-and-drop внутри таблицы)
+     * @{
+     */
+
+    /// MIME-тип с номерами перетаскиваемых строк.
+    static constexpr char kRowsMimeType[] = "application/x-mymodel-rows";
+
+    /// Только перенос (Qt::MoveAction).
+    Qt::DropActions supportedDropActions() const override;
+
+    QStringList mimeTypes() const override;
+
+    /**
+     * @brief Упаковывает номера строк перетаскиваемых ячеек (каждая строка — один раз).
+     *
+     * @details
+     * Вместе с номерами сохраняется адрес модели: бросок из другой модели
+     * (или другого процесса) отклоняется.
+     */
+    QMimeData* mimeData(const QModelIndexList& indexes) const override;
+
+    bool canDropMimeData(const QMimeData* data,
+                         Qt::DropAction action,
+                         int row,
+                         int column,
+                         const QModelIndex& parent) const override;
+
+    /**
+     * @brief Переносит перетащенные строки через moveRowsTo().
+     *
+     * @details
+     * Место назначения — @p row, а при броске на ячейку — строка этой ячейки
+     * (блок встаёт перед ней). Перенос выполняется здесь же, поэтому метод
+     * возвращает false: иначе QAbstractItemView после Qt::MoveAction удалил бы
+     * исходные строки (clearOrRemove()), уже стоящие на новом месте.
+     */
+    bool dropMimeData(const QMimeData* data,
+                      Qt::DropAction action,
+                      int row,
+                      int column,
+                      const QModelIndex& parent) override;
+    /** @} */
+
+    /**
+     * @brief Добавляет в конец модели пачку прямоугольников одной вставкой.
+     *
+     * @details
+     * В отличие от цикла по slotAddData() (insertRows + dataChanged на каждую строку):
+     * - выполняется ровно одна пара beginInsertRows/endInsertRows на всю пачку;
+     * - dataChanged не эмитится: вставленные строки уже содержат данные,
+     *   и View получает их при обработке rowsInserted.
+     *
+     * Пустая пачка не меняет модель и не эмитит сигналов. Стиль пера вне
+     * 0..Qt::MPenStyle и невалидный цвет заменяются дефолтами (PackedRect::fromRect()).
+     *
+     * @param rects Указатель на первый элемент непрерывного диапазона (аналог span).
+     * @param count Количество элементов.
+     */
+    void appendRects(const MyRect* rects, int count);
+
+    /**
+     * @brief Перегрузка appendRects() для QVector.
+     */
+    void appendRects(const QVector<MyRect>& rects);
+
+    /**
+     * @brief Возвращает строку модели как MyRect.
+     *
+     * @details
+     * Распаковывает внутреннее представление (PackedRect).
+     * Для строки вне диапазона возвращается MyRect{}.
+     *
+     * @param row Номер строки.
+     * @return Прямоугольник строки @p row.
+     */
+    MyRect rectAt(int row) const;
+
+    /**
+     * @brief Неизменяемый снимок всех строк для чтения в других потоках.
+     *
+     * @details
+     * Вызывается в потоке модели; сам снимок можно передавать в любой поток
+     * и читать без блокировок. Данные не копируются: снимок разделяет их
+     * с моделью, а последующие setData()/insertRows()/... отделяют копию
+     * модели (в раскладке StorageLayout::Chunks — только затронутый блок,
+     * иначе весь массив при первой записи после снимка).
+     *
+     * Строки постепенной загрузки, ещё не подгруженные fetchMore(), в снимок
+     * не попадают.
+     */
+    RectSnapshot snapshot() const;
+
     /**
      * @brief Заполняет модель тестовыми данными.
      *
@@ -292,10 +663,16 @@ public:
      * - иметь режим ReadOnly.
      *
      * Алгоритм:
-     * 1) читаем строки,
-     * 2) парсим поля,
-     * 3) при первой же ошибке возвращаем false и НЕ меняем текущую модель,
-     * 4) при полном успехе делаем beginResetModel/endResetModel и заменяем m_items.
+     * 1) TsvReader читает устройство блоками и разбирает строки прямо из байтов
+     *    (без QString на строку/поле) во временное хранилище,
+     * 2) при первой же ошибке возвращаем false и НЕ меняем текущую модель,
+     * 3) при полном успехе делаем beginResetModel/endResetModel и заменяем m_items.
+     *
+     * В режиме TsvLoadMode::MemoryMap (по умолчанию) данные разбираются на месте:
+     * локальный файл (QFile, не последовательный) отображается в память,
+     * у QBuffer берутся его байты. Такой фрагмент разбирается параллельно
+     * (см. setTsvParseThreads()). Последовательные устройства и файлы, которые
+     * не удалось отобразить, читаются потоково.
      *
      * @param in Устройство ввода (QFile/QBuffer/и т.п.).
      * @param error Опционально: строка ошибки.
@@ -303,6 +680,391 @@ public:
      */
     bool loadFromTsv(QIODevice& in, QString* error = nullptr);
 
+    /**
+     * @brief Загружает в модель окно строк [@p firstRow, @p firstRow + @p count) TSV-файла.
+     *
+     * @details
+     * Через индекс смещений строк (TsvIndex, файл-спутник "<файл>.idx"):
+     * при актуальном спутнике разбираются только строки окна, поэтому окно
+     * большого файла открывается за миллисекунды. Отсутствующий или устаревший
+     * (другой размер/время изменения TSV) спутник строится заново одним
+     * проходом без разбора полей.
+     *
+     * Окно, выходящее за конец файла, усекается. Как и loadFromTsv():
+     * при ошибке модель НЕ меняется, при успехе — один beginResetModel/endResetModel.
+     *
+     * @param fileName Путь к TSV-файлу.
+     * @param firstRow Номер первой строки данных файла (с 0).
+     * @param count Число строк окна.
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе, false при ошибке открытия/формата или @p firstRow за концом файла.
+     */
+    bool loadFromTsvRange(const QString& fileName, qint64 firstRow, int count, QString* error = nullptr);
+
+    /**
+     * @brief Сохраняет модель в двоичный снимок по имени файла.
+     *
+     * @details
+     * Открывает QFile на запись и делегирует в saveToBinary(QIODevice&).
+     *
+     * @param fileName Путь к файлу.
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе, false при ошибке открытия/записи.
+     */
+    bool saveToBinary(const QString& fileName, QString* error = nullptr) const;
+
+    /**
+     * @brief Загружает модель из двоичного снимка по имени файла.
+     *
+     * @details
+     * Открывает QFile на чтение и делегирует в loadFromBinary(QIODevice&).
+     *
+     * @param fileName Путь к файлу.
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе, false при ошибке открытия/формата.
+     */
+    bool loadFromBinary(const QString& fileName, QString* error = nullptr);
+
+    /**
+     * @brief Сохраняет модель в двоичный снимок (RectBinary) в устройство вывода.
+     *
+     * @details
+     * Устройство должно быть открыто в режиме WriteOnly (без QIODevice::Text).
+     *
+     * @param out Устройство вывода (QFile/QBuffer/и т.п.).
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе, false при ошибке состояния устройства/записи.
+     */
+    bool saveToBinary(QIODevice& out, QString* error = nullptr) const;
+
+    /**
+     * @brief Загружает модель из двоичного снимка (RectBinary).
+     *
+     * @details
+     * Как и loadFromTsv(): данные читаются во временное хранилище, при ошибке
+     * (сигнатура, версия, раскладка столбцов, обрезанный файл, недопустимый
+     * стиль пера) модель НЕ меняется; при успехе — один beginResetModel/endResetModel.
+     *
+     * @param in Устройство ввода, открытое в режиме ReadOnly.
+     * @param error Опционально: строка ошибки.
+     * @return true при успехе, false при ошибке формата/чтения.
+     */
+    bool loadFromBinary(QIODevice& in, QString* error = nullptr);
+
+    /**
+     * @brief Число строк, добавляемых одним вызовом fetchMore().
+     */
+    static constexpr int kFetchBatchRows = 4096;
+
+    /**
+     * @brief Открывает TSV-файл для постепенной загрузки по мере прокрутки.
+     *
+     * @details
+     * Файл только открывается: модель сбрасывается в пустое состояние
+     * (beginResetModel/endResetModel), а строки читает TsvReader порциями
+     * по kFetchBatchRows в fetchMore() — каждая порция одной парой
+     * beginInsertRows/endInsertRows в конец модели.
+     *
+     * Когда файл дочитан или встретилась ошибка формата, файл закрывается
+     * и эмитится loadFinished(). В отличие от loadFromTsv(), при ошибке
+     * уже подгруженные строки (и строки порции до ошибочной) остаются в модели.
+     *
+     * Успешные loadFromTsv()/loadFromBinary()/фоновая загрузка и повторный
+     * вызов прерывают постепенную загрузку.
+     *
+     * @param fileName Путь к файлу.
+     * @param error Опционально: строка ошибки.
+     * @return false, если файл не удалось открыть (модель не меняется).
+     */
+    bool openTsvIncremental(const QString& fileName, QString* error = nullptr);
+
+    /**
+     * @brief Идёт ли постепенная загрузка (остались непрочитанные строки файла).
+     */
+    bool isIncrementalLoadActive() const;
+
+    /**
+     * @brief Есть ли ещё строки для fetchMore() (только для корня таблицы).
+     */
+    bool canFetchMore(const QModelIndex& parent) const override;
+
+    /**
+     * @brief Подгружает следующую порцию (до kFetchBatchRows строк) из файла,
+     * открытого openTsvIncremental().
+     */
+    void fetchMore(const QModelIndex& parent) override;
+
+    /**
+     * @brief Способ чтения TSV в loadFromTsv().
+     */
+    enum class TsvLoadMode
+    {
+        Stream,    ///< Всегда потоковое чтение блоками (QIODevice::read()).
+        MemoryMap  ///< Разбирать на месте: файл — через map(), QBuffer — его данные (иначе — Stream).
+    };
+
+    /**
+     * @brief Задаёт способ чтения TSV (по умолчанию TsvLoadMode::MemoryMap).
+     */
+    void setTsvLoadMode(TsvLoadMode mode);
+
+    /**
+     * @brief Текущий способ чтения TSV.
+     */
+    TsvLoadMode tsvLoadMode() const;
+
+    /**
+     * @brief Число потоков разбора TSV в режиме TsvLoadMode::MemoryMap.
+     *
+     * @details
+     * Данные режутся по границам строк на блоки, которые разбираются на пуле
+     * потоков и склеиваются по порядку; номера строк в ошибках сохраняются.
+     *
+     * @param threads 0 (по умолчанию) — QThread::idealThreadCount(); 1 — последовательно.
+     */
+    void setTsvParseThreads(int threads);
+
+    /**
+     * @brief Заданное число потоков разбора TSV (0 — автоматически).
+     */
+    int tsvParseThreads() const;
+
+    /**
+     * @brief Число потоков форматирования при сохранении TSV.
+     *
+     * @details
+     * Диапазоны строк форматируются параллельно в собственные буферы и
+     * пишутся в устройство по порядку (TsvWriter::setThreads()); файл
+     * побайтно совпадает с последовательной записью.
+     *
+     * @param threads 0 (по умолчанию) — QThread::idealThreadCount(); 1 — последовательно.
+     */
+    void setTsvSaveThreads(int threads);
+
+    /**
+     * @brief Заданное число потоков сохранения TSV (0 — автоматически).
+     */
+    int tsvSaveThreads() const;
+
+    /**
+     * @brief Число строк в одной порции фоновой загрузки/сохранения.
+     *
+     * @details
+     * Между порциями фоновая операция сообщает о прогрессе (ioProgress())
+     * и проверяет запрос отмены.
+     */
+    static constexpr int kAsyncBatchRows = 64 * 1024;
+
+    /**
+     * @brief Запускает загрузку TSV-файла в фоновом потоке.
+     *
+     * @details
+     * Файл читается и разбирается TsvReader в рабочем потоке во временное
+     * хранилище, прогресс (байты и строки) приходит сигналом ioProgress().
+     * По окончании в GUI-потоке:
+     * - при успехе данные подменяются одним beginResetModel/endResetModel;
+     * - при ошибке или отмене модель не меняется.
+     * В любом случае эмитится loadFinished().
+     *
+     * Все сигналы эмитятся в потоке модели (доставка из рабочего потока — очередью).
+     *
+     * @param fileName Путь к файлу.
+     * @return false, если уже выполняется другая фоновая операция.
+     */
+    bool loadFromTsvAsync(const QString& fileName);
+
+    /**
+     * @brief Запускает сохранение в TSV-файл в фоновом потоке.
+     *
+     * @details
+     * Сохраняется снимок данных на момент вызова (копия RectStore разделяет
+     * массивы с моделью — implicit sharing, без копирования). Запись ведётся
+     * через QSaveFile: при ошибке или отмене прежнее содержимое файла сохраняется.
+     * При параллельной записи (setTsvSaveThreads()) порция — kAsyncBatchRows
+     * строк на поток. По окончании эмитится saveFinished().
+     *
+     * @param fileName Путь к файлу.
+     * @return false, если уже выполняется другая фоновая операция.
+     */
+    bool saveToTsvAsync(const QString& fileName);
+
+    /**
+     * @brief Запрашивает отмену текущей фоновой операции.
+     *
+     * @details
+     * Рабочий поток останавливается на границе порции. Загрузка, отменённая
+     * до применения результата, модель не меняет. Сохранение, отменённое
+     * до фиксации QSaveFile, файл не меняет.
+     */
+    void cancelAsyncOperation();
+
+    /**
+     * @brief Выполняется ли фоновая загрузка/сохранение.
+     */
+    bool isAsyncOperationRunning() const;
+
+    /**
+     * @brief Раскладка хранения строк в памяти (см. RectStore::Layout).
+     */
+    using StorageLayout = RectStore::Layout;
+
+    /**
+     * @brief Переключает раскладку внутреннего хранилища.
+     *
+     * @details
+     * - StorageLayout::Rows — массив упакованных строк (по умолчанию);
+     * - StorageLayout::Columns — столбец = отдельный непрерывный массив,
+     *   выгодно для поколоночных проходов (rowsInRange(), rowOrderBy(), totalArea());
+     * - StorageLayout::Chunks — строки блоками: insertRows()/removeRows() в середине
+     *   большой таблицы сдвигают один блок, а не весь хвост; snapshot() и фоновое
+     *   сохранение не заставляют следующую правку копировать всю таблицу.
+     *
+     * Данные и контракт data()/setData() не меняются, поэтому сигналы не эмитятся.
+     *
+     * @param layout Новая раскладка.
+     */
+    void setStorageLayout(StorageLayout layout);
+
+    /**
+     * @brief Текущая раскладка внутреннего хранилища.
+     */
+    StorageLayout storageLayout() const;
+
+    /**
+     * @brief Сумма площадей (Width * Height) всех прямоугольников.
+     */
+    qint64 totalArea() const;
+
+    /**
+     * @brief Строки, у которых значение столбца лежит в [@p min, @p max].
+     *
+     * @details
+     * Значения сравниваются как EditRole-числа; для PenColor — как QRgb (#AARRGGBB).
+     *
+     * @param column Номер столбца таблицы.
+     * @return Номера строк по возрастанию; пусто для невалидного столбца.
+     */
+    QVector<int> rowsInRange(int column, qint64 min, qint64 max) const;
+
+    /**
+     * @brief Порядок строк по возрастанию значения столбца (устойчивая сортировка).
+     *
+     * @param column Номер столбца таблицы.
+     * @return result[i] — номер строки, стоящей i-й; пусто для невалидного столбца.
+     */
+    QVector<int> rowOrderBy(int column) const;
+
+    /**
+     * @name Пространственные запросы по геометрии (Left/Top/Width/Height)
+     *
+     * @details
+     * Прямоугольник строки — [Left, Left + Width) × [Top, Top + Height), как QRect;
+     * отрицательные Width/Height отсчитываются в другую сторону. Строки нулевой
+     * ширины или высоты не содержат точек и ни с чем не пересекаются.
+     *
+     * Первый запрос строит индекс (@ref RectSpatialIndex, O(n)); дальше
+     * setData(), insertRows(), removeRows(), moveRows(), appendRects(),
+     * fetchMore() и undo()/redo() обновляют его по месту за O(log n) на
+     * строку (в любом месте таблицы), а загрузки сбрасывают — до следующего
+     * запроса.
+     * @{
+     */
+
+    /**
+     * @brief Строки, прямоугольник которых содержит точку @p point.
+     *
+     * @return Номера строк по возрастанию.
+     */
+    QVector<int> rowsAt(const QPoint& point) const;
+
+    /**
+     * @brief Строки, прямоугольник которых пересекается с @p area.
+     *
+     * @details
+     * @p area берётся как x/y/width/height (по тем же правилам, что и строки).
+     *
+     * @return Номера строк по возрастанию.
+     */
+    QVector<int> rowsIntersecting(const QRect& area) const;
+
+    /**
+     * @brief @p k строк, ближайших к точке @p point (расстояние до прямоугольника, 0 внутри).
+     *
+     * @return Номера строк по возрастанию расстояния, при равенстве — по номеру.
+     */
+    QVector<int> nearestRows(const QPoint& point, int k) const;
+    /** @} */
+
+    /**
+     * @brief Ёмкость кэша иконок по умолчанию (число различных цветов).
+     */
+    static constexpr int kDefaultIconCacheCapacity = ColorCache::kDefaultIconCapacity;
+
+    /**
+     * @brief Задаёт ёмкость LRU-кэша иконок DecorationRole.
+     *
+     * @details
+     * При уменьшении ёмкости давно не использованные иконки вытесняются сразу.
+     * Значение 0 отключает кэширование (каждый запрос — промах).
+     *
+     * @param capacity Максимальное число различных цветов в кэше (отрицательное трактуется как 0).
+     */
+    void setIconCacheCapacity(int capacity);
+
+    /**
+     * @brief Текущая ёмкость кэша иконок.
+     */
+    int iconCacheCapacity() const;
+
+    /**
+     * @brief Число запросов DecorationRole, обслуженных из кэша.
+     */
+    quint64 iconCacheHits() const;
+
+    /**
+     * @brief Число запросов DecorationRole, для которых иконку пришлось создать.
+     */
+    quint64 iconCacheMisses() const;
+
+    /**
+     * @brief Обнуляет счётчики попаданий/промахов (содержимое кэша сохраняется).
+     */
+    void resetIconCacheStats();
+
+signals:
+    /**
+     * @brief Прогресс фоновой операции.
+     *
+     * @param bytesDone Обработано байт файла.
+     * @param bytesTotal Размер файла (загрузка) или -1, если неизвестен (сохранение).
+     * @param rowsDone Обработано строк.
+     * @param rowsTotal Всего строк (сохранение) или -1, если неизвестно (загрузка).
+     */
+    void ioProgress(qint64 bytesDone, qint64 bytesTotal, int rowsDone, int rowsTotal);
+
+    /**
+     * @brief Фоновая загрузка завершена.
+     *
+     * @param ok Данные загружены и применены к модели.
+     * @param canceled Операция отменена (модель не менялась).
+     * @param error Текст ошибки (пусто при успехе и отмене).
+     */
+    void loadFinished(bool ok, bool canceled, const QString& error);
+
+    /**
+     * @brief Фоновое сохранение завершено.
+     *
+     * @param ok Файл записан.
+     * @param canceled Операция отменена (файл не менялся).
+     * @param error Текст ошибки (пусто при успехе и отмене).
+     */
+    void saveFinished(bool ok, bool canceled, const QString& error);
+
+    /**
+     * @brief Изменилась доступность отмены/повтора (для пунктов меню).
+     */
+    void undoStateChanged(bool canUndo, bool canRedo);
+
 public slots:
     /**
      * @brief Добавляет одну строку в конец модели.
@@ -321,92 +1083,205 @@ public slots:
 
 private:
     /**
-     * @brief Семантические столбцы модели.
-     *
-     * @note Column::Count — служебный элемент “число столбцов”.
+     * @brief Семантические столбцы модели (см. RectColumns::Column).
      */
-    enum class Column : int
-    {
-        PenColor = 0,
-        PenStyle,
-        PenWidth,
-        Left,
-        Top,
-        Width,
-        Height,
-        Count
-    };
+    using Column = RectColumns::Column;
 
     /**
-     * @brief Метаданные одного столбца: семантика и текст заголовка.
+     * @brief Метаданные одного столбца (см. RectColumns::ColumnInfo).
      */
-    struct ColumnInfo
-    {
-        Column      col;     ///< Семантика столбца.
-        const char* header;  ///< Текст заголовка (ASCII/Latin1).
-    };
+    using ColumnInfo = RectColumns::ColumnInfo;
 
     /**
      * @brief Количество столбцов как std::size_t (нужно для std::array).
      */
-    static constexpr std::size_t kColCount =
-        static_cast<std::size_t>(Column::Count);
+    static constexpr std::size_t kColCount = RectColumns::kColCount;
 
     /**
      * @brief Количество столбцов в терминах Qt (int).
      */
-    static constexpr int kColCountInt =
-        static_cast<int>(kColCount);
+    static constexpr int kColCountInt = RectColumns::kColCountInt;
 
     /**
      * @brief Единый источник правды о колонках (порядок/заголовки/TSV).
      *
      * @details
      * Индекс в массиве = индекс столбца в QTableView.
+     * Определение — в rectcolumns.h (общее для модели, хранилища и сериализации).
      */
-    static constexpr std::array<ColumnInfo, kColCount> kColumns = {{
-        {Column::PenColor, "PenColor"},
-        {Column::PenStyle, "PenStyle"},
-        {Column::PenWidth, "PenWidth"},
-        {Column::Left,     "Left"},
-        {Column::Top,      "Top"},
-        {Column::Width,    "Width"},
-        {Column::Height,   "Height"},
-    }};
+    static constexpr std::array<ColumnInfo, kColCount> kColumns = RectColumns::kColumns;
 
 private:
     /**
-     * @brief Преобразует Qt::PenStyle в строку (для DisplayRole и TSV).
+     * @brief Возвращает набор ролей, которые надо указать в dataChanged для столбца.
+     *
+     * @details
+     * В Qt5/Qt6 третьим параметром dataChanged является QVector<int>.
      */
-    static QString penStyleToString(Qt::PenStyle style);
+    static const QVector<int>& changedRolesForColumn(Column c);
 
     /**
-     * @brief Разбирает Qt::PenStyle из строки.
+     * @brief Отказ setData(): внутри транзакции помечает её как неудачную.
      *
-     * @details
-     * Поддерживаем форматы:
-     * - "3"
-     * - "Qt::PenStyle(3)"
-     * - "Qt::DotLine"
+     * @return Всегда false (для return rejectEdit();).
      */
-    static Qt::PenStyle penStyleFromString(const QString& s, bool* ok = nullptr);
+    bool rejectEdit();
 
     /**
-     * @brief Возвращает набор ролей, которые надо указать в dataChanged для столбца.
+     * @brief Закрывает внешнюю транзакцию: фиксирует или откатывает журнал (см. commitBatchEdit()).
+     */
+    void finishBatchEdit(bool rollback);
+
+    /**
+     * @brief Запоминает размер таблицы и истории, к которым вернётся откат транзакции.
+     */
+    void markBatchStart();
+
+    /**
+     * @brief Подменяет данные модели одним reset (загрузки).
      *
      * @details
-     * В Qt5/Qt6 третьим параметром dataChanged является QVector<int>.
+     * Заодно закрывает файл постепенной загрузки, очищает журнал транзакции
+     * и кладёт прежнюю таблицу в историю (шаг отмены загрузки).
+     */
+    void replaceItems(RectStore&& items);
+
+    /**
+     * @brief dataChanged для ячеек (строка, столбец): по прямоугольникам соседних строк и наборам ролей.
+     */
+    void emitCellsChanged(const QVector<QPair<int, int>>& cells);
+
+    /// Записывает шаг истории и сообщает об изменении доступности undo/redo.
+    void recordHistory(EditHistory::Entry entry);
+
+    /// Эмитит undoStateChanged(), если доступность отмены/повтора изменилась.
+    void notifyUndoState();
+
+    /**
+     * @brief Применяет шаг истории: отмена — записи с конца, повтор — с начала.
+     */
+    void applyHistoryStep(EditHistory::Step& step, bool undo);
+
+    /**
+     * @brief Применяет одну запись истории (с уведомлениями, если @p notify).
+     */
+    void applyHistoryEntry(EditHistory::Entry& entry, bool undo, bool notify);
+
+    /**
+     * @brief Пространственный индекс строк; строится при первом обращении.
+     */
+    const RectSpatialIndex& spatialIndex() const;
+
+    /**
+     * @brief Сбрасывает пространственный индекс (данные заменены целиком).
+     */
+    void invalidateSpatialIndex();
+
+    /**
+     * @brief Переносит строку в индексе после записи поля @p column (было @p before, см. cellBits()).
+     */
+    void updateSpatialCell(int row, Column column, quint32 before);
+
+    /**
+     * @brief Передаёт прогресс из рабочего потока в поток модели (ioProgress()).
+     */
+    void postIoProgress(qint64 bytesDone, qint64 bytesTotal, int rowsDone, int rowsTotal);
+
+    /**
+     * @brief Дожидается завершения рабочего потока и освобождает его.
+     */
+    void joinIoThread();
+
+    /**
+     * @brief Завершение фоновой загрузки (в потоке модели): подмена данных одним reset.
+     */
+    void finishAsyncLoad(bool ok, const QString& error, const RectStore& rows);
+
+    /**
+     * @brief Завершение фонового сохранения (в потоке модели).
+     */
+    void finishAsyncSave(bool ok, bool canceled, const QString& error);
+
+    /**
+     * @brief Закрывает файл постепенной загрузки (если открыт), сигналов не эмитит.
      */
-    static QVector<int> changedRolesForColumn(Column c);
+    void stopIncrementalLoad();
 
 private:
     /**
      * @brief Контейнер данных модели.
      *
      * @details
-     * Каждая строка таблицы соответствует одному элементу MyRect.
+     * Каждая строка таблицы соответствует одному элементу PackedRect
+     * (упакованный MyRect: 28 байт вместо 40). Наружу модель отдаёт MyRect
+     * (см. rectAt(), slotAddData()), упаковка и раскладка (строки/столбцы) —
+     * деталь реализации RectStore.
+     */
+    RectStore m_items;
+
+    /// Рабочий поток фоновой загрузки/сохранения (nullptr — операций нет).
+    QThread* m_ioThread = nullptr;
+
+    /// Запрос отмены фоновой операции (читается рабочим потоком).
+    std::atomic<bool> m_ioCancel { false };
+
+    /// Способ чтения TSV (см. setTsvLoadMode()).
+    TsvLoadMode m_tsvLoadMode = TsvLoadMode::MemoryMap;
+
+    /// Число потоков разбора TSV (см. setTsvParseThreads()).
+    int m_tsvParseThreads = 0;
+
+    /// Число потоков сохранения TSV (см. setTsvSaveThreads()).
+    int m_tsvSaveThreads = 0;
+
+    /// Файл постепенной загрузки (см. openTsvIncremental()).
+    std::unique_ptr<QFile> m_fetchFile;
+
+    /// Читатель m_fetchFile; nullptr — постепенной загрузки нет.
+    std::unique_ptr<TsvReader> m_fetchReader;
+
+    /// Глубина вложенности транзакций (0 — транзакции нет).
+    int m_batchDepth = 0;
+
+    /// Внутри транзакции был отказ setData() или rollbackBatchEdit().
+    bool m_batchFailed = false;
+
+    /**
+     * @brief Журнал транзакции: ключ — ячейка (строка << 8 | столбец),
+     *        значение — битовое представление поля до транзакции.
+     */
+    QHash<quint64, quint32> m_batchOld;
+
+    /// Число строк в начале транзакции (или после загрузки внутри неё): откат удаляет строки дальше.
+    int m_batchRows = 0;
+
+    /// Число записей открытого шага истории там же: откат отбрасывает записи дальше.
+    int m_batchHistoryMark = 0;
+
+    /// История правок (undo/redo).
+    EditHistory m_history;
+
+    /// Последняя сообщённая доступность отмены/повтора (см. undoStateChanged()).
+    bool m_canUndo = false;
+    bool m_canRedo = false;
+
+    /**
+     * @brief Пространственный индекс по геометрии строк (см. rowsAt()).
+     *
+     * @details
+     * mutable: строится лениво из const-запросов. Пока m_spatialValid == false,
+     * правки индекс не трогают.
+     */
+    mutable RectSpatialIndex m_spatial;
+    mutable bool m_spatialValid = false;
+
+    /**
+     * @brief Кэши иконок (DecorationRole) и имён цветов (DisplayRole) столбца PenColor.
+     *
+     * @details
+     * mutable, т.к. заполняется из const-метода data().
      */
-    QVector<MyRect> m_items;
+    mutable ColorCache m_colorCache;
 };
 
 #endif // MYMODEL_H
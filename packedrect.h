@@ -0,0 +1,117 @@
+#ifndef PACKEDRECT_H
+#define PACKEDRECT_H
+
+#include <QColor>
+#include <QRgb>
+#include <Qt>
+#include <QtGlobal>
+
+#include "myrect.h"
+
+/**
+ * @brief Компактное (упакованное) представление MyRect для внутреннего хранения в модели.
+ *
+ * @details
+ * MyRect удобен на границе API, но дорог для хранения миллионов строк:
+ * QColor занимает 16 байт (spec + 5 x ushort), Qt::PenStyle — 4 байта.
+ *
+ * PackedRect хранит:
+ * - цвет как 32-битный ARGB (QRgb, 8 бит на канал);
+ * - стиль пера как один байт;
+ * - толщину и геометрию как int.
+ *
+ * Итог: 28 байт на строку вместо 40 у MyRect и никаких указателей —
+ * QVector<PackedRect> хранит данные плотно и перемещает их memmove
+ * (Q_MOVABLE_TYPE; конструктор по умолчанию сохраняет дефолты MyRect).
+ *
+ * @note Упаковка теряет точность/спецификацию QColor: цвет всегда восстанавливается
+ *       как QColor::Rgb с 8 битами на канал (HSV/CMYK и 16-битные каналы округляются).
+ *       Стиль пера ограничен диапазоном 0..Qt::MPenStyle (см. isValidPenStyle()).
+ */
+struct PackedRect
+{
+    /// Цвет пера (#AARRGGBB).
+    QRgb penColor { qRgb(0, 0, 0) };
+
+    /// Толщина пера (в пикселях).
+    qint32 penWidth { 1 };
+
+    /// X координата левого верхнего угла.
+    qint32 left { 0 };
+
+    /// Y координата левого верхнего угла.
+    qint32 top { 0 };
+
+    /// Ширина прямоугольника.
+    qint32 width { 10 };
+
+    /// Высота прямоугольника.
+    qint32 height { 10 };
+
+    /// Стиль линии пера (значение Qt::PenStyle).
+    quint8 penStyle { static_cast<quint8>(Qt::SolidLine) };
+
+    /**
+     * @brief Проверяет, что значение стиля представимо в упакованном виде.
+     *
+     * @param style Числовое значение Qt::PenStyle.
+     * @return true для 0..Qt::MPenStyle.
+     */
+    static constexpr bool isValidPenStyle(int style)
+    {
+        return style >= 0 && style <= static_cast<int>(Qt::MPenStyle);
+    }
+
+    /**
+     * @brief Упаковывает MyRect.
+     *
+     * @details
+     * Непредставимые значения заменяются дефолтами MyRect, а не усекаются:
+     * стиль вне 0..Qt::MPenStyle (его отвергает и setData()) — Qt::SolidLine,
+     * невалидный QColor — чёрный цвет по умолчанию.
+     */
+    static PackedRect fromRect(const MyRect& r)
+    {
+        PackedRect p;
+        if (r.penColor.isValid())
+            p.penColor = r.penColor.rgba();
+        if (isValidPenStyle(static_cast<int>(r.penStyle)))
+            p.penStyle = static_cast<quint8>(r.penStyle);
+        p.penWidth = r.penWidth;
+        p.left     = r.left;
+        p.top      = r.top;
+        p.width    = r.width;
+        p.height   = r.height;
+        return p;
+    }
+
+    /**
+     * @brief Распаковывает в MyRect (граница API модели).
+     */
+    MyRect toRect() const
+    {
+        return MyRect(color(), style(), penWidth, left, top, width, height);
+    }
+
+    /**
+     * @brief Цвет пера как QColor.
+     */
+    QColor color() const
+    {
+        return QColor::fromRgba(penColor);
+    }
+
+    /**
+     * @brief Стиль пера как Qt::PenStyle.
+     */
+    Qt::PenStyle style() const
+    {
+        return static_cast<Qt::PenStyle>(penStyle);
+    }
+};
+
+static_assert(sizeof(PackedRect) == 28, "PackedRect layout must stay compact");
+
+Q_DECLARE_TYPEINFO(PackedRect, Q_MOVABLE_TYPE);
+
+#endif // PACKEDRECT_H
@@ -0,0 +1,293 @@
+#include "rectbinary.h"
+
+#include <QIODevice>
+#include <QVector>
+#include <QtEndian>
+
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+using RectColumns::Column;
+using RectColumns::kColCountInt;
+using RectColumns::kColumns;
+using RectBinary::ColumnType;
+using RectBinary::kHeaderSize;
+using RectBinary::kRecordSize;
+
+/// Сигнатура файла.
+constexpr char kMagic[] = "RECTSNAP";
+constexpr int kMagicSize = 8;
+
+/// Часть заголовка до описателей столбцов.
+constexpr int kFixedHeaderSize = 32;
+
+/// Размер описателя столбца и поля имени в нём.
+constexpr int kColumnDescSize = 24;
+constexpr int kColumnNameSize = 16;
+
+/// Смещения полей заголовка.
+constexpr int kOffVersion     = 8;
+constexpr int kOffHeaderSize  = 12;
+constexpr int kOffRowCount    = 16;
+constexpr int kOffRecordSize  = 24;
+
+/// Число записей в одном блоке чтения/записи (~900 КиБ).
+constexpr int kBlockRows = 32 * 1024;
+
+static_assert(sizeof(PackedRect) == kRecordSize, "запись должна совпадать с PackedRect");
+static_assert(offsetof(PackedRect, penColor) == 0 && offsetof(PackedRect, penWidth) == 4
+                  && offsetof(PackedRect, left) == 8 && offsetof(PackedRect, top) == 12
+                  && offsetof(PackedRect, width) == 16 && offsetof(PackedRect, height) == 20
+                  && offsetof(PackedRect, penStyle) == 24,
+              "раскладка PackedRect изменилась — нужна новая версия формата");
+static_assert(kHeaderSize % 8 == 0, "заголовок должен сохранять выравнивание записей");
+
+/**
+ * @brief Тип и смещение поля столбца в записи.
+ */
+struct FieldInfo
+{
+    ColumnType type;
+    quint16 size;
+    quint32 offset;
+};
+
+FieldInfo fieldInfo(Column c)
+{
+    switch (c)
+    {
+    case Column::PenColor: return {ColumnType::Rgba32,    4, offsetof(PackedRect, penColor)};
+    case Column::PenStyle: return {ColumnType::PenStyle8, 1, offsetof(PackedRect, penStyle)};
+    case Column::PenWidth: return {ColumnType::Int32,     4, offsetof(PackedRect, penWidth)};
+    case Column::Left:     return {ColumnType::Int32,     4, offsetof(PackedRect, left)};
+    case Column::Top:      return {ColumnType::Int32,     4, offsetof(PackedRect, top)};
+    case Column::Width:    return {ColumnType::Int32,     4, offsetof(PackedRect, width)};
+    case Column::Height:   return {ColumnType::Int32,     4, offsetof(PackedRect, height)};
+    case Column::Count:    break;
+    }
+    Q_UNREACHABLE();
+    return {ColumnType::Int32, 0, 0};
+}
+
+/**
+ * @brief Читает ровно @p size байт (последовательные устройства отдают данные частями).
+ *
+ * @return Число прочитанных байт (меньше @p size — конец данных или ошибка).
+ */
+qint64 readFully(QIODevice& in, char* data, qint64 size)
+{
+    qint64 done = 0;
+    while (done < size)
+    {
+        const qint64 n = in.read(data + done, size - done);
+        if (n <= 0)
+        {
+            if (n < 0 || !in.waitForReadyRead(-1))
+                break;
+            continue;
+        }
+        done += n;
+    }
+    return done;
+}
+
+} // namespace
+
+namespace RectBinary {
+
+QByteArray makeHeader(qint64 rowCount)
+{
+    QByteArray header(kHeaderSize, '\0');
+    char* p = header.data();
+
+    std::memcpy(p, kMagic, kMagicSize);
+    qToLittleEndian<quint32>(kVersion, p + kOffVersion);
+    qToLittleEndian<quint32>(kHeaderSize, p + kOffHeaderSize);
+    qToLittleEndian<quint64>(static_cast<quint64>(rowCount), p + kOffRowCount);
+    qToLittleEndian<quint32>(kRecordSize, p + kOffRecordSize);
+    qToLittleEndian<quint32>(static_cast<quint32>(kColCountInt), p + kOffRecordSize + 4);
+
+    char* desc = p + kFixedHeaderSize;
+    for (const auto& col : kColumns)
+    {
+        const FieldInfo f = fieldInfo(col.col);
+        std::strncpy(desc, col.header, kColumnNameSize);
+        desc[kColumnNameSize]     = static_cast<char>(col.col);
+        desc[kColumnNameSize + 1] = static_cast<char>(f.type);
+        qToLittleEndian<quint16>(f.size, desc + kColumnNameSize + 2);
+        qToLittleEndian<quint32>(f.offset, desc + kColumnNameSize + 4);
+        desc += kColumnDescSize;
+    }
+
+    return header;
+}
+
+/**
+ * @details
+ * В версии 1 всё после числа записей (размер записи, число и описатели
+ * столбцов) однозначно задано kColumns, поэтому раскладка проверяется
+ * сравнением с эталонным заголовком.
+ */
+bool parseHeader(const char* data, qint64 size, Header* header, QString* error)
+{
+    if (size < kFixedHeaderSize || std::memcmp(data, kMagic, kMagicSize) != 0)
+    {
+        if (error) *error = size < kMagicSize ? "Двоичный файл обрезан (нет заголовка)"
+                                              : "Неверная сигнатура двоичного файла";
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(data + kOffVersion);
+    if (version != kVersion)
+    {
+        if (error) *error = QString("Неподдерживаемая версия двоичного формата: %1").arg(version);
+        return false;
+    }
+
+    const quint32 headerSize = qFromLittleEndian<quint32>(data + kOffHeaderSize);
+    if (headerSize != quint32(kHeaderSize) || size < kHeaderSize)
+    {
+        if (error) *error = size < kHeaderSize ? "Двоичный файл обрезан (нет заголовка)"
+                                               : "Некорректный размер заголовка двоичного файла";
+        return false;
+    }
+
+    const QByteArray expected = makeHeader(0);
+    if (std::memcmp(data + kOffRecordSize, expected.constData() + kOffRecordSize,
+                    static_cast<std::size_t>(kHeaderSize - kOffRecordSize)) != 0)
+    {
+        if (error) *error = "Раскладка столбцов двоичного файла не совпадает с ожидаемой";
+        return false;
+    }
+
+    const quint64 rowCount = qFromLittleEndian<quint64>(data + kOffRowCount);
+    if (rowCount > quint64(std::numeric_limits<int>::max()))
+    {
+        if (error) *error = QString("Слишком много записей в двоичном файле: %1").arg(rowCount);
+        return false;
+    }
+
+    header->version = version;
+    header->headerSize = int(headerSize);
+    header->rowCount = qint64(rowCount);
+    return true;
+}
+
+PackedRect decodeRecord(const char* p)
+{
+    PackedRect r;
+    r.penColor = qFromLittleEndian<quint32>(p + offsetof(PackedRect, penColor));
+    r.penWidth = qFromLittleEndian<qint32>(p + offsetof(PackedRect, penWidth));
+    r.left     = qFromLittleEndian<qint32>(p + offsetof(PackedRect, left));
+    r.top      = qFromLittleEndian<qint32>(p + offsetof(PackedRect, top));
+    r.width    = qFromLittleEndian<qint32>(p + offsetof(PackedRect, width));
+    r.height   = qFromLittleEndian<qint32>(p + offsetof(PackedRect, height));
+    r.penStyle = static_cast<quint8>(p[offsetof(PackedRect, penStyle)]);
+    return r;
+}
+
+void encodeRecord(const PackedRect& r, char* p)
+{
+    qToLittleEndian<quint32>(r.penColor, p + offsetof(PackedRect, penColor));
+    qToLittleEndian<qint32>(r.penWidth, p + offsetof(PackedRect, penWidth));
+    qToLittleEndian<qint32>(r.left,     p + offsetof(PackedRect, left));
+    qToLittleEndian<qint32>(r.top,      p + offsetof(PackedRect, top));
+    qToLittleEndian<qint32>(r.width,    p + offsetof(PackedRect, width));
+    qToLittleEndian<qint32>(r.height,   p + offsetof(PackedRect, height));
+    p[offsetof(PackedRect, penStyle)] = static_cast<char>(r.penStyle);
+    std::memset(p + offsetof(PackedRect, penStyle) + 1, 0,
+                kRecordSize - offsetof(PackedRect, penStyle) - 1);
+}
+
+bool write(QIODevice& out, const RectStore& rows, QString* error)
+{
+    auto writeBytes = [&](const char* data, qint64 size) {
+        if (out.write(data, size) == size)
+            return true;
+        if (error) *error = "Ошибка записи двоичного потока";
+        return false;
+    };
+
+    const QByteArray header = makeHeader(rows.size());
+    if (!writeBytes(header.constData(), header.size()))
+        return false;
+
+    QByteArray block(kBlockRows * kRecordSize, Qt::Uninitialized);
+    const int total = rows.size();
+    for (int first = 0; first < total; first += kBlockRows)
+    {
+        const int count = qMin(kBlockRows, total - first);
+        char* p = block.data();
+        for (int row = first; row < first + count; ++row, p += kRecordSize)
+            encodeRecord(rows.at(row), p);
+
+        if (!writeBytes(block.constData(), qint64(count) * kRecordSize))
+            return false;
+    }
+
+    return true;
+}
+
+/**
+ * @details
+ * Блок читается прямо в QVector<PackedRect> (выравнивание по типу): на
+ * little-endian машине записи уже имеют нужный вид и после проверки стилей
+ * целиком копируются в @p out; на big-endian — декодируются на месте.
+ */
+bool read(QIODevice& in, RectStore& out, QString* error)
+{
+    char headerBytes[kHeaderSize];
+    const qint64 got = readFully(in, headerBytes, kHeaderSize);
+
+    Header header;
+    if (!parseHeader(headerBytes, got, &header, error))
+        return false;
+
+    const qint64 dataSize = header.rowCount * kRecordSize;
+    if (!in.isSequential() && in.size() - in.pos() < dataSize)
+    {
+        if (error) *error = "Двоичный файл обрезан";
+        return false;
+    }
+
+    const int total = int(header.rowCount);
+    out.reserve(out.size() + total);
+
+    QVector<PackedRect> block(qMin(kBlockRows, total));
+    for (int first = 0; first < total; first += kBlockRows)
+    {
+        const int count = qMin(kBlockRows, total - first);
+        const qint64 bytes = qint64(count) * kRecordSize;
+        if (readFully(in, reinterpret_cast<char*>(block.data()), bytes) != bytes)
+        {
+            if (error) *error = "Двоичный файл обрезан";
+            return false;
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+            block[i] = decodeRecord(reinterpret_cast<const char*>(&block[i]));
+#endif
+            if (!PackedRect::isValidPenStyle(block[i].penStyle))
+            {
+                if (error)
+                {
+                    *error = QString("Запись %1: некорректный стиль пера %2")
+                                 .arg(first + i + 1)
+                                 .arg(block[i].penStyle);
+                }
+                return false;
+            }
+        }
+
+        out.append(block.constData(), count);
+    }
+
+    return true;
+}
+
+} // namespace RectBinary
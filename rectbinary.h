@@ -0,0 +1,119 @@
+#ifndef RECTBINARY_H
+#define RECTBINARY_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include "packedrect.h"
+#include "rectstore.h"
+
+class QIODevice;
+
+/**
+ * @brief Двоичный снимок строк MyModel (версионированный формат).
+ *
+ * @details
+ * Файл = заголовок + записи фиксированной длины, все числа little-endian.
+ *
+ * Заголовок (kHeaderSize байт, кратно 8 — записи в отображённом файле выровнены):
+ * | Смещение | Тип       | Поле                                   |
+ * |----------|-----------|----------------------------------------|
+ * | 0        | char[8]   | сигнатура "RECTSNAP"                   |
+ * | 8        | quint32   | версия формата (kVersion)              |
+ * | 12       | quint32   | размер заголовка (начало записей)      |
+ * | 16       | quint64   | число записей                          |
+ * | 24       | quint32   | размер записи (kRecordSize)            |
+ * | 28       | quint32   | число столбцов                         |
+ * | 32       | 24 x N    | описатели столбцов в порядке kColumns  |
+ *
+ * Описатель столбца: заголовок из RectColumns::kColumns (char[16], дополнен
+ * нулями), номер Column (quint8), тип (quint8, ColumnType), размер поля
+ * (quint16), смещение поля в записи (quint32).
+ *
+ * Запись (kRecordSize = 28 байт) совпадает с образом PackedRect в памяти
+ * little-endian машины: penColor, penWidth, left, top, width, height, penStyle
+ * и три нулевых байта выравнивания. Поэтому на x86/ARM загрузка — это
+ * копирование блока памяти (RectStore::append(const PackedRect*, int)),
+ * а на big-endian машинах поля переставляются по одному.
+ *
+ * Читатель версии 1 принимает только ту же раскладку столбцов, которую
+ * пишет сам; иная раскладка — ошибка, а не попытка угадать.
+ */
+namespace RectBinary {
+
+/// Текущая версия формата.
+constexpr quint32 kVersion = 1;
+
+/// Размер записи (одна строка).
+constexpr int kRecordSize = 28;
+
+/// Размер заголовка версии 1.
+constexpr int kHeaderSize = 32 + 24 * RectColumns::kColCountInt;
+
+/// Тип поля в описателе столбца.
+enum class ColumnType : quint8
+{
+    Rgba32    = 1, ///< QRgb (#AARRGGBB), quint32.
+    PenStyle8 = 2, ///< Значение Qt::PenStyle, quint8 (0..Qt::MPenStyle).
+    Int32     = 3  ///< qint32.
+};
+
+/**
+ * @brief Разобранный заголовок.
+ */
+struct Header
+{
+    quint32 version = 0;
+    int headerSize = 0;
+    qint64 rowCount = 0;
+};
+
+/**
+ * @brief Формирует заголовок для @p rowCount записей.
+ */
+QByteArray makeHeader(qint64 rowCount);
+
+/**
+ * @brief Проверяет и разбирает заголовок.
+ *
+ * @param data Начало файла.
+ * @param size Число доступных байт (не меньше kHeaderSize для успеха).
+ * @param header Сюда пишется результат.
+ * @param error Опционально: текст ошибки.
+ * @return false при неверной сигнатуре, версии или раскладке столбцов.
+ */
+bool parseHeader(const char* data, qint64 size, Header* header, QString* error = nullptr);
+
+/**
+ * @brief Декодирует одну запись (kRecordSize байт, выравнивание не требуется).
+ */
+PackedRect decodeRecord(const char* p);
+
+/**
+ * @brief Кодирует одну запись в @p p (kRecordSize байт, байты выравнивания — нули).
+ */
+void encodeRecord(const PackedRect& r, char* p);
+
+/**
+ * @brief Записывает все строки @p rows (заголовок + записи).
+ *
+ * @return false при ошибке записи в устройство.
+ */
+bool write(QIODevice& out, const RectStore& rows, QString* error = nullptr);
+
+/**
+ * @brief Читает снимок из текущей позиции @p in и добавляет строки в @p out.
+ *
+ * @details
+ * Записи читаются блоками; стиль пера каждой записи проверяется
+ * (PackedRect::isValidPenStyle()). При ошибке @p out может содержать
+ * часть строк — вызывающий отбрасывает его целиком.
+ *
+ * @return false при ошибке формата, обрезанном файле или ошибке чтения.
+ */
+bool read(QIODevice& in, RectStore& out, QString* error = nullptr);
+
+} // namespace RectBinary
+
+#endif // RECTBINARY_H
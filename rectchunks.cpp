@@ -0,0 +1,373 @@
+#include "rectchunks.h"
+
+#include <algorithm>
+
+namespace {
+
+/// Дописывает @p count строк из @p rows в конец @p v (у QVector в Qt 5 нет такой перегрузки).
+void appendRows(QVector<PackedRect>& v, const PackedRect* rows, int count)
+{
+    const int oldSize = v.size();
+    v.resize(oldSize + count);
+    std::copy(rows, rows + count, v.begin() + oldSize);
+}
+
+/// Младший установленный бит (шаг дерева Фенвика).
+int lowBit(int i)
+{
+    return i & -i;
+}
+
+} // namespace
+
+int RectChunks::size() const
+{
+    return m_size;
+}
+
+bool RectChunks::isEmpty() const
+{
+    return m_size == 0;
+}
+
+void RectChunks::clear()
+{
+    m_chunks.clear();
+    m_index.clear();
+    m_uniform = true;
+    m_size = 0;
+}
+
+void RectChunks::reserve(int count)
+{
+    const int chunks = (count + kChunkRows - 1) / kChunkRows;
+    m_chunks.reserve(chunks);
+    m_index.reserve(chunks + 1);
+}
+
+// -------------------- lookup --------------------
+
+/**
+ * @details
+ * В общем случае — спуск по дереву Фенвика: ищется наибольшее число
+ * первых блоков, суммарный размер которых не больше @p row.
+ */
+RectChunks::Position RectChunks::locate(int row) const
+{
+    if (m_uniform)
+        return Position{row / kChunkRows, row % kChunkRows};
+
+    const int count = m_chunks.size();
+    int step = 1;
+    while (step * 2 <= count)
+        step *= 2;
+
+    const int* index = m_index.constData();
+    Position p;
+    p.offset = row;
+    for (; step > 0; step /= 2)
+    {
+        const int next = p.chunk + step;
+        if (next <= count && index[next] <= p.offset)
+        {
+            p.chunk = next;
+            p.offset -= index[next];
+        }
+    }
+    return p;
+}
+
+const PackedRect& RectChunks::at(int row) const
+{
+    const Position p = locate(row);
+    return m_chunks.at(p.chunk).at(p.offset);
+}
+
+/**
+ * @details
+ * Неконстантный operator[] внешнего QVector отделяет список блоков (копия
+ * указателей), неконстантный operator[] блока — только сам блок.
+ */
+PackedRect& RectChunks::operator[](int row)
+{
+    const Position p = locate(row);
+    return m_chunks[p.chunk][p.offset];
+}
+
+// -------------------- append --------------------
+
+void RectChunks::append(const PackedRect& r)
+{
+    append(&r, 1);
+}
+
+/**
+ * @details
+ * Сначала дописывается неполный последний блок, затем создаются новые
+ * блоки с резервом на kChunkRows строк.
+ */
+void RectChunks::append(const PackedRect* rows, int count)
+{
+    while (count > 0)
+    {
+        const int last = m_chunks.size() - 1;
+        if (last >= 0 && m_chunks.at(last).size() < kChunkRows)
+        {
+            const int n = qMin(count, kChunkRows - m_chunks.at(last).size());
+            appendRows(m_chunks[last], rows, n);
+            indexAdd(last, n);
+
+            rows += n;
+            count -= n;
+            m_size += n;
+            continue;
+        }
+
+        // Новый блок после неполного нарушил бы равномерность; здесь предыдущий полон
+        const int n = qMin(count, kChunkRows);
+        QVector<PackedRect> chunk;
+        chunk.reserve(kChunkRows);
+        appendRows(chunk, rows, n);
+        m_chunks.append(chunk);
+        indexAppend(n);
+
+        rows += n;
+        count -= n;
+        m_size += n;
+    }
+}
+
+void RectChunks::append(const RectChunks& other, int row, int count)
+{
+    if (count <= 0)
+        return;
+
+    Position p = other.locate(row);
+    while (count > 0)
+    {
+        // Копия ручки блока, а не ссылка: при &other == this дописывание
+        // может переложить m_chunks или отделить этот же блок
+        const QVector<PackedRect> source = other.m_chunks.at(p.chunk);
+        const int n = qMin(count, source.size() - p.offset);
+        append(source.constData() + p.offset, n);
+
+        count -= n;
+        ++p.chunk;
+        p.offset = 0;
+    }
+}
+
+// -------------------- structural edits --------------------
+
+void RectChunks::insert(int row, int count, const PackedRect& value)
+{
+    if (count <= 0)
+        return;
+
+    const QVector<PackedRect> block(count, value);
+    insertRows(row, block.constData(), count);
+}
+
+void RectChunks::insert(int row, const RectChunks& rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    QVector<PackedRect> block;
+    block.reserve(rows.size());
+    for (const QVector<PackedRect>& c : rows.m_chunks)
+        block += c;
+    insertRows(row, block.constData(), block.size());
+}
+
+/**
+ * @details
+ * Если строки помещаются в блок, раздвигается только он, индекс
+ * обновляется за O(log). Иначе блок вместе с новыми строками делится
+ * на равные части не больше kChunkRows: части встают на место блока
+ * (сдвиг хвоста списка блоков — memmove ручек, без копирования строк),
+ * и индекс перестраивается за O(блоков).
+ */
+void RectChunks::insertRows(int row, const PackedRect* rows, int count)
+{
+    if (row == m_size)
+    {
+        append(rows, count);
+        return;
+    }
+
+    const Position p = locate(row);
+    const QVector<PackedRect>& target = m_chunks.at(p.chunk);
+
+    if (target.size() + count <= kChunkRows)
+    {
+        QVector<PackedRect>& chunk = m_chunks[p.chunk];
+        chunk.insert(p.offset, count, PackedRect{});
+        std::copy(rows, rows + count, chunk.begin() + p.offset);
+
+        m_size += count;
+        indexAdd(p.chunk, count);
+        m_uniform = m_uniform && p.chunk == m_chunks.size() - 1;
+        return;
+    }
+
+    QVector<PackedRect> combined;
+    combined.reserve(target.size() + count);
+    appendRows(combined, target.constData(), p.offset);
+    appendRows(combined, rows, count);
+    appendRows(combined, target.constData() + p.offset, target.size() - p.offset);
+
+    const int parts = (combined.size() + kChunkRows - 1) / kChunkRows;
+    m_chunks.insert(p.chunk + 1, parts - 1, QVector<PackedRect>());
+    for (int k = 0; k < parts; ++k)
+    {
+        const int begin = int(qint64(combined.size()) * k / parts);
+        const int end = int(qint64(combined.size()) * (k + 1) / parts);
+        QVector<PackedRect> part;
+        appendRows(part, combined.constData() + begin, end - begin);
+        m_chunks[p.chunk + k] = std::move(part);
+    }
+
+    m_size += count;
+    rebuildIndex();
+}
+
+/**
+ * @details
+ * Целиком удалённые блоки выбрасываются без копирования (даже если они
+ * общие со снимком), частично затронутые — укорачиваются. Маленький
+ * остаток и в первом, и в последнем затронутом блоке сливается с
+ * соседом. Если список блоков изменился, индекс перестраивается за
+ * O(блоков).
+ */
+void RectChunks::remove(int row, int count)
+{
+    if (count <= 0)
+        return;
+
+    const Position p = locate(row);
+    const int lastBefore = m_chunks.size() - 1;
+
+    int chunk = p.chunk;
+    int offset = p.offset;
+    int left = count;
+    int trimmed = -1;   // последний укороченный блок
+    bool dropped = false;
+    while (left > 0)
+    {
+        const int chunkSize = m_chunks.at(chunk).size();
+        const int n = qMin(left, chunkSize - offset);
+        if (n == chunkSize)
+        {
+            m_chunks.remove(chunk);
+            dropped = true;
+        }
+        else
+        {
+            m_chunks[chunk].remove(offset, n);
+            if (!dropped)
+                indexAdd(chunk, -n);
+            m_uniform = m_uniform && chunk == lastBefore;
+            trimmed = chunk;
+            ++chunk;
+            offset = 0;
+        }
+        left -= n;
+    }
+
+    m_size -= count;
+
+    // Сначала дальний блок: его слияние не сдвигает номер p.chunk
+    bool merged = false;
+    if (trimmed > p.chunk)
+        merged = mergeSmall(trimmed);
+    merged = mergeSmall(p.chunk) || merged;
+    if (merged || dropped)
+        rebuildIndex();
+}
+
+void RectChunks::move(int sourceRow, int count, int destinationRow)
+{
+    RectChunks block;
+    block.append(*this, sourceRow, count);
+    remove(sourceRow, count);
+    insert(destinationRow > sourceRow ? destinationRow - count : destinationRow, block);
+}
+
+bool RectChunks::mergeSmall(int index)
+{
+    if (index < 0 || index >= m_chunks.size() || m_chunks.at(index).size() >= kChunkRows / 2)
+        return false;
+
+    const int size = m_chunks.at(index).size();
+    if (index + 1 < m_chunks.size() && size + m_chunks.at(index + 1).size() <= kChunkRows)
+    {
+        m_chunks[index] += m_chunks.at(index + 1);
+        m_chunks.remove(index + 1);
+        return true;
+    }
+    if (index > 0 && size + m_chunks.at(index - 1).size() <= kChunkRows)
+    {
+        m_chunks[index - 1] += m_chunks.at(index);
+        m_chunks.remove(index);
+        return true;
+    }
+    return false;
+}
+
+// -------------------- index --------------------
+
+void RectChunks::indexAdd(int chunk, int delta)
+{
+    for (int i = chunk + 1; i < m_index.size(); i += lowBit(i))
+        m_index[i] += delta;
+}
+
+/**
+ * @details
+ * Новый узел i покрывает блоки (i - lowbit(i), i]: его значение — размер
+ * нового блока плюс суммы узлов, покрывающих остальные блоки этого отрезка.
+ */
+void RectChunks::indexAppend(int rows)
+{
+    if (m_index.isEmpty())
+        m_index.append(0);
+
+    const int i = m_index.size();
+    int value = rows;
+    for (int j = i - 1; j > i - lowBit(i); j -= lowBit(j))
+        value += m_index.at(j);
+    m_index.append(value);
+}
+
+void RectChunks::rebuildIndex()
+{
+    const int count = m_chunks.size();
+    m_index.resize(count + 1);
+    m_index[0] = 0;
+    m_uniform = true;
+    for (int i = 1; i <= count; ++i)
+    {
+        m_index[i] = m_chunks.at(i - 1).size();
+        if (i < count && m_index.at(i) != kChunkRows)
+            m_uniform = false;
+    }
+    for (int i = 1; i <= count; ++i)
+    {
+        const int parent = i + lowBit(i);
+        if (parent <= count)
+            m_index[parent] += m_index.at(i);
+    }
+}
+
+// -------------------- chunks --------------------
+
+int RectChunks::chunkCount() const
+{
+    return m_chunks.size();
+}
+
+const QVector<PackedRect>& RectChunks::chunk(int index) const
+{
+    return m_chunks.at(index);
+}
@@ -0,0 +1,161 @@
+#ifndef RECTCHUNKS_H
+#define RECTCHUNKS_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "packedrect.h"
+
+/**
+ * @brief Последовательность строк PackedRect, разбитая на блоки (chunks).
+ *
+ * @details
+ * # Устройство
+ * Строки лежат в блоках от 1 до kChunkRows строк; и список блоков, и каждый
+ * блок — QVector с implicit sharing. Номер строки переводится в (блок,
+ * смещение) через индекс размеров блоков — дерево Фенвика (m_index): сумма
+ * размеров первых k блоков и поиск блока по номеру строки за O(log блоков).
+ *
+ * Пока все блоки, кроме последнего, полные (загрузка, добавление в конец),
+ * поиск сводится к делению: row / kChunkRows (см. m_uniform).
+ *
+ * # Вставка и удаление
+ * Правка меняет только блоки, в которые попадает: вставка раздвигает
+ * не более kChunkRows строк блока, переполненный блок делится пополам,
+ * опустевший удаляется, а маленький сливается с соседом. Пока список
+ * блоков не меняется, индекс обновляется за O(log); деление, удаление
+ * и слияние блоков сдвигают хвост списка блоков и перестраивают индекс
+ * за O(n / kChunkRows). Список блоков — плоский QVector, не дерево:
+ * на десять миллионов строк это около 2500 ручек блоков.
+ *
+ * # Копирование при записи по блокам
+ * Копия RectChunks разделяет все блоки с оригиналом (копируется только
+ * список блоков и индекс). Запись в строку через operator[] отделяет
+ * список блоков и единственный блок, в котором лежит строка: остальные
+ * блоки по-прежнему общие. Поэтому снимок большой таблицы стоит
+ * O(n / kChunkRows), а правка после снимка — копию одного блока.
+ *
+ * Счётчики ссылок QVector атомарны: копию можно читать в другом потоке,
+ * пока владелец оригинала продолжает его менять (см. RectSnapshot).
+ *
+ * # Сложность
+ * - at(), operator[] — O(1) при полных блоках, иначе O(log n);
+ * - append() — амортизированно O(1) на строку;
+ * - insert(), remove() в любом месте — O(kChunkRows + count + log n),
+ *   если список блоков не меняется, иначе O(kChunkRows + count + n / kChunkRows);
+ * - move() — то же, что remove() и insert() (вырезать и вставить).
+ *
+ * @note Индексы строк не проверяются (как у QVector::operator[]).
+ */
+class RectChunks
+{
+public:
+    /// Наибольшее число строк в блоке.
+    static constexpr int kChunkRows = 4096;
+
+    /// Количество строк.
+    int size() const;
+
+    /// Пусто ли хранилище.
+    bool isEmpty() const;
+
+    /// Удаляет все строки.
+    void clear();
+
+    /// Резервирует место в списке блоков под @p count строк.
+    void reserve(int count);
+
+    /// Строка @p row (без отделения блоков).
+    const PackedRect& at(int row) const;
+
+    /// Строка @p row для записи: отделяет только блок, в котором она лежит.
+    PackedRect& operator[](int row);
+
+    /**
+     * @name Добавление в конец
+     * @{
+     */
+    void append(const PackedRect& r);
+    void append(const PackedRect* rows, int count);
+
+    /**
+     * @brief Добавляет строки [@p row, @p row + @p count) из @p other.
+     */
+    void append(const RectChunks& other, int row, int count);
+    /** @} */
+
+    /**
+     * @brief Вставляет @p count копий @p value перед строкой @p row.
+     */
+    void insert(int row, int count, const PackedRect& value);
+
+    /**
+     * @brief Вставляет все строки @p rows перед строкой @p row.
+     */
+    void insert(int row, const RectChunks& rows);
+
+    /**
+     * @brief Удаляет строки [@p row, @p row + @p count).
+     */
+    void remove(int row, int count);
+
+    /**
+     * @brief Переносит строки [@p sourceRow, @p sourceRow + @p count) перед
+     *        строкой @p destinationRow (нумерация до переноса, как RectStore::move()).
+     */
+    void move(int sourceRow, int count, int destinationRow);
+
+    /**
+     * @name Блоки для линейных проходов
+     * @{
+     */
+    int chunkCount() const;
+    const QVector<PackedRect>& chunk(int index) const;
+    /** @} */
+
+private:
+    /// Положение строки: номер блока и смещение в нём.
+    struct Position
+    {
+        int chunk = 0;
+        int offset = 0;
+    };
+
+    /**
+     * @brief Блок и смещение строки @p row; для row == size() — позиция после последней строки.
+     */
+    Position locate(int row) const;
+
+    /**
+     * @brief Вставляет @p count строк из @p rows перед строкой @p row.
+     */
+    void insertRows(int row, const PackedRect* rows, int count);
+
+    /**
+     * @brief Сливает блок @p index с соседом, если он мал и вместе они помещаются в блок.
+     *
+     * @return true, если список блоков изменился (индекс нужно перестроить).
+     */
+    bool mergeSmall(int index);
+
+    /**
+     * @name Индекс размеров блоков (дерево Фенвика, нумерация с 1)
+     * @{
+     */
+    void indexAdd(int chunk, int delta);
+    void indexAppend(int rows);
+    void rebuildIndex();
+    /** @} */
+
+    QVector<QVector<PackedRect>> m_chunks;
+
+    /// m_index[i] — сумма размеров блоков (i - lowbit(i), i] (m_index[0] не используется).
+    QVector<int> m_index;
+
+    /// Все блоки, кроме последнего, содержат ровно kChunkRows строк.
+    bool m_uniform = true;
+
+    int m_size = 0;
+};
+
+#endif // RECTCHUNKS_H
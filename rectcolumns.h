@@ -0,0 +1,81 @@
+#ifndef RECTCOLUMNS_H
+#define RECTCOLUMNS_H
+
+#include <array>
+#include <cstddef> // std::size_t
+
+/**
+ * @brief Описание столбцов таблицы прямоугольников.
+ *
+ * @details
+ * Единый источник правды о колонках (семантика, порядок, заголовки, порядок полей TSV).
+ * Вынесен из MyModel, т.к. тем же раскладом пользуются хранилище строк (RectStore)
+ * и сериализация — все они должны оставаться согласованными с таблицей.
+ */
+namespace RectColumns {
+
+/**
+ * @brief Семантические столбцы модели.
+ *
+ * @note Column::Count — служебный элемент “число столбцов”.
+ */
+enum class Column : int
+{
+    PenColor = 0,
+    PenStyle,
+    PenWidth,
+    Left,
+    Top,
+    Width,
+    Height,
+    Count
+};
+
+/**
+ * @brief Метаданные одного столбца: семантика и текст заголовка.
+ */
+struct ColumnInfo
+{
+    Column      col;     ///< Семантика столбца.
+    const char* header;  ///< Текст заголовка (ASCII/Latin1).
+};
+
+/**
+ * @brief Количество столбцов как std::size_t (нужно для std::array).
+ */
+inline constexpr std::size_t kColCount =
+    static_cast<std::size_t>(Column::Count);
+
+/**
+ * @brief Количество столбцов в терминах Qt (int).
+ */
+inline constexpr int kColCountInt =
+    static_cast<int>(kColCount);
+
+/**
+ * @brief Порядок/заголовки столбцов.
+ *
+ * @details
+ * Индекс в массиве = индекс столбца в QTableView = номер поля в TSV.
+ */
+inline constexpr std::array<ColumnInfo, kColCount> kColumns = {{
+    {Column::PenColor, "PenColor"},
+    {Column::PenStyle, "PenStyle"},
+    {Column::PenWidth, "PenWidth"},
+    {Column::Left,     "Left"},
+    {Column::Top,      "Top"},
+    {Column::Width,    "Width"},
+    {Column::Height,   "Height"},
+}};
+
+/**
+ * @brief Является ли столбец целочисленным (PenWidth/Left/Top/Width/Height).
+ */
+constexpr bool isIntColumn(Column c)
+{
+    return c >= Column::PenWidth && c < Column::Count;
+}
+
+} // namespace RectColumns
+
+#endif // RECTCOLUMNS_H
@@ -0,0 +1,422 @@
+#include "rectformat.h"
+
+#include <QByteArray>
+
+#include <array>
+#include <cstring>
+#include <limits>
+
+#include "packedrect.h"
+
+namespace {
+
+/**
+ * @brief Размер таблицы интернированных имён: все значения Qt::PenStyle (0..Qt::MPenStyle).
+ */
+constexpr int kPenStyleNameCount = static_cast<int>(Qt::MPenStyle) + 1;
+
+/**
+ * @brief Таблица интернированных строк для всех значений Qt::PenStyle.
+ *
+ * @details
+ * Строится один раз (thread-safe инициализация function-local static).
+ * Известные стили — QStringLiteral (статические данные, без кучи);
+ * прочие значения диапазона заранее форматируются как "Qt::PenStyle(N)".
+ * Копия QString из таблицы — только инкремент счётчика ссылок.
+ */
+const std::array<QString, kPenStyleNameCount>& penStyleNames()
+{
+    static const std::array<QString, kPenStyleNameCount> kNames = [] {
+        std::array<QString, kPenStyleNameCount> names;
+        for (int i = 0; i < kPenStyleNameCount; ++i)
+            names[static_cast<std::size_t>(i)] = QStringLiteral("Qt::PenStyle(%1)").arg(i);
+
+        names[Qt::NoPen]          = QStringLiteral("Qt::NoPen");
+        names[Qt::SolidLine]      = QStringLiteral("Qt::SolidLine");
+        names[Qt::DashLine]       = QStringLiteral("Qt::DashLine");
+        names[Qt::DotLine]        = QStringLiteral("Qt::DotLine");
+        names[Qt::DashDotLine]    = QStringLiteral("Qt::DashDotLine");
+        names[Qt::DashDotDotLine] = QStringLiteral("Qt::DashDotDotLine");
+        return names;
+    }();
+    return kNames;
+}
+
+/**
+ * @brief Байтовые копии интернированных имён (для formatRow()/TsvWriter).
+ */
+const std::array<QByteArray, kPenStyleNameCount>& penStyleNamesLatin1()
+{
+    static const std::array<QByteArray, kPenStyleNameCount> kNames = [] {
+        std::array<QByteArray, kPenStyleNameCount> names;
+        for (int i = 0; i < kPenStyleNameCount; ++i)
+            names[static_cast<std::size_t>(i)] = penStyleNames()[static_cast<std::size_t>(i)].toLatin1();
+        return names;
+    }();
+    return kNames;
+}
+
+/// Длина "#rrggbb".
+constexpr int kHexColorSize = RectFormat::kColorNameSize;
+
+/// Строчные шестнадцатеричные цифры (как у QColor::name()).
+constexpr char kLowerHexDigits[] = "0123456789abcdef";
+
+/**
+ * @brief Пары десятичных цифр "00".."99" для formatInt().
+ */
+constexpr std::array<char, 200> makeDigitPairs()
+{
+    std::array<char, 200> table {};
+    for (int i = 0; i < 100; ++i)
+    {
+        table[static_cast<std::size_t>(2 * i)]     = static_cast<char>('0' + i / 10);
+        table[static_cast<std::size_t>(2 * i + 1)] = static_cast<char>('0' + i % 10);
+    }
+    return table;
+}
+
+constexpr std::array<char, 200> kDigitPairs = makeDigitPairs();
+
+/**
+ * @brief Число десятичных цифр в @p v.
+ */
+constexpr int decimalDigits(quint32 v)
+{
+    int n = 1;
+    while (v >= 10)
+    {
+        v /= 10;
+        ++n;
+    }
+    return n;
+}
+
+/// Признак "не шестнадцатеричная цифра" в kHexDigits.
+constexpr quint8 kInvalidHexDigit = 0x80;
+
+/**
+ * @brief Таблица значений шестнадцатеричных цифр по байту (иначе kInvalidHexDigit).
+ */
+constexpr std::array<quint8, 256> makeHexDigits()
+{
+    std::array<quint8, 256> table {};
+    for (int c = 0; c < 256; ++c)
+    {
+        if (c >= '0' && c <= '9')
+            table[static_cast<std::size_t>(c)] = static_cast<quint8>(c - '0');
+        else if (c >= 'a' && c <= 'f')
+            table[static_cast<std::size_t>(c)] = static_cast<quint8>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F')
+            table[static_cast<std::size_t>(c)] = static_cast<quint8>(c - 'A' + 10);
+        else
+            table[static_cast<std::size_t>(c)] = kInvalidHexDigit;
+    }
+    return table;
+}
+
+constexpr std::array<quint8, 256> kHexDigits = makeHexDigits();
+
+/// Наибольшее значение int (предел для parseInt()).
+constexpr int kIntMax = std::numeric_limits<int>::max();
+
+/**
+ * @brief Пробельный байт в смысле QChar::isSpace() для Latin-1.
+ */
+constexpr bool isSpaceByte(char c)
+{
+    const uchar u = uchar(c);
+    return u == ' ' || (u >= '\t' && u <= '\r') || u == 0x85 || u == 0xa0;
+}
+
+/// Префикс формата "Qt::PenStyle(N)".
+constexpr char kPenStylePrefix[] = "Qt::PenStyle(";
+
+/// Общий префикс всех имён стилей: "Qt::".
+constexpr char kQtPrefix[] = "Qt::";
+constexpr int kQtPrefixSize = int(sizeof(kQtPrefix) - 1);
+
+/// Известное имя стиля пера.
+struct PenStyleNameItem
+{
+    const char* name;
+    int size;
+    Qt::PenStyle style;
+};
+
+/// Длина C-строки во время компиляции.
+constexpr int literalSize(const char* s)
+{
+    int n = 0;
+    while (s[n] != '\0')
+        ++n;
+    return n;
+}
+
+constexpr PenStyleNameItem kPenStyleNameItems[] = {
+    {"Qt::NoPen",          literalSize("Qt::NoPen"),          Qt::NoPen},
+    {"Qt::SolidLine",      literalSize("Qt::SolidLine"),      Qt::SolidLine},
+    {"Qt::DashLine",       literalSize("Qt::DashLine"),       Qt::DashLine},
+    {"Qt::DotLine",        literalSize("Qt::DotLine"),        Qt::DotLine},
+    {"Qt::DashDotLine",    literalSize("Qt::DashDotLine"),    Qt::DashDotLine},
+    {"Qt::DashDotDotLine", literalSize("Qt::DashDotDotLine"), Qt::DashDotDotLine},
+};
+
+constexpr int kPenStyleNameItemCount = int(sizeof(kPenStyleNameItems) / sizeof(kPenStyleNameItems[0]));
+
+/// Длина самого длинного имени (+1) — размер таблицы диспетчеризации.
+constexpr int kPenStyleLengthSlots = [] {
+    int longest = 0;
+    for (const auto& it : kPenStyleNameItems)
+        longest = it.size > longest ? it.size : longest;
+    return longest + 1;
+}();
+
+/// Пустой слот таблицы диспетчеризации.
+constexpr qint8 kNoPenStyleName = -1;
+
+/**
+ * @brief Таблица "длина имени -> индекс в kPenStyleNameItems".
+ *
+ * @details
+ * Длины всех известных имён различны, поэтому длина — совершенный хеш:
+ * кандидат находится одним обращением к таблице, после чего остаётся
+ * одно сравнение байтов. Если в Qt появится имя с уже занятой длиной,
+ * сборка остановится на static_assert ниже.
+ */
+constexpr std::array<qint8, kPenStyleLengthSlots> makePenStyleByLength()
+{
+    std::array<qint8, kPenStyleLengthSlots> table {};
+    for (auto& slot : table)
+        slot = kNoPenStyleName;
+    for (int i = 0; i < kPenStyleNameItemCount; ++i)
+        table[static_cast<std::size_t>(kPenStyleNameItems[i].size)] = static_cast<qint8>(i);
+    return table;
+}
+
+constexpr std::array<qint8, kPenStyleLengthSlots> kPenStyleByLength = makePenStyleByLength();
+
+constexpr bool penStyleLengthsArePerfect()
+{
+    int used = 0;
+    for (qint8 slot : kPenStyleByLength)
+        used += slot != kNoPenStyleName ? 1 : 0;
+    return used == kPenStyleNameItemCount;
+}
+
+static_assert(penStyleLengthsArePerfect(), "Длины имён Qt::PenStyle должны быть различны");
+
+} // namespace
+
+namespace RectFormat {
+
+QString colorName(QRgb rgba)
+{
+    return QColor::fromRgb(rgba & RGB_MASK).name();
+}
+
+QString penStyleName(Qt::PenStyle style)
+{
+    const int v = static_cast<int>(style);
+    if (v >= 0 && v < kPenStyleNameCount)
+        return penStyleNames()[static_cast<std::size_t>(v)];
+
+    return QString("Qt::PenStyle(%1)").arg(v);
+}
+
+char* formatColor(QRgb rgba, char* out)
+{
+    out[0] = '#';
+    for (int i = 0; i < 6; ++i)
+        out[1 + i] = kLowerHexDigits[(rgba >> (20 - 4 * i)) & 0xf];
+    return out + kHexColorSize;
+}
+
+QLatin1String penStyleNameLatin1(Qt::PenStyle style)
+{
+    Q_ASSERT(PackedRect::isValidPenStyle(static_cast<int>(style)));
+    const QByteArray& name = penStyleNamesLatin1()[static_cast<std::size_t>(style)];
+    return QLatin1String(name.constData(), name.size());
+}
+
+/**
+ * @details
+ * Модуль считается в quint32 (|INT_MIN| в int не помещается); цифры пишутся
+ * с конца парами из kDigitPairs — вдвое меньше делений, чем по одной цифре.
+ */
+char* formatInt(qint32 value, char* out)
+{
+    quint32 v = static_cast<quint32>(value);
+    if (value < 0)
+    {
+        *out++ = '-';
+        v = 0u - v;
+    }
+
+    char* end = out + decimalDigits(v);
+    char* p = end;
+    while (v >= 100)
+    {
+        const quint32 pair = (v % 100) * 2;
+        v /= 100;
+        *--p = kDigitPairs[pair + 1];
+        *--p = kDigitPairs[pair];
+    }
+    if (v >= 10)
+    {
+        *--p = kDigitPairs[v * 2 + 1];
+        *--p = kDigitPairs[v * 2];
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+/**
+ * @details
+ * Три допустимых написания не пересекаются по первому байту: имена и
+ * "Qt::PenStyle(N)" начинаются с "Qt::", число — с цифры или знака.
+ * Поэтому вместо последовательных попыток достаточно одной развилки:
+ * - не 'Q' — только число;
+ * - "Qt::P..." — только "Qt::PenStyle(N)";
+ * - прочие "Qt::..." — имя, найденное по длине (kPenStyleByLength) и
+ *   сверенное одним memcmp.
+ * Результат тот же, что у прежней цепочки "число, Qt::PenStyle(N), имя".
+ */
+Qt::PenStyle parsePenStyle(QLatin1String text, bool* ok)
+{
+    const QLatin1String t = text.trimmed();
+    const char* p = t.data();
+    const int size = t.size();
+    bool numOk = false;
+
+    // (1) число
+    if (size == 0 || p[0] != 'Q')
+    {
+        const int v = parseInt(t, &numOk);
+        if (numOk && PackedRect::isValidPenStyle(v))
+        {
+            if (ok) *ok = true;
+            return static_cast<Qt::PenStyle>(v);
+        }
+    }
+    else if (size > kQtPrefixSize && std::memcmp(p, kQtPrefix, kQtPrefixSize) == 0)
+    {
+        constexpr int prefixSize = int(sizeof(kPenStylePrefix) - 1);
+
+        if (p[kQtPrefixSize] == 'P')
+        {
+            // (2) "Qt::PenStyle(3)"
+            if (size > prefixSize && p[size - 1] == ')'
+                && std::memcmp(p, kPenStylePrefix, prefixSize) == 0)
+            {
+                const int v = parseInt(QLatin1String(p + prefixSize, size - prefixSize - 1), &numOk);
+                if (numOk && PackedRect::isValidPenStyle(v))
+                {
+                    if (ok) *ok = true;
+                    return static_cast<Qt::PenStyle>(v);
+                }
+            }
+        }
+        else if (size < kPenStyleLengthSlots)
+        {
+            // (3) имена
+            const qint8 index = kPenStyleByLength[static_cast<std::size_t>(size)];
+            if (index != kNoPenStyleName)
+            {
+                const PenStyleNameItem& it = kPenStyleNameItems[index];
+                if (std::memcmp(p + kQtPrefixSize, it.name + kQtPrefixSize, size - kQtPrefixSize) == 0)
+                {
+                    if (ok) *ok = true;
+                    return it.style;
+                }
+            }
+        }
+    }
+
+    if (ok) *ok = false;
+    return Qt::SolidLine;
+}
+
+bool parseColor(QLatin1String text, QRgb* rgba)
+{
+    const QLatin1String t = text.trimmed();
+
+    if (t.size() == kHexColorSize && t.data()[0] == '#')
+    {
+        const uchar* p = reinterpret_cast<const uchar*>(t.data()) + 1;
+        const quint32 d[6] = {
+            kHexDigits[p[0]], kHexDigits[p[1]], kHexDigits[p[2]],
+            kHexDigits[p[3]], kHexDigits[p[4]], kHexDigits[p[5]],
+        };
+
+        if (((d[0] | d[1] | d[2] | d[3] | d[4] | d[5]) & kInvalidHexDigit) == 0)
+        {
+            *rgba = 0xff000000u
+                  | d[0] << 20 | d[1] << 16
+                  | d[2] << 12 | d[3] << 8
+                  | d[4] << 4  | d[5];
+            return true;
+        }
+    }
+
+    const QColor color(t);
+    if (!color.isValid())
+        return false;
+
+    *rgba = color.rgba();
+    return true;
+}
+
+/**
+ * @details
+ * Один проход по байтам поля без временных строк и без учёта локали:
+ * пробелы по краям пропускаются (тот же набор, что у QLatin1String::trimmed()),
+ * затем необязательный знак и хотя бы одна цифра. Модуль копится в quint32
+ * и до умножения сравнивается с пределом (INT_MAX или |INT_MIN|), поэтому
+ * переполнение обнаруживается до того, как произойдёт.
+ */
+int parseInt(QLatin1String text, bool* ok)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+
+    while (p != end && isSpaceByte(*p))
+        ++p;
+    while (p != end && isSpaceByte(end[-1]))
+        --end;
+
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    const quint32 limit = negative ? quint32(kIntMax) + 1u : quint32(kIntMax);
+    quint32 value = 0;
+
+    if (p == end)
+    {
+        *ok = false;
+        return 0;
+    }
+
+    for (; p != end; ++p)
+    {
+        const quint32 digit = quint32(uchar(*p)) - '0';
+        if (digit > 9 || value > (limit - digit) / 10)
+        {
+            *ok = false;
+            return 0;
+        }
+        value = value * 10 + digit;
+    }
+
+    *ok = true;
+    return negative ? int(0u - value) : int(value);
+}
+
+} // namespace RectFormat
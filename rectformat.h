@@ -0,0 +1,124 @@
+#ifndef RECTFORMAT_H
+#define RECTFORMAT_H
+
+#include <QColor>
+#include <QRgb>
+#include <QString>
+#include <Qt>
+
+/**
+ * @brief Текстовое представление полей MyRect (общая часть для DisplayRole и TSV).
+ *
+ * @details
+ * Функции разбора работают с QLatin1String как с невладеющим представлением
+ * байтов (указатель + длина) — так поля можно разбирать прямо из буфера
+ * чтения без создания QString на каждое поле.
+ *
+ * Принимаемые форматы совпадают с прежним MyModel::loadFromTsv():
+ * - цвет — всё, что понимает QColor ("#RRGGBB", "#AARRGGBB", имена SVG и т.п.);
+ * - стиль пера — "3", "Qt::PenStyle(3)" или "Qt::DotLine";
+ * - целые — десятичные числа со знаком в диапазоне int.
+ *
+ * Пробельные символы по краям поля игнорируются.
+ */
+namespace RectFormat {
+
+/**
+ * @brief Имя цвета "#rrggbb" (альфа-канал не выводится, как у QColor::name()).
+ */
+QString colorName(QRgb rgba);
+
+/**
+ * @brief Имя стиля пера: "Qt::DotLine" или "Qt::PenStyle(N)".
+ *
+ * @details
+ * Для 0..Qt::MPenStyle строка берётся из интернированной таблицы
+ * (без выделения памяти); arg() используется только вне диапазона enum.
+ */
+QString penStyleName(Qt::PenStyle style);
+
+/// Наибольшая длина результата formatInt() ("-2147483648").
+constexpr int kMaxIntSize = 11;
+
+/// Длина результата formatColor() ("#rrggbb").
+constexpr int kColorNameSize = 7;
+
+/**
+ * @brief Записывает имя цвета "#rrggbb" в @p out (ровно kColorNameSize байт).
+ *
+ * @details
+ * Байтовый аналог colorName(): тот же текст (строчные цифры, без альфы),
+ * но без QColor/QString.
+ *
+ * @return Указатель за последним записанным байтом.
+ */
+char* formatColor(QRgb rgba, char* out);
+
+/**
+ * @brief Имя стиля пера в виде байтов (тот же текст, что у penStyleName()).
+ *
+ * @details
+ * Представление указывает на статическую таблицу, действительную до конца
+ * программы. Стиль должен лежать в 0..Qt::MPenStyle (как в PackedRect).
+ */
+QLatin1String penStyleNameLatin1(Qt::PenStyle style);
+
+/**
+ * @brief Записывает десятичное представление @p value в @p out (не более kMaxIntSize байт).
+ *
+ * @details
+ * Тот же текст, что у QString::number(int), без выделений памяти.
+ *
+ * @return Указатель за последним записанным байтом.
+ */
+char* formatInt(qint32 value, char* out);
+
+/**
+ * @brief Разбирает стиль пера.
+ *
+ * @details
+ * Поддерживаем форматы:
+ * - "3"
+ * - "Qt::PenStyle(3)"
+ * - "Qt::DotLine"
+ *
+ * Числовые значения принимаются только в диапазоне 0..Qt::MPenStyle
+ * (модель хранит стиль одним байтом, см. PackedRect).
+ *
+ * @param text Текст поля.
+ * @param ok Если не nullptr, сюда пишется успешность разбора.
+ * @return Стиль; при ошибке — Qt::SolidLine.
+ */
+Qt::PenStyle parsePenStyle(QLatin1String text, bool* ok = nullptr);
+
+/**
+ * @brief Разбирает цвет пера.
+ *
+ * @details
+ * Быстрый путь — ровно то, что пишет saveToTsv(): "#rrggbb" (7 байт, регистр любой).
+ * Шесть шестнадцатеричных цифр декодируются через таблицу без ветвлений
+ * (проверка корректности — одна на все цифры). Всё остальное (имена SVG,
+ * "#rgb", "#aarrggbb", ...) разбирается общим парсером QColor.
+ *
+ * @param text Текст поля.
+ * @param rgba Сюда пишется цвет (#AARRGGBB) при успехе.
+ * @return true, если цвет распознан.
+ */
+bool parseColor(QLatin1String text, QRgb* rgba);
+
+/**
+ * @brief Разбирает десятичное целое со знаком.
+ *
+ * @details
+ * Работает прямо по байтам поля (в духе std::from_chars): без выделений
+ * памяти и без локали. Пробелы по краям допускаются, знак '+'/'-' — тоже.
+ *
+ * @param text Текст поля.
+ * @param ok Сюда пишется успешность разбора (переполнение int — ошибка).
+ * @return Значение; при ошибке — 0.
+ */
+int parseInt(QLatin1String text, bool* ok);
+
+} // namespace RectFormat
+
+#endif // RECTFORMAT_H
@@ -0,0 +1,58 @@
+#include "rectsnapshot.h"
+
+#include <utility>
+
+RectSnapshot::RectSnapshot(RectStore rows)
+    : m_rows(std::move(rows))
+{
+}
+
+int RectSnapshot::size() const
+{
+    return m_rows.size();
+}
+
+bool RectSnapshot::isEmpty() const
+{
+    return m_rows.isEmpty();
+}
+
+PackedRect RectSnapshot::at(int row) const
+{
+    return m_rows.at(row);
+}
+
+MyRect RectSnapshot::rectAt(int row) const
+{
+    return m_rows.at(row).toRect();
+}
+
+QRgb RectSnapshot::penColor(int row) const
+{
+    return m_rows.penColor(row);
+}
+
+quint8 RectSnapshot::penStyle(int row) const
+{
+    return m_rows.penStyle(row);
+}
+
+qint32 RectSnapshot::intValue(int row, Column c) const
+{
+    return m_rows.intValue(row, c);
+}
+
+qint64 RectSnapshot::totalArea() const
+{
+    return m_rows.totalArea();
+}
+
+QVector<int> RectSnapshot::rowsInRange(Column c, qint64 min, qint64 max) const
+{
+    return m_rows.rowsInRange(c, min, max);
+}
+
+const RectStore& RectSnapshot::rows() const
+{
+    return m_rows;
+}
@@ -0,0 +1,87 @@
+#ifndef RECTSNAPSHOT_H
+#define RECTSNAPSHOT_H
+
+#include <QVector>
+#include <QtGlobal>
+
+#include "myrect.h"
+#include "rectstore.h"
+
+/**
+ * @brief Неизменяемый снимок строк MyModel для чтения в других потоках.
+ *
+ * @details
+ * Снимок — копия хранилища модели с implicit sharing: данные не копируются,
+ * пока модель их не меняет. Снимок не даёт способа записи, поэтому его
+ * можно передать в рабочий поток и читать там без блокировок, пока поток
+ * GUI продолжает setData()/insertRows(): запись в модели отделяет её
+ * собственную копию, а данные снимка остаются прежними.
+ *
+ * Стоимость первой записи в модель после снимка зависит от раскладки:
+ * - RectStore::Layout::Chunks — копируется один блок из
+ *   RectChunks::kChunkRows строк, остальные блоки остаются общими;
+ * - Rows / Columns — копируется весь массив (или все массивы столбцов).
+ *
+ * Копии снимка дёшевы (счётчик ссылок) и тоже неизменяемы. Один и тот же
+ * снимок можно читать из нескольких потоков одновременно.
+ *
+ * @note Индексы строк не проверяются (как у RectStore).
+ */
+class RectSnapshot
+{
+public:
+    using Column = RectColumns::Column;
+
+    /**
+     * @brief Пустой снимок.
+     */
+    RectSnapshot() = default;
+
+    /**
+     * @brief Снимок строк @p rows (копия с implicit sharing).
+     */
+    explicit RectSnapshot(RectStore rows);
+
+    /// Количество строк.
+    int size() const;
+
+    /// Пуст ли снимок.
+    bool isEmpty() const;
+
+    /// Строка во внутреннем представлении.
+    PackedRect at(int row) const;
+
+    /// Строка как MyRect.
+    MyRect rectAt(int row) const;
+
+    /**
+     * @name Поля строки
+     * @{
+     */
+    QRgb penColor(int row) const;
+    quint8 penStyle(int row) const;
+
+    /**
+     * @warning @p c обязан удовлетворять RectColumns::isIntColumn().
+     */
+    qint32 intValue(int row, Column c) const;
+    /** @} */
+
+    /**
+     * @name Поколоночные проходы (как у RectStore)
+     * @{
+     */
+    qint64 totalArea() const;
+    QVector<int> rowsInRange(Column c, qint64 min, qint64 max) const;
+    /** @} */
+
+    /**
+     * @brief Строки снимка только для чтения (для алгоритмов над RectStore).
+     */
+    const RectStore& rows() const;
+
+private:
+    RectStore m_rows;
+};
+
+#endif // RECTSNAPSHOT_H
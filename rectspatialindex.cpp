@@ -0,0 +1,468 @@
+#include "rectspatialindex.h"
+
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// -------------------- Box / CellRange --------------------
+
+RectSpatialIndex::Box RectSpatialIndex::Box::of(const PackedRect& r)
+{
+    return of(r.left, r.top, r.width, r.height);
+}
+
+RectSpatialIndex::Box RectSpatialIndex::Box::of(qint64 left, qint64 top, qint64 width, qint64 height)
+{
+    Box b;
+    b.x1 = width < 0 ? left + width : left;
+    b.x2 = width < 0 ? left : left + width;
+    b.y1 = height < 0 ? top + height : top;
+    b.y2 = height < 0 ? top : top + height;
+    return b;
+}
+
+bool RectSpatialIndex::Box::isEmpty() const
+{
+    return x1 == x2 || y1 == y2;
+}
+
+bool RectSpatialIndex::Box::contains(qint64 x, qint64 y) const
+{
+    return x1 <= x && x < x2 && y1 <= y && y < y2;
+}
+
+bool RectSpatialIndex::Box::intersects(const Box& other) const
+{
+    return !isEmpty() && !other.isEmpty()
+        && x1 < other.x2 && other.x1 < x2
+        && y1 < other.y2 && other.y1 < y2;
+}
+
+double RectSpatialIndex::Box::distance2(qint64 x, qint64 y) const
+{
+    const qint64 dx = x < x1 ? x1 - x : (x > x2 ? x - x2 : 0);
+    const qint64 dy = y < y1 ? y1 - y : (y > y2 ? y - y2 : 0);
+    return double(dx) * double(dx) + double(dy) * double(dy);
+}
+
+bool RectSpatialIndex::Box::operator==(const Box& other) const
+{
+    return x1 == other.x1 && y1 == other.y1 && x2 == other.x2 && y2 == other.y2;
+}
+
+qint64 RectSpatialIndex::CellRange::count() const
+{
+    const qint64 w = cx2 - cx1 + 1;
+    const qint64 h = cy2 - cy1 + 1;
+    if (w > std::numeric_limits<qint64>::max() / h)
+        return std::numeric_limits<qint64>::max();
+    return w * h;
+}
+
+bool RectSpatialIndex::CellRange::operator==(const CellRange& other) const
+{
+    return cx1 == other.cx1 && cy1 == other.cy1 && cx2 == other.cx2 && cy2 == other.cy2;
+}
+
+// -------------------- cells --------------------
+
+/**
+ * @details
+ * Приведение к qint32 сохраняет порядок, поэтому точка и прямоугольник,
+ * которые её содержат, по-прежнему попадают в общую ячейку, а номера
+ * ячеек умещаются в 32 бита ключа.
+ */
+qint64 RectSpatialIndex::cellOf(qint64 v) const
+{
+    v = qBound(qint64(std::numeric_limits<qint32>::min()), v,
+               qint64(std::numeric_limits<qint32>::max()));
+    return v >= 0 ? v / m_cellSize : -((-v + m_cellSize - 1) / m_cellSize);
+}
+
+RectSpatialIndex::CellRange RectSpatialIndex::cellsOf(const Box& box) const
+{
+    return CellRange{cellOf(box.x1), cellOf(box.y1), cellOf(box.x2), cellOf(box.y2)};
+}
+
+quint64 RectSpatialIndex::cellKey(qint64 cx, qint64 cy)
+{
+    return (quint64(quint32(qint32(cx))) << 32) | quint32(qint32(cy));
+}
+
+void RectSpatialIndex::add(int id, const Box& box)
+{
+    const CellRange cells = cellsOf(box);
+    if (cells.count() > kMaxRectCells)
+    {
+        m_large.append(id);
+        return;
+    }
+
+    for (qint64 cy = cells.cy1; cy <= cells.cy2; ++cy)
+    {
+        for (qint64 cx = cells.cx1; cx <= cells.cx2; ++cx)
+            m_cells[cellKey(cx, cy)].append(id);
+    }
+
+    if (!m_hasExtent)
+    {
+        m_extent = cells;
+        m_hasExtent = true;
+        return;
+    }
+    m_extent.cx1 = qMin(m_extent.cx1, cells.cx1);
+    m_extent.cy1 = qMin(m_extent.cy1, cells.cy1);
+    m_extent.cx2 = qMax(m_extent.cx2, cells.cx2);
+    m_extent.cy2 = qMax(m_extent.cy2, cells.cy2);
+}
+
+void RectSpatialIndex::take(int id, const Box& box)
+{
+    // Порядок id в ячейке не важен: удаление — перестановкой последнего на место
+    const auto removeFrom = [id](QVector<int>& ids)
+    {
+        const int i = ids.indexOf(id);
+        if (i < 0)
+            return;
+        ids[i] = ids.last();
+        ids.removeLast();
+    };
+
+    const CellRange cells = cellsOf(box);
+    if (cells.count() > kMaxRectCells)
+    {
+        removeFrom(m_large);
+        return;
+    }
+
+    for (qint64 cy = cells.cy1; cy <= cells.cy2; ++cy)
+    {
+        for (qint64 cx = cells.cx1; cx <= cells.cx2; ++cx)
+        {
+            const auto it = m_cells.find(cellKey(cx, cy));
+            if (it == m_cells.end())
+                continue;
+            removeFrom(it.value());
+            if (it.value().isEmpty())
+                m_cells.erase(it);
+        }
+    }
+}
+
+// -------------------- build / edits --------------------
+
+/**
+ * @details
+ * Сторона ячейки — удвоенная медиана max(ширина, высота) непустых
+ * прямоугольников (медиана не сдвигается от нескольких огромных строк),
+ * но не меньше стороны, при которой на ячейку охвата данных приходится
+ * в среднем kTargetRowsPerCell строк: мелкие редкие прямоугольники
+ * иначе дали бы по ячейке на строку.
+ */
+void RectSpatialIndex::rebuild(const RectStore& rows)
+{
+    clear();
+
+    const int count = rows.size();
+    QVector<qint64> sizes;
+    sizes.reserve(count);
+    Box extent;
+    for (int row = 0; row < count; ++row)
+    {
+        const Box box = Box::of(rows.at(row));
+        if (box.isEmpty())
+            continue;
+
+        if (sizes.isEmpty())
+            extent = box;
+        extent.x1 = qMin(extent.x1, box.x1);
+        extent.y1 = qMin(extent.y1, box.y1);
+        extent.x2 = qMax(extent.x2, box.x2);
+        extent.y2 = qMax(extent.y2, box.y2);
+        sizes.append(qMax(box.x2 - box.x1, box.y2 - box.y1));
+    }
+
+    if (!sizes.isEmpty())
+    {
+        const auto median = sizes.begin() + sizes.size() / 2;
+        std::nth_element(sizes.begin(), median, sizes.end());
+
+        const double area = double(extent.x2 - extent.x1) * double(extent.y2 - extent.y1);
+        const qint64 dense = qint64(std::sqrt(area * kTargetRowsPerCell / sizes.size()));
+        m_cellSize = qBound(qint64(1), qMax(2 * *median, dense), qint64(1) << 30);
+    }
+    sizes = QVector<qint64>();
+
+    m_order.assign(count);
+    for (int row = 0; row < count; ++row)
+        add(row, Box::of(rows.at(row)));
+}
+
+void RectSpatialIndex::clear()
+{
+    m_cellSize = kDefaultCellSize;
+    m_cells.clear();
+    m_large.clear();
+    m_extent = CellRange{};
+    m_hasExtent = false;
+    m_order.clear();
+}
+
+int RectSpatialIndex::size() const
+{
+    return m_order.size();
+}
+
+qint64 RectSpatialIndex::cellSize() const
+{
+    return m_cellSize;
+}
+
+void RectSpatialIndex::insertRows(const RectStore& rows, int row, int count)
+{
+    const QVector<int> ids = m_order.insert(row, count);
+    for (int i = 0; i < ids.size(); ++i)
+        add(ids.at(i), Box::of(rows.at(row + i)));
+}
+
+void RectSpatialIndex::removeRows(const RectStore& rows, int row, int count)
+{
+    const QVector<int> ids = m_order.remove(row, count);
+    for (int i = 0; i < ids.size(); ++i)
+        take(ids.at(i), Box::of(rows.at(row + i)));
+}
+
+void RectSpatialIndex::moveRows(int sourceRow, int count, int destinationRow)
+{
+    m_order.move(sourceRow, count, destinationRow);
+}
+
+/**
+ * @details
+ * Правка, не выводящая строку за её ячейки (сдвиг на несколько пикселей),
+ * индекс не меняет.
+ */
+void RectSpatialIndex::updateRow(int row, const PackedRect& before, const PackedRect& after)
+{
+    const Box oldBox = Box::of(before);
+    const Box newBox = Box::of(after);
+    if (oldBox == newBox)
+        return;
+
+    const CellRange oldCells = cellsOf(oldBox);
+    const CellRange newCells = cellsOf(newBox);
+    const bool oldLarge = oldCells.count() > kMaxRectCells;
+    const bool newLarge = newCells.count() > kMaxRectCells;
+    if (oldLarge == newLarge && (oldLarge || oldCells == newCells))
+        return;
+
+    const int id = m_order.idAt(row);
+    take(id, oldBox);
+    add(id, newBox);
+}
+
+// -------------------- queries --------------------
+
+QVector<int> RectSpatialIndex::rowsAt(const RectStore& rows, const QPoint& point) const
+{
+    const qint64 x = point.x();
+    const qint64 y = point.y();
+
+    QVector<int> result;
+    const auto test = [&](int id)
+    {
+        const int row = m_order.rowOf(id);
+        if (Box::of(rows.at(row)).contains(x, y))
+            result.append(row);
+    };
+
+    const auto it = m_cells.constFind(cellKey(cellOf(x), cellOf(y)));
+    if (it != m_cells.cend())
+    {
+        for (int id : it.value())
+            test(id);
+    }
+    for (int id : m_large)
+        test(id);
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @details
+ * Общая точка строки и области лежит в ячейке, куда записаны обе, поэтому
+ * достаточно ячеек самой области. Если их больше, чем непустых ячеек сетки,
+ * дешевле перебрать непустые и отфильтровать по координатам.
+ */
+QVector<int> RectSpatialIndex::rowsIntersecting(const RectStore& rows, const QRect& area) const
+{
+    const Box box = Box::of(area.x(), area.y(), area.width(), area.height());
+    if (box.isEmpty())
+        return {};
+
+    QVector<int> result;
+    const auto test = [&](int id)
+    {
+        const int row = m_order.rowOf(id);
+        if (Box::of(rows.at(row)).intersects(box))
+            result.append(row);
+    };
+
+    // Ячейки точек области: правая/нижняя граница в неё не входит
+    const CellRange cells{cellOf(box.x1), cellOf(box.y1), cellOf(box.x2 - 1), cellOf(box.y2 - 1)};
+    if (cells.count() <= m_cells.size())
+    {
+        for (qint64 cy = cells.cy1; cy <= cells.cy2; ++cy)
+        {
+            for (qint64 cx = cells.cx1; cx <= cells.cx2; ++cx)
+            {
+                const auto it = m_cells.constFind(cellKey(cx, cy));
+                if (it == m_cells.cend())
+                    continue;
+                for (int id : it.value())
+                    test(id);
+            }
+        }
+    }
+    else
+    {
+        for (auto it = m_cells.cbegin(); it != m_cells.cend(); ++it)
+        {
+            const qint64 cx = qint32(quint32(it.key() >> 32));
+            const qint64 cy = qint32(quint32(it.key()));
+            if (cx < cells.cx1 || cx > cells.cx2 || cy < cells.cy1 || cy > cells.cy2)
+                continue;
+            for (int id : it.value())
+                test(id);
+        }
+    }
+    for (int id : m_large)
+        test(id);
+
+    // Строка из нескольких ячеек найдена несколько раз
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return result;
+}
+
+/**
+ * @details
+ * Кольцо радиуса r — ячейки на расстоянии ровно r (по Чебышёву) от ячейки
+ * точки. После просмотра колец 0..r любая ещё не найденная строка лежит
+ * целиком вне квадрата этих ячеек, т.е. не ближе его границы. Поиск
+ * останавливается, когда k-й кандидат строго ближе границы (при равенстве
+ * непросмотренная строка с меньшим номером могла бы его вытеснить).
+ *
+ * Кольца обрезаются по охвату занятых ячеек; если кольцо длиннее, чем
+ * непустых ячеек в сетке, оставшиеся ячейки просто перебираются.
+ */
+QVector<int> RectSpatialIndex::nearestRows(const RectStore& rows, const QPoint& point, int k) const
+{
+    if (k <= 0 || m_order.size() == 0)
+        return {};
+
+    const qint64 x = point.x();
+    const qint64 y = point.y();
+
+    struct Candidate
+    {
+        double distance2;
+        int row;
+    };
+    QVector<Candidate> candidates;
+    QSet<int> seen;
+    const auto consider = [&](int id)
+    {
+        if (seen.contains(id))
+            return;
+        seen.insert(id);
+        const int row = m_order.rowOf(id);
+        candidates.append(Candidate{Box::of(rows.at(row)).distance2(x, y), row});
+    };
+    const auto considerCell = [&](qint64 cx, qint64 cy)
+    {
+        const auto it = m_cells.constFind(cellKey(cx, cy));
+        if (it == m_cells.cend())
+            return;
+        for (int id : it.value())
+            consider(id);
+    };
+
+    for (int id : m_large)
+        consider(id);
+
+    if (m_hasExtent)
+    {
+        const qint64 qcx = cellOf(x);
+        const qint64 qcy = cellOf(y);
+
+        // Кольца до охвата занятых ячеек пусты
+        qint64 r = qMax(qMax(m_extent.cx1 - qcx, qcx - m_extent.cx2),
+                        qMax(m_extent.cy1 - qcy, qcy - m_extent.cy2));
+        r = qMax(r, qint64(0));
+
+        for (;; ++r)
+        {
+            if (8 * r + 1 > m_cells.size())
+            {
+                for (auto it = m_cells.cbegin(); it != m_cells.cend(); ++it)
+                {
+                    for (int id : it.value())
+                        consider(id);
+                }
+                break;
+            }
+
+            const qint64 left = qcx - r;
+            const qint64 right = qcx + r;
+            const qint64 top = qcy - r;
+            const qint64 bottom = qcy + r;
+            for (qint64 cy = qMax(top, m_extent.cy1); cy <= qMin(bottom, m_extent.cy2); ++cy)
+            {
+                if (cy == top || cy == bottom)
+                {
+                    for (qint64 cx = qMax(left, m_extent.cx1); cx <= qMin(right, m_extent.cx2); ++cx)
+                        considerCell(cx, cy);
+                    continue;
+                }
+                if (left >= m_extent.cx1)
+                    considerCell(left, cy);
+                if (right <= m_extent.cx2)
+                    considerCell(right, cy);
+            }
+
+            if (left <= m_extent.cx1 && right >= m_extent.cx2
+                && top <= m_extent.cy1 && bottom >= m_extent.cy2)
+                break;
+
+            if (candidates.size() >= k)
+            {
+                const qint64 bound = qMin(qMin(x - left * m_cellSize, (right + 1) * m_cellSize - x),
+                                          qMin(y - top * m_cellSize, (bottom + 1) * m_cellSize - y));
+                QVector<double> distances;
+                distances.reserve(candidates.size());
+                for (const Candidate& c : candidates)
+                    distances.append(c.distance2);
+                std::nth_element(distances.begin(), distances.begin() + (k - 1), distances.end());
+                if (distances.at(k - 1) < double(bound) * double(bound))
+                    break;
+            }
+        }
+    }
+
+    const auto closer = [](const Candidate& a, const Candidate& b)
+    {
+        return a.distance2 < b.distance2 || (a.distance2 == b.distance2 && a.row < b.row);
+    };
+    const int n = qMin(k, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end(), closer);
+
+    QVector<int> result;
+    result.reserve(n);
+    for (int i = 0; i < n; ++i)
+        result.append(candidates.at(i).row);
+    return result;
+}
@@ -0,0 +1,230 @@
+#ifndef RECTSPATIALINDEX_H
+#define RECTSPATIALINDEX_H
+
+#include <QHash>
+#include <QPoint>
+#include <QRect>
+#include <QVector>
+#include <QtGlobal>
+
+#include "packedrect.h"
+#include "rectcolumns.h"
+#include "rectstore.h"
+#include "rowidtree.h"
+
+/**
+ * @brief Пространственный индекс строк по геометрии (Left/Top/Width/Height).
+ *
+ * @details
+ * # Устройство
+ * Равномерная сетка квадратных ячеек со стороной cellSize(): строка
+ * записывается во все ячейки, которые задевает её прямоугольник. Хранятся
+ * только непустые ячейки (QHash по координатам ячейки), поэтому сетка
+ * не ограничена по площади и не зависит от разброса координат.
+ *
+ * Сторона ячейки выбирается при rebuild() — вдвое больше медианного
+ * размера прямоугольника (типичная строка попадает в 1–4 ячейки), а для
+ * мелких и редких прямоугольников — по плотности, около kTargetRowsPerCell
+ * строк на ячейку.
+ * Прямоугольники больше kMaxRectCells ячеек хранятся отдельным списком
+ * и проверяются в каждом запросе — иначе один огромный прямоугольник
+ * занял бы тысячи ячеек.
+ *
+ * Ячейки хранят не номера строк, а постоянные id (@ref RowIdTree):
+ * вставка, удаление и перенос строк сдвигают номера, но записи в ячейках
+ * не трогают. Запросы переводят id кандидатов в номера строк, берут их
+ * геометрию из самого хранилища и проверяют точно.
+ *
+ * # Геометрия
+ * Строка занимает [left, left + width) × [top, top + height), как QRect;
+ * отрицательные ширина и высота отсчитываются от left/top в другую сторону.
+ * Прямоугольник нулевой ширины или высоты не содержит точек и ни с чем
+ * не пересекается, но участвует в поиске ближайших (как отрезок или точка).
+ *
+ * # Поддержка при правках
+ * - updateRow() — перенос строки между ячейками, O(ячеек строки);
+ * - insertRows(), removeRows() — запись или удаление самих строк,
+ *   O(count × ячеек строки + log n), в любом месте таблицы;
+ * - moveRows() — только порядок id, O(log n);
+ * - загрузка или правка «всего сразу» — rebuild(), O(n).
+ *
+ * Пока номера не сдвигались (загрузка, добавление в конец), id равен
+ * номеру строки и перевод бесплатен; первая сдвигающая правка строит
+ * дерево порядка за O(n), дальше перевод — O(log n) на кандидата.
+ *
+ * # Запросы
+ * - rowsAt(): одна ячейка сетки;
+ * - rowsIntersecting(): ячейки прямоугольника запроса (или все непустые,
+ *   если их меньше);
+ * - nearestRows(): обход колец ячеек вокруг точки, пока k-й найденный
+ *   не окажется ближе границы уже просмотренной области.
+ *
+ * @note Индексы строк не проверяются (как у RectStore).
+ */
+class RectSpatialIndex
+{
+public:
+    using Column = RectColumns::Column;
+
+    /// Сторона ячейки пустого индекса (и индекса из одних пустых прямоугольников).
+    static constexpr qint64 kDefaultCellSize = 64;
+
+    /// Среднее число строк на ячейку, под которое rebuild() выбирает сторону ячейки.
+    static constexpr int kTargetRowsPerCell = 8;
+
+    /// Прямоугольники, задевающие больше ячеек, хранятся вне сетки.
+    static constexpr qint64 kMaxRectCells = 16;
+
+    /**
+     * @brief Влияет ли столбец на положение строки в индексе.
+     */
+    static constexpr bool isGeometryColumn(Column c)
+    {
+        return c == Column::Left || c == Column::Top || c == Column::Width || c == Column::Height;
+    }
+
+    /**
+     * @brief Строит индекс заново по всем строкам @p rows (и выбирает сторону ячейки).
+     */
+    void rebuild(const RectStore& rows);
+
+    /// Удаляет все записи.
+    void clear();
+
+    /// Число проиндексированных строк.
+    int size() const;
+
+    /// Сторона ячейки сетки.
+    qint64 cellSize() const;
+
+    /**
+     * @name Поддержка при правках
+     * @{
+     */
+
+    /**
+     * @brief Строки [@p row, @p row + @p count) вставлены в @p rows (вызывать после вставки).
+     */
+    void insertRows(const RectStore& rows, int row, int count);
+
+    /**
+     * @brief Строки [@p row, @p row + @p count) удаляются из @p rows (вызывать до удаления:
+     *        нужна их геометрия).
+     */
+    void removeRows(const RectStore& rows, int row, int count);
+
+    /**
+     * @brief Строки перенесены (аргументы — как у RectStore::move()).
+     */
+    void moveRows(int sourceRow, int count, int destinationRow);
+
+    /**
+     * @brief Геометрия строки @p row изменилась с @p before на @p after.
+     */
+    void updateRow(int row, const PackedRect& before, const PackedRect& after);
+    /** @} */
+
+    /**
+     * @name Запросы (@p rows — то же хранилище, по которому ведётся индекс)
+     * @{
+     */
+
+    /**
+     * @brief Строки, прямоугольник которых содержит точку @p point.
+     *
+     * @return Номера строк по возрастанию.
+     */
+    QVector<int> rowsAt(const RectStore& rows, const QPoint& point) const;
+
+    /**
+     * @brief Строки, прямоугольник которых пересекается с @p area.
+     *
+     * @details
+     * @p area понимается как x/y/width/height (как и строки); пустая область
+     * ни с чем не пересекается.
+     *
+     * @return Номера строк по возрастанию.
+     */
+    QVector<int> rowsIntersecting(const RectStore& rows, const QRect& area) const;
+
+    /**
+     * @brief @p k строк, ближайших к точке @p point.
+     *
+     * @details
+     * Расстояние — евклидово от точки до прямоугольника (0, если точка
+     * внутри или на границе).
+     *
+     * @return Номера строк по возрастанию расстояния, при равенстве — по номеру;
+     *         не больше @p k (все строки, если их меньше).
+     */
+    QVector<int> nearestRows(const RectStore& rows, const QPoint& point, int k) const;
+    /** @} */
+
+private:
+    /// Нормализованный прямоугольник строки: [x1, x2) × [y1, y2).
+    struct Box
+    {
+        qint64 x1 = 0;
+        qint64 y1 = 0;
+        qint64 x2 = 0;
+        qint64 y2 = 0;
+
+        static Box of(const PackedRect& r);
+        static Box of(qint64 left, qint64 top, qint64 width, qint64 height);
+
+        bool isEmpty() const;
+        bool contains(qint64 x, qint64 y) const;
+        bool intersects(const Box& other) const;
+
+        /// Квадрат расстояния от точки до замкнутого прямоугольника [x1, x2] × [y1, y2].
+        double distance2(qint64 x, qint64 y) const;
+
+        bool operator==(const Box& other) const;
+    };
+
+    /// Диапазон ячеек [cx1, cx2] × [cy1, cy2] (включительно).
+    struct CellRange
+    {
+        qint64 cx1 = 0;
+        qint64 cy1 = 0;
+        qint64 cx2 = 0;
+        qint64 cy2 = 0;
+
+        /// Число ячеек (с насыщением, а не переполнением).
+        qint64 count() const;
+
+        bool operator==(const CellRange& other) const;
+    };
+
+    /// Ячейка координаты (координата сначала приводится к диапазону qint32).
+    qint64 cellOf(qint64 v) const;
+
+    /// Ячейки, которые задевает замкнутый прямоугольник [x1, x2] × [y1, y2].
+    CellRange cellsOf(const Box& box) const;
+
+    static quint64 cellKey(qint64 cx, qint64 cy);
+
+    /// Записывает id строки в ячейки (или в список больших прямоугольников).
+    void add(int id, const Box& box);
+
+    /// Убирает запись, сделанную add() с тем же @p box.
+    void take(int id, const Box& box);
+
+    /// Сторона ячейки.
+    qint64 m_cellSize = kDefaultCellSize;
+
+    /// Непустые ячейки: ключ — cellKey(), значение — id строк (без порядка).
+    QHash<quint64, QVector<int>> m_cells;
+
+    /// id строк, прямоугольник которых задевает больше kMaxRectCells ячеек.
+    QVector<int> m_large;
+
+    /// Охват занятых ячеек (только растёт до следующего rebuild()).
+    CellRange m_extent;
+    bool m_hasExtent = false;
+
+    /// Порядок строк: номер строки <-> id в ячейках.
+    RowIdTree m_order;
+};
+
+#endif // RECTSPATIALINDEX_H
@@ -0,0 +1,649 @@
+#include "rectstore.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+// -------------------- helpers --------------------
+
+namespace {
+
+/**
+ * @brief Одно-проходное удаление диапазонов из массива (см. RectStore::removeRanges()).
+ *
+ * @details
+ * Блок оставшихся строк между диапазонами i и i+1 переносится на позицию
+ * записи; источник всегда правее приёмника, поэтому std::move вперёд
+ * корректен и для перекрывающихся областей (для тривиальных типов — memmove).
+ */
+template <typename T>
+void compactRanges(QVector<T>& v, const QVector<RectStore::Range>& ranges)
+{
+    T* data = v.data();
+    const int size = v.size();
+
+    int write = ranges.first().first;
+    for (int i = 0; i < ranges.size(); ++i)
+    {
+        const int keepBegin = ranges[i].first + ranges[i].count;
+        const int keepEnd = i + 1 < ranges.size() ? ranges[i + 1].first : size;
+        std::move(data + keepBegin, data + keepEnd, data + write);
+        write += keepEnd - keepBegin;
+    }
+
+    v.resize(write);
+}
+
+/**
+ * @brief Вставка блока @p block в массив перед позицией @p row (одно раздвижение хвоста).
+ */
+template <typename T>
+void insertBlock(QVector<T>& v, int row, const QVector<T>& block)
+{
+    v.insert(row, block.size(), T{});
+    std::copy(block.cbegin(), block.cend(), v.begin() + row);
+}
+
+/**
+ * @brief Перенос блока строк поворотом участка (см. RectStore::move()).
+ *
+ * @details
+ * Вниз: участок [source, destination) поворачивается так, что блок уходит
+ * в его конец; вверх: участок [destination, source + count) — блок встаёт
+ * в начало. Строки вне участка не трогаются.
+ */
+template <typename T>
+void rotateBlock(QVector<T>& v, int source, int count, int destination)
+{
+    T* data = v.data();
+    if (destination > source)
+        std::rotate(data + source, data + source + count, data + destination);
+    else
+        std::rotate(data + destination, data + source, data + source + count);
+}
+
+} // namespace
+
+/**
+ * @brief Индекс массива в m_ints для целочисленного столбца.
+ */
+int RectStore::intColumnIndex(Column c)
+{
+    Q_ASSERT(RectColumns::isIntColumn(c));
+    return static_cast<int>(c) - static_cast<int>(Column::PenWidth);
+}
+
+/**
+ * @brief Указатель на поле PackedRect для целочисленного столбца.
+ */
+qint32 PackedRect::* RectStore::intMember(Column c)
+{
+    switch (c)
+    {
+    case Column::PenWidth: return &PackedRect::penWidth;
+    case Column::Left:     return &PackedRect::left;
+    case Column::Top:      return &PackedRect::top;
+    case Column::Width:    return &PackedRect::width;
+    case Column::Height:   return &PackedRect::height;
+    case Column::PenColor:
+    case Column::PenStyle:
+    case Column::Count:
+        break;
+    }
+    Q_ASSERT_X(false, "RectStore::intMember", "not an integer column");
+    return &PackedRect::penWidth;
+}
+
+// -------------------- ctor / layout --------------------
+
+RectStore::RectStore(Layout layout)
+    : m_layout(layout)
+{
+}
+
+RectStore::Layout RectStore::layout() const
+{
+    return m_layout;
+}
+
+/**
+ * @brief Переключение раскладки.
+ *
+ * @details
+ * Данные переносятся через временное хранилище новой раскладки,
+ * затем старые массивы освобождаются (swap с пустыми).
+ */
+void RectStore::setLayout(Layout layout)
+{
+    if (layout == m_layout)
+        return;
+
+    RectStore converted(layout);
+    const int n = size();
+    converted.reserve(n);
+    for (int row = 0; row < n; ++row)
+        converted.append(at(row));
+
+    *this = std::move(converted);
+}
+
+int RectStore::size() const
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    return m_rows.size();
+    case Layout::Columns: return m_penColor.size();
+    case Layout::Chunks:  return m_chunks.size();
+    }
+    return 0;
+}
+
+bool RectStore::isEmpty() const
+{
+    return size() == 0;
+}
+
+void RectStore::clear()
+{
+    m_rows.clear();
+    m_penColor.clear();
+    m_penStyle.clear();
+    for (QVector<qint32>& column : m_ints)
+        column.clear();
+    m_chunks.clear();
+}
+
+void RectStore::reserve(int count)
+{
+    if (m_layout == Layout::Rows)
+    {
+        m_rows.reserve(count);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.reserve(count);
+        return;
+    }
+
+    m_penColor.reserve(count);
+    m_penStyle.reserve(count);
+    for (QVector<qint32>& column : m_ints)
+        column.reserve(count);
+}
+
+// -------------------- whole rows --------------------
+
+PackedRect RectStore::at(int row) const
+{
+    if (m_layout == Layout::Rows)
+        return m_rows.at(row);
+    if (m_layout == Layout::Chunks)
+        return m_chunks.at(row);
+
+    PackedRect r;
+    r.penColor = m_penColor.at(row);
+    r.penStyle = m_penStyle.at(row);
+    r.penWidth = m_ints[0].at(row);
+    r.left     = m_ints[1].at(row);
+    r.top      = m_ints[2].at(row);
+    r.width    = m_ints[3].at(row);
+    r.height   = m_ints[4].at(row);
+    return r;
+}
+
+void RectStore::set(int row, const PackedRect& r)
+{
+    if (m_layout == Layout::Rows)
+    {
+        m_rows[row] = r;
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks[row] = r;
+        return;
+    }
+
+    m_penColor[row] = r.penColor;
+    m_penStyle[row] = r.penStyle;
+    m_ints[0][row]  = r.penWidth;
+    m_ints[1][row]  = r.left;
+    m_ints[2][row]  = r.top;
+    m_ints[3][row]  = r.width;
+    m_ints[4][row]  = r.height;
+}
+
+void RectStore::append(const PackedRect& r)
+{
+    if (m_layout == Layout::Rows)
+    {
+        m_rows.append(r);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.append(r);
+        return;
+    }
+
+    m_penColor.append(r.penColor);
+    m_penStyle.append(r.penStyle);
+    m_ints[0].append(r.penWidth);
+    m_ints[1].append(r.left);
+    m_ints[2].append(r.top);
+    m_ints[3].append(r.width);
+    m_ints[4].append(r.height);
+}
+
+void RectStore::append(const RectStore& other)
+{
+    if (other.m_layout != m_layout)
+    {
+        const int n = other.size();
+        reserve(size() + n);
+        for (int row = 0; row < n; ++row)
+            append(other.at(row));
+        return;
+    }
+
+    if (m_layout == Layout::Rows)
+    {
+        m_rows += other.m_rows;
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.append(other.m_chunks, 0, other.size());
+        return;
+    }
+
+    m_penColor += other.m_penColor;
+    m_penStyle += other.m_penStyle;
+    for (std::size_t i = 0; i < m_ints.size(); ++i)
+        m_ints[i] += other.m_ints[i];
+}
+
+void RectStore::append(const PackedRect* rows, int count)
+{
+    if (count <= 0)
+        return;
+
+    if (m_layout == Layout::Rows)
+    {
+        const int oldSize = m_rows.size();
+        m_rows.resize(oldSize + count);
+        std::memcpy(m_rows.data() + oldSize, rows, sizeof(PackedRect) * static_cast<std::size_t>(count));
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.append(rows, count);
+        return;
+    }
+
+    reserve(size() + count);
+    for (int i = 0; i < count; ++i)
+        append(rows[i]);
+}
+
+void RectStore::insert(int row, int count, const PackedRect& value)
+{
+    if (m_layout == Layout::Rows)
+    {
+        m_rows.insert(row, count, value);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.insert(row, count, value);
+        return;
+    }
+
+    m_penColor.insert(row, count, value.penColor);
+    m_penStyle.insert(row, count, value.penStyle);
+    m_ints[0].insert(row, count, value.penWidth);
+    m_ints[1].insert(row, count, value.left);
+    m_ints[2].insert(row, count, value.top);
+    m_ints[3].insert(row, count, value.width);
+    m_ints[4].insert(row, count, value.height);
+}
+
+void RectStore::insert(int row, const RectStore& rows)
+{
+    if (rows.isEmpty())
+        return;
+
+    if (rows.m_layout != m_layout)
+    {
+        insert(row, rows.size(), PackedRect{});
+        for (int i = 0; i < rows.size(); ++i)
+            set(row + i, rows.at(i));
+        return;
+    }
+
+    if (m_layout == Layout::Rows)
+    {
+        insertBlock(m_rows, row, rows.m_rows);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.insert(row, rows.m_chunks);
+        return;
+    }
+
+    insertBlock(m_penColor, row, rows.m_penColor);
+    insertBlock(m_penStyle, row, rows.m_penStyle);
+    for (std::size_t i = 0; i < m_ints.size(); ++i)
+        insertBlock(m_ints[i], row, rows.m_ints[i]);
+}
+
+RectStore RectStore::mid(int row, int count) const
+{
+    RectStore result(m_layout);
+    if (m_layout == Layout::Rows)
+    {
+        result.m_rows = m_rows.mid(row, count);
+        return result;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        result.m_chunks.append(m_chunks, row, count);
+        return result;
+    }
+
+    result.m_penColor = m_penColor.mid(row, count);
+    result.m_penStyle = m_penStyle.mid(row, count);
+    for (std::size_t i = 0; i < m_ints.size(); ++i)
+        result.m_ints[i] = m_ints[i].mid(row, count);
+    return result;
+}
+
+void RectStore::remove(int row, int count)
+{
+    if (m_layout == Layout::Rows)
+    {
+        m_rows.remove(row, count);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.remove(row, count);
+        return;
+    }
+
+    m_penColor.remove(row, count);
+    m_penStyle.remove(row, count);
+    for (auto& column : m_ints)
+        column.remove(row, count);
+}
+
+void RectStore::removeRanges(const QVector<Range>& ranges)
+{
+    if (ranges.isEmpty())
+        return;
+
+    if (m_layout == Layout::Rows)
+    {
+        compactRanges(m_rows, ranges);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        // Оставшиеся блоки строк между диапазонами — в новое хранилище, O(n)
+        RectChunks kept;
+        kept.reserve(size());
+        int from = 0;
+        for (const Range& r : ranges)
+        {
+            kept.append(m_chunks, from, r.first - from);
+            from = r.first + r.count;
+        }
+        kept.append(m_chunks, from, size() - from);
+        m_chunks = std::move(kept);
+        return;
+    }
+
+    compactRanges(m_penColor, ranges);
+    compactRanges(m_penStyle, ranges);
+    for (auto& column : m_ints)
+        compactRanges(column, ranges);
+}
+
+void RectStore::move(int sourceRow, int count, int destinationRow)
+{
+    Q_ASSERT(destinationRow < sourceRow || destinationRow > sourceRow + count);
+
+    if (m_layout == Layout::Rows)
+    {
+        rotateBlock(m_rows, sourceRow, count, destinationRow);
+        return;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        m_chunks.move(sourceRow, count, destinationRow);
+        return;
+    }
+
+    rotateBlock(m_penColor, sourceRow, count, destinationRow);
+    rotateBlock(m_penStyle, sourceRow, count, destinationRow);
+    for (auto& column : m_ints)
+        rotateBlock(column, sourceRow, count, destinationRow);
+}
+
+QVector<RectStore::Range> RectStore::toRanges(QVector<int> rows, int size)
+{
+    std::sort(rows.begin(), rows.end());
+
+    QVector<Range> ranges;
+    for (const int row : rows)
+    {
+        if (row < 0 || row >= size)
+            continue;
+
+        if (!ranges.isEmpty())
+        {
+            Range& last = ranges.last();
+            const int end = last.first + last.count;
+            if (row < end)
+                continue;
+            if (row == end)
+            {
+                ++last.count;
+                continue;
+            }
+        }
+
+        ranges.append(Range{row, 1});
+    }
+
+    return ranges;
+}
+
+// -------------------- single fields --------------------
+
+QRgb RectStore::penColor(int row) const
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    return m_rows.at(row).penColor;
+    case Layout::Columns: return m_penColor.at(row);
+    case Layout::Chunks:  return m_chunks.at(row).penColor;
+    }
+    return 0;
+}
+
+quint8 RectStore::penStyle(int row) const
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    return m_rows.at(row).penStyle;
+    case Layout::Columns: return m_penStyle.at(row);
+    case Layout::Chunks:  return m_chunks.at(row).penStyle;
+    }
+    return 0;
+}
+
+qint32 RectStore::intValue(int row, Column c) const
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    return m_rows.at(row).*intMember(c);
+    case Layout::Columns: return m_ints[static_cast<std::size_t>(intColumnIndex(c))].at(row);
+    case Layout::Chunks:  return m_chunks.at(row).*intMember(c);
+    }
+    return 0;
+}
+
+void RectStore::setPenColor(int row, QRgb value)
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    m_rows[row].penColor = value; break;
+    case Layout::Columns: m_penColor[row] = value; break;
+    case Layout::Chunks:  m_chunks[row].penColor = value; break;
+    }
+}
+
+void RectStore::setPenStyle(int row, quint8 value)
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    m_rows[row].penStyle = value; break;
+    case Layout::Columns: m_penStyle[row] = value; break;
+    case Layout::Chunks:  m_chunks[row].penStyle = value; break;
+    }
+}
+
+void RectStore::setIntValue(int row, Column c, qint32 value)
+{
+    switch (m_layout)
+    {
+    case Layout::Rows:    m_rows[row].*intMember(c) = value; break;
+    case Layout::Columns: m_ints[static_cast<std::size_t>(intColumnIndex(c))][row] = value; break;
+    case Layout::Chunks:  m_chunks[row].*intMember(c) = value; break;
+    }
+}
+
+// -------------------- column scans --------------------
+
+/**
+ * @brief Сумма площадей.
+ *
+ * @details
+ * В раскладке Columns читаются только массивы Width и Height — простой
+ * цикл по двум указателям, который компилятор векторизует.
+ */
+qint64 RectStore::totalArea() const
+{
+    const int n = size();
+    qint64 sum = 0;
+
+    if (m_layout == Layout::Rows)
+    {
+        const PackedRect* rows = m_rows.constData();
+        for (int i = 0; i < n; ++i)
+            sum += qint64(rows[i].width) * rows[i].height;
+        return sum;
+    }
+    if (m_layout == Layout::Chunks)
+    {
+        for (int c = 0; c < m_chunks.chunkCount(); ++c)
+        {
+            const QVector<PackedRect>& chunk = m_chunks.chunk(c);
+            const PackedRect* rows = chunk.constData();
+            for (int i = 0; i < chunk.size(); ++i)
+                sum += qint64(rows[i].width) * rows[i].height;
+        }
+        return sum;
+    }
+
+    const qint32* w = m_ints[static_cast<std::size_t>(intColumnIndex(Column::Width))].constData();
+    const qint32* h = m_ints[static_cast<std::size_t>(intColumnIndex(Column::Height))].constData();
+    for (int i = 0; i < n; ++i)
+        sum += qint64(w[i]) * h[i];
+    return sum;
+}
+
+qint64 RectStore::key(int row, Column c) const
+{
+    switch (c)
+    {
+    case Column::PenColor: return penColor(row);
+    case Column::PenStyle: return penStyle(row);
+    case Column::PenWidth:
+    case Column::Left:
+    case Column::Top:
+    case Column::Width:
+    case Column::Height:
+        return intValue(row, c);
+    case Column::Count:
+        break;
+    }
+    return 0;
+}
+
+/**
+ * @brief Значения столбца в массив ключей.
+ *
+ * @details
+ * Для раскладки Columns и целочисленных столбцов — прямой проход
+ * по непрерывному массиву; в остальных случаях — через key().
+ */
+void RectStore::collectKeys(Column c, QVector<qint64>& keys) const
+{
+    const int n = size();
+    keys.resize(n);
+    qint64* out = keys.data();
+
+    if (m_layout == Layout::Columns && RectColumns::isIntColumn(c))
+    {
+        const qint32* in = m_ints[static_cast<std::size_t>(intColumnIndex(c))].constData();
+        for (int i = 0; i < n; ++i)
+            out[i] = in[i];
+        return;
+    }
+
+    for (int i = 0; i < n; ++i)
+        out[i] = key(i, c);
+}
+
+QVector<int> RectStore::rowsInRange(Column c, qint64 min, qint64 max) const
+{
+    QVector<int> result;
+    const int n = size();
+
+    if (m_layout == Layout::Columns && RectColumns::isIntColumn(c))
+    {
+        const qint32* in = m_ints[static_cast<std::size_t>(intColumnIndex(c))].constData();
+        for (int i = 0; i < n; ++i)
+        {
+            if (in[i] >= min && in[i] <= max)
+                result.append(i);
+        }
+        return result;
+    }
+
+    for (int i = 0; i < n; ++i)
+    {
+        const qint64 v = key(i, c);
+        if (v >= min && v <= max)
+            result.append(i);
+    }
+    return result;
+}
+
+QVector<int> RectStore::rowOrderBy(Column c) const
+{
+    QVector<qint64> keys;
+    collectKeys(c, keys);
+
+    QVector<int> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    const qint64* k = keys.constData();
+    std::stable_sort(order.begin(), order.end(),
+                     [k](int a, int b) { return k[a] < k[b]; });
+    return order;
+}
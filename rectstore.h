@@ -0,0 +1,272 @@
+#ifndef RECTSTORE_H
+#define RECTSTORE_H
+
+#include <QRgb>
+#include <QVector>
+#include <QtGlobal>
+
+#include <array>
+
+#include "packedrect.h"
+#include "rectchunks.h"
+#include "rectcolumns.h"
+
+/**
+ * @brief Хранилище строк MyModel с выбираемой раскладкой в памяти.
+ *
+ * @details
+ * # Раскладки
+ * - Layout::Rows (по умолчанию) — массив структур: QVector<PackedRect>.
+ *   Строка целиком лежит в одной кэш-линии — удобно для data()/setData() по строке.
+ * - Layout::Columns — структура массивов: каждый столбец из RectColumns::kColumns
+ *   хранится в собственном непрерывном QVector (QRgb / quint8 / qint32).
+ *   Поколоночные проходы (сортировка по Left, фильтр по Width, сумма площадей)
+ *   читают только нужные массивы и сводятся к линейным векторизуемым циклам.
+ * - Layout::Chunks — строки блоками до RectChunks::kChunkRows с индексом
+ *   размеров блоков. Вставка и удаление в любом месте раздвигают один блок
+ *   (O(kChunkRows + log n); при делении, слиянии или удалении блоков ещё
+ *   O(n / kChunkRows) на список блоков и индекс), а не весь хвост массива,
+ *   как в Rows/Columns.
+ *   Каждый блок разделяется копиями отдельно: копия хранилища (снимок для
+ *   другого потока, см. RectSnapshot) стоит O(n / kChunkRows), а запись
+ *   после копирования отделяет один блок, а не весь массив.
+ *
+ * Интерфейс одинаков для всех раскладок: модель работает с хранилищем
+ * через доступ к полям по (row, Column) и не знает, как лежат данные.
+ *
+ * @note Индексы строк не проверяются (как у QVector::operator[]):
+ *       проверка диапазонов — ответственность модели.
+ */
+class RectStore
+{
+public:
+    /// Раскладка данных в памяти.
+    enum class Layout
+    {
+        Rows,    ///< Массив структур (QVector<PackedRect>).
+        Columns, ///< Структура массивов (столбец = непрерывный массив).
+        Chunks   ///< Строки блоками с разделением копий по блокам (RectChunks).
+    };
+
+    using Column = RectColumns::Column;
+
+    /**
+     * @brief Непрерывный диапазон строк [first, first + count).
+     */
+    struct Range
+    {
+        int first = 0;
+        int count = 0;
+    };
+
+    /**
+     * @brief Превращает набор номеров строк в упорядоченные непересекающиеся диапазоны.
+     *
+     * @details
+     * Номера сортируются, повторы и номера вне [0, @p size) отбрасываются,
+     * соседние номера сливаются в один диапазон; между диапазонами всегда
+     * есть хотя бы одна строка.
+     *
+     * @param rows Номера строк в любом порядке.
+     * @param size Число строк хранилища.
+     */
+    static QVector<Range> toRanges(QVector<int> rows, int size);
+
+    /**
+     * @brief Создаёт пустое хранилище с заданной раскладкой.
+     */
+    explicit RectStore(Layout layout = Layout::Rows);
+
+    /**
+     * @brief Текущая раскладка.
+     */
+    Layout layout() const;
+
+    /**
+     * @brief Переключает раскладку с переносом данных (O(n)).
+     *
+     * @details
+     * Содержимое и порядок строк сохраняются; память старой раскладки освобождается.
+     */
+    void setLayout(Layout layout);
+
+    /// Количество строк.
+    int size() const;
+
+    /// Пусто ли хранилище.
+    bool isEmpty() const;
+
+    /// Удаляет все строки (раскладка сохраняется).
+    void clear();
+
+    /// Резервирует место под @p count строк.
+    void reserve(int count);
+
+    /**
+     * @name Доступ к строке целиком
+     * @{
+     */
+    PackedRect at(int row) const;
+    void set(int row, const PackedRect& r);
+    void append(const PackedRect& r);
+
+    /**
+     * @brief Вставляет @p count копий @p value перед строкой @p row.
+     */
+    void insert(int row, int count, const PackedRect& value);
+
+    /**
+     * @brief Вставляет все строки @p rows (в их порядке) перед строкой @p row.
+     *
+     * @details
+     * При одинаковой раскладке массивы копируются блоками, иначе строки
+     * переносятся по одной.
+     */
+    void insert(int row, const RectStore& rows);
+
+    /**
+     * @brief Копия строк [@p row, @p row + @p count) в той же раскладке.
+     */
+    RectStore mid(int row, int count) const;
+
+    /**
+     * @brief Удаляет строки [@p row, @p row + @p count) (хвост сдвигается один раз).
+     */
+    void remove(int row, int count);
+
+    /**
+     * @brief Удаляет несколько диапазонов строк за один проход.
+     *
+     * @details
+     * Оставшиеся строки сдвигаются к началу блоками между диапазонами
+     * (memmove), каждая — не более одного раза: O(n) независимо от числа
+     * диапазонов, тогда как remove() по каждому диапазону — O(n) на диапазон.
+     *
+     * @param ranges Диапазоны в порядке возрастания, непересекающиеся (см. toRanges()).
+     */
+    void removeRanges(const QVector<Range>& ranges);
+
+    /**
+     * @brief Переносит строки [@p sourceRow, @p sourceRow + @p count) так,
+     *        чтобы они оказались перед строкой @p destinationRow.
+     *
+     * @details
+     * Номер @p destinationRow — в нумерации до переноса (как у
+     * QAbstractItemModel::beginMoveRows()).
+     * - Layout::Rows / Layout::Columns — поворот (std::rotate) участка между
+     *   блоком и местом назначения на месте: сдвигаются только строки этого
+     *   участка, без копии всего массива и без выделения памяти.
+     * - Layout::Chunks — блок копируется во временный RectChunks, удаляется
+     *   и вставляется на новое место (RectChunks::move()): O(count + kChunkRows + n / kChunkRows)
+     *   с выделением памяти под копию блока, остальные строки не сдвигаются.
+     *
+     * @warning @p destinationRow не должен лежать в [sourceRow, sourceRow + count].
+     */
+    void move(int sourceRow, int count, int destinationRow);
+
+    /**
+     * @brief Добавляет в конец все строки @p other (в его порядке).
+     *
+     * @details
+     * При одинаковой раскладке массивы склеиваются целиком (memcpy; для
+     * Layout::Chunks — дописыванием блоков, RectChunks::append()),
+     * иначе строки переносятся по одной.
+     */
+    void append(const RectStore& other);
+
+    /**
+     * @brief Добавляет в конец @p count строк из непрерывного массива @p rows.
+     *
+     * @details
+     * Для Layout::Rows — одно копирование блока памяти (memcpy),
+     * для Layout::Columns — раскладка по столбцам за один проход,
+     * для Layout::Chunks — дозаполнение последнего блока и новые блоки
+     * по RectChunks::kChunkRows строк (копирование кусками, без сдвига
+     * существующих строк).
+     */
+    void append(const PackedRect* rows, int count);
+    /** @} */
+
+    /**
+     * @name Доступ к отдельным полям
+     * @{
+     */
+    QRgb penColor(int row) const;
+    quint8 penStyle(int row) const;
+
+    /**
+     * @brief Значение целочисленного столбца (PenWidth/Left/Top/Width/Height).
+     *
+     * @warning @p c обязан удовлетворять RectColumns::isIntColumn().
+     */
+    qint32 intValue(int row, Column c) const;
+
+    void setPenColor(int row, QRgb value);
+    void setPenStyle(int row, quint8 value);
+    void setIntValue(int row, Column c, qint32 value);
+    /** @} */
+
+    /**
+     * @name Поколоночные проходы
+     * @{
+     */
+
+    /**
+     * @brief Сумма площадей (width * height) всех строк в 64-битной арифметике.
+     */
+    qint64 totalArea() const;
+
+    /**
+     * @brief Номера строк, у которых значение столбца @p c лежит в [@p min, @p max].
+     *
+     * @details
+     * Для PenColor сравниваются значения QRgb, для PenStyle — числовое значение стиля.
+     * Строки возвращаются по возрастанию.
+     */
+    QVector<int> rowsInRange(Column c, qint64 min, qint64 max) const;
+
+    /**
+     * @brief Перестановка строк, упорядочивающая их по столбцу @p c (устойчивая сортировка).
+     *
+     * @return result[i] — номер строки, стоящей i-й в отсортированном порядке.
+     */
+    QVector<int> rowOrderBy(Column c) const;
+    /** @} */
+
+private:
+    /// Число целочисленных столбцов (PenWidth..Height).
+    static constexpr int kIntColumnCount =
+        static_cast<int>(Column::Count) - static_cast<int>(Column::PenWidth);
+
+    /// Номер массива в m_ints для целочисленного столбца.
+    static int intColumnIndex(Column c);
+
+    /// Поле PackedRect, соответствующее целочисленному столбцу.
+    static qint32 PackedRect::* intMember(Column c);
+
+    /// Значение любого столбца строки как qint64 (ключ для фильтра/сортировки).
+    qint64 key(int row, Column c) const;
+
+    /// Заполняет @p keys значениями столбца @p c для всех строк (линейный проход).
+    void collectKeys(Column c, QVector<qint64>& keys) const;
+
+private:
+    Layout m_layout;
+
+    /// Layout::Rows: строки целиком.
+    QVector<PackedRect> m_rows;
+
+    /// Layout::Columns: столбец PenColor.
+    QVector<QRgb> m_penColor;
+
+    /// Layout::Columns: столбец PenStyle.
+    QVector<quint8> m_penStyle;
+
+    /// Layout::Columns: столбцы PenWidth, Left, Top, Width, Height (в порядке Column).
+    std::array<QVector<qint32>, kIntColumnCount> m_ints;
+
+    /// Layout::Chunks: строки блоками.
+    RectChunks m_chunks;
+};
+
+#endif // RECTSTORE_H
@@ -0,0 +1,289 @@
+#include "rowidtree.h"
+
+// -------------------- tree primitives --------------------
+
+/**
+ * @details
+ * Перемешивание битов id (финализатор MurmurHash3): последовательные id
+ * получают независимые на вид приоритеты, и глубина дерева остаётся
+ * O(log n) ожидаемо.
+ */
+quint32 RowIdTree::priority(int id)
+{
+    quint32 h = quint32(id);
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+int RowIdTree::sizeOf(int node) const
+{
+    return node < 0 ? 0 : m_nodes.at(node).size;
+}
+
+void RowIdTree::update(int node)
+{
+    Node& n = m_nodes[node];
+    n.size = 1 + sizeOf(n.left) + sizeOf(n.right);
+    if (n.left >= 0)
+        m_nodes[n.left].parent = node;
+    if (n.right >= 0)
+        m_nodes[n.right].parent = node;
+}
+
+void RowIdTree::split(int node, int count, int& left, int& right)
+{
+    if (node < 0)
+    {
+        left = right = -1;
+        return;
+    }
+
+    const int leftSize = sizeOf(m_nodes.at(node).left);
+    if (count <= leftSize)
+    {
+        int rest = -1;
+        split(m_nodes.at(node).left, count, left, rest);
+        m_nodes[node].left = rest;
+        update(node);
+        right = node;
+    }
+    else
+    {
+        int rest = -1;
+        split(m_nodes.at(node).right, count - leftSize - 1, rest, right);
+        m_nodes[node].right = rest;
+        update(node);
+        left = node;
+    }
+
+    if (left >= 0) m_nodes[left].parent = -1;
+    if (right >= 0) m_nodes[right].parent = -1;
+}
+
+int RowIdTree::merge(int left, int right)
+{
+    if (left < 0) return right;
+    if (right < 0) return left;
+
+    if (priority(left) > priority(right))
+    {
+        m_nodes[left].right = merge(m_nodes.at(left).right, right);
+        update(left);
+        return left;
+    }
+    m_nodes[right].left = merge(left, m_nodes.at(right).left);
+    update(right);
+    return right;
+}
+
+/**
+ * @details
+ * Декартово дерево за один проход со стеком правой ветви; размеры
+ * поддеревьев досчитываются обходом в обратном порядке (потомок в ids
+ * всегда обрабатывается раньше, чем из стека уходит его предок).
+ */
+int RowIdTree::build(const QVector<int>& ids)
+{
+    QVector<int> stack;
+    QVector<int> order;   // узлы в порядке «снятия» со стека: дети раньше родителей
+    order.reserve(ids.size());
+
+    for (const int id : ids)
+    {
+        m_nodes[id] = Node{};
+        int last = -1;
+        while (!stack.isEmpty() && priority(stack.last()) < priority(id))
+        {
+            last = stack.takeLast();
+            order.append(last);
+        }
+        m_nodes[id].left = last;
+        if (!stack.isEmpty())
+            m_nodes[stack.last()].right = id;
+        stack.append(id);
+    }
+    while (!stack.isEmpty())
+        order.append(stack.takeLast());
+
+    for (const int node : order)
+        update(node);
+
+    if (order.isEmpty())
+        return -1;
+    m_nodes[order.last()].parent = -1;
+    return order.last();
+}
+
+void RowIdTree::collect(int node, QVector<int>& out) const
+{
+    QVector<int> stack;
+    while (node >= 0 || !stack.isEmpty())
+    {
+        while (node >= 0)
+        {
+            stack.append(node);
+            node = m_nodes.at(node).left;
+        }
+        node = stack.takeLast();
+        out.append(node);
+        node = m_nodes.at(node).right;
+    }
+}
+
+void RowIdTree::materialize()
+{
+    if (!m_identity)
+        return;
+
+    QVector<int> ids(m_count);
+    for (int i = 0; i < m_count; ++i)
+        ids[i] = i;
+    m_nodes.resize(m_count);
+    m_root = build(ids);
+    m_identity = false;
+}
+
+// -------------------- sequence --------------------
+
+void RowIdTree::assign(int count)
+{
+    clear();
+    m_count = count;
+}
+
+void RowIdTree::clear()
+{
+    m_nodes = QVector<Node>();
+    m_free = QVector<int>();
+    m_root = -1;
+    m_count = 0;
+    m_identity = true;
+}
+
+int RowIdTree::size() const
+{
+    return m_count;
+}
+
+QVector<int> RowIdTree::insert(int row, int count)
+{
+    QVector<int> ids;
+    if (count <= 0)
+        return ids;
+    ids.reserve(count);
+
+    if (m_identity && row == m_count)
+    {
+        for (int i = 0; i < count; ++i)
+            ids.append(m_count + i);
+        m_count += count;
+        return ids;
+    }
+
+    materialize();
+    while (ids.size() < count && !m_free.isEmpty())
+        ids.append(m_free.takeLast());
+    while (ids.size() < count)
+    {
+        ids.append(m_nodes.size());
+        m_nodes.append(Node{});
+    }
+
+    int left = -1;
+    int right = -1;
+    split(m_root, row, left, right);
+    m_root = merge(merge(left, build(ids)), right);
+    m_count += count;
+    return ids;
+}
+
+QVector<int> RowIdTree::remove(int row, int count)
+{
+    QVector<int> ids;
+    if (count <= 0)
+        return ids;
+    ids.reserve(count);
+
+    if (m_identity && row + count == m_count)
+    {
+        for (int i = row; i < m_count; ++i)
+            ids.append(i);
+        m_count = row;
+        return ids;
+    }
+
+    materialize();
+    int left = -1;
+    int middle = -1;
+    int right = -1;
+    split(m_root, row, left, middle);
+    split(middle, count, middle, right);
+    m_root = merge(left, right);
+
+    collect(middle, ids);
+    m_free += ids;
+    m_count -= count;
+    return ids;
+}
+
+void RowIdTree::move(int sourceRow, int count, int destinationRow)
+{
+    const int sourceEnd = sourceRow + count;
+    if (count <= 0 || (destinationRow >= sourceRow && destinationRow <= sourceEnd))
+        return;
+
+    materialize();
+    int left = -1;
+    int block = -1;
+    int right = -1;
+    split(m_root, sourceRow, left, block);
+    split(block, count, block, right);
+
+    // Место назначения — в нумерации без перенесённого блока
+    const int destination = destinationRow > sourceRow ? destinationRow - count : destinationRow;
+    split(merge(left, right), destination, left, right);
+    m_root = merge(merge(left, block), right);
+}
+
+int RowIdTree::idAt(int row) const
+{
+    if (m_identity)
+        return row;
+
+    int node = m_root;
+    for (;;)
+    {
+        const int leftSize = sizeOf(m_nodes.at(node).left);
+        if (row == leftSize)
+            return node;
+        if (row < leftSize)
+        {
+            node = m_nodes.at(node).left;
+        }
+        else
+        {
+            row -= leftSize + 1;
+            node = m_nodes.at(node).right;
+        }
+    }
+}
+
+int RowIdTree::rowOf(int id) const
+{
+    if (m_identity)
+        return id;
+
+    int row = sizeOf(m_nodes.at(id).left);
+    for (int node = id; m_nodes.at(node).parent >= 0;)
+    {
+        const int parent = m_nodes.at(node).parent;
+        if (m_nodes.at(parent).right == node)
+            row += sizeOf(m_nodes.at(parent).left) + 1;
+        node = parent;
+    }
+    return row;
+}
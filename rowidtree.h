@@ -0,0 +1,117 @@
+#ifndef ROWIDTREE_H
+#define ROWIDTREE_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/**
+ * @brief Порядок строк таблицы как последовательность постоянных идентификаторов.
+ *
+ * @details
+ * Строка получает id при вставке и сохраняет его, пока не удалена:
+ * вставки, удаления и переносы других строк меняют номер строки, но не её
+ * id. Поэтому структура, которая ссылается на строки по id (например,
+ * RectSpatialIndex), при сдвиге номеров не переписывается, а номер
+ * строки по id и id по номеру вычисляются здесь.
+ *
+ * # Устройство
+ * Декартово дерево по неявному ключу (treap): позиция id — число узлов
+ * левее него, у каждого узла — размер поддерева и ссылка на родителя.
+ * Узлы лежат в массиве, индекс узла и есть id; id удалённых строк
+ * переиспользуются. Приоритет узла — хэш id, поэтому не хранится.
+ *
+ * Пока номера строк ни разу не сдвигались (только добавление в конец
+ * и удаление с конца), id строки равен её номеру и дерево не строится
+ * вовсе: ни памяти, ни обращений. Первая правка, сдвигающая номера,
+ * строит его за O(n).
+ *
+ * # Сложность
+ * - idAt(), rowOf() — O(1) без сдвигов, иначе O(log n) (ожидаемо);
+ * - insert(), remove() — O(count + log n);
+ * - move() — O(log n).
+ *
+ * @note Номера строк не проверяются (как у RectStore).
+ */
+class RowIdTree
+{
+public:
+    /// Последовательность из @p count строк с id 0..count-1.
+    void assign(int count);
+
+    /// Удаляет все строки.
+    void clear();
+
+    /// Число строк.
+    int size() const;
+
+    /**
+     * @brief Вставляет @p count строк перед строкой @p row.
+     *
+     * @return id вставленных строк по порядку.
+     */
+    QVector<int> insert(int row, int count);
+
+    /**
+     * @brief Удаляет строки [@p row, @p row + @p count).
+     *
+     * @return id удалённых строк по порядку (дальше они могут достаться новым строкам).
+     */
+    QVector<int> remove(int row, int count);
+
+    /**
+     * @brief Переносит строки (аргументы — как у RectStore::move()).
+     */
+    void move(int sourceRow, int count, int destinationRow);
+
+    /// id строки @p row.
+    int idAt(int row) const;
+
+    /// Номер строки с id @p id.
+    int rowOf(int id) const;
+
+private:
+    struct Node
+    {
+        int left = -1;
+        int right = -1;
+        int parent = -1;
+        int size = 1;
+    };
+
+    /// Приоритет узла в куче treap.
+    static quint32 priority(int id);
+
+    int sizeOf(int node) const;
+
+    /// Пересчитывает размер узла и ссылки детей на него.
+    void update(int node);
+
+    /// Делит поддерево: первые @p count узлов — в @p left, остальные — в @p right.
+    void split(int node, int count, int& left, int& right);
+
+    /// Склеивает поддеревья (все узлы @p left раньше узлов @p right).
+    int merge(int left, int right);
+
+    /// Поддерево из узлов @p ids в данном порядке, O(count).
+    int build(const QVector<int>& ids);
+
+    /// Узлы поддерева по порядку.
+    void collect(int node, QVector<int>& out) const;
+
+    /// Строит дерево для id 0..size()-1 (выход из режима «id == номер»).
+    void materialize();
+
+    /// Узлы по id.
+    QVector<Node> m_nodes;
+
+    /// Свободные id (узлы удалённых строк).
+    QVector<int> m_free;
+
+    int m_root = -1;
+    int m_count = 0;
+
+    /// Номера строк не сдвигались: id == номер, m_nodes пуст.
+    bool m_identity = true;
+};
+
+#endif // ROWIDTREE_H
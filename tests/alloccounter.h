@@ -0,0 +1,81 @@
+// tests/alloccounter.h
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+/**
+ * @file alloccounter.h
+ * @brief Счётчик выделений динамической памяти для бенчмарков.
+ *
+ * @details
+ * Qt выделяет буферы QString/QByteArray/QVector через ::malloc (QArrayData),
+ * а не через operator new, поэтому считаем именно вызовы malloc/calloc/realloc.
+ *
+ * - glibc: перехватываем malloc/calloc/realloc и передаём в __libc_*;
+ *   operator new по умолчанию тоже идёт через malloc, поэтому учитывается.
+ * - прочие платформы (MinGW и т.п.): перехват недоступен,
+ *   AllocCounter::isAvailable() возвращает false, а бенчмарки пропускают подсчёт.
+ *
+ * @warning Подключать ровно в одну единицу трансляции исполняемого файла
+ *          (в бенчмарке это единственный .cpp).
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+
+namespace AllocCounter {
+
+/// Глобальный счётчик выделений (constant-initialized, безопасен до main()).
+inline std::atomic<unsigned long long> g_allocations { 0 };
+
+/**
+ * @brief Доступен ли подсчёт на текущей платформе.
+ */
+constexpr bool isAvailable()
+{
+#if defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Текущее значение счётчика.
+ */
+inline unsigned long long count()
+{
+    return g_allocations.load(std::memory_order_relaxed);
+}
+
+} // namespace AllocCounter
+
+#if defined(__GLIBC__)
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t n, std::size_t size);
+void* __libc_realloc(void* ptr, std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+    AllocCounter::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t n, std::size_t size) noexcept
+{
+    AllocCounter::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void* realloc(void* ptr, std::size_t size) noexcept
+{
+    AllocCounter::g_allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+} // extern "C"
+#endif
+
+#endif // ALLOCCOUNTER_H
@@ -0,0 +1,854 @@
+// tests/bench_mymodel.cpp
+/**
+ * @file bench_mymodel.cpp
+ * @brief Бенчмарки горячих путей MyModel (QtTest QBENCHMARK).
+ *
+ * @details
+ * Бенчмарки собираются отдельной целью (add_qt_benchmark) и не входят в CTest,
+ * т.к. работают на больших объёмах данных. Запуск:
+ *
+ *     ./build/tests/bench_mymodel
+ *
+ * Помимо времени (QBENCHMARK) часть бенчмарков печатает число выделений памяти
+ * на вызов (см. alloccounter.h) — для сравнения "до/после" используется
+ * эталонная реализация старого кода прямо в бенчмарке.
+ */
+
+#include <QtTest/QtTest>
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QIcon>
+#include <QTableView>
+#include <QTemporaryFile>
+#include <QTextStream>
+
+#include "alloccounter.h"
+#include "mymodel.h"
+
+namespace {
+
+constexpr int kColPenColor = 0;
+constexpr int kColPenStyle = 1;
+
+/// Число строк в модели для бенчмарков data().
+constexpr int kDataRows = 10000;
+
+/// Число различных цветов (типичная палитра реальных файлов).
+constexpr int kDistinctColors = 64;
+
+/// Число строк TSV для бенчмарков загрузки.
+constexpr int kTsvRows = 1000000;
+
+/// Источник данных для бенчмарка загрузки TSV.
+enum class TsvSource
+{
+    Legacy,     ///< Прежний разбор QTextStream + split из QBuffer.
+    Buffer,     ///< loadFromTsv(QIODevice&) из QBuffer.
+    FileStream, ///< loadFromTsv(fileName), TsvLoadMode::Stream.
+    FileMap     ///< loadFromTsv(fileName), TsvLoadMode::MemoryMap.
+};
+
+/**
+ * @brief Эталон "до": прежняя реализация penStyleToString() (switch + arg()).
+ */
+QString legacyPenStyleToString(Qt::PenStyle style)
+{
+    switch (style)
+    {
+    case Qt::NoPen:          return "Qt::NoPen";
+    case Qt::SolidLine:      return "Qt::SolidLine";
+    case Qt::DashLine:       return "Qt::DashLine";
+    case Qt::DotLine:        return "Qt::DotLine";
+    case Qt::DashDotLine:    return "Qt::DashDotLine";
+    case Qt::DashDotDotLine: return "Qt::DashDotDotLine";
+    default:
+        return QString("Qt::PenStyle(%1)").arg(static_cast<int>(style));
+    }
+}
+
+/**
+ * @brief Строка i тестового набора: цвет из палитры, стиль по кругу 0..6.
+ */
+MyRect sampleRect(int i)
+{
+    const int c = i % kDistinctColors;
+    return MyRect(QColor(c * 3, 255 - c * 2, c),
+                  static_cast<Qt::PenStyle>(i % 7),
+                  1 + i % 5, i, i * 2, 10 + i % 100, 20 + i % 50);
+}
+
+/**
+ * @brief Эталон "до": прежний разбор TSV (QTextStream::readLine + split + trimmed).
+ *
+ * @details
+ * Повторяет прежний MyModel::loadFromTsv() без сообщений об ошибках;
+ * стиль пера разбирается как число или имя.
+ */
+int legacyLoadTsv(QIODevice& in)
+{
+    QTextStream stream(&in);
+    QVector<MyRect> rows;
+
+    while (!stream.atEnd())
+    {
+        const QString line = stream.readLine();
+        if (line.trimmed().isEmpty())
+            continue;
+
+        const QStringList parts = line.split('\t', Qt::KeepEmptyParts);
+        if (parts.size() != 7)
+            return -1;
+
+        const QColor color(parts[0].trimmed());
+        bool ok = false;
+        int style = parts[1].trimmed().toInt(&ok);
+        if (!ok)
+        {
+            style = 0;
+            for (int s = 0; s <= static_cast<int>(Qt::CustomDashLine); ++s)
+            {
+                if (legacyPenStyleToString(static_cast<Qt::PenStyle>(s)) == parts[1].trimmed())
+                    style = s;
+            }
+        }
+
+        int v[5];
+        for (int i = 0; i < 5; ++i)
+            v[i] = parts[2 + i].trimmed().toInt(&ok);
+
+        rows.append(MyRect(color, static_cast<Qt::PenStyle>(style), v[0], v[1], v[2], v[3], v[4]));
+    }
+    return rows.size();
+}
+
+/**
+ * @brief Эталон "до": прежний saveToTsv() (QStringList на строку + join + QTextStream).
+ */
+void legacySaveTsv(const MyModel& model, QIODevice& out)
+{
+    QTextStream stream(&out);
+    for (int row = 0; row < model.rowCount(); ++row)
+    {
+        const MyRect r = model.rectAt(row);
+        QStringList fields;
+        fields << r.penColor.name();
+        fields << legacyPenStyleToString(r.penStyle);
+        fields << QString::number(r.penWidth);
+        fields << QString::number(r.left);
+        fields << QString::number(r.top);
+        fields << QString::number(r.width);
+        fields << QString::number(r.height);
+        stream << fields.join('\t') << '\n';
+    }
+    stream.flush();
+}
+
+/**
+ * @brief Печатает среднее число выделений на вызов.
+ */
+void reportAllocations(const char* what, unsigned long long allocs, int calls)
+{
+    qInfo("%s: %.3f allocations/call", what, double(allocs) / double(calls));
+}
+
+} // namespace
+
+/**
+ * @brief Бенчмарки MyModel.
+ */
+class BenchMyModel : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    // data(): DisplayRole / DecorationRole
+    void displayRole_allocations_before_after();
+    void displayRole_penColor();
+    void displayRole_penStyle();
+    void decorationRole_penColor();
+
+    // Пакетное добавление: appendRects() vs цикл slotAddData()
+    void append_batch_data();
+    void append_batch();
+
+    // Удаление разрозненных строк: removeRowsAt() vs цикл removeRows()
+    void remove_scattered_data();
+    void remove_scattered();
+
+    // Снимок + первая правка после него: Rows (копия всей таблицы) vs Chunks (один блок)
+    void snapshot_then_edit_data();
+    void snapshot_then_edit();
+
+    // Вставка строк в случайные места: Rows (сдвиг хвоста) vs Chunks (один блок)
+    void insert_random_data();
+    void insert_random();
+
+    // Запрос по точке: пространственный индекс vs полный перебор строк
+    void spatial_point_query_data();
+    void spatial_point_query();
+
+    // Загрузка TSV: прежний разбор vs TsvReader (поток / на месте / параллельно)
+    void tsv_load_data();
+    void tsv_load();
+
+    // Загрузка двоичного снимка (сравнить с tsv_load)
+    void binary_load();
+
+    // Сохранение TSV: прежняя запись vs TsvWriter (последовательно/параллельно)
+    void tsv_save_data();
+    void tsv_save();
+
+private:
+    MyModel* m = nullptr;
+};
+
+void BenchMyModel::initTestCase()
+{
+    m = new MyModel();
+    for (int i = 0; i < kDataRows; ++i)
+        m->slotAddData(sampleRect(i));
+}
+
+void BenchMyModel::cleanupTestCase()
+{
+    delete m;
+    m = nullptr;
+}
+
+/**
+ * @brief Выделения памяти на один DisplayRole-вызов: прежний код vs модель.
+ *
+ * @details
+ * "before" воспроизводит прежний data(): QVariant(QColor::name()) и
+ * QVariant(legacyPenStyleToString()). "after" — MyModel::data() с интернированными строками.
+ * Первый проход модели прогревает кэш имён цветов.
+ */
+void BenchMyModel::displayRole_allocations_before_after()
+{
+    if (!AllocCounter::isAvailable())
+        QSKIP("Подсчёт выделений памяти недоступен на этой платформе");
+
+    QVector<MyRect> rects;
+    rects.reserve(kDataRows);
+    for (int i = 0; i < kDataRows; ++i)
+        rects.push_back(sampleRect(i));
+
+    // before
+    unsigned long long start = AllocCounter::count();
+    for (const MyRect& r : rects)
+    {
+        const QVariant v = QVariant(r.penColor.name());
+        Q_UNUSED(v);
+    }
+    reportAllocations("before PenColor DisplayRole", AllocCounter::count() - start, kDataRows);
+
+    start = AllocCounter::count();
+    for (const MyRect& r : rects)
+    {
+        const QVariant v = QVariant(legacyPenStyleToString(r.penStyle));
+        Q_UNUSED(v);
+    }
+    reportAllocations("before PenStyle DisplayRole", AllocCounter::count() - start, kDataRows);
+
+    // after (прогрев кэша)
+    for (int row = 0; row < kDataRows; ++row)
+        m->data(m->index(row, kColPenColor), Qt::DisplayRole);
+
+    start = AllocCounter::count();
+    for (int row = 0; row < kDataRows; ++row)
+    {
+        const QVariant v = m->data(m->index(row, kColPenColor), Qt::DisplayRole);
+        Q_UNUSED(v);
+    }
+    reportAllocations("after  PenColor DisplayRole", AllocCounter::count() - start, kDataRows);
+
+    start = AllocCounter::count();
+    for (int row = 0; row < kDataRows; ++row)
+    {
+        const QVariant v = m->data(m->index(row, kColPenStyle), Qt::DisplayRole);
+        Q_UNUSED(v);
+    }
+    reportAllocations("after  PenStyle DisplayRole", AllocCounter::count() - start, kDataRows);
+}
+
+/**
+ * @brief Время DisplayRole для столбца PenColor по всей модели.
+ */
+void BenchMyModel::displayRole_penColor()
+{
+    QBENCHMARK {
+        for (int row = 0; row < kDataRows; ++row)
+            m->data(m->index(row, kColPenColor), Qt::DisplayRole);
+    }
+}
+
+/**
+ * @brief Время DisplayRole для столбца PenStyle по всей модели.
+ */
+void BenchMyModel::displayRole_penStyle()
+{
+    QBENCHMARK {
+        for (int row = 0; row < kDataRows; ++row)
+            m->data(m->index(row, kColPenStyle), Qt::DisplayRole);
+    }
+}
+
+/**
+ * @brief Время DecorationRole (иконка цвета) по всей модели + статистика кэша.
+ */
+void BenchMyModel::decorationRole_penColor()
+{
+    m->resetIconCacheStats();
+
+    QBENCHMARK {
+        for (int row = 0; row < kDataRows; ++row)
+            m->data(m->index(row, kColPenColor), Qt::DecorationRole);
+    }
+
+    qInfo("icon cache: hits=%llu misses=%llu",
+          static_cast<unsigned long long>(m->iconCacheHits()),
+          static_cast<unsigned long long>(m->iconCacheMisses()));
+}
+
+/**
+ * @brief Размеры пачек для сравнения appendRects() и цикла slotAddData().
+ */
+void BenchMyModel::append_batch_data()
+{
+    QTest::addColumn<bool>("bulk");
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("slotAddData x10000") << false << 10000;
+    QTest::newRow("appendRects 10000")  << true  << 10000;
+    QTest::newRow("slotAddData x50000") << false << 50000;
+    QTest::newRow("appendRects 50000")  << true  << 50000;
+}
+
+/**
+ * @brief Добавление пачки строк в модель, подключённую к QTableView.
+ *
+ * @details
+ * View подключено, чтобы учитывалась реальная стоимость обработки сигналов
+ * (rowsInserted/dataChanged) представлением. Печатается число сигналов на пачку.
+ */
+void BenchMyModel::append_batch()
+{
+    QFETCH(bool, bulk);
+    QFETCH(int, count);
+
+    QVector<MyRect> rects;
+    rects.reserve(count);
+    for (int i = 0; i < count; ++i)
+        rects.push_back(sampleRect(i));
+
+    int signalsPerBatch = 0;
+
+    QBENCHMARK {
+        MyModel model;
+        QTableView view;
+        view.setModel(&model);
+
+        int emitted = 0;
+        QObject::connect(&model, &MyModel::rowsInserted, [&emitted] { ++emitted; });
+        QObject::connect(&model, &MyModel::dataChanged, [&emitted] { ++emitted; });
+
+        if (bulk)
+        {
+            model.appendRects(rects);
+        }
+        else
+        {
+            for (const MyRect& r : rects)
+                model.slotAddData(r);
+        }
+
+        signalsPerBatch = emitted;
+    }
+
+    qInfo("%s: %d signals per batch", bulk ? "appendRects" : "slotAddData", signalsPerBatch);
+}
+
+/**
+ * @brief Размеры модели и число удаляемых разрозненных строк.
+ */
+void BenchMyModel::remove_scattered_data()
+{
+    QTest::addColumn<bool>("bulk");
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("removed");
+
+    QTest::newRow("removeRows x10000 of 100000") << false << 100000 << 10000;
+    QTest::newRow("removeRowsAt 10000 of 100000") << true << 100000 << 10000;
+    QTest::newRow("removeRowsAt 100000 of 1000000") << true << 1000000 << 100000;
+}
+
+/**
+ * @brief Удаление каждой N-й строки модели, подключённой к QTableView.
+ *
+ * @details
+ * Эталон "до" — цикл removeRows(row, 1) с конца таблицы: сдвиг хвоста и пара
+ * уведомлений на каждую строку. QBENCHMARK включает заполнение модели,
+ * поэтому время самого удаления печатается отдельно.
+ */
+void BenchMyModel::remove_scattered()
+{
+    QFETCH(bool, bulk);
+    QFETCH(int, rows);
+    QFETCH(int, removed);
+
+    QVector<MyRect> rects;
+    rects.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        rects.push_back(sampleRect(i));
+
+    const int step = rows / removed;
+    QVector<int> doomed;
+    doomed.reserve(removed);
+    for (int i = 0; i < removed; ++i)
+        doomed.append(i * step);
+
+    MyModel model;
+    QTableView view;
+    view.setModel(&model);
+
+    qint64 elapsedNs = 0;
+    int runs = 0;
+
+    QBENCHMARK {
+        model.removeRows(0, model.rowCount());
+        model.appendRects(rects);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if (bulk)
+        {
+            model.removeRowsAt(doomed);
+        }
+        else
+        {
+            for (int i = doomed.size() - 1; i >= 0; --i)
+                model.removeRows(doomed[i], 1);
+        }
+
+        elapsedNs += timer.nsecsElapsed();
+        ++runs;
+    }
+
+    qInfo("%s: %.2f ms per removal (model fill excluded)",
+          bulk ? "removeRowsAt" : "removeRows loop", double(elapsedNs) / 1e6 / runs);
+    QCOMPARE(model.rowCount(), rows - removed);
+}
+
+/**
+ * @brief Раскладки хранения для бенчмарка снимков.
+ */
+void BenchMyModel::snapshot_then_edit_data()
+{
+    QTest::addColumn<int>("layout");
+
+    QTest::newRow("rows 1000000")   << int(MyModel::StorageLayout::Rows);
+    QTest::newRow("chunks 1000000") << int(MyModel::StorageLayout::Chunks);
+}
+
+/**
+ * @brief snapshot() и одна setData() после него (модель на 1 000 000 строк).
+ *
+ * @details
+ * Так выглядит цикл "рабочий поток взял снимок — пользователь правит ячейку".
+ * В раскладке Rows первая запись после снимка копирует весь массив строк,
+ * в Chunks — один блок из RectChunks::kChunkRows строк.
+ */
+void BenchMyModel::snapshot_then_edit()
+{
+    QFETCH(int, layout);
+
+    MyModel model;
+    model.setStorageLayout(static_cast<MyModel::StorageLayout>(layout));
+    QVector<MyRect> rects;
+    rects.reserve(1000000);
+    for (int i = 0; i < 1000000; ++i)
+        rects.push_back(sampleRect(i));
+    model.appendRects(rects);
+
+    const QModelIndex cell = model.index(500000, 3);
+    int value = 0;
+
+    QBENCHMARK {
+        const RectSnapshot snap = model.snapshot();
+        model.setData(cell, ++value, Qt::EditRole);
+        QVERIFY(snap.size() == model.rowCount());
+    }
+}
+
+/**
+ * @brief Раскладки и размеры модели для вставок в случайные места.
+ */
+void BenchMyModel::insert_random_data()
+{
+    QTest::addColumn<int>("layout");
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<bool>("spatial");
+
+    QTest::newRow("rows 1000000")   << int(MyModel::StorageLayout::Rows)   << 1000000 << false;
+    QTest::newRow("chunks 1000000") << int(MyModel::StorageLayout::Chunks) << 1000000 << false;
+    QTest::newRow("rows 5000000")   << int(MyModel::StorageLayout::Rows)   << 5000000 << false;
+    QTest::newRow("chunks 5000000") << int(MyModel::StorageLayout::Chunks) << 5000000 << false;
+    QTest::newRow("chunks 5000000 spatial index") << int(MyModel::StorageLayout::Chunks) << 5000000 << true;
+}
+
+/**
+ * @brief 1000 вызовов insertRows(row, 1) в случайные строки модели.
+ *
+ * @details
+ * В раскладке Rows каждая вставка сдвигает в среднем половину таблицы,
+ * в Chunks — не больше одного блока из RectChunks::kChunkRows строк.
+ * Номера строк — из линейного конгруэнтного генератора, одинаковые для обеих раскладок.
+ *
+ * С @c spatial перед вставками строится пространственный индекс: вставка
+ * обновляет его за O(log n) (id строк в ячейках не переписываются);
+ * отдельно выводится время запроса после вставок — перестроения нет.
+ */
+void BenchMyModel::insert_random()
+{
+    QFETCH(int, layout);
+    QFETCH(int, rows);
+    QFETCH(bool, spatial);
+
+    MyModel model;
+    model.setStorageLayout(static_cast<MyModel::StorageLayout>(layout));
+    QVector<MyRect> rects;
+    rects.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        rects.push_back(sampleRect(i));
+    model.appendRects(rects);
+    rects.clear();
+
+    if (spatial)
+        QVERIFY(!model.rowsAt(QPoint(0, 0)).isEmpty());
+
+    quint32 state = 12345;
+    QBENCHMARK {
+        for (int i = 0; i < 1000; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            model.insertRows(int(state % quint32(model.rowCount())), 1);
+        }
+    }
+
+    // data() после вставок: в Chunks блок ищется через индекс размеров
+    constexpr int kLookups = 1000000;
+    qint64 sum = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < kLookups; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        sum += model.data(model.index(int(state % quint32(model.rowCount())), 3), Qt::EditRole).toInt();
+    }
+    qInfo("data() at random rows: %.1f ns per call (checksum %lld)",
+          double(timer.nsecsElapsed()) / kLookups, static_cast<long long>(sum));
+
+    if (spatial)
+    {
+        timer.restart();
+        const int found = model.rowsAt(QPoint(0, 0)).size();
+        qInfo("spatial query after inserts: %.1f ms (%d rows at point)",
+              double(timer.nsecsElapsed()) / 1e6, found);
+    }
+}
+
+/**
+ * @brief Способ поиска строк, содержащих точку.
+ */
+void BenchMyModel::spatial_point_query_data()
+{
+    QTest::addColumn<bool>("indexed");
+
+    QTest::newRow("full scan 1000000") << false;
+    QTest::newRow("index 1000000")     << true;
+}
+
+/**
+ * @brief 100 запросов «какие прямоугольники содержат точку» на 1M строк.
+ *
+ * @details
+ * Прямоугольники 1..100 пикселей разбросаны по квадрату 100000 x 100000
+ * (генератор одинаков для обоих вариантов). Перебор читает геометрию всех
+ * строк через rectAt(); rowsAt() смотрит одну ячейку сетки. Построение
+ * индекса (первый запрос) меряется отдельно и печатается.
+ */
+void BenchMyModel::spatial_point_query()
+{
+    QFETCH(bool, indexed);
+
+    constexpr int kRows = 1000000;
+    quint32 state = 777;
+    const auto next = [&state](int bound) {
+        state = state * 1664525u + 1013904223u;
+        return int((state >> 8) % quint32(bound));
+    };
+
+    MyModel model;
+    QVector<MyRect> rects;
+    rects.reserve(kRows);
+    for (int i = 0; i < kRows; ++i)
+        rects.push_back(MyRect(QColor(Qt::black), Qt::SolidLine, 1,
+                               next(100000), next(100000), 1 + next(100), 1 + next(100)));
+    model.appendRects(rects);
+    rects.clear();
+
+    if (indexed)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        model.rowsAt(QPoint(0, 0));
+        qInfo("spatial index build: %lld ms", static_cast<long long>(timer.elapsed()));
+    }
+
+    qint64 found = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i)
+        {
+            const QPoint p(next(100000), next(100000));
+            if (indexed)
+            {
+                found += model.rowsAt(p).size();
+                continue;
+            }
+            for (int row = 0; row < kRows; ++row)
+            {
+                const MyRect r = model.rectAt(row);
+                if (r.left <= p.x() && p.x() < r.left + r.width && r.top <= p.y() && p.y() < r.top + r.height)
+                    ++found;
+            }
+        }
+    }
+    qInfo("rows found: %lld", static_cast<long long>(found));
+}
+
+/**
+ * @brief Варианты загрузки TSV.
+ */
+void BenchMyModel::tsv_load_data()
+{
+    QTest::addColumn<int>("source");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("legacy QTextStream+split (QBuffer)") << int(TsvSource::Legacy)     << 1;
+    QTest::newRow("TsvReader stream (file)")            << int(TsvSource::FileStream) << 1;
+    QTest::newRow("TsvReader in place (QBuffer) x1")    << int(TsvSource::Buffer)     << 1;
+    QTest::newRow("TsvReader mmap (file) x1")           << int(TsvSource::FileMap)    << 1;
+
+    for (int threads : {2, 4, 8, 16})
+    {
+        const QByteArray tag = "TsvReader mmap (file) x" + QByteArray::number(threads);
+        QTest::newRow(tag.constData()) << int(TsvSource::FileMap) << threads;
+    }
+}
+
+/**
+ * @brief Загрузка kTsvRows строк TSV.
+ *
+ * @details
+ * Данные формируются saveToTsv() и читаются из QBuffer либо из временного файла
+ * (по имени, в режимах TsvLoadMode::Stream / TsvLoadMode::MemoryMap).
+ * Для режима на месте задаётся число потоков разбора — видно масштабирование.
+ * Печатаются пропускная способность (МБ/с) и число выделений памяти на строку.
+ */
+void BenchMyModel::tsv_load()
+{
+    QFETCH(int, source);
+    QFETCH(int, threads);
+    const auto src = static_cast<TsvSource>(source);
+
+    QByteArray bytes;
+    {
+        MyModel model;
+        QVector<MyRect> rects;
+        rects.reserve(kTsvRows);
+        for (int i = 0; i < kTsvRows; ++i)
+            rects.push_back(sampleRect(i));
+        model.appendRects(rects);
+
+        QBuffer out(&bytes);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        QVERIFY(model.saveToTsv(out));
+    }
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+    file.close();
+
+    qint64 elapsedNs = 0;
+    unsigned long long allocs = 0;
+    int runs = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        const unsigned long long start = AllocCounter::count();
+        timer.start();
+
+        if (src == TsvSource::Legacy)
+        {
+            QBuffer in(&bytes);
+            QVERIFY(in.open(QIODevice::ReadOnly));
+            QCOMPARE(legacyLoadTsv(in), kTsvRows);
+        }
+        else
+        {
+            MyModel model;
+            model.setTsvParseThreads(threads);
+            if (src == TsvSource::Buffer)
+            {
+                QBuffer in(&bytes);
+                QVERIFY(in.open(QIODevice::ReadOnly));
+                QVERIFY(model.loadFromTsv(in));
+            }
+            else
+            {
+                model.setTsvLoadMode(src == TsvSource::FileMap ? MyModel::TsvLoadMode::MemoryMap
+                                                               : MyModel::TsvLoadMode::Stream);
+                QVERIFY(model.loadFromTsv(file.fileName()));
+            }
+            QCOMPARE(model.rowCount(), kTsvRows);
+        }
+
+        elapsedNs += timer.nsecsElapsed();
+        allocs += AllocCounter::count() - start;
+        ++runs;
+    }
+
+    const double seconds = double(elapsedNs) / 1e9 / runs;
+    qInfo("%s: %.1f MB/s", QTest::currentDataTag(), double(bytes.size()) / 1e6 / seconds);
+    if (AllocCounter::isAvailable())
+        reportAllocations("  allocations per row", allocs / runs, kTsvRows);
+}
+
+/**
+ * @brief Загрузка kTsvRows строк из двоичного снимка (файл).
+ *
+ * @details
+ * Те же строки, что в tsv_load; печатается пропускная способность (МБ/с)
+ * и время на строку — для сравнения с разбором TSV.
+ */
+void BenchMyModel::binary_load()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    {
+        MyModel model;
+        QVector<MyRect> rects;
+        rects.reserve(kTsvRows);
+        for (int i = 0; i < kTsvRows; ++i)
+            rects.push_back(sampleRect(i));
+        model.appendRects(rects);
+        QVERIFY(model.saveToBinary(file));
+    }
+    const qint64 fileSize = file.size();
+    file.close();
+
+    qint64 elapsedNs = 0;
+    int runs = 0;
+
+    QBENCHMARK {
+        QElapsedTimer timer;
+        timer.start();
+
+        MyModel model;
+        QVERIFY(model.loadFromBinary(file.fileName()));
+        QCOMPARE(model.rowCount(), kTsvRows);
+
+        elapsedNs += timer.nsecsElapsed();
+        ++runs;
+    }
+
+    const double seconds = double(elapsedNs) / 1e9 / runs;
+    qInfo("binary snapshot: %.1f MB/s, %.1f ns/row",
+          double(fileSize) / 1e6 / seconds, seconds * 1e9 / kTsvRows);
+}
+
+void BenchMyModel::tsv_save_data()
+{
+    QTest::addColumn<bool>("legacy");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("legacy QStringList+QTextStream (QBuffer)") << true  << 1;
+
+    for (int threads : {1, 2, 4, 8, 16})
+    {
+        const QByteArray tag = "TsvWriter (QBuffer) x" + QByteArray::number(threads);
+        QTest::newRow(tag.constData()) << false << threads;
+    }
+}
+
+/**
+ * @brief Сохранение kTsvRows строк в QBuffer.
+ *
+ * @details
+ * Для TsvWriter задаётся число потоков форматирования (setTsvSaveThreads()).
+ * Печатаются пропускная способность (МБ/с) и число выделений памяти на строку;
+ * результат всех вариантов сверяется побайтно с прежней записью.
+ */
+void BenchMyModel::tsv_save()
+{
+    QFETCH(bool, legacy);
+    QFETCH(int, threads);
+
+    MyModel model;
+    model.setTsvSaveThreads(threads);
+    {
+        QVector<MyRect> rects;
+        rects.reserve(kTsvRows);
+        for (int i = 0; i < kTsvRows; ++i)
+            rects.push_back(sampleRect(i));
+        model.appendRects(rects);
+    }
+
+    QByteArray expected;
+    {
+        QBuffer out(&expected);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        legacySaveTsv(model, out);
+    }
+
+    QByteArray bytes;
+    bytes.reserve(expected.size());
+
+    qint64 elapsedNs = 0;
+    unsigned long long allocs = 0;
+    int runs = 0;
+
+    QBENCHMARK {
+        bytes.resize(0);
+        QBuffer out(&bytes);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+
+        QElapsedTimer timer;
+        const unsigned long long start = AllocCounter::count();
+        timer.start();
+
+        if (legacy)
+            legacySaveTsv(model, out);
+        else
+            QVERIFY(model.saveToTsv(out));
+
+        elapsedNs += timer.nsecsElapsed();
+        allocs += AllocCounter::count() - start;
+        ++runs;
+    }
+
+    QCOMPARE(bytes, expected);
+
+    const double seconds = double(elapsedNs) / 1e9 / runs;
+    qInfo("%s: %.1f MB/s", QTest::currentDataTag(), double(bytes.size()) / 1e6 / seconds);
+    if (AllocCounter::isAvailable())
+        reportAllocations("  allocations per row", allocs / runs, kTsvRows);
+}
+
+QTEST_MAIN(BenchMyModel)
+#include "bench_mymodel.moc"
@@ -0,0 +1,313 @@
+// tests/bench_rectformat.cpp
+/**
+ * @file bench_rectformat.cpp
+ * @brief Микробенчмарки разбора полей TSV (RectFormat) против прежнего кода.
+ *
+ * @details
+ * Как и bench_mymodel, собирается отдельной целью и в CTest не входит:
+ *
+ *     ./build/tests/bench_rectformat
+ *
+ * Входные данные — поля, лежащие подряд в одном байтовом буфере (как в
+ * буфере чтения TsvReader); разбираются представления QLatin1String.
+ */
+
+#include <QtTest/QtTest>
+
+#include <QColor>
+#include <QVector>
+
+#include "rectformat.h"
+
+namespace {
+
+/// Число цветов в бенчмарке разбора цвета.
+constexpr int kColorCount = 10 * 1000 * 1000;
+
+/// Длина "#rrggbb".
+constexpr int kHexColorSize = 7;
+
+/// Число целых полей в бенчмарке разбора целых.
+constexpr int kIntCount = 10 * 1000 * 1000;
+
+/**
+ * @brief Буфер из kColorCount цветов "#rrggbb" подряд (без разделителей).
+ */
+QByteArray makeHexColors()
+{
+    QByteArray bytes;
+    bytes.reserve(kColorCount * kHexColorSize);
+
+    quint32 x = 0x12345678;
+    for (int i = 0; i < kColorCount; ++i)
+    {
+        x = x * 1664525u + 1013904223u;
+        bytes += QColor::fromRgb(x & RGB_MASK).name().toLatin1();
+    }
+    return bytes;
+}
+
+/**
+ * @brief Буфер из kIntCount целых полей, разделённых '\t'.
+ *
+ * @details
+ * Значения — как в типичном TSV: координаты и размеры разной длины, часть отрицательных.
+ */
+QByteArray makeIntFields(QVector<QLatin1String>* fields)
+{
+    QByteArray bytes;
+    bytes.reserve(kIntCount * 6);
+
+    QVector<int> offsets;
+    offsets.reserve(kIntCount + 1);
+
+    quint32 x = 0x9e3779b9;
+    for (int i = 0; i < kIntCount; ++i)
+    {
+        x = x * 1664525u + 1013904223u;
+        offsets.append(bytes.size());
+        bytes += QByteArray::number(int(x >> 16) % 20000 - 5000);
+        bytes += '\t';
+    }
+    offsets.append(bytes.size());
+
+    fields->clear();
+    fields->reserve(kIntCount);
+    for (int i = 0; i < kIntCount; ++i)
+    {
+        const char* b = bytes.constData() + offsets[i];
+        fields->append(QLatin1String(b, offsets[i + 1] - offsets[i] - 1));
+    }
+    return bytes;
+}
+
+/// Число полей в бенчмарке разбора стиля пера.
+constexpr int kPenStyleCount = 10 * 1000 * 1000;
+
+/**
+ * @brief Прежний разбор стиля: число, затем "Qt::PenStyle(N)", затем линейный поиск имени.
+ */
+Qt::PenStyle legacyParsePenStyle(QLatin1String text, bool* ok)
+{
+    const QLatin1String t = text.trimmed();
+
+    bool numOk = false;
+    const int asInt = RectFormat::parseInt(t, &numOk);
+    if (numOk && asInt >= 0 && asInt <= int(Qt::MPenStyle))
+    {
+        *ok = true;
+        return static_cast<Qt::PenStyle>(asInt);
+    }
+
+    const QLatin1String prefix("Qt::PenStyle(");
+    if (t.startsWith(prefix) && t.endsWith(QLatin1Char(')')))
+    {
+        const int v = RectFormat::parseInt(t.mid(prefix.size(), t.size() - prefix.size() - 1), &numOk);
+        if (numOk && v >= 0 && v <= int(Qt::MPenStyle))
+        {
+            *ok = true;
+            return static_cast<Qt::PenStyle>(v);
+        }
+    }
+
+    static const char* const kNames[] = {
+        "Qt::NoPen", "Qt::SolidLine", "Qt::DashLine",
+        "Qt::DotLine", "Qt::DashDotLine", "Qt::DashDotDotLine",
+    };
+    for (int i = 0; i < 6; ++i)
+    {
+        if (t == QLatin1String(kNames[i]))
+        {
+            *ok = true;
+            return static_cast<Qt::PenStyle>(i);
+        }
+    }
+
+    *ok = false;
+    return Qt::SolidLine;
+}
+
+/**
+ * @brief Имена стилей NoPen..DashDotDotLine, как их пишет saveToTsv().
+ */
+QVector<QByteArray> makePenStyleFields()
+{
+    QVector<QByteArray> names;
+    for (int v = int(Qt::NoPen); v <= int(Qt::DashDotDotLine); ++v)
+        names.append(RectFormat::penStyleName(static_cast<Qt::PenStyle>(v)).toLatin1());
+    return names;
+}
+
+} // namespace
+
+/**
+ * @brief Микробенчмарки RectFormat.
+ */
+class BenchRectFormat : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+
+    // Цвет "#rrggbb": QColor(QString) vs RectFormat::parseColor()
+    void parseColor_hex_data();
+    void parseColor_hex();
+
+    // Целое поле: QString::trimmed().toInt() / QByteArray::toInt() / RectFormat::parseInt()
+    void parseInt_data();
+    void parseInt();
+
+    // Стиль пера: прежний линейный поиск vs диспетчеризация по длине
+    void parsePenStyle_data();
+    void parsePenStyle();
+
+private:
+    QByteArray m_hexColors;
+    QByteArray m_intBytes;
+    QVector<QLatin1String> m_intFields;
+    QVector<QByteArray> m_penStyleNames;
+};
+
+void BenchRectFormat::initTestCase()
+{
+    m_hexColors = makeHexColors();
+    m_intBytes = makeIntFields(&m_intFields);
+    m_penStyleNames = makePenStyleFields();
+}
+
+void BenchRectFormat::parseColor_hex_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy QColor(QString::trimmed())") << true;
+    QTest::newRow("RectFormat::parseColor")           << false;
+}
+
+/**
+ * @brief Разбор kColorCount цветов.
+ *
+ * @details
+ * "legacy" повторяет прежний путь: QString из поля, trimmed(), QColor(QString).
+ * Сумма результатов печатается, чтобы компилятор не выбросил цикл.
+ */
+void BenchRectFormat::parseColor_hex()
+{
+    QFETCH(bool, legacy);
+
+    const char* data = m_hexColors.constData();
+    quint32 checksum = 0;
+
+    QBENCHMARK {
+        checksum = 0;
+        for (int i = 0; i < kColorCount; ++i)
+        {
+            const char* p = data + i * kHexColorSize;
+            if (legacy)
+            {
+                const QColor color(QString::fromLatin1(p, kHexColorSize).trimmed());
+                checksum += color.rgba();
+            }
+            else
+            {
+                QRgb rgba = 0;
+                RectFormat::parseColor(QLatin1String(p, kHexColorSize), &rgba);
+                checksum += rgba;
+            }
+        }
+    }
+
+    qInfo("checksum: %08x", checksum);
+}
+
+/// Вариант разбора целого поля.
+enum class IntParser
+{
+    QStringToInt,    ///< Прежний путь: QString + trimmed() + toInt().
+    QByteArrayToInt, ///< QByteArray::fromRawData() + toInt() (без копии, но через strtoll).
+    RectFormat       ///< RectFormat::parseInt().
+};
+
+Q_DECLARE_METATYPE(IntParser)
+
+void BenchRectFormat::parseInt_data()
+{
+    QTest::addColumn<IntParser>("parser");
+
+    QTest::newRow("legacy QString::trimmed().toInt()") << IntParser::QStringToInt;
+    QTest::newRow("QByteArray::fromRawData().toInt()") << IntParser::QByteArrayToInt;
+    QTest::newRow("RectFormat::parseInt")              << IntParser::RectFormat;
+}
+
+/**
+ * @brief Разбор kIntCount целых полей из одного буфера.
+ */
+void BenchRectFormat::parseInt()
+{
+    QFETCH(IntParser, parser);
+
+    qint64 checksum = 0;
+
+    QBENCHMARK {
+        checksum = 0;
+        for (const QLatin1String& f : qAsConst(m_intFields))
+        {
+            bool ok = false;
+            int v = 0;
+            switch (parser)
+            {
+            case IntParser::QStringToInt:
+                v = QString(f).trimmed().toInt(&ok);
+                break;
+            case IntParser::QByteArrayToInt:
+                v = QByteArray::fromRawData(f.data(), f.size()).toInt(&ok);
+                break;
+            case IntParser::RectFormat:
+                v = RectFormat::parseInt(f, &ok);
+                break;
+            }
+            checksum += ok ? v : 0;
+        }
+    }
+
+    qInfo("checksum: %lld", checksum);
+}
+
+void BenchRectFormat::parsePenStyle_data()
+{
+    QTest::addColumn<bool>("legacy");
+
+    QTest::newRow("legacy linear scan")        << true;
+    QTest::newRow("RectFormat::parsePenStyle") << false;
+}
+
+/**
+ * @brief Разбор kPenStyleCount имён стилей (равномерно по шести известным).
+ */
+void BenchRectFormat::parsePenStyle()
+{
+    QFETCH(bool, legacy);
+
+    QVector<QLatin1String> names;
+    for (const QByteArray& n : qAsConst(m_penStyleNames))
+        names.append(QLatin1String(n.constData(), n.size()));
+    const int nameCount = names.size();
+
+    qint64 checksum = 0;
+
+    QBENCHMARK {
+        checksum = 0;
+        for (int i = 0; i < kPenStyleCount; ++i)
+        {
+            bool ok = false;
+            const QLatin1String f = names[i % nameCount];
+            const Qt::PenStyle style = legacy ? legacyParsePenStyle(f, &ok)
+                                              : RectFormat::parsePenStyle(f, &ok);
+            checksum += ok ? int(style) : -1;
+        }
+    }
+
+    qInfo("checksum: %lld", checksum);
+}
+
+QTEST_MAIN(BenchRectFormat)
+#include "bench_rectformat.moc"
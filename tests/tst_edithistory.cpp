@@ -0,0 +1,178 @@
+// tests/tst_edithistory.cpp
+#include <QtTest/QtTest>
+#include "edithistory.h"
+
+/**
+ * @brief Набор юнит-тестов для истории правок EditHistory.
+ *
+ * @details
+ * История не применяет записи сама (это делает MyModel), поэтому здесь
+ * проверяется только учёт: стеки отмены/повтора, шаги, слияние правок
+ * одной ячейки и выбрасывание старых шагов по бюджету памяти.
+ */
+class TestEditHistory : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief take/push переносят шаги между стеками; новая запись очищает повтор.
+     */
+    void undo_redo_stacks();
+
+    /**
+     * @brief Подряд идущие правки одной ячейки сливаются; возврат к исходному удаляет шаг.
+     */
+    void mergeCell_merges_consecutive_edits_only();
+
+    /**
+     * @brief beginStep()/endStep(): записи шага отменяются вместе, пустой шаг не сохраняется;
+     *        truncateOpen() отбрасывает хвост открытого шага.
+     */
+    void steps_group_entries();
+
+    /**
+     * @brief При превышении бюджета выбрасываются самые старые шаги.
+     */
+    void memory_budget_evicts_oldest();
+};
+
+namespace {
+
+EditHistory::Entry cell(int row, int column, quint32 before, quint32 after)
+{
+    return EditHistory::cells({EditHistory::CellDiff{row, static_cast<quint8>(column), before, after}});
+}
+
+/// Хранилище из @p rows строк по умолчанию.
+RectStore defaultRows(int rows)
+{
+    RectStore store;
+    store.insert(0, rows, PackedRect{});
+    return store;
+}
+
+} // namespace
+
+void TestEditHistory::undo_redo_stacks()
+{
+    EditHistory history;
+    QVERIFY(!history.canUndo());
+    QVERIFY(!history.canRedo());
+    QVERIFY(history.takeUndo().isEmpty());
+
+    history.record(EditHistory::insert(0, 3));
+    history.record(cell(1, 2, 10, 20));
+    QCOMPARE(history.undoCount(), 2);
+
+    EditHistory::Step step = history.takeUndo();
+    QCOMPARE(step.size(), 1);
+    QVERIFY(step.first().kind == EditHistory::Kind::Cells);
+    history.pushRedo(step);
+    QVERIFY(history.canRedo());
+
+    history.pushUndo(history.takeRedo());
+    QCOMPARE(history.undoCount(), 2);
+    QCOMPARE(history.redoCount(), 0);
+
+    history.pushRedo(history.takeUndo());
+    history.record(EditHistory::move(0, 1, 3));
+    QCOMPARE(history.redoCount(), 0);
+    QCOMPARE(history.undoCount(), 2);
+
+    history.clear();
+    QVERIFY(!history.canUndo());
+    QCOMPARE(history.memoryUsage(), qint64(0));
+}
+
+void TestEditHistory::mergeCell_merges_consecutive_edits_only()
+{
+    EditHistory history;
+
+    QVERIFY(!history.mergeCell(0, 0, 1));   // истории нет
+
+    history.record(cell(0, 3, 1, 2));
+    QVERIFY(history.mergeCell(0, 3, 3));
+    QVERIFY(!history.mergeCell(0, 4, 3));   // другая ячейка
+    QCOMPARE(history.undoCount(), 1);
+
+    history.record(cell(0, 4, 5, 6));
+    QVERIFY(!history.mergeCell(0, 3, 9));   // цепочка прервана другой ячейкой
+
+    // Возврат к исходному значению: шаг удаляется
+    QVERIFY(history.mergeCell(0, 4, 5));
+    QCOMPARE(history.undoCount(), 1);
+
+    const EditHistory::Step step = history.takeUndo();
+    QCOMPARE(step.first().cells.first().before, quint32(1));
+    QCOMPARE(step.first().cells.first().after, quint32(3));
+
+    // После отмены/повтора слияния нет
+    history.pushRedo(step);
+    history.pushUndo(history.takeRedo());
+    QVERIFY(!history.mergeCell(0, 3, 4));
+}
+
+void TestEditHistory::steps_group_entries()
+{
+    EditHistory history;
+
+    history.beginStep();
+    history.record(EditHistory::remove(5, defaultRows(2)));
+    history.beginStep();
+    history.record(EditHistory::remove(1, defaultRows(1)));
+    history.endStep();
+    QVERIFY(!history.canUndo());
+    history.endStep();
+
+    QCOMPARE(history.undoCount(), 1);
+    const EditHistory::Step step = history.takeUndo();
+    QCOMPARE(step.size(), 2);
+    QCOMPARE(step.at(0).row, 5);
+    QCOMPARE(step.at(0).count, 2);
+    QCOMPARE(step.at(1).row, 1);
+
+    history.beginStep();
+    history.endStep();
+    QVERIFY(!history.canUndo());
+
+    // truncateOpen(): хвост открытого шага отбрасывается, усечённый до нуля шаг не сохраняется
+    history.beginStep();
+    history.record(EditHistory::insert(0, 1));
+    history.record(EditHistory::insert(1, 1));
+    QCOMPARE(history.openEntryCount(), 2);
+    history.truncateOpen(1);
+    QCOMPARE(history.openEntryCount(), 1);
+    history.truncateOpen(0);
+    history.endStep();
+    QVERIFY(!history.canUndo());
+}
+
+void TestEditHistory::memory_budget_evicts_oldest()
+{
+    EditHistory history;
+    QCOMPARE(history.memoryBudget(), EditHistory::kDefaultMemoryBudget);
+
+    const qint64 stepSize = EditHistory::remove(0, defaultRows(100)).bytes();
+    history.setMemoryBudget(stepSize * 3);
+
+    for (int i = 0; i < 5; ++i)
+        history.record(EditHistory::remove(i, defaultRows(100)));
+
+    QCOMPARE(history.undoCount(), 3);
+    QCOMPARE(history.memoryUsage(), stepSize * 3);
+    QCOMPARE(history.takeUndo().first().row, 4);
+
+    // Уменьшение бюджета сразу выбрасывает лишнее
+    history.setMemoryBudget(stepSize);
+    QCOMPARE(history.undoCount(), 1);
+    QCOMPARE(history.takeUndo().first().row, 3);
+
+    // Шаг больше бюджета не сохраняется
+    history.record(EditHistory::remove(0, defaultRows(1000)));
+    QVERIFY(!history.canUndo());
+    QCOMPARE(history.memoryUsage(), qint64(0));
+}
+
+QTEST_MAIN(TestEditHistory)
+#include "tst_edithistory.moc"
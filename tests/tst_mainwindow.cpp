@@ -6,6 +6,9 @@
 #include <QHeaderView>
 #include <QMenu>
 #include <QMenuBar>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QStatusBar>
 #include <QTableView>
 
 #include "mainwindow.h"
@@ -34,9 +37,17 @@
  *
  * 4) Меню "Файл":
  *    - меню "Файл" существует;
- *    - в меню есть действия "Открыть..." и "Сохранить...";
+ *    - в меню есть действия "Открыть...", "Открыть постепенно..." и "Сохранить...";
  *    - у действий стоят стандартные шорткаты Open/Save.
  *
+ * 5) Меню "Правка":
+ *    - действия "Отменить"/"Повторить" с шорткатами Ctrl+Z/Ctrl+Y;
+ *    - доступность действий следует истории модели.
+ *
+ * 6) Строка состояния:
+ *    - индикатор прогресса и кнопка "Отмена" скрыты без фоновой операции;
+ *    - индикатор следует сигналу MyModel::ioProgress().
+ *
  * @note
  * Мы НЕ тестируем тут QFileDialog/QMessageBox (slotSaveToFile/slotLoadFromFile),
  * потому что в коде используются статические методы QFileDialog::get*,
@@ -102,6 +113,8 @@ private slots:
     void model_is_filled_by_test_data();
     void file_menu_exists_and_has_expected_actions();
     void file_actions_have_standard_shortcuts();
+    void edit_menu_follows_undo_state();
+    void status_bar_progress_follows_model_signals();
 };
 
 void TestMainWindow::constructs_and_has_menubar()
@@ -165,9 +178,11 @@ void TestMainWindow::file_menu_exists_and_has_expected_actions()
     QVERIFY2(fileMenu != nullptr, "MenuBar must contain menu titled 'Файл'");
 
     QAction* actOpen = findActionByText(fileMenu, "Открыть...");
+    QAction* actOpenIncremental = findActionByText(fileMenu, "Открыть постепенно...");
     QAction* actSave = findActionByText(fileMenu, "Сохранить...");
 
     QVERIFY2(actOpen != nullptr, "File menu must contain action 'Открыть...'");
+    QVERIFY2(actOpenIncremental != nullptr, "File menu must contain action 'Открыть постепенно...'");
     QVERIFY2(actSave != nullptr, "File menu must contain action 'Сохранить...'");
 }
 
@@ -188,5 +203,66 @@ void TestMainWindow::file_actions_have_standard_shortcuts()
     QCOMPARE(actSave->shortcut(), QKeySequence::Save);
 }
 
+void TestMainWindow::edit_menu_follows_undo_state()
+{
+    MainWindow w;
+
+    QMenu* editMenu = findMenuByTitle(w.menuBar(), "Правка");
+    QVERIFY2(editMenu != nullptr, "MenuBar must contain menu titled 'Правка'");
+
+    QAction* actUndo = findActionByText(editMenu, "Отменить");
+    QAction* actRedo = findActionByText(editMenu, "Повторить");
+    QVERIFY2(actUndo != nullptr, "Edit menu must contain action 'Отменить'");
+    QVERIFY2(actRedo != nullptr, "Edit menu must contain action 'Повторить'");
+
+    QCOMPARE(actUndo->shortcut(), QKeySequence(QKeySequence::Undo));
+    QCOMPARE(actRedo->shortcut(), QKeySequence(Qt::CTRL + Qt::Key_Y));
+
+    // Тестовые данные конструктора в историю не попадают
+    QVERIFY(!actUndo->isEnabled());
+    QVERIFY(!actRedo->isEnabled());
+
+    auto* model = qobject_cast<MyModel*>(findTableView(w)->model());
+    QVERIFY(model != nullptr);
+
+    QVERIFY(model->setData(model->index(0, 3), 42, Qt::EditRole));
+    QVERIFY(actUndo->isEnabled());
+
+    actUndo->trigger();
+    QVERIFY(!actUndo->isEnabled());
+    QVERIFY(actRedo->isEnabled());
+    QVERIFY(model->data(model->index(0, 3), Qt::EditRole).toInt() != 42);
+
+    actRedo->trigger();
+    QCOMPARE(model->data(model->index(0, 3), Qt::EditRole).toInt(), 42);
+}
+
+void TestMainWindow::status_bar_progress_follows_model_signals()
+{
+    MainWindow w;
+
+    auto* progress = w.statusBar()->findChild<QProgressBar*>("ioProgressBar");
+    auto* cancel = w.statusBar()->findChild<QPushButton*>("ioCancelButton");
+    QVERIFY2(progress != nullptr, "Status bar must contain QProgressBar 'ioProgressBar'");
+    QVERIFY2(cancel != nullptr, "Status bar must contain QPushButton 'ioCancelButton'");
+    QVERIFY(progress->isHidden());
+    QVERIFY(cancel->isHidden());
+
+    auto* model = qobject_cast<MyModel*>(findTableView(w)->model());
+    QVERIFY(model != nullptr);
+
+    // Загрузка: процент по байтам
+    emit model->ioProgress(50, 200, 10, -1);
+    QCOMPARE(progress->value(), 25);
+
+    // Сохранение: размер неизвестен, процент по строкам
+    emit model->ioProgress(1000, -1, 3, 4);
+    QCOMPARE(progress->value(), 75);
+
+    emit model->loadFinished(false, true, QString());
+    QVERIFY(progress->isHidden());
+    QVERIFY(cancel->isHidden());
+}
+
 QTEST_MAIN(TestMainWindow)
 #include "tst_mainwindow.moc"
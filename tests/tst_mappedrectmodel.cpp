@@ -0,0 +1,198 @@
+// tests/tst_mappedrectmodel.cpp
+#include <QtTest/QtTest>
+
+#include <QAbstractItemModelTester>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+
+#include "mappedrectmodel.h"
+#include "mymodel.h"
+
+/**
+ * @brief Набор юнит-тестов для MappedRectModel (снимок, отображённый в память).
+ *
+ * @details
+ * Эталон — MyModel с теми же строками: роли, заголовки и значения обязаны
+ * совпадать; отличаются только флаги (модель только для чтения).
+ */
+class TestMappedRectModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    /**
+     * @brief data()/headerData()/rectAt() совпадают с MyModel для всех ролей и столбцов.
+     */
+    void data_matches_mymodel();
+
+    /**
+     * @brief Модель только для чтения: нет Qt::ItemIsEditable, setData() отклоняется.
+     */
+    void is_read_only();
+
+    /**
+     * @brief open() сбрасывает модель одним modelReset; close() делает её пустой.
+     */
+    void open_and_close_reset_model();
+
+    /**
+     * @brief Ошибка open() (нет файла, обрезан, не снимок) не трогает открытый снимок.
+     */
+    void open_error_keeps_current_snapshot();
+
+private:
+    /// Пишет снимок @p source во временный файл @p file.
+    static bool writeSnapshot(const MyModel& source, QTemporaryFile& file);
+
+    MyModel* m_source = nullptr;
+    MappedRectModel* m = nullptr;
+};
+
+bool TestMappedRectModel::writeSnapshot(const MyModel& source, QTemporaryFile& file)
+{
+    if (!file.open())
+        return false;
+    const bool ok = source.saveToBinary(file);
+    file.close();
+    return ok;
+}
+
+void TestMappedRectModel::init()
+{
+    m_source = new MyModel();
+    m_source->slotAddData(MyRect(QColor("#112233"), Qt::DotLine, 5, 10, 20, 30, 40));
+    m_source->slotAddData(MyRect(QColor(0xaa, 0xbb, 0xcc, 0x40), Qt::CustomDashLine, 1, -7, 0, 1, 2));
+    m_source->slotAddData(MyRect(QColor(Qt::red), Qt::NoPen, 0, 2147483647, -2147483647 - 1, 3, 4));
+
+    m = new MappedRectModel();
+    new QAbstractItemModelTester(m, QAbstractItemModelTester::FailureReportingMode::QtTest, m);
+}
+
+void TestMappedRectModel::cleanup()
+{
+    delete m;
+    m = nullptr;
+    delete m_source;
+    m_source = nullptr;
+}
+
+void TestMappedRectModel::data_matches_mymodel()
+{
+    QTemporaryFile file;
+    QVERIFY(writeSnapshot(*m_source, file));
+
+    QString err;
+    QVERIFY2(m->open(file.fileName(), &err), qPrintable(err));
+    QVERIFY(m->isOpen());
+    QCOMPARE(m->fileName(), file.fileName());
+
+    QCOMPARE(m->rowCount(), m_source->rowCount());
+    QCOMPARE(m->columnCount(), m_source->columnCount());
+
+    for (int col = 0; col < m->columnCount(); ++col)
+        QCOMPARE(m->headerData(col, Qt::Horizontal), m_source->headerData(col, Qt::Horizontal));
+    QCOMPARE(m->headerData(0, Qt::Vertical), m_source->headerData(0, Qt::Vertical));
+
+    for (int row = 0; row < m->rowCount(); ++row)
+    {
+        for (int col = 0; col < m->columnCount(); ++col)
+        {
+            const QModelIndex a = m->index(row, col);
+            const QModelIndex b = m_source->index(row, col);
+            QCOMPARE(a.data(Qt::DisplayRole), b.data(Qt::DisplayRole));
+            QCOMPARE(a.data(Qt::EditRole), b.data(Qt::EditRole));
+            QCOMPARE(a.data(Qt::DecorationRole).isValid(), b.data(Qt::DecorationRole).isValid());
+        }
+
+        QCOMPARE(m->rectAt(row).penColor.rgba(), m_source->rectAt(row).penColor.rgba());
+        QCOMPARE(m->rectAt(row).height, m_source->rectAt(row).height);
+    }
+
+    QVERIFY(!m->data(m->index(m->rowCount(), 0)).isValid());
+
+    // Вне диапазона — MyRect{}, как у MyModel::rectAt(), а не чтение за отображением
+    QCOMPARE(m->rectAt(m->rowCount()).width, MyRect{}.width);
+    QCOMPARE(m->rectAt(-1).height, MyRect{}.height);
+    QCOMPARE(m->rectAt(-1).penColor, MyRect{}.penColor);
+
+    m->close();
+    QCOMPARE(m->rectAt(0).width, MyRect{}.width);
+}
+
+void TestMappedRectModel::is_read_only()
+{
+    QTemporaryFile file;
+    QVERIFY(writeSnapshot(*m_source, file));
+    QVERIFY(m->open(file.fileName()));
+
+    const QModelIndex idx = m->index(0, 2);
+    QVERIFY(!(m->flags(idx) & Qt::ItemIsEditable));
+    QVERIFY(m->flags(idx) & Qt::ItemIsSelectable);
+    QVERIFY(!m->setData(idx, 99, Qt::EditRole));
+    QCOMPARE(idx.data(Qt::EditRole).toInt(), 5);
+}
+
+void TestMappedRectModel::open_and_close_reset_model()
+{
+    QTemporaryFile file;
+    QVERIFY(writeSnapshot(*m_source, file));
+
+    QSignalSpy resetSpy(m, &QAbstractItemModel::modelReset);
+
+    QVERIFY(m->open(file.fileName()));
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(m->rowCount(), 3);
+
+    m->close();
+    QCOMPARE(resetSpy.count(), 2);
+    QVERIFY(!m->isOpen());
+    QCOMPARE(m->rowCount(), 0);
+    QVERIFY(m->fileName().isEmpty());
+
+    m->close();
+    QCOMPARE(resetSpy.count(), 2);
+}
+
+void TestMappedRectModel::open_error_keeps_current_snapshot()
+{
+    QTemporaryFile good;
+    QVERIFY(writeSnapshot(*m_source, good));
+    QVERIFY(m->open(good.fileName()));
+
+    QByteArray bytes;
+    {
+        QFile f(good.fileName());
+        QVERIFY(f.open(QIODevice::ReadOnly));
+        bytes = f.readAll();
+    }
+
+    QTemporaryFile truncated;
+    QVERIFY(truncated.open());
+    truncated.write(bytes.left(bytes.size() - 1));
+    truncated.close();
+
+    QTemporaryFile tsv;
+    QVERIFY(tsv.open());
+    QVERIFY(m_source->saveToTsv(tsv));
+    tsv.close();
+
+    QSignalSpy resetSpy(m, &QAbstractItemModel::modelReset);
+
+    for (const QString& name : {truncated.fileName(), tsv.fileName(), QString("/nonexistent/snapshot.bin")})
+    {
+        QString err;
+        QVERIFY(!m->open(name, &err));
+        QVERIFY(!err.isEmpty());
+    }
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(m->fileName(), good.fileName());
+    QCOMPARE(m->rowCount(), 3);
+    QCOMPARE(m->index(0, 0).data().toString(), QString("#112233"));
+}
+
+QTEST_MAIN(TestMappedRectModel)
+#include "tst_mappedrectmodel.moc"
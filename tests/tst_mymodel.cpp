@@ -33,11 +33,22 @@
 #include <QtTest/QtTest>
 
 #include <QAbstractItemModelTester>
+#include <QApplication>
 #include <QBuffer>
+#include <QFileInfo>
 #include <QIcon>
+#include <QMimeData>
 #include <QSignalSpy>
+#include <QTemporaryFile>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 #include "mymodel.h"
+#include "tsvindex.h"
+#include "tsvwriter.h"
 
 namespace {
 
@@ -139,14 +150,27 @@ void compareModelColor(const QAbstractItemModel& model, const QModelIndex& idx,
  * - Группы тестов:
  *   - basics: row/col, headers, flags.
  *   - insertRows: валидация и дефолтные значения.
- *   - data(): корректные роли и обработка невалидных индексов.
+ *   - data(): корректные роли и обработка невалидных индексов, кэш иконок DecorationRole.
  *   - setData(): валидация входа, обновления, dataChanged и роли.
  *   - slotAddData(): добавление строки и обновление диапазона.
  *   - TSV: требования к QIODevice режимам, roundtrip, парсинг, ошибки и неизменность модели при ошибке.
+ *   - раскладка хранения и поколоночные проходы.
+ *   - пространственные запросы: совпадение с полным перебором после любых правок.
+ *
+ * Весь набор прогоняется для каждой раскладки хранения (см. main()): Rows, Columns и Chunks,
+ * т.к. контракт data()/setData() и TSV не должен зависеть от раскладки.
  */
 class TestMyModel : public QObject
 {
     Q_OBJECT
+public:
+    /**
+     * @param layout Раскладка хранения, с которой создаются модели в тестах.
+     */
+    explicit TestMyModel(MyModel::StorageLayout layout)
+        : m_layout(layout)
+    {}
+
 private slots:
     /**
      * @brief Вызывается перед каждым тестом.
@@ -175,10 +199,23 @@ private slots:
     void insertRows_rejects_bad_args();
     void insertRows_clamps_row_and_inserts_defaults();
 
+    // removeRows / removeRowsAt
+    void removeRows_rejects_bad_args_and_removes_range();
+    void removeRowsAt_few_ranges_one_notification_per_range();
+    void removeRowsAt_many_ranges_single_reset();
+
+    // moveRows / moveRowsTo / drag-and-drop
+    void moveRows_rejects_bad_args_and_moves_block();
+    void moveRowsTo_collects_rows_before_destination();
+    void dropMimeData_moves_own_rows_only();
+
     // data()
     void data_invalid_index_and_out_of_range_returns_invalid();
     void data_roles_for_penColor();
     void data_roles_for_penStyle_and_numeric_columns();
+    void data_decoration_icon_cache_hits_and_shares_icon();
+    void data_decoration_icon_cache_respects_capacity();
+    void data_display_strings_are_shared_between_calls();
 
     // setData()
     void setData_rejects_wrong_role_invalid_index_out_of_range();
@@ -188,6 +225,33 @@ private slots:
     void setData_no_change_returns_true_and_emits_nothing();
     void setData_penStyle_changes_and_updates_display();
     void setData_numeric_columns_change();
+    void setData_penStyle_rejects_out_of_range();
+
+    // beginBatchEdit() / commitBatchEdit()
+    void batchEdit_coalesces_dataChanged_per_role_set();
+    void batchEdit_many_ranges_single_bounding_signal();
+    void batchEdit_failed_setData_rolls_back_everything();
+    void batchEdit_nested_and_structure_changes();
+    void batchEdit_rollback_restores_value_before_repeated_edits();
+    void batchEdit_rollback_removes_appended_rows();
+
+    // undo() / redo()
+    void undo_redo_setData_merges_same_cell();
+    void undo_redo_row_operations_restore_contents();
+    void undo_redo_batch_edit_and_load();
+    void undo_redo_batch_edit_repeated_cell();
+    void undo_memory_budget_and_state_signal();
+
+    // appendRects()
+    void appendRects_single_insert_notification_and_values();
+    void appendRects_empty_is_noop();
+
+    // rectAt()
+    void rectAt_returns_row_and_defaults_out_of_range();
+
+    // snapshot()
+    void snapshot_is_isolated_from_later_edits();
+    void snapshot_read_on_worker_thread_while_editing();
 
     // slotAddData()
     void slotAddData_appends_row_sets_values_and_emits_range_roles();
@@ -198,6 +262,8 @@ private slots:
 
     // TSV: roundtrip + parsing variants
     void tsv_roundtrip_via_buffer();
+    void binary_roundtrip_via_buffer();
+    void binary_load_error_does_not_modify_model();
     void tsv_load_parses_penStyle_as_number_and_qtpenstyle_n();
 
     // TSV: errors + "model not modified on failure"
@@ -205,8 +271,40 @@ private slots:
     void tsv_load_invalid_color_does_not_modify_model();
     void tsv_load_invalid_style_does_not_modify_model();
     void tsv_load_invalid_integer_does_not_modify_model();
+    void tsv_load_out_of_range_style_does_not_modify_model();
+
+    // TSV: memory-mapped file vs streaming
+    void tsv_load_file_memory_mapped_matches_stream();
+    void tsv_load_file_memory_mapped_error_does_not_modify_model();
+    void tsvParseThreads_setting_and_parallel_load();
+    void tsvSaveThreads_setting_and_identical_output();
+
+    // async load/save
+    void asyncLoad_applies_rows_with_single_reset_and_progress();
+    void asyncLoad_cancel_does_not_modify_model();
+    void asyncLoad_error_reports_line_and_keeps_model();
+    void asyncSave_matches_sync_save();
+
+    // incremental load (canFetchMore/fetchMore)
+    void incrementalLoad_fetches_in_batches_and_matches_full_load();
+    void incrementalLoad_error_keeps_fetched_rows_and_stops();
+    void incrementalLoad_open_error_and_full_load_stop_fetching();
+
+    // TSV window via row index
+    void tsvRange_loads_window_and_keeps_model_on_error();
+
+    // storage layout + column scans
+    void storageLayout_switch_preserves_data();
+    void columnScans_totalArea_rowsInRange_rowOrderBy();
+
+    // spatial queries (point / area / nearest)
+    void spatialQueries_point_area_and_nearest();
+    void spatialQueries_follow_edits_undo_and_load();
 
 private:
+    /// Раскладка хранения для всех моделей набора.
+    MyModel::StorageLayout m_layout;
+
     /// Текущая тестируемая модель (создаётся заново в init()).
     MyModel* m = nullptr;
 };
@@ -216,6 +314,8 @@ private:
 void TestMyModel::init()
 {
     m = new MyModel();
+    m->setStorageLayout(m_layout);
+    QCOMPARE(m->storageLayout(), m_layout);
 
     // Автоматический тест корректности модели (инварианты Qt Model/View).
     // Родитель = m, чтобы корректно освободилось при удалении модели.
@@ -361,6 +461,227 @@ void TestMyModel::insertRows_clamps_row_and_inserts_defaults()
     QCOMPARE(m->rowCount(), 3);
 }
 
+// -------------------- removeRows / removeRowsAt --------------------
+
+namespace {
+
+/**
+ * @brief Заполняет модель @p rows строками, у которых Left = номер строки.
+ */
+void fillNumberedRows(MyModel& model, int rows)
+{
+    QVector<MyRect> rects;
+    rects.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        rects.push_back(MyRect(QColor(i % 256, 0, 0), Qt::SolidLine, 1, i, 0, 10, 10));
+    model.appendRects(rects);
+}
+
+} // namespace
+
+/**
+ * @brief removeRows(): невалидные аргументы отклоняются, диапазон удаляется одной парой сигналов.
+ */
+void TestMyModel::removeRows_rejects_bad_args_and_removes_range()
+{
+    fillNumberedRows(*m, 10);
+
+    QVERIFY(!m->removeRows(0, 0));
+    QVERIFY(!m->removeRows(-1, 1));
+    QVERIFY(!m->removeRows(8, 3));
+    QVERIFY(!m->removeRows(0, 1, m->index(0, 0)));
+    QCOMPARE(m->rowCount(), 10);
+
+    QSignalSpy removedSpy(m, &MyModel::rowsRemoved);
+    QVERIFY(m->removeRows(2, 3));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.first().at(1).toInt(), 2);
+    QCOMPARE(removedSpy.first().at(2).toInt(), 4);
+
+    QCOMPARE(m->rowCount(), 7);
+    QCOMPARE(m->data(m->index(1, kColLeft), Qt::EditRole).toInt(), 1);
+    QCOMPARE(m->data(m->index(2, kColLeft), Qt::EditRole).toInt(), 5);
+    QCOMPARE(m->data(m->index(6, kColLeft), Qt::EditRole).toInt(), 9);
+}
+
+/**
+ * @brief removeRowsAt(): номера в любом порядке с повторами сливаются в диапазоны,
+ * по одной паре beginRemoveRows/endRemoveRows на диапазон, с конца таблицы.
+ */
+void TestMyModel::removeRowsAt_few_ranges_one_notification_per_range()
+{
+    fillNumberedRows(*m, 20);
+
+    QSignalSpy removedSpy(m, &MyModel::rowsRemoved);
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+
+    QCOMPARE(m->removeRowsAt({15, 3, 4, 16, 5, 4, 19, -1, 20, 0}), 7);
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(removedSpy.count(), 4);
+    const QVector<QPair<int, int>> expected = {{19, 19}, {15, 16}, {3, 5}, {0, 0}};
+    for (int i = 0; i < expected.size(); ++i)
+    {
+        QCOMPARE(removedSpy.at(i).at(1).toInt(), expected[i].first);
+        QCOMPARE(removedSpy.at(i).at(2).toInt(), expected[i].second);
+    }
+
+    const QVector<int> kept = {1, 2, 6, 7, 8, 9, 10, 11, 12, 13, 14, 17, 18};
+    QCOMPARE(m->rowCount(), kept.size());
+    for (int i = 0; i < kept.size(); ++i)
+        QCOMPARE(m->data(m->index(i, kColLeft), Qt::EditRole).toInt(), kept[i]);
+
+    QCOMPARE(m->removeRowsAt({}), 0);
+    QCOMPARE(m->removeRowsAt({100}), 0);
+    QCOMPARE(removedSpy.count(), 4);
+}
+
+/**
+ * @brief removeRowsAt(): больше kMaxRemoveNotifications диапазонов — один проход и один reset.
+ */
+void TestMyModel::removeRowsAt_many_ranges_single_reset()
+{
+    const int rows = 10000;
+    fillNumberedRows(*m, rows);
+
+    QVector<int> doomed;
+    for (int i = rows - 1; i >= 0; --i)
+    {
+        if (i % 3 == 0)
+            doomed.append(i);
+    }
+
+    QSignalSpy removedSpy(m, &MyModel::rowsRemoved);
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+
+    QCOMPARE(m->removeRowsAt(doomed), doomed.size());
+
+    QCOMPARE(removedSpy.count(), 0);
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(m->rowCount(), rows - doomed.size());
+
+    int row = 0;
+    for (int i = 0; i < rows; ++i)
+    {
+        if (i % 3 != 0)
+            QCOMPARE(m->data(m->index(row++, kColLeft), Qt::EditRole).toInt(), i);
+    }
+}
+
+// -------------------- moveRows / moveRowsTo / drag-and-drop --------------------
+
+namespace {
+
+/**
+ * @brief Значения Left всех строк модели (при fillNumberedRows() — исходные номера строк).
+ */
+QVector<int> leftColumn(const MyModel& model)
+{
+    QVector<int> values;
+    for (int row = 0; row < model.rowCount(); ++row)
+        values.append(model.data(model.index(row, kColLeft), Qt::EditRole).toInt());
+    return values;
+}
+
+} // namespace
+
+/**
+ * @brief moveRows(): невалидные аргументы отклоняются, блок переносится одной парой сигналов.
+ */
+void TestMyModel::moveRows_rejects_bad_args_and_moves_block()
+{
+    fillNumberedRows(*m, 10);
+    const QModelIndex root;
+
+    QVERIFY(!m->moveRows(root, 0, 0, root, 5));
+    QVERIFY(!m->moveRows(root, -1, 1, root, 5));
+    QVERIFY(!m->moveRows(root, 8, 3, root, 0));
+    QVERIFY(!m->moveRows(root, 0, 1, root, 11));
+    QVERIFY(!m->moveRows(m->index(0, 0), 0, 1, root, 5));
+    QVERIFY(!m->moveRows(root, 2, 3, root, 4));   // внутрь исходного диапазона
+    QVERIFY(!m->moveRows(root, 2, 3, root, 5));   // сразу за ним — перенос на место
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+
+    QSignalSpy movedSpy(m, &MyModel::rowsMoved);
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+
+    QVERIFY(m->moveRows(root, 2, 3, root, 8));
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 5, 6, 7, 2, 3, 4, 8, 9}));
+
+    QVERIFY(m->moveRows(root, 8, 2, root, 0));
+    QCOMPARE(leftColumn(*m), QVector<int>({8, 9, 0, 1, 5, 6, 7, 2, 3, 4}));
+
+    QCOMPARE(movedSpy.count(), 2);
+    QCOMPARE(movedSpy.first().at(1).toInt(), 2);
+    QCOMPARE(movedSpy.first().at(2).toInt(), 4);
+    QCOMPARE(movedSpy.first().at(4).toInt(), 8);
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+/**
+ * @brief moveRowsTo(): разрозненные строки собираются в блок с сохранением порядка.
+ */
+void TestMyModel::moveRowsTo_collects_rows_before_destination()
+{
+    fillNumberedRows(*m, 12);
+
+    QSignalSpy movedSpy(m, &MyModel::rowsMoved);
+
+    // Выше (1, 3-4), пересекающий место назначения (6-7 при destination 7), ниже (10)
+    QCOMPARE(m->moveRowsTo({10, 4, 1, 7, 3, 6, 4, 42}, 7), 6);
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 2, 5, 1, 3, 4, 6, 7, 10, 8, 9, 11}));
+
+    // 6 уже на месте, 7 стоит сразу за ним — переносятся только 1, 3-4 и 10
+    QCOMPARE(movedSpy.count(), 3);
+
+    // Блок, уже стоящий на месте, не порождает сигналов
+    movedSpy.clear();
+    QCOMPARE(m->moveRowsTo({3, 4, 5}, 6), 3);
+    QCOMPARE(movedSpy.count(), 0);
+
+    QCOMPARE(m->moveRowsTo({0}, 13), 0);
+    QCOMPARE(m->moveRowsTo({0}, -1), 0);
+    QCOMPARE(m->moveRowsTo({}, 0), 0);
+
+    // В конец таблицы
+    QCOMPARE(m->moveRowsTo({0, 1}, 12), 2);
+    QCOMPARE(leftColumn(*m), QVector<int>({5, 1, 3, 4, 6, 7, 10, 8, 9, 11, 0, 2}));
+}
+
+/**
+ * @brief dropMimeData(): свои строки переносятся (результат false — без удаления view),
+ * чужие данные отклоняются.
+ */
+void TestMyModel::dropMimeData_moves_own_rows_only()
+{
+    fillNumberedRows(*m, 6);
+
+    const QModelIndex any = m->index(0, 0);
+    QVERIFY(m->flags(any).testFlag(Qt::ItemIsDragEnabled));
+    QVERIFY(m->flags(any).testFlag(Qt::ItemIsDropEnabled));
+    QCOMPARE(m->supportedDropActions(), Qt::DropActions(Qt::MoveAction));
+
+    // Две ячейки строки 4 и одна строки 1 -> строки {1, 4}
+    std::unique_ptr<QMimeData> data(m->mimeData({m->index(4, 0), m->index(1, 2), m->index(4, 3)}));
+    QVERIFY(data);
+    QVERIFY(data->hasFormat(m->mimeTypes().first()));
+
+    QVERIFY(m->canDropMimeData(data.get(), Qt::MoveAction, -1, -1, m->index(0, 0)));
+    QVERIFY(!m->canDropMimeData(data.get(), Qt::CopyAction, -1, -1, m->index(0, 0)));
+
+    // Бросок на ячейку строки 0: блок встаёт перед ней
+    QVERIFY(!m->dropMimeData(data.get(), Qt::MoveAction, -1, -1, m->index(0, 3)));
+    QCOMPARE(leftColumn(*m), QVector<int>({1, 4, 0, 2, 3, 5}));
+
+    // Данные другой модели отклоняются
+    MyModel other;
+    fillNumberedRows(other, 6);
+    std::unique_ptr<QMimeData> foreign(other.mimeData({other.index(5, 0)}));
+    QVERIFY(!m->canDropMimeData(foreign.get(), Qt::MoveAction, 0, 0, QModelIndex()));
+    QVERIFY(!m->dropMimeData(foreign.get(), Qt::MoveAction, 0, 0, QModelIndex()));
+    QCOMPARE(leftColumn(*m), QVector<int>({1, 4, 0, 2, 3, 5}));
+}
+
 // -------------------- data() --------------------
 
 /**
@@ -427,6 +748,98 @@ void TestMyModel::data_roles_for_penStyle_and_numeric_columns()
     QCOMPARE(m->data(m->index(0, kColHeight), Qt::EditRole).toInt(), 40);
 }
 
+/**
+ * @brief Проверяет кэш иконок DecorationRole: одинаковый цвет -> попадание и общий QIcon.
+ *
+ * @details
+ * - первый запрос для цвета — промах, последующие (в т.ч. для другой строки с тем же цветом) — попадания;
+ * - QIcon из кэша разделяет данные (одинаковый cacheKey()).
+ */
+void TestMyModel::data_decoration_icon_cache_hits_and_shares_icon()
+{
+    m->slotAddData(MyRect(QColor("#102030"), Qt::SolidLine, 1, 0, 0, 10, 10));
+    m->slotAddData(MyRect(QColor("#102030"), Qt::DotLine,   2, 5, 5, 20, 20));
+    m->resetIconCacheStats();
+
+    const QIcon first  = qvariant_cast<QIcon>(m->data(m->index(0, kColPenColor), Qt::DecorationRole));
+    const QIcon second = qvariant_cast<QIcon>(m->data(m->index(1, kColPenColor), Qt::DecorationRole));
+    const QIcon third  = qvariant_cast<QIcon>(m->data(m->index(0, kColPenColor), Qt::DecorationRole));
+
+    QVERIFY(!first.isNull());
+    QCOMPARE(m->iconCacheMisses(), quint64(1));
+    QCOMPARE(m->iconCacheHits(), quint64(2));
+    QCOMPARE(second.cacheKey(), first.cacheKey());
+    QCOMPARE(third.cacheKey(), first.cacheKey());
+
+    // Не-PenColor столбцы иконок не дают и счётчики не трогают
+    QVERIFY(!m->data(m->index(0, kColPenStyle), Qt::DecorationRole).isValid());
+    QCOMPARE(m->iconCacheHits() + m->iconCacheMisses(), quint64(3));
+}
+
+/**
+ * @brief Проверяет ограничение ёмкости кэша иконок (LRU) и отключение кэша ёмкостью 0.
+ */
+void TestMyModel::data_decoration_icon_cache_respects_capacity()
+{
+    QCOMPARE(m->iconCacheCapacity(), MyModel::kDefaultIconCacheCapacity);
+
+    m->slotAddData(MyRect(QColor("#010101"), Qt::SolidLine, 1, 0, 0, 10, 10));
+    m->slotAddData(MyRect(QColor("#020202"), Qt::SolidLine, 1, 0, 0, 10, 10));
+    const QModelIndex a = m->index(0, kColPenColor);
+    const QModelIndex b = m->index(1, kColPenColor);
+
+    // Ёмкость 1: чередование двух цветов вытесняет друг друга -> только промахи
+    m->setIconCacheCapacity(1);
+    m->resetIconCacheStats();
+    m->data(a, Qt::DecorationRole);
+    m->data(b, Qt::DecorationRole);
+    m->data(a, Qt::DecorationRole);
+    QCOMPARE(m->iconCacheHits(), quint64(0));
+    QCOMPARE(m->iconCacheMisses(), quint64(3));
+
+    // Повтор последнего цвета — попадание
+    m->data(a, Qt::DecorationRole);
+    QCOMPARE(m->iconCacheHits(), quint64(1));
+
+    // Ёмкость 0: кэш отключён, но иконка всё равно возвращается
+    m->setIconCacheCapacity(0);
+    m->resetIconCacheStats();
+    QVERIFY(m->data(a, Qt::DecorationRole).canConvert<QIcon>());
+    QVERIFY(m->data(a, Qt::DecorationRole).canConvert<QIcon>());
+    QCOMPARE(m->iconCacheHits(), quint64(0));
+    QCOMPARE(m->iconCacheMisses(), quint64(2));
+}
+
+/**
+ * @brief Проверяет, что DisplayRole для PenColor/PenStyle возвращает разделяемые строки.
+ *
+ * @details
+ * Повторный запрос той же ячейки (и ячейки другой строки с тем же значением)
+ * должен вернуть QString с тем же буфером (constData()), т.е. без нового выделения памяти.
+ * Значения стиля вне именованных (например 6) тоже берутся из таблицы.
+ */
+void TestMyModel::data_display_strings_are_shared_between_calls()
+{
+    m->slotAddData(MyRect(QColor("#A0B0C0"), Qt::DashDotLine, 1, 0, 0, 10, 10));
+    m->slotAddData(MyRect(QColor("#A0B0C0"), Qt::DashDotLine, 2, 0, 0, 10, 10));
+    m->slotAddData(MyRect(QColor("#A0B0C0"), static_cast<Qt::PenStyle>(6), 3, 0, 0, 10, 10));
+
+    const QString c0 = m->data(m->index(0, kColPenColor), Qt::DisplayRole).toString();
+    const QString c1 = m->data(m->index(1, kColPenColor), Qt::DisplayRole).toString();
+    QCOMPARE(c0, QString("#a0b0c0"));
+    QCOMPARE(c1.constData(), c0.constData());
+
+    const QString s0 = m->data(m->index(0, kColPenStyle), Qt::DisplayRole).toString();
+    const QString s1 = m->data(m->index(1, kColPenStyle), Qt::DisplayRole).toString();
+    QCOMPARE(s0, QString("Qt::DashDotLine"));
+    QCOMPARE(s1.constData(), s0.constData());
+
+    const QString u0 = m->data(m->index(2, kColPenStyle), Qt::DisplayRole).toString();
+    const QString u1 = m->data(m->index(2, kColPenStyle), Qt::DisplayRole).toString();
+    QCOMPARE(u0, QString("Qt::PenStyle(6)"));
+    QCOMPARE(u1.constData(), u0.constData());
+}
+
 // -------------------- setData() --------------------
 
 /**
@@ -564,6 +977,599 @@ void TestMyModel::setData_numeric_columns_change()
     QCOMPARE(m->data(leftIdx, Qt::DisplayRole).toInt(), 777);
 }
 
+/**
+ * @brief Проверяет, что setData для PenStyle отвергает значения вне 0..Qt::MPenStyle.
+ *
+ * @details
+ * Модель хранит стиль одним байтом (PackedRect), поэтому такие значения непредставимы.
+ */
+void TestMyModel::setData_penStyle_rejects_out_of_range()
+{
+    m->slotAddData(MyRect(QColor(Qt::black), Qt::DotLine, 1, 0, 0, 10, 10));
+    const QModelIndex idx = m->index(0, kColPenStyle);
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+    QVERIFY(spy.isValid());
+
+    QVERIFY(!m->setData(idx, -1, Qt::EditRole));
+    QVERIFY(!m->setData(idx, 300, Qt::EditRole));
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(m->data(idx, Qt::EditRole).toInt(), static_cast<int>(Qt::DotLine));
+
+    QVERIFY(m->setData(idx, static_cast<int>(Qt::CustomDashLine), Qt::EditRole));
+    QCOMPARE(m->data(idx, Qt::EditRole).toInt(), static_cast<int>(Qt::CustomDashLine));
+}
+
+// -------------------- beginBatchEdit() / commitBatchEdit() --------------------
+
+namespace {
+
+/**
+ * @brief Прямоугольник dataChanged из записи QSignalSpy: {top, bottom, left, right}.
+ */
+QVector<int> spanFromSpyArgs(const QList<QVariant>& args)
+{
+    const QModelIndex topLeft = args.at(0).toModelIndex();
+    const QModelIndex bottomRight = args.at(1).toModelIndex();
+    return {topLeft.row(), bottomRight.row(), topLeft.column(), bottomRight.column()};
+}
+
+} // namespace
+
+/**
+ * @brief Внутри транзакции сигналов нет; при фиксации — по прямоугольнику
+ * на группу соседних строк в каждом наборе ролей.
+ */
+void TestMyModel::batchEdit_coalesces_dataChanged_per_role_set()
+{
+    fillNumberedRows(*m, 10);
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    m->beginBatchEdit();
+    QVERIFY(m->isBatchEditActive());
+    QVERIFY(m->setData(m->index(0, kColPenColor), QColor(Qt::green)));
+    QVERIFY(m->setData(m->index(1, kColPenColor), QColor(Qt::blue)));
+    for (int row = 2; row <= 4; ++row)
+    {
+        QVERIFY(m->setData(m->index(row, kColLeft), 100 + row));
+        QVERIFY(m->setData(m->index(row, kColLeft), 200 + row));   // повторная правка той же ячейки
+    }
+    QVERIFY(m->setData(m->index(3, kColTop), 5));
+    QVERIFY(m->setData(m->index(7, kColWidth), 1));
+    QVERIFY(m->setData(m->index(8, kColHeight), 2));
+    QVERIFY(m->setData(m->index(8, kColHeight), 10));                // вернули исходное значение
+
+    QCOMPARE(spy.count(), 0);
+    QCOMPARE(m->data(m->index(3, kColLeft), Qt::EditRole).toInt(), 203);
+
+    QVERIFY(m->commitBatchEdit());
+    QVERIFY(!m->isBatchEditActive());
+
+    QCOMPARE(spy.count(), 3);
+
+    const QList<QVariant> color = spy.takeFirst();
+    QCOMPARE(spanFromSpyArgs(color), QVector<int>({0, 1, kColPenColor, kColPenColor}));
+    QVERIFY(vectorContainsRole(rolesFromSpyArgs(color), Qt::DecorationRole));
+
+    const QList<QVariant> block = spy.takeFirst();
+    QCOMPARE(spanFromSpyArgs(block), QVector<int>({2, 4, kColLeft, kColTop}));
+    QVERIFY(!vectorContainsRole(rolesFromSpyArgs(block), Qt::DecorationRole));
+
+    QCOMPARE(spanFromSpyArgs(spy.takeFirst()), QVector<int>({7, 7, kColWidth, kColWidth}));
+
+    QVERIFY(!m->commitBatchEdit());   // транзакция не открыта
+}
+
+/**
+ * @brief Больше kMaxEditNotifications диапазонов — один охватывающий dataChanged.
+ */
+void TestMyModel::batchEdit_many_ranges_single_bounding_signal()
+{
+    const int rows = 1000;
+    fillNumberedRows(*m, rows);
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    m->beginBatchEdit();
+    for (int row = 10; row < rows; row += 3)
+        QVERIFY(m->setData(m->index(row, kColWidth), 1000 + row));
+    QVERIFY(m->commitBatchEdit());
+
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spanFromSpyArgs(spy.takeFirst()), QVector<int>({10, 997, kColWidth, kColWidth}));
+    QCOMPARE(m->data(m->index(997, kColWidth), Qt::EditRole).toInt(), 1997);
+}
+
+/**
+ * @brief Отказ setData() внутри транзакции: commitBatchEdit() возвращает false,
+ * все значения восстанавливаются.
+ */
+void TestMyModel::batchEdit_failed_setData_rolls_back_everything()
+{
+    fillNumberedRows(*m, 5);
+    const QColor before = m->data(m->index(2, kColPenColor), Qt::EditRole).value<QColor>();
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(1, kColLeft), 42));
+    QVERIFY(m->setData(m->index(2, kColPenColor), QColor(Qt::yellow)));
+    QVERIFY(!m->setData(m->index(3, kColPenColor), QString("not a color")));
+    QVERIFY(m->setData(m->index(2, kColTop), 7));
+    QVERIFY(!m->commitBatchEdit());
+
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4}));
+    compareModelColor(*m, m->index(2, kColPenColor), before);
+    QCOMPARE(m->data(m->index(2, kColTop), Qt::EditRole).toInt(), 0);
+
+    // Восстановленные ячейки уведомляются (представление могло их перерисовать):
+    // цвет строки 2 и прямоугольник строк 1-2 x Left..Top
+    QCOMPARE(spy.count(), 2);
+
+    // Явный откат
+    spy.clear();
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(0, kColHeight), 1));
+    m->rollbackBatchEdit();
+    QVERIFY(!m->isBatchEditActive());
+    QCOMPARE(m->data(m->index(0, kColHeight), Qt::EditRole).toInt(), 10);
+    QCOMPARE(spy.count(), 1);
+}
+
+/**
+ * @brief Вложенные транзакции фиксируются внешней; сдвигающие строки операции отклоняются.
+ */
+void TestMyModel::batchEdit_nested_and_structure_changes()
+{
+    fillNumberedRows(*m, 5);
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    m->beginBatchEdit();
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(0, kColLeft), 10));
+    QVERIFY(m->commitBatchEdit());
+    QCOMPARE(spy.count(), 0);
+    QVERIFY(m->isBatchEditActive());
+
+    QVERIFY(!m->insertRows(0, 1));
+    QVERIFY(!m->removeRows(0, 1));
+    QVERIFY(!m->moveRows(QModelIndex(), 0, 1, QModelIndex(), 3));
+    QCOMPARE(m->removeRowsAt({1, 2}), 0);
+    QCOMPARE(m->moveRowsTo({1}, 4), 0);
+    QCOMPARE(m->rowCount(), 5);
+
+    // Вставка в конец номера строк не сдвигает
+    QVERIFY(m->insertRows(m->rowCount(), 1));
+    QVERIFY(m->setData(m->index(5, kColLeft), 55));
+
+    QVERIFY(m->commitBatchEdit());
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(leftColumn(*m), QVector<int>({10, 1, 2, 3, 4, 55}));
+
+    // Вложенный откат откатывает и внешнюю транзакцию
+    spy.clear();
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(1, kColLeft), 11));
+    m->beginBatchEdit();
+    m->rollbackBatchEdit();
+    QVERIFY(m->isBatchEditActive());
+    QVERIFY(!m->commitBatchEdit());
+    QCOMPARE(leftColumn(*m), QVector<int>({10, 1, 2, 3, 4, 55}));
+}
+
+/**
+ * @brief Повторная правка ячейки: откат возвращает значение до транзакции,
+ * а не промежуточное.
+ */
+void TestMyModel::batchEdit_rollback_restores_value_before_repeated_edits()
+{
+    fillNumberedRows(*m, 3);
+    const QColor before = m->data(m->index(1, kColPenColor), Qt::EditRole).value<QColor>();
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(1, kColLeft), 100));
+    QVERIFY(m->setData(m->index(1, kColLeft), 200));
+    QVERIFY(m->setData(m->index(1, kColPenColor), QColor(Qt::green)));
+    QVERIFY(m->setData(m->index(1, kColPenColor), QColor(Qt::blue)));
+    m->rollbackBatchEdit();
+
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2}));
+    compareModelColor(*m, m->index(1, kColPenColor), before);
+    QCOMPARE(spy.count(), 2);
+
+    // Ячейка, вернувшаяся к исходному значению, не считается изменённой
+    spy.clear();
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(2, kColTop), 5));
+    QVERIFY(m->setData(m->index(2, kColTop), 0));
+    m->rollbackBatchEdit();
+    QCOMPARE(m->data(m->index(2, kColTop), Qt::EditRole).toInt(), 0);
+    QCOMPARE(spy.count(), 0);
+}
+
+/**
+ * @brief Откат удаляет строки, добавленные в конец внутри транзакции, и их записи истории.
+ */
+void TestMyModel::batchEdit_rollback_removes_appended_rows()
+{
+    fillNumberedRows(*m, 3);
+    m->clearHistory();
+    QVERIFY(m->setData(m->index(0, kColLeft), 100));
+
+    QSignalSpy removedSpy(m, &MyModel::rowsRemoved);
+
+    m->beginBatchEdit();
+    QVERIFY(m->insertRows(m->rowCount(), 2));
+    QVERIFY(m->setData(m->index(3, kColLeft), 33));
+    m->appendRects(QVector<MyRect>{MyRect(QColor(Qt::blue), Qt::DotLine, 2, 40, 0, 10, 10)});
+    m->slotAddData(MyRect(QColor(Qt::green), Qt::DashLine, 3, 50, 0, 10, 10));
+    QVERIFY(m->setData(m->index(1, kColLeft), 11));
+    QCOMPARE(m->rowCount(), 7);
+    m->rollbackBatchEdit();
+
+    QCOMPARE(m->rowCount(), 3);
+    QCOMPARE(leftColumn(*m), QVector<int>({100, 1, 2}));
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(removedSpy.first().at(1).toInt(), 3);
+    QCOMPARE(removedSpy.first().at(2).toInt(), 6);
+
+    // В истории — только правка до транзакции
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2}));
+    QVERIFY(!m->canUndo());
+
+    // Неудачный setData() откатывает так же
+    m->beginBatchEdit();
+    QVERIFY(m->insertRows(m->rowCount(), 1));
+    QVERIFY(!m->setData(m->index(0, kColPenColor), QString("not a color")));
+    QVERIFY(!m->commitBatchEdit());
+    QCOMPARE(m->rowCount(), 3);
+}
+
+// -------------------- undo() / redo() --------------------
+
+/**
+ * @brief Правки ячеек отменяются по одной; подряд идущие правки одной ячейки — одним шагом.
+ */
+void TestMyModel::undo_redo_setData_merges_same_cell()
+{
+    fillNumberedRows(*m, 3);
+    m->clearHistory();
+    QVERIFY(!m->canUndo());
+    QVERIFY(!m->undo());
+
+    QVERIFY(m->setData(m->index(0, kColLeft), 5));
+    QVERIFY(m->setData(m->index(0, kColLeft), 6));
+    QVERIFY(m->setData(m->index(1, kColPenColor), QColor(Qt::green)));
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+
+    QVERIFY(m->undo());
+    QCOMPARE(spy.count(), 1);
+    QVERIFY(vectorContainsRole(rolesFromSpyArgs(spy.takeFirst()), Qt::DecorationRole));
+    compareModelColor(*m, m->index(1, kColPenColor), QColor(1, 0, 0));
+
+    QVERIFY(m->undo());
+    QCOMPARE(m->data(m->index(0, kColLeft), Qt::EditRole).toInt(), 0);
+    QVERIFY(!m->canUndo());
+
+    QVERIFY(m->redo());
+    QCOMPARE(m->data(m->index(0, kColLeft), Qt::EditRole).toInt(), 6);
+    QVERIFY(m->redo());
+    compareModelColor(*m, m->index(1, kColPenColor), QColor(Qt::green));
+    QVERIFY(!m->redo());
+
+    // Новая правка после отмены очищает повтор
+    QVERIFY(m->undo());
+    QVERIFY(m->setData(m->index(2, kColTop), 1));
+    QVERIFY(!m->canRedo());
+}
+
+/**
+ * @brief Вставка, удаление и перенос строк отменяются и повторяются с тем же содержимым.
+ */
+void TestMyModel::undo_redo_row_operations_restore_contents()
+{
+    fillNumberedRows(*m, 6);
+    m->clearHistory();
+
+    // Вставка: повтор возвращает строку с содержимым на момент отмены
+    QVERIFY(m->insertRows(2, 1));
+    QVERIFY(m->setData(m->index(2, kColLeft), 77));
+    QVERIFY(m->undo());
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5}));
+    QVERIFY(m->redo());
+    QCOMPARE(m->rowCount(), 7);
+    QVERIFY(m->redo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 77, 2, 3, 4, 5}));
+    QVERIFY(m->undo());
+    QVERIFY(m->undo());
+
+    // Удаление
+    QVERIFY(m->removeRows(1, 2));
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5}));
+    QVERIFY(m->redo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 3, 4, 5}));
+    QVERIFY(m->undo());
+
+    // Перенос вниз и вверх
+    QVERIFY(m->moveRows(QModelIndex(), 0, 2, QModelIndex(), 5));
+    QVERIFY(m->moveRows(QModelIndex(), 4, 2, QModelIndex(), 1));
+    QCOMPARE(leftColumn(*m), QVector<int>({2, 1, 5, 3, 4, 0}));
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({2, 3, 4, 0, 1, 5}));
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5}));
+
+    // Несколько диапазонов / сборка блока — один шаг
+    QCOMPARE(m->removeRowsAt({5, 0, 2, 3}), 4);
+    QCOMPARE(m->moveRowsTo({}, 0), 0);
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5}));
+
+    QCOMPARE(m->moveRowsTo({4, 1}, 0), 2);
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3, 4, 5}));
+    QVERIFY(m->redo());
+    QCOMPARE(leftColumn(*m), QVector<int>({1, 4, 0, 2, 3, 5}));
+}
+
+/**
+ * @brief Зафиксированная транзакция — один шаг; загрузка отменяется возвратом прежней таблицы.
+ */
+void TestMyModel::undo_redo_batch_edit_and_load()
+{
+    fillNumberedRows(*m, 4);
+    m->clearHistory();
+
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(0, kColLeft), 10));
+    QVERIFY(m->setData(m->index(3, kColLeft), 13));
+    QVERIFY(!m->undo());   // внутри транзакции
+    QVERIFY(m->commitBatchEdit());
+
+    // Откаченная транзакция в историю не попадает
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(1, kColLeft), 11));
+    m->rollbackBatchEdit();
+
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3}));
+    QVERIFY(!m->canUndo());
+
+    QByteArray bytes = "#ff0000\tQt::SolidLine\t1\t42\t0\t10\t10\n";
+    QBuffer in(&bytes);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    QVERIFY(m->loadFromTsv(in));
+    QCOMPARE(leftColumn(*m), QVector<int>({42}));
+
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QVERIFY(m->undo());
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2, 3}));
+
+    QVERIFY(m->redo());
+    QCOMPARE(leftColumn(*m), QVector<int>({42}));
+}
+
+/**
+ * @brief Повторная правка ячейки в транзакции: undo() возвращает значение до транзакции.
+ */
+void TestMyModel::undo_redo_batch_edit_repeated_cell()
+{
+    fillNumberedRows(*m, 3);
+    m->clearHistory();
+
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(0, kColLeft), 10));
+    QVERIFY(m->setData(m->index(0, kColLeft), 20));
+    QVERIFY(m->setData(m->index(0, kColLeft), 30));
+    QVERIFY(m->commitBatchEdit());
+    QCOMPARE(leftColumn(*m), QVector<int>({30, 1, 2}));
+
+    QVERIFY(m->undo());
+    QCOMPARE(leftColumn(*m), QVector<int>({0, 1, 2}));
+    QVERIFY(!m->canUndo());
+
+    QVERIFY(m->redo());
+    QCOMPARE(leftColumn(*m), QVector<int>({30, 1, 2}));
+
+    // Правки, вернувшие исходное значение, шага истории не дают
+    m->clearHistory();
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(2, kColLeft), 7));
+    QVERIFY(m->setData(m->index(2, kColLeft), 2));
+    QVERIFY(m->commitBatchEdit());
+    QVERIFY(!m->canUndo());
+}
+
+/**
+ * @brief Бюджет памяти выбрасывает старые шаги; undoStateChanged — только при смене доступности.
+ */
+void TestMyModel::undo_memory_budget_and_state_signal()
+{
+    fillNumberedRows(*m, 100);
+    m->clearHistory();
+
+    QSignalSpy stateSpy(m, &MyModel::undoStateChanged);
+
+    QVERIFY(m->setData(m->index(0, kColLeft), 1000));
+    QVERIFY(m->setData(m->index(1, kColLeft), 1001));
+    QCOMPARE(stateSpy.count(), 1);
+    QCOMPARE(stateSpy.first().at(0).toBool(), true);
+    QCOMPARE(stateSpy.first().at(1).toBool(), false);
+    QVERIFY(m->undoMemoryUsage() > 0);
+
+    // Удалённые строки не помещаются в бюджет: шаг не сохраняется, старые правки тоже
+    m->setUndoMemoryBudget(m->undoMemoryUsage() + 1024);
+    QVERIFY(m->removeRows(0, 90));
+    QVERIFY(!m->canUndo());
+    QCOMPARE(m->undoMemoryUsage(), qint64(0));
+    QCOMPARE(stateSpy.count(), 2);
+    QCOMPARE(stateSpy.last().at(0).toBool(), false);
+
+    // Мелкие правки по-прежнему отменяются
+    QVERIFY(m->setData(m->index(0, kColTop), 5));
+    QVERIFY(m->undo());
+    QCOMPARE(m->data(m->index(0, kColTop), Qt::EditRole).toInt(), 0);
+}
+
+// -------------------- appendRects() --------------------
+
+/**
+ * @brief appendRects: одна пара rowsAboutToBeInserted/rowsInserted на всю пачку, без dataChanged.
+ */
+void TestMyModel::appendRects_single_insert_notification_and_values()
+{
+    m->slotAddData(MyRect(QColor(Qt::black), Qt::SolidLine, 1, 0, 0, 10, 10));
+
+    QSignalSpy aboutSpy(m, &MyModel::rowsAboutToBeInserted);
+    QSignalSpy insertedSpy(m, &MyModel::rowsInserted);
+    QSignalSpy changedSpy(m, &MyModel::dataChanged);
+    QVERIFY(aboutSpy.isValid());
+    QVERIFY(insertedSpy.isValid());
+    QVERIFY(changedSpy.isValid());
+
+    QVector<MyRect> batch;
+    for (int i = 0; i < 1000; ++i)
+        batch.append(MyRect(QColor(i % 256, 0, 0), Qt::DotLine, 2, i, -i, 5, 6));
+
+    m->appendRects(batch);
+
+    QCOMPARE(m->rowCount(), 1001);
+    QCOMPARE(aboutSpy.count(), 1);
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(changedSpy.count(), 0);
+
+    const QList<QVariant> args = insertedSpy.takeFirst();
+    QCOMPARE(args.at(1).toInt(), 1);
+    QCOMPARE(args.at(2).toInt(), 1000);
+
+    const MyRect last = m->rectAt(1000);
+    QCOMPARE(last.penColor, QColor(999 % 256, 0, 0));
+    QCOMPARE(last.penStyle, Qt::DotLine);
+    QCOMPARE(last.left, 999);
+    QCOMPARE(last.top, -999);
+}
+
+/**
+ * @brief appendRects с пустой пачкой ничего не делает.
+ */
+void TestMyModel::appendRects_empty_is_noop()
+{
+    QSignalSpy insertedSpy(m, &MyModel::rowsInserted);
+    QVERIFY(insertedSpy.isValid());
+
+    m->appendRects(QVector<MyRect>{});
+    m->appendRects(nullptr, 5);
+
+    QCOMPARE(m->rowCount(), 0);
+    QCOMPARE(insertedSpy.count(), 0);
+}
+
+// -------------------- rectAt() --------------------
+
+/**
+ * @brief Проверяет rectAt(): распаковка строки в MyRect и MyRect{} вне диапазона.
+ */
+void TestMyModel::rectAt_returns_row_and_defaults_out_of_range()
+{
+    m->slotAddData(MyRect(QColor("#AABBCC"), Qt::DashLine, 4, 5, 6, 7, 8));
+
+    const MyRect r = m->rectAt(0);
+    QCOMPARE(r.penColor, QColor("#AABBCC"));
+    QCOMPARE(r.penStyle, Qt::DashLine);
+    QCOMPARE(r.penWidth, 4);
+    QCOMPARE(r.left, 5);
+    QCOMPARE(r.top, 6);
+    QCOMPARE(r.width, 7);
+    QCOMPARE(r.height, 8);
+
+    const MyRect out = m->rectAt(1);
+    QCOMPARE(out.penColor, MyRect{}.penColor);
+    QCOMPARE(out.width, MyRect{}.width);
+    QCOMPARE(m->rectAt(-1).height, MyRect{}.height);
+}
+
+// -------------------- snapshot() --------------------
+
+/**
+ * @brief Снимок не видит правок, вставок, удалений и загрузок после него.
+ */
+void TestMyModel::snapshot_is_isolated_from_later_edits()
+{
+    const int rows = 2 * RectChunks::kChunkRows + 10;
+    fillNumberedRows(*m, rows);
+
+    const RectSnapshot snap = m->snapshot();
+    QCOMPARE(snap.size(), rows);
+    QCOMPARE(snap.rows().layout(), m_layout);
+
+    QVERIFY(m->setData(m->index(RectChunks::kChunkRows + 1, kColLeft), -5, Qt::EditRole));
+    QVERIFY(m->insertRows(0, 3));
+    QVERIFY(m->removeRows(rows - 5, 5));
+
+    QCOMPARE(snap.size(), rows);
+    for (int row = 0; row < rows; ++row)
+        QCOMPARE(snap.intValue(row, RectColumns::Column::Left), row);
+    QCOMPARE(snap.rectAt(7).left, 7);
+    QCOMPARE(snap.totalArea(), qint64(rows) * 100);
+
+    // Снимок после правок видит их; загрузка не трогает прежний снимок
+    const RectSnapshot after = m->snapshot();
+    QCOMPARE(after.size(), m->rowCount());
+    QCOMPARE(after.intValue(RectChunks::kChunkRows + 4, RectColumns::Column::Left), -5);
+
+    QByteArray tsv("#ff0000\tQt::SolidLine\t1\t2\t3\t4\t5\n");
+    QBuffer in(&tsv);
+    QVERIFY(in.open(QIODevice::ReadOnly | QIODevice::Text));
+    QVERIFY(m->loadFromTsv(in));
+    QCOMPARE(m->rowCount(), 1);
+    QCOMPARE(after.size(), rows - 2);
+    QVERIFY(RectSnapshot().isEmpty());
+}
+
+/**
+ * @brief Рабочий поток читает снимок без блокировок, пока GUI-поток правит модель.
+ */
+void TestMyModel::snapshot_read_on_worker_thread_while_editing()
+{
+    const int rows = 3 * RectChunks::kChunkRows;
+    fillNumberedRows(*m, rows);
+
+    const RectSnapshot snap = m->snapshot();
+    const qint64 expected = qint64(rows) * (rows - 1) / 2;
+
+    std::atomic<bool> mismatch { false };
+    std::thread reader([snap, expected, &mismatch]() {
+        for (int pass = 0; pass < 50; ++pass)
+        {
+            qint64 sum = 0;
+            for (int row = 0; row < snap.size(); ++row)
+                sum += snap.intValue(row, RectColumns::Column::Left);
+            if (sum != expected)
+                mismatch = true;
+        }
+    });
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        const int row = (i * 7919) % rows;
+        m->setData(m->index(row, kColLeft), -i, Qt::EditRole);
+    }
+    m->appendRects(QVector<MyRect>(100, MyRect{}));
+
+    reader.join();
+    QVERIFY(!mismatch);
+    QCOMPARE(snap.size(), rows);
+}
+
 // -------------------- slotAddData() --------------------
 
 /**
@@ -694,6 +1700,7 @@ void TestMyModel::tsv_roundtrip_via_buffer()
     QVERIFY(err.isEmpty());
 
     MyModel m2;
+    m2.setStorageLayout(m_layout);
     QBuffer in(&bytes);
     QVERIFY(in.open(QIODevice::ReadOnly | QIODevice::Text));
     QVERIFY(m2.loadFromTsv(in, &err));
@@ -705,11 +1712,87 @@ void TestMyModel::tsv_roundtrip_via_buffer()
     QCOMPARE(m2.data(m2.index(1, kColPenStyle), Qt::DisplayRole).toString(), QString("Qt::DashLine"));
 }
 
+/**
+ * @brief Roundtrip двоичного снимка: saveToBinary -> bytes -> loadFromBinary в новую модель.
+ *
+ * @details
+ * В отличие от TSV, снимок сохраняет и альфа-канал цвета; проверяем все поля,
+ * в т.ч. крайние значения int, и загрузку в модель с другой раскладкой хранения.
+ */
+void TestMyModel::binary_roundtrip_via_buffer()
+{
+    m->slotAddData(MyRect(QColor(0x11, 0x22, 0x33, 0x80), Qt::DotLine, 5, 10, 20, 30, 40));
+    m->slotAddData(MyRect(QColor("#AABBCC"), Qt::CustomDashLine, 1, -2147483647 - 1, 2147483647, 1, 2));
+
+    QByteArray bytes;
+    QBuffer out(&bytes);
+    QVERIFY(out.open(QIODevice::WriteOnly));
+    QString err;
+    QVERIFY(m->saveToBinary(out, &err));
+    QVERIFY(err.isEmpty());
+
+    for (auto layout : {MyModel::StorageLayout::Rows, MyModel::StorageLayout::Columns})
+    {
+        MyModel m2;
+        m2.setStorageLayout(layout);
+        QBuffer in(&bytes);
+        QVERIFY(in.open(QIODevice::ReadOnly));
+        QVERIFY2(m2.loadFromBinary(in, &err), qPrintable(err));
+
+        QCOMPARE(m2.rowCount(), 2);
+        for (int row = 0; row < 2; ++row)
+        {
+            const MyRect a = m->rectAt(row);
+            const MyRect b = m2.rectAt(row);
+            QCOMPARE(b.penColor.rgba(), a.penColor.rgba());
+            QCOMPARE(b.penStyle, a.penStyle);
+            QCOMPARE(b.penWidth, a.penWidth);
+            QCOMPARE(b.left, a.left);
+            QCOMPARE(b.top, a.top);
+            QCOMPARE(b.width, a.width);
+            QCOMPARE(b.height, a.height);
+        }
+    }
+}
+
+/**
+ * @brief Обрезанный или чужой двоичный файл: ошибка, модель не меняется.
+ */
+void TestMyModel::binary_load_error_does_not_modify_model()
+{
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+
+    QByteArray bytes;
+    {
+        MyModel src;
+        src.slotAddData(MyRect(QColor("#112233"), Qt::DotLine, 5, 10, 20, 30, 40));
+        src.slotAddData(MyRect(QColor("#445566"), Qt::DashLine, 1, 0, 0, 1, 2));
+        QBuffer out(&bytes);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        QVERIFY(src.saveToBinary(out));
+    }
+
+    const QByteArray truncated = bytes.left(bytes.size() - 1);
+    const QByteArray tsv = "#112233\tQt::DotLine\t5\t10\t20\t30\t40\n";
+
+    for (const QByteArray& broken : {truncated, tsv})
+    {
+        QBuffer in(const_cast<QByteArray*>(&broken));
+        QVERIFY(in.open(QIODevice::ReadOnly));
+        QString err;
+        QVERIFY(!m->loadFromBinary(in, &err));
+        QVERIFY(!err.isEmpty());
+
+        QCOMPARE(m->rowCount(), 1);
+        QCOMPARE(m->data(m->index(0, kColPenColor), Qt::DisplayRole).toString(), QString("#010203"));
+    }
+}
+
 /**
  * @brief Проверяет поддержку альтернативных форматов PenStyle при чтении TSV.
  *
  * @details
- * MyModel::penStyleFromString() поддерживает:
+ * RectFormat::parsePenStyle() поддерживает:
  * - "3" (число)
  * - "Qt::PenStyle(3)"
  * - "Qt::DotLine" (полное имя)
@@ -791,7 +1874,7 @@ void TestMyModel::tsv_load_invalid_color_does_not_modify_model()
  * @brief Ошибка формата: невалидный стиль пера.
  *
  * @details
- * По реализации penStyleFromString():
+ * По реализации RectFormat::parsePenStyle():
  * - если стиль не распознан, styleOk=false => loadFromTsv возвращает false.
  * Также проверяем гарантию “модель не меняется при ошибке”.
  */
@@ -814,7 +1897,7 @@ void TestMyModel::tsv_load_invalid_style_does_not_modify_model()
  * @brief Ошибка формата: одно из числовых полей не парсится в int.
  *
  * @details
- * В loadFromTsv() есть локальная parseInt(), которая при ошибке:
+ * Разбор целых полей (RectFormat::parseInt()) при ошибке:
  * - возвращает false,
  * - пишет error,
  * - и не меняет текущую модель (tmp не применяется).
@@ -835,5 +1918,681 @@ void TestMyModel::tsv_load_invalid_integer_does_not_modify_model()
     QCOMPARE(m->data(m->index(0, kColLeft), Qt::EditRole).toInt(), beforeLeft);
 }
 
-QTEST_MAIN(TestMyModel)
+/**
+ * @brief Ошибка формата: числовой стиль пера вне 0..Qt::MPenStyle.
+ */
+void TestMyModel::tsv_load_out_of_range_style_does_not_modify_model()
+{
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+
+    QByteArray bad = "#112233\tQt::PenStyle(99)\t1\t0\t0\t10\t10\n";
+    QBuffer in(&bad);
+    QVERIFY(in.open(QIODevice::ReadOnly | QIODevice::Text));
+    QString err;
+    QVERIFY(!m->loadFromTsv(in, &err));
+    QVERIFY(!err.isEmpty());
+
+    QCOMPARE(m->rowCount(), 1);
+    QCOMPARE(m->data(m->index(0, kColPenStyle), Qt::DisplayRole).toString(), QString("Qt::SolidLine"));
+}
+
+// -------------------- TSV: memory-mapped file --------------------
+
+/**
+ * @brief Загрузка файла через отображение в память даёт тот же результат, что и потоковая.
+ *
+ * @details
+ * Файл содержит BOM, "\r\n" и пустую строку; открывается по имени
+ * (loadFromTsv(const QString&)) в обоих режимах.
+ */
+void TestMyModel::tsv_load_file_memory_mapped_matches_stream()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("\xEF\xBB\xBF");
+    file.write("#112233\tQt::DotLine\t5\t10\t20\t30\t40\r\n");
+    file.write("\r\n");
+    file.write("#aabbcc\t2\t1\t-1\t-2\t3\t4\r\n");
+    file.write("red\tQt::PenStyle(4)\t7\t0\t0\t100\t200");
+    file.close();
+
+    MyModel mapped;
+    mapped.setStorageLayout(m_layout);
+    QCOMPARE(mapped.tsvLoadMode(), MyModel::TsvLoadMode::MemoryMap);
+
+    MyModel streamed;
+    streamed.setStorageLayout(m_layout);
+    streamed.setTsvLoadMode(MyModel::TsvLoadMode::Stream);
+
+    QString err;
+    QVERIFY2(mapped.loadFromTsv(file.fileName(), &err), qPrintable(err));
+    QVERIFY2(streamed.loadFromTsv(file.fileName(), &err), qPrintable(err));
+
+    QCOMPARE(mapped.rowCount(), 3);
+    QCOMPARE(streamed.rowCount(), 3);
+    for (int row = 0; row < 3; ++row)
+    {
+        for (int col = 0; col < kColCount; ++col)
+        {
+            QCOMPARE(mapped.data(mapped.index(row, col), Qt::EditRole),
+                     streamed.data(streamed.index(row, col), Qt::EditRole));
+        }
+    }
+    QCOMPARE(mapped.data(mapped.index(2, kColPenStyle), Qt::DisplayRole).toString(),
+             QString("Qt::DashDotLine"));
+}
+
+/**
+ * @brief Ошибка в отображённом файле: номер строки в сообщении, модель не меняется.
+ */
+void TestMyModel::tsv_load_file_memory_mapped_error_does_not_modify_model()
+{
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("#112233\tQt::DotLine\t5\t10\t20\t30\t40\n");
+    file.write("#112233\tQt::DotLine\t5\t10\tNOPE\t30\t40\n");
+    file.close();
+
+    QString err;
+    QVERIFY(!m->loadFromTsv(file.fileName(), &err));
+    QVERIFY(err.startsWith("Строка 2:"));
+
+    QCOMPARE(m->rowCount(), 1);
+    QCOMPARE(m->data(m->index(0, kColPenColor), Qt::DisplayRole).toString(), QString("#010203"));
+}
+
+/**
+ * @brief setTsvParseThreads(): отрицательное -> 0 (авто); загрузка при любом значении одинакова.
+ */
+void TestMyModel::tsvParseThreads_setting_and_parallel_load()
+{
+    QCOMPARE(m->tsvParseThreads(), 0);
+    m->setTsvParseThreads(-3);
+    QCOMPARE(m->tsvParseThreads(), 0);
+
+    QByteArray bytes;
+    for (int i = 0; i < 500; ++i)
+        bytes += "#112233\tQt::DotLine\t1\t" + QByteArray::number(i) + "\t0\t10\t10\n";
+
+    for (int threads : {1, 4, 0})
+    {
+        m->setTsvParseThreads(threads);
+        QCOMPARE(m->tsvParseThreads(), threads);
+
+        QBuffer in(&bytes);
+        QVERIFY(in.open(QIODevice::ReadOnly));
+        QString err;
+        QVERIFY2(m->loadFromTsv(in, &err), qPrintable(err));
+        QCOMPARE(m->rowCount(), 500);
+        QCOMPARE(m->data(m->index(499, kColLeft), Qt::EditRole).toInt(), 499);
+    }
+}
+
+/**
+ * @brief setTsvSaveThreads(): отрицательное -> 0 (авто); файл при любом значении побайтно одинаков.
+ */
+void TestMyModel::tsvSaveThreads_setting_and_identical_output()
+{
+    QCOMPARE(m->tsvSaveThreads(), 0);
+    m->setTsvSaveThreads(-2);
+    QCOMPARE(m->tsvSaveThreads(), 0);
+
+    // Больше двух блоков TsvWriter::kParallelChunkRows — включается параллельная запись.
+    const int rows = 2 * TsvWriter::kParallelChunkRows + 123;
+    QVector<MyRect> rects;
+    rects.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        rects.push_back(MyRect(QColor(i % 256, 0, 255 - i % 256), static_cast<Qt::PenStyle>(i % 6),
+                               1 + i % 4, i, -i, 10 + i % 100, 20 + i % 50));
+    m->appendRects(rects);
+
+    QByteArray expected;
+    for (int threads : {1, 2, 4, 0})
+    {
+        m->setTsvSaveThreads(threads);
+        QCOMPARE(m->tsvSaveThreads(), threads);
+
+        QByteArray bytes;
+        QBuffer out(&bytes);
+        QVERIFY(out.open(QIODevice::WriteOnly));
+        QString err;
+        QVERIFY2(m->saveToTsv(out, &err), qPrintable(err));
+
+        if (threads == 1)
+            expected = bytes;
+        else
+            QCOMPARE(bytes, expected);
+    }
+    QCOMPARE(expected.count('\n'), rows);
+}
+
+// -------------------- async load/save --------------------
+
+namespace {
+
+/**
+ * @brief Пишет во временный файл TSV из @p rows строк (через синхронный saveToTsv()).
+ */
+bool writeSampleTsv(QTemporaryFile& file, int rows)
+{
+    MyModel source;
+    QVector<MyRect> rects;
+    rects.reserve(rows);
+    for (int i = 0; i < rows; ++i)
+        rects.push_back(MyRect(QColor(i % 256, 0, 0), Qt::DashLine, 1, i, -i, 10, 20));
+    source.appendRects(rects);
+
+    if (!file.open())
+        return false;
+    file.close();
+    return source.saveToTsv(file.fileName());
+}
+
+} // namespace
+
+/**
+ * @brief Фоновая загрузка: один modelReset, прогресс до конца файла, повторный запуск отклоняется.
+ */
+void TestMyModel::asyncLoad_applies_rows_with_single_reset_and_progress()
+{
+    const int rows = 3 * MyModel::kAsyncBatchRows + 17;
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, rows));
+
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QSignalSpy progressSpy(m, &MyModel::ioProgress);
+    QSignalSpy finishedSpy(m, &MyModel::loadFinished);
+
+    QVERIFY(m->loadFromTsvAsync(file.fileName()));
+    QVERIFY(m->isAsyncOperationRunning());
+    QVERIFY(!m->loadFromTsvAsync(file.fileName()));
+    QVERIFY(!m->saveToTsvAsync(file.fileName()));
+
+    QVERIFY(finishedSpy.wait(30000));
+    QVERIFY(!m->isAsyncOperationRunning());
+
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), true);
+    QCOMPARE(args.at(1).toBool(), false);
+    QVERIFY(args.at(2).toString().isEmpty());
+
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(m->rowCount(), rows);
+    QCOMPARE(m->data(m->index(rows - 1, kColLeft), Qt::EditRole).toInt(), rows - 1);
+
+    QVERIFY(progressSpy.count() >= 4);
+    const QList<QVariant> last = progressSpy.last();
+    QCOMPARE(last.at(0).toLongLong(), QFileInfo(file.fileName()).size());
+    QCOMPARE(last.at(1).toLongLong(), QFileInfo(file.fileName()).size());
+    QCOMPARE(last.at(2).toInt(), rows);
+}
+
+/**
+ * @brief Отмена до применения результата: модель не меняется, finished(canceled=true).
+ */
+void TestMyModel::asyncLoad_cancel_does_not_modify_model()
+{
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, 1000));
+
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QSignalSpy finishedSpy(m, &MyModel::loadFinished);
+
+    QVERIFY(m->loadFromTsvAsync(file.fileName()));
+    m->cancelAsyncOperation();
+    QVERIFY(finishedSpy.wait(30000));
+
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), false);
+    QCOMPARE(args.at(1).toBool(), true);
+
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(m->rowCount(), 1);
+    QCOMPARE(m->data(m->index(0, kColPenColor), Qt::DisplayRole).toString(), QString("#010203"));
+}
+
+/**
+ * @brief Ошибка формата в фоне: текст с номером строки, модель не меняется.
+ */
+void TestMyModel::asyncLoad_error_reports_line_and_keeps_model()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("#112233\tQt::DotLine\t5\t10\t20\t30\t40\n");
+    file.write("#112233\tQt::DotLine\t5\t10\t20\t30\n");
+    file.close();
+
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+    QSignalSpy finishedSpy(m, &MyModel::loadFinished);
+
+    QVERIFY(m->loadFromTsvAsync(file.fileName()));
+    QVERIFY(finishedSpy.wait(30000));
+
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), false);
+    QCOMPARE(args.at(1).toBool(), false);
+    QVERIFY(args.at(2).toString().startsWith("Строка 2:"));
+    QCOMPARE(m->rowCount(), 1);
+}
+
+/**
+ * @brief Фоновое сохранение даёт тот же файл, что и синхронное.
+ */
+void TestMyModel::asyncSave_matches_sync_save()
+{
+    QVector<MyRect> rects;
+    for (int i = 0; i < MyModel::kAsyncBatchRows + 5; ++i)
+        rects.push_back(MyRect(QColor(0, i % 256, 0), static_cast<Qt::PenStyle>(i % 6), 2, i, i, 5, 6));
+    m->appendRects(rects);
+
+    QTemporaryFile syncFile;
+    QVERIFY(syncFile.open());
+    syncFile.close();
+    QVERIFY(m->saveToTsv(syncFile.fileName()));
+
+    QTemporaryFile asyncFile;
+    QVERIFY(asyncFile.open());
+    asyncFile.close();
+
+    QSignalSpy finishedSpy(m, &MyModel::saveFinished);
+    QVERIFY(m->saveToTsvAsync(asyncFile.fileName()));
+
+    // Правка во время сохранения не попадает в файл (сохраняется снимок)
+    QVERIFY(m->setData(m->index(0, kColLeft), 12345, Qt::EditRole));
+
+    QVERIFY(finishedSpy.wait(30000));
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), true);
+    QCOMPARE(args.at(1).toBool(), false);
+
+    QFile a(syncFile.fileName());
+    QFile b(asyncFile.fileName());
+    QVERIFY(a.open(QIODevice::ReadOnly));
+    QVERIFY(b.open(QIODevice::ReadOnly));
+    QCOMPARE(b.readAll(), a.readAll());
+}
+
+// -------------------- incremental load --------------------
+
+/**
+ * @brief Постепенная загрузка: порции не больше kFetchBatchRows, итог = loadFromTsv().
+ *
+ * @details
+ * QAbstractItemModelTester сам вызывает fetchMore() после сброса модели,
+ * поэтому число строк сразу после открытия проверяется только сверху.
+ */
+void TestMyModel::incrementalLoad_fetches_in_batches_and_matches_full_load()
+{
+    const int rows = 3 * MyModel::kFetchBatchRows + 17;
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, rows));
+
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QSignalSpy insertSpy(m, &MyModel::rowsInserted);
+    QSignalSpy finishedSpy(m, &MyModel::loadFinished);
+
+    QString error;
+    QVERIFY2(m->openTsvIncremental(file.fileName(), &error), qPrintable(error));
+    QCOMPARE(resetSpy.count(), 1);
+    QVERIFY(m->isIncrementalLoadActive());
+    QVERIFY(m->rowCount() <= MyModel::kFetchBatchRows);
+    QVERIFY(!m->canFetchMore(m->index(0, 0)));
+
+    int fetches = 0;
+    while (m->canFetchMore(QModelIndex()))
+    {
+        m->fetchMore(QModelIndex());
+        QVERIFY(++fetches <= rows);
+    }
+
+    QVERIFY(!m->isIncrementalLoadActive());
+    QCOMPARE(m->rowCount(), rows);
+    QCOMPARE(resetSpy.count(), 1);
+
+    for (const QList<QVariant>& args : insertSpy)
+        QVERIFY(args.at(2).toInt() - args.at(1).toInt() + 1 <= MyModel::kFetchBatchRows);
+    QVERIFY(insertSpy.count() >= rows / MyModel::kFetchBatchRows);
+
+    QCOMPARE(finishedSpy.count(), 1);
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), true);
+    QCOMPARE(args.at(1).toBool(), false);
+
+    // Лишний fetchMore() после конца ничего не делает
+    m->fetchMore(QModelIndex());
+    QCOMPARE(m->rowCount(), rows);
+    QCOMPARE(finishedSpy.count(), 0);
+
+    MyModel full;
+    QVERIFY(full.loadFromTsv(file.fileName()));
+    QCOMPARE(full.rowCount(), rows);
+    for (int r = 0; r < rows; ++r)
+        for (int c = 0; c < kColCount; ++c)
+            QCOMPARE(m->data(m->index(r, c), Qt::EditRole), full.data(full.index(r, c), Qt::EditRole));
+}
+
+/**
+ * @brief Ошибка формата в середине файла: подгруженные строки остаются,
+ * загрузка останавливается, loadFinished(false) с номером строки.
+ */
+void TestMyModel::incrementalLoad_error_keeps_fetched_rows_and_stops()
+{
+    const int goodRows = MyModel::kFetchBatchRows + 10;
+
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, goodRows));
+    {
+        QFile f(file.fileName());
+        QVERIFY(f.open(QIODevice::Append));
+        QVERIFY(f.write("#ff0000\tQt::SolidLine\t1\t2\n") > 0);
+    }
+
+    QSignalSpy finishedSpy(m, &MyModel::loadFinished);
+    QVERIFY(m->openTsvIncremental(file.fileName()));
+
+    while (m->canFetchMore(QModelIndex()))
+        m->fetchMore(QModelIndex());
+
+    QVERIFY(!m->isIncrementalLoadActive());
+    QCOMPARE(m->rowCount(), goodRows);
+    QCOMPARE(m->data(m->index(goodRows - 1, kColLeft), Qt::EditRole).toInt(), goodRows - 1);
+
+    QCOMPARE(finishedSpy.count(), 1);
+    const QList<QVariant> args = finishedSpy.takeFirst();
+    QCOMPARE(args.at(0).toBool(), false);
+    QCOMPARE(args.at(1).toBool(), false);
+    QVERIFY(args.at(2).toString().startsWith(QString("Строка %1:").arg(goodRows + 1)));
+}
+
+/**
+ * @brief Несуществующий файл не трогает модель; полная загрузка прерывает постепенную.
+ */
+void TestMyModel::incrementalLoad_open_error_and_full_load_stop_fetching()
+{
+    m->slotAddData(MyRect(QColor("#010203"), Qt::SolidLine, 1, 0, 0, 10, 10));
+
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QString error;
+    QVERIFY(!m->openTsvIncremental("/nonexistent/dir/file.tsv", &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!m->isIncrementalLoadActive());
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(m->rowCount(), 1);
+
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, 2 * MyModel::kFetchBatchRows));
+    QVERIFY(m->openTsvIncremental(file.fileName()));
+    QVERIFY(m->canFetchMore(QModelIndex()));
+
+    QBuffer buffer;
+    buffer.setData("#00ff00\tQt::DotLine\t3\t10\t10\t100\t200\n");
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(m->loadFromTsv(buffer));
+
+    QVERIFY(!m->isIncrementalLoadActive());
+    QVERIFY(!m->canFetchMore(QModelIndex()));
+    QCOMPARE(m->rowCount(), 1);
+    QCOMPARE(m->data(m->index(0, kColPenColor), Qt::DisplayRole).toString(), QString("#00ff00"));
+}
+
+// -------------------- TSV window via row index --------------------
+
+/**
+ * @brief loadFromTsvRange(): окно файла одним reset, спутник индекса создаётся,
+ * ошибка (начало за концом файла) модель не меняет.
+ */
+void TestMyModel::tsvRange_loads_window_and_keeps_model_on_error()
+{
+    const int rows = 3 * TsvIndex::kDefaultStride + 100;
+    QTemporaryFile file;
+    QVERIFY(writeSampleTsv(file, rows));
+
+    QSignalSpy resetSpy(m, &MyModel::modelReset);
+    QString error;
+    QVERIFY2(m->loadFromTsvRange(file.fileName(), 2 * TsvIndex::kDefaultStride + 5, 50, &error),
+             qPrintable(error));
+    QCOMPARE(resetSpy.count(), 1);
+    QCOMPARE(m->rowCount(), 50);
+    QCOMPARE(m->data(m->index(0, kColLeft), Qt::EditRole).toInt(), 2 * TsvIndex::kDefaultStride + 5);
+    QCOMPARE(m->data(m->index(49, kColLeft), Qt::EditRole).toInt(), 2 * TsvIndex::kDefaultStride + 54);
+
+    const QString sidecar = TsvIndex::sidecarFileName(file.fileName());
+    QVERIFY(QFileInfo::exists(sidecar));
+
+    // Окно у конца файла усекается
+    QVERIFY(m->loadFromTsvRange(file.fileName(), rows - 10, 1000));
+    QCOMPARE(m->rowCount(), 10);
+    QCOMPARE(m->data(m->index(9, kColLeft), Qt::EditRole).toInt(), rows - 1);
+
+    resetSpy.clear();
+    QVERIFY(!m->loadFromTsvRange(file.fileName(), rows + 1, 10, &error));
+    QVERIFY(!error.isEmpty());
+    QCOMPARE(resetSpy.count(), 0);
+    QCOMPARE(m->rowCount(), 10);
+
+    QFile::remove(sidecar);
+}
+
+// -------------------- storage layout + column scans --------------------
+
+/**
+ * @brief Переключение раскладки туда и обратно не меняет данные и не эмитит сигналов.
+ */
+void TestMyModel::storageLayout_switch_preserves_data()
+{
+    m->slotAddData(MyRect(QColor("#112233"), Qt::DotLine,  5, 10, 20, 30, 40));
+    m->slotAddData(MyRect(QColor("#AABBCC"), Qt::DashLine, 1, -1, -2,  3,  4));
+
+    QSignalSpy spy(m, &MyModel::dataChanged);
+    QVERIFY(spy.isValid());
+
+    const MyModel::StorageLayout other = (m_layout == MyModel::StorageLayout::Rows)
+        ? MyModel::StorageLayout::Columns
+        : MyModel::StorageLayout::Rows;
+
+    m->setStorageLayout(other);
+    QCOMPARE(m->storageLayout(), other);
+    QCOMPARE(m->rowCount(), 2);
+    compareModelColor(*m, m->index(1, kColPenColor), QColor("#AABBCC"));
+    QCOMPARE(m->data(m->index(0, kColPenStyle), Qt::DisplayRole).toString(), QString("Qt::DotLine"));
+    QCOMPARE(m->data(m->index(1, kColTop), Qt::EditRole).toInt(), -2);
+
+    // Редактирование в новой раскладке
+    QVERIFY(m->setData(m->index(0, kColHeight), 99, Qt::EditRole));
+
+    m->setStorageLayout(m_layout);
+    QCOMPARE(m->data(m->index(0, kColHeight), Qt::EditRole).toInt(), 99);
+    QCOMPARE(m->data(m->index(0, kColWidth), Qt::EditRole).toInt(), 30);
+    QCOMPARE(spy.count(), 1);
+}
+
+/**
+ * @brief Поколоночные проходы: сумма площадей, фильтр по диапазону и порядок сортировки.
+ */
+void TestMyModel::columnScans_totalArea_rowsInRange_rowOrderBy()
+{
+    m->slotAddData(MyRect(QColor(Qt::red),   Qt::SolidLine, 1, 30, 0, 10, 10)); // area 100
+    m->slotAddData(MyRect(QColor(Qt::green), Qt::DotLine,   1, 10, 0, 20,  5)); // area 100
+    m->slotAddData(MyRect(QColor(Qt::red),   Qt::DashLine,  1, 20, 0,  3,  7)); // area 21
+    m->slotAddData(MyRect(QColor(Qt::red),   Qt::SolidLine, 1, 10, 0, 50,  1)); // area 50
+
+    QCOMPARE(m->totalArea(), qint64(271));
+
+    QCOMPARE(m->rowsInRange(kColWidth, 10, 20), (QVector<int>{0, 1}));
+    QCOMPARE(m->rowsInRange(kColPenStyle, Qt::SolidLine, Qt::SolidLine), (QVector<int>{0, 3}));
+    QVERIFY(m->rowsInRange(kColCount, 0, 100).isEmpty());
+
+    // Устойчивость: строки 1 и 3 с Left=10 сохраняют исходный порядок
+    QCOMPARE(m->rowOrderBy(kColLeft), (QVector<int>{1, 3, 2, 0}));
+    QVERIFY(m->rowOrderBy(-1).isEmpty());
+
+    // Большие значения не переполняют 32 бита
+    QVERIFY(m->setData(m->index(0, kColWidth),  100000, Qt::EditRole));
+    QVERIFY(m->setData(m->index(0, kColHeight), 100000, Qt::EditRole));
+    QCOMPARE(m->totalArea(), qint64(10000000000LL) + 171);
+}
+
+// -------------------- spatial queries --------------------
+
+namespace {
+
+/// Нормализованные границы строки модели [x1, x2) × [y1, y2).
+void rowBounds(const MyModel& model, int row, qint64& x1, qint64& y1, qint64& x2, qint64& y2)
+{
+    const MyRect r = model.rectAt(row);
+    x1 = qMin<qint64>(r.left, qint64(r.left) + r.width);
+    x2 = qMax<qint64>(r.left, qint64(r.left) + r.width);
+    y1 = qMin<qint64>(r.top, qint64(r.top) + r.height);
+    y2 = qMax<qint64>(r.top, qint64(r.top) + r.height);
+}
+
+/**
+ * @brief Сверяет rowsAt()/rowsIntersecting()/nearestRows() с полным перебором на сетке проб.
+ */
+bool spatialQueriesMatchScan(const MyModel& model)
+{
+    for (int px = -40; px <= 240; px += 20)
+    {
+        for (int py = -40; py <= 240; py += 20)
+        {
+            const QPoint p(px, py);
+            const QRect area(px, py, 25, 15);
+
+            QVector<int> at;
+            QVector<int> intersecting;
+            QVector<QPair<double, int>> byDistance;
+            for (int row = 0; row < model.rowCount(); ++row)
+            {
+                qint64 x1, y1, x2, y2;
+                rowBounds(model, row, x1, y1, x2, y2);
+                if (x1 <= px && px < x2 && y1 <= py && py < y2)
+                    at.append(row);
+                if (x1 < x2 && y1 < y2 && x1 < px + 25 && px < x2 && y1 < py + 15 && py < y2)
+                    intersecting.append(row);
+
+                const qint64 dx = px < x1 ? x1 - px : (px > x2 ? px - x2 : 0);
+                const qint64 dy = py < y1 ? y1 - py : (py > y2 ? py - y2 : 0);
+                byDistance.append(qMakePair(double(dx * dx + dy * dy), row));
+            }
+            std::sort(byDistance.begin(), byDistance.end());
+            QVector<int> nearest;
+            for (int i = 0; i < qMin(3, byDistance.size()); ++i)
+                nearest.append(byDistance.at(i).second);
+
+            if (model.rowsAt(p) != at || model.rowsIntersecting(area) != intersecting
+                || model.nearestRows(p, 3) != nearest)
+                return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @brief Запросы по точке, области и k ближайших на небольшом наборе строк.
+ */
+void TestMyModel::spatialQueries_point_area_and_nearest()
+{
+    QVERIFY(m->rowsAt(QPoint(0, 0)).isEmpty());
+    QVERIFY(m->nearestRows(QPoint(0, 0), 5).isEmpty());
+
+    m->slotAddData(MyRect(QColor(Qt::red),   Qt::SolidLine, 1,   0,   0, 100, 100)); // 0
+    m->slotAddData(MyRect(QColor(Qt::green), Qt::SolidLine, 1,  50,  50,  10,  10)); // 1
+    m->slotAddData(MyRect(QColor(Qt::blue),  Qt::SolidLine, 1, 200,   0,  20,  20)); // 2
+    m->slotAddData(MyRect(QColor(Qt::black), Qt::SolidLine, 1, 300, 300,   0,  50)); // 3: пустой
+
+    QCOMPARE(m->rowsAt(QPoint(55, 55)), QVector<int>({0, 1}));
+    QCOMPARE(m->rowsAt(QPoint(99, 99)), QVector<int>({0}));
+    QVERIFY(m->rowsAt(QPoint(100, 100)).isEmpty());
+    QVERIFY(m->rowsAt(QPoint(300, 310)).isEmpty());
+
+    QCOMPARE(m->rowsIntersecting(QRect(90, 0, 120, 5)), QVector<int>({0, 2}));
+    QCOMPARE(m->rowsIntersecting(QRect(-1000, -1000, 3000, 3000)), QVector<int>({0, 1, 2}));
+    QVERIFY(m->rowsIntersecting(QRect(100, 0, 100, 100)).isEmpty());
+
+    QCOMPARE(m->nearestRows(QPoint(55, 55), 2), QVector<int>({0, 1}));
+    QCOMPARE(m->nearestRows(QPoint(250, 10), 1), QVector<int>({2}));
+    QCOMPARE(m->nearestRows(QPoint(300, 400), 10), QVector<int>({3, 0, 2, 1}));
+}
+
+/**
+ * @brief Индекс, построенный первым запросом, следует за правками, undo/redo и загрузкой.
+ */
+void TestMyModel::spatialQueries_follow_edits_undo_and_load()
+{
+    for (int i = 0; i < 40; ++i)
+    {
+        const int left = (i * 37) % 200;
+        const int top = (i * 53) % 200;
+        m->slotAddData(MyRect(QColor(Qt::red), Qt::SolidLine, 1, left, top, 5 + i % 30, 5 + (i * 7) % 30));
+    }
+    QVERIFY(spatialQueriesMatchScan(*m));
+
+    // setData по геометрии, в том числе перенос строки далеко и «выворот»
+    QVERIFY(m->setData(m->index(3, kColLeft), 150));
+    QVERIFY(m->setData(m->index(4, kColWidth), -30));
+    QVERIFY(m->setData(m->index(5, kColHeight), 0));
+    QVERIFY(m->setData(m->index(6, kColTop), 5000));
+    QVERIFY(spatialQueriesMatchScan(*m));
+
+    // Вставка в середину, удаление, перенос
+    QVERIFY(m->insertRows(10, 3));
+    QVERIFY(m->setData(m->index(11, kColLeft), 120));
+    QVERIFY(spatialQueriesMatchScan(*m));
+    QVERIFY(m->removeRows(0, 4));
+    QVERIFY(m->moveRows(QModelIndex(), 2, 5, QModelIndex(), 30));
+    QCOMPARE(m->removeRowsAt({1, 7, 20}), 3);
+    m->appendRects({MyRect(QColor(Qt::blue), Qt::SolidLine, 1, 100, 100, 40, 40)});
+    QVERIFY(spatialQueriesMatchScan(*m));
+
+    // Откат транзакции и undo/redo
+    m->beginBatchEdit();
+    QVERIFY(m->setData(m->index(0, kColLeft), 190));
+    QVERIFY(m->setData(m->index(1, kColTop), -20));
+    m->rollbackBatchEdit();
+    QVERIFY(spatialQueriesMatchScan(*m));
+    for (int i = 0; i < 6; ++i)
+        QVERIFY(m->undo());
+    QVERIFY(spatialQueriesMatchScan(*m));
+    for (int i = 0; i < 3; ++i)
+        QVERIFY(m->redo());
+    QVERIFY(spatialQueriesMatchScan(*m));
+
+    // Загрузка подменяет таблицу: индекс строится заново при следующем запросе
+    QByteArray bytes = "#000000\tQt::SolidLine\t1\t0\t0\t10\t10\n";
+    QBuffer in(&bytes);
+    QVERIFY(in.open(QIODevice::ReadOnly | QIODevice::Text));
+    QVERIFY(m->loadFromTsv(in));
+    QCOMPARE(m->rowsAt(QPoint(5, 5)), QVector<int>({0}));
+    QVERIFY(spatialQueriesMatchScan(*m));
+    QVERIFY(m->undo());
+    QVERIFY(spatialQueriesMatchScan(*m));
+}
+
+/**
+ * @brief Точка входа: весь набор прогоняется для каждой раскладки хранения.
+ */
+int main(int argc, char* argv[])
+{
+    QApplication app(argc, argv);
+
+    int status = 0;
+    {
+        TestMyModel rows(MyModel::StorageLayout::Rows);
+        status |= QTest::qExec(&rows, argc, argv);
+    }
+    {
+        TestMyModel columns(MyModel::StorageLayout::Columns);
+        status |= QTest::qExec(&columns, argc, argv);
+    }
+    {
+        TestMyModel chunks(MyModel::StorageLayout::Chunks);
+        status |= QTest::qExec(&chunks, argc, argv);
+    }
+    return status;
+}
 #include "tst_mymodel.moc"
@@ -0,0 +1,105 @@
+// tests/tst_packedrect.cpp
+#include <QtTest/QtTest>
+#include "packedrect.h"
+
+/**
+ * @brief Набор юнит-тестов для структуры PackedRect.
+ *
+ * @details
+ * PackedRect — внутреннее упакованное представление MyRect в модели.
+ * Тесты фиксируют:
+ * - дефолты совпадают с MyRect{} (иначе insertRows() вставлял бы другие значения);
+ * - fromRect()/toRect() — взаимно обратные для RGB-цветов и стилей 0..Qt::MPenStyle;
+ * - непредставимые стиль и цвет заменяются дефолтами, а не усекаются;
+ * - диапазон представимых стилей пера.
+ */
+class TestPackedRect : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Дефолтный PackedRect распаковывается в MyRect{}.
+     */
+    void defaults_match_myrect();
+
+    /**
+     * @brief fromRect() -> toRect() сохраняет все поля (включая альфу цвета).
+     */
+    void roundtrip_preserves_fields();
+
+    /**
+     * @brief fromRect(): стиль вне 0..Qt::MPenStyle и невалидный цвет — дефолты MyRect.
+     */
+    void fromRect_replaces_unrepresentable_values();
+
+    /**
+     * @brief isValidPenStyle() принимает ровно 0..Qt::MPenStyle.
+     */
+    void isValidPenStyle_range();
+};
+
+void TestPackedRect::defaults_match_myrect()
+{
+    const MyRect r = PackedRect{}.toRect();
+    const MyRect d;
+    QCOMPARE(r.penColor, d.penColor);
+    QCOMPARE(r.penStyle, d.penStyle);
+    QCOMPARE(r.penWidth, d.penWidth);
+    QCOMPARE(r.left, d.left);
+    QCOMPARE(r.top, d.top);
+    QCOMPARE(r.width, d.width);
+    QCOMPARE(r.height, d.height);
+}
+
+void TestPackedRect::roundtrip_preserves_fields()
+{
+    const MyRect src(QColor(0x12, 0x34, 0x56, 0x78), Qt::DashDotDotLine, 7, -1, 2, 300, 400);
+    const PackedRect p = PackedRect::fromRect(src);
+    QCOMPARE(p.penColor, qRgba(0x12, 0x34, 0x56, 0x78));
+
+    const MyRect r = p.toRect();
+    QCOMPARE(r.penColor, src.penColor);
+    QCOMPARE(r.penStyle, Qt::DashDotDotLine);
+    QCOMPARE(r.penWidth, 7);
+    QCOMPARE(r.left, -1);
+    QCOMPARE(r.top, 2);
+    QCOMPARE(r.width, 300);
+    QCOMPARE(r.height, 400);
+}
+
+void TestPackedRect::fromRect_replaces_unrepresentable_values()
+{
+    const MyRect d;
+
+    // 0x100 при усечении до байта дал бы Qt::NoPen
+    for (const int style : {static_cast<int>(Qt::MPenStyle) + 1, 0x7f, 0xff, 0x100, 0x101, -1})
+    {
+        const MyRect src(QColor(Qt::red), static_cast<Qt::PenStyle>(style), 3, 1, 2, 30, 40);
+        const PackedRect p = PackedRect::fromRect(src);
+        QVERIFY(PackedRect::isValidPenStyle(p.penStyle));
+        QCOMPARE(p.style(), d.penStyle);
+        QCOMPARE(p.color(), QColor(Qt::red));
+        QCOMPARE(p.width, 30);
+    }
+
+    MyRect invalidColor;
+    invalidColor.penColor = QColor();
+    invalidColor.penStyle = Qt::DotLine;
+    const PackedRect p = PackedRect::fromRect(invalidColor);
+    QCOMPARE(p.color(), d.penColor);
+    QCOMPARE(p.style(), Qt::DotLine);
+}
+
+void TestPackedRect::isValidPenStyle_range()
+{
+    QVERIFY(PackedRect::isValidPenStyle(Qt::NoPen));
+    QVERIFY(PackedRect::isValidPenStyle(Qt::CustomDashLine));
+    QVERIFY(PackedRect::isValidPenStyle(Qt::MPenStyle));
+    QVERIFY(!PackedRect::isValidPenStyle(-1));
+    QVERIFY(!PackedRect::isValidPenStyle(static_cast<int>(Qt::MPenStyle) + 1));
+    QVERIFY(!PackedRect::isValidPenStyle(256));
+}
+
+QTEST_MAIN(TestPackedRect)
+#include "tst_packedrect.moc"
@@ -0,0 +1,215 @@
+// tests/tst_rectbinary.cpp
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QtEndian>
+
+#include "rectbinary.h"
+
+/**
+ * @brief Набор юнит-тестов для двоичного снимка (RectBinary).
+ *
+ * @details
+ * Формат — внешний контракт (файлы живут дольше программы), поэтому
+ * проверяем и сами байты заголовка/записи, и отказ на чужих данных:
+ * сигнатура, версия, раскладка столбцов, обрезанный файл, стиль пера.
+ */
+class TestRectBinary : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Заголовок: сигнатура, версия, размеры и имена столбцов из kColumns.
+     */
+    void header_layout_follows_kColumns();
+
+    /**
+     * @brief Запись: поля little-endian на своих смещениях, выравнивание — нули.
+     */
+    void record_bytes_are_little_endian();
+
+    /// Раскладки хранилища.
+    void roundtrip_preserves_rows_data();
+
+    /**
+     * @brief write() + read() сохраняют все поля (несколько блоков чтения).
+     */
+    void roundtrip_preserves_rows();
+
+    /// Порча файла и ожидаемый текст ошибки.
+    void read_rejects_broken_data_data();
+
+    /**
+     * @brief Чужие/испорченные данные отклоняются с понятной ошибкой.
+     */
+    void read_rejects_broken_data();
+};
+
+namespace {
+
+RectStore makeRows(int count, RectStore::Layout layout)
+{
+    RectStore rows(layout);
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        PackedRect r;
+        r.penColor = quint32(i) * 2654435761u;
+        r.penStyle = static_cast<quint8>(i % (int(Qt::MPenStyle) + 1));
+        r.penWidth = i % 9;
+        r.left = i;
+        r.top = -i;
+        r.width = i * 7;
+        r.height = (i % 2) ? 2147483647 : -2147483647 - 1;
+        rows.append(r);
+    }
+    return rows;
+}
+
+QByteArray writeToBytes(const RectStore& rows)
+{
+    QByteArray bytes;
+    QBuffer out(&bytes);
+    out.open(QIODevice::WriteOnly);
+    RectBinary::write(out, rows);
+    return bytes;
+}
+
+} // namespace
+
+void TestRectBinary::header_layout_follows_kColumns()
+{
+    const QByteArray h = RectBinary::makeHeader(12345);
+    QCOMPARE(h.size(), RectBinary::kHeaderSize);
+    QCOMPARE(h.size() % 8, 0);
+
+    const char* p = h.constData();
+    QCOMPARE(QByteArray(p, 8), QByteArray("RECTSNAP"));
+    QCOMPARE(qFromLittleEndian<quint32>(p + 8), RectBinary::kVersion);
+    QCOMPARE(qFromLittleEndian<quint32>(p + 12), quint32(RectBinary::kHeaderSize));
+    QCOMPARE(qFromLittleEndian<quint64>(p + 16), quint64(12345));
+    QCOMPARE(qFromLittleEndian<quint32>(p + 24), quint32(RectBinary::kRecordSize));
+    QCOMPARE(qFromLittleEndian<quint32>(p + 28), quint32(RectColumns::kColCountInt));
+
+    for (int i = 0; i < RectColumns::kColCountInt; ++i)
+    {
+        const char* desc = p + 32 + 24 * i;
+        QCOMPARE(QByteArray(desc), QByteArray(RectColumns::kColumns[i].header));
+        QCOMPARE(int(desc[16]), int(RectColumns::kColumns[i].col));
+    }
+
+    RectBinary::Header parsed;
+    QVERIFY(RectBinary::parseHeader(p, h.size(), &parsed));
+    QCOMPARE(parsed.rowCount, qint64(12345));
+    QCOMPARE(parsed.headerSize, RectBinary::kHeaderSize);
+}
+
+void TestRectBinary::record_bytes_are_little_endian()
+{
+    PackedRect r;
+    r.penColor = 0x80112233;
+    r.penStyle = static_cast<quint8>(Qt::DashDotLine);
+    r.penWidth = 3;
+    r.left = -1;
+    r.top = 0x01020304;
+    r.width = 7;
+    r.height = 8;
+
+    QByteArray rec(RectBinary::kRecordSize, '\x55');
+    RectBinary::encodeRecord(r, rec.data());
+
+    const QByteArray expected = QByteArray::fromHex(
+        "33221180" "03000000" "ffffffff" "04030201" "07000000" "08000000" "04" "000000");
+    QCOMPARE(rec, expected);
+
+    const PackedRect back = RectBinary::decodeRecord(rec.constData());
+    QCOMPARE(back.penColor, r.penColor);
+    QCOMPARE(back.penStyle, r.penStyle);
+    QCOMPARE(back.left, r.left);
+    QCOMPARE(back.top, r.top);
+}
+
+void TestRectBinary::roundtrip_preserves_rows_data()
+{
+    QTest::addColumn<int>("layout");
+
+    QTest::newRow("rows")    << int(RectStore::Layout::Rows);
+    QTest::newRow("columns") << int(RectStore::Layout::Columns);
+}
+
+void TestRectBinary::roundtrip_preserves_rows()
+{
+    QFETCH(int, layout);
+    const auto l = static_cast<RectStore::Layout>(layout);
+
+    const RectStore rows = makeRows(100000, l);
+    QByteArray bytes = writeToBytes(rows);
+    QCOMPARE(bytes.size(), RectBinary::kHeaderSize + rows.size() * RectBinary::kRecordSize);
+
+    QBuffer in(&bytes);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    RectStore back(l);
+    QString error;
+    QVERIFY2(RectBinary::read(in, back, &error), qPrintable(error));
+    QVERIFY(in.atEnd());
+
+    QCOMPARE(back.size(), rows.size());
+    for (int row = 0; row < rows.size(); ++row)
+    {
+        const PackedRect a = rows.at(row);
+        const PackedRect b = back.at(row);
+        QCOMPARE(b.penColor, a.penColor);
+        QCOMPARE(b.penStyle, a.penStyle);
+        QCOMPARE(b.penWidth, a.penWidth);
+        QCOMPARE(b.left, a.left);
+        QCOMPARE(b.top, a.top);
+        QCOMPARE(b.width, a.width);
+        QCOMPARE(b.height, a.height);
+    }
+}
+
+void TestRectBinary::read_rejects_broken_data_data()
+{
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<QString>("errorPrefix");
+
+    const QByteArray good = writeToBytes(makeRows(10, RectStore::Layout::Rows));
+
+    QByteArray badMagic = good;
+    badMagic[0] = 'X';
+
+    QByteArray newerVersion = good;
+    qToLittleEndian<quint32>(RectBinary::kVersion + 1, newerVersion.data() + 8);
+
+    QByteArray otherLayout = good;
+    otherLayout[32] = 'X'; // имя первого столбца
+
+    QByteArray badStyle = good;
+    badStyle[RectBinary::kHeaderSize + 3 * RectBinary::kRecordSize + 24] = char(int(Qt::MPenStyle) + 1);
+
+    QTest::newRow("empty")         << QByteArray()                  << "Двоичный файл обрезан";
+    QTest::newRow("tsv")           << QByteArray("#112233\tQt::DotLine\t5\t10\t20\t30\t40\n")
+                                                                    << "Неверная сигнатура";
+    QTest::newRow("magic")         << badMagic                      << "Неверная сигнатура";
+    QTest::newRow("version")       << newerVersion                  << "Неподдерживаемая версия";
+    QTest::newRow("layout")        << otherLayout                   << "Раскладка столбцов";
+    QTest::newRow("header only")   << good.left(RectBinary::kHeaderSize - 1) << "Двоичный файл обрезан";
+    QTest::newRow("records")       << good.left(good.size() - 1)    << "Двоичный файл обрезан";
+    QTest::newRow("style")         << badStyle                      << "Запись 4:";
+}
+
+void TestRectBinary::read_rejects_broken_data()
+{
+    QFETCH(QByteArray, bytes);
+    QFETCH(QString, errorPrefix);
+
+    QBuffer in(&bytes);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    RectStore out;
+    QString error;
+    QVERIFY(!RectBinary::read(in, out, &error));
+    QVERIFY2(error.startsWith(errorPrefix), qPrintable(error));
+}
+
+QTEST_MAIN(TestRectBinary)
+#include "tst_rectbinary.moc"
@@ -0,0 +1,335 @@
+// tests/tst_rectchunks.cpp
+#include <QtTest/QtTest>
+#include "rectchunks.h"
+
+/**
+ * @brief Набор юнит-тестов для блочного хранилища строк RectChunks.
+ *
+ * @details
+ * Эталон — QVector<PackedRect> с теми же операциями: содержимое обязано
+ * совпадать после каждой правки, в том числе на границах блоков, а блоки —
+ * оставаться непустыми и не больше kChunkRows. Отдельно проверяются деление
+ * и слияние блоков и копирование при записи: правка копии отделяет один блок.
+ */
+class TestRectChunks : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief append() заполняет блоки по kChunkRows строк, at() читает через границы.
+     */
+    void append_fills_whole_chunks();
+
+    /**
+     * @brief insert()/remove()/move() на границах блоков совпадают с QVector.
+     */
+    void edits_match_vector();
+
+    /**
+     * @brief Вставки в одно место делят блок, удаления сливают маленькие блоки.
+     */
+    void inserts_split_and_removals_merge_chunks();
+
+    /**
+     * @brief Удаление через несколько блоков сливает и укороченный последний блок.
+     */
+    void range_removal_merges_trailing_chunk();
+
+    /// Зерно генератора случайных правок.
+    void random_edits_match_vector_data();
+
+    /**
+     * @brief Случайная последовательность вставок/удалений/переносов совпадает с QVector.
+     */
+    void random_edits_match_vector();
+
+    /**
+     * @brief Запись в копию отделяет только блок со строкой.
+     */
+    void write_detaches_single_chunk();
+};
+
+namespace {
+
+constexpr int kChunk = RectChunks::kChunkRows;
+
+PackedRect makeRect(int i)
+{
+    PackedRect r;
+    r.left   = i;
+    r.top    = -i;
+    r.width  = i % 97;
+    r.height = i % 13;
+    return r;
+}
+
+RectChunks makeChunks(int rows)
+{
+    RectChunks chunks;
+    for (int i = 0; i < rows; ++i)
+        chunks.append(makeRect(i));
+    return chunks;
+}
+
+QVector<int> lefts(const RectChunks& chunks)
+{
+    QVector<int> result;
+    for (int i = 0; i < chunks.size(); ++i)
+        result.append(chunks.at(i).left);
+    return result;
+}
+
+QVector<int> lefts(const QVector<PackedRect>& rows)
+{
+    QVector<int> result;
+    for (const PackedRect& r : rows)
+        result.append(r.left);
+    return result;
+}
+
+/// Блоки непустые, не больше kChunkRows и в сумме дают size().
+bool chunksAreValid(const RectChunks& chunks)
+{
+    int total = 0;
+    for (int i = 0; i < chunks.chunkCount(); ++i)
+    {
+        const int n = chunks.chunk(i).size();
+        if (n == 0 || n > kChunk)
+            return false;
+        total += n;
+    }
+    return total == chunks.size();
+}
+
+} // namespace
+
+void TestRectChunks::append_fills_whole_chunks()
+{
+    RectChunks chunks;
+    QVERIFY(chunks.isEmpty());
+    QCOMPARE(chunks.chunkCount(), 0);
+
+    chunks = makeChunks(2 * kChunk + 5);
+    QCOMPARE(chunks.size(), 2 * kChunk + 5);
+    QCOMPARE(chunks.chunkCount(), 3);
+    QCOMPARE(chunks.chunk(2).size(), 5);
+    QCOMPARE(chunks.at(kChunk - 1).left, kChunk - 1);
+    QCOMPARE(chunks.at(kChunk).left, kChunk);
+
+    // Блок строк из середины другого хранилища, через границу блока
+    RectChunks part;
+    part.append(chunks, kChunk - 3, 10);
+    QCOMPARE(part.size(), 10);
+    QCOMPARE(part.at(0).left, kChunk - 3);
+    QCOMPARE(part.at(9).left, kChunk + 6);
+
+    // Добавление строк самого хранилища: источник растёт по ходу копирования
+    part = makeChunks(kChunk + 5);
+    part.append(part, 3, kChunk);
+    QCOMPARE(part.size(), 2 * kChunk + 5);
+    QVERIFY(chunksAreValid(part));
+    QCOMPARE(part.at(kChunk + 4).left, kChunk + 4);
+    QCOMPARE(part.at(kChunk + 5).left, 3);
+    QCOMPARE(part.at(2 * kChunk + 4).left, kChunk + 2);
+
+    chunks.clear();
+    QVERIFY(chunks.isEmpty());
+    QCOMPARE(chunks.chunkCount(), 0);
+}
+
+void TestRectChunks::edits_match_vector()
+{
+    const int rows = 3 * kChunk + 100;
+
+    RectChunks chunks = makeChunks(rows);
+    QVector<PackedRect> expected;
+    for (int i = 0; i < rows; ++i)
+        expected.append(makeRect(i));
+
+    chunks.insert(kChunk - 1, 3, makeRect(-1));
+    expected.insert(kChunk - 1, 3, makeRect(-1));
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    chunks.remove(2 * kChunk - 10, kChunk);
+    expected.remove(2 * kChunk - 10, kChunk);
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    chunks.insert(0, makeChunks(kChunk + 1));
+    for (int i = kChunk; i >= 0; --i)
+        expected.prepend(makeRect(i));
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    // Перенос вниз через несколько блоков и вверх в начало
+    chunks.move(10, 20, 3 * kChunk);
+    std::rotate(expected.begin() + 10, expected.begin() + 30, expected.begin() + 3 * kChunk);
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    chunks.move(2 * kChunk, 5, 0);
+    std::rotate(expected.begin(), expected.begin() + 2 * kChunk, expected.begin() + 2 * kChunk + 5);
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    chunks.remove(chunks.size() - 7, 7);
+    expected.remove(expected.size() - 7, 7);
+    QCOMPARE(lefts(chunks), lefts(expected));
+
+    QCOMPARE(chunks.size(), expected.size());
+    QVERIFY(chunksAreValid(chunks));
+}
+
+void TestRectChunks::inserts_split_and_removals_merge_chunks()
+{
+    RectChunks chunks = makeChunks(4 * kChunk);
+    QCOMPARE(chunks.chunkCount(), 4);
+
+    // Вставки в середину второго блока: он делится, остальные не трогаются
+    const PackedRect* third = chunks.chunk(2).constData();
+    for (int i = 0; i < kChunk; ++i)
+        chunks.insert(kChunk + 100, 1, makeRect(-i));
+    QVERIFY(chunksAreValid(chunks));
+    QVERIFY(chunks.chunkCount() <= 6);
+    QCOMPARE(chunks.size(), 5 * kChunk);
+    QCOMPARE(chunks.at(kChunk + 99).left, kChunk + 99);
+    QCOMPARE(chunks.at(kChunk + 100).left, -(kChunk - 1));
+    QCOMPARE(chunks.at(2 * kChunk + 100).left, kChunk + 100);
+    bool thirdShared = false;
+    for (int i = 0; i < chunks.chunkCount(); ++i)
+        thirdShared = thirdShared || chunks.chunk(i).constData() == third;
+    QVERIFY(thirdShared);
+
+    // Удаления по одной строке: маленькие остатки сливаются с соседями
+    while (chunks.size() > kChunk)
+        chunks.remove(chunks.size() / 2, 1);
+    QVERIFY(chunksAreValid(chunks));
+    QVERIFY(chunks.chunkCount() <= 3);
+
+    chunks.remove(0, chunks.size());
+    QVERIFY(chunks.isEmpty());
+    QCOMPARE(chunks.chunkCount(), 0);
+}
+
+void TestRectChunks::range_removal_merges_trailing_chunk()
+{
+    RectChunks chunks = makeChunks(4 * kChunk);
+
+    // Первый блок остаётся почти полным, от третьего — 10 строк
+    chunks.remove(kChunk - 10, 2 * kChunk);
+    QVERIFY(chunksAreValid(chunks));
+    QCOMPARE(chunks.size(), 2 * kChunk);
+    QCOMPARE(chunks.chunkCount(), 2);
+    QCOMPARE(chunks.chunk(0).size(), kChunk);
+    QCOMPARE(chunks.at(kChunk - 11).left, kChunk - 11);
+    QCOMPARE(chunks.at(kChunk - 10).left, 3 * kChunk - 10);
+    QCOMPARE(chunks.at(kChunk).left, 3 * kChunk);
+
+    // Без удаления целых блоков: два соседних блока укорочены с разных концов
+    chunks.remove(kChunk - 5, 10);
+    QVERIFY(chunksAreValid(chunks));
+    QCOMPARE(chunks.chunkCount(), 2);
+    chunks.remove(kChunk / 2, kChunk);
+    QVERIFY(chunksAreValid(chunks));
+    QCOMPARE(chunks.chunkCount(), 1);
+    QCOMPARE(chunks.at(kChunk / 2).left, 3 * kChunk + kChunk / 2 + 10);
+}
+
+void TestRectChunks::random_edits_match_vector_data()
+{
+    QTest::addColumn<int>("seed");
+
+    QTest::newRow("1")  << 1;
+    QTest::newRow("2")  << 2;
+    QTest::newRow("17") << 17;
+}
+
+void TestRectChunks::random_edits_match_vector()
+{
+    QFETCH(int, seed);
+
+    // Линейный конгруэнтный генератор: последовательность одинакова на всех платформах
+    quint32 state = quint32(seed);
+    const auto next = [&state](int bound) {
+        state = state * 1664525u + 1013904223u;
+        return bound > 0 ? int((state >> 8) % quint32(bound)) : 0;
+    };
+
+    RectChunks chunks = makeChunks(2 * kChunk);
+    QVector<PackedRect> expected;
+    for (int i = 0; i < 2 * kChunk; ++i)
+        expected.append(makeRect(i));
+
+    for (int step = 0; step < 300; ++step)
+    {
+        const int size = expected.size();
+        switch (next(3))
+        {
+        case 0:
+        {
+            const int row = next(size + 1);
+            const int count = 1 + next(step % 10 == 0 ? 3 * kChunk : 50);
+            chunks.insert(row, count, makeRect(step));
+            expected.insert(row, count, makeRect(step));
+            break;
+        }
+        case 1:
+        {
+            if (size == 0)
+                break;
+            const int row = next(size);
+            const int count = 1 + next(qMin(size - row, step % 10 == 0 ? 2 * kChunk : 50));
+            chunks.remove(row, count);
+            expected.remove(row, count);
+            break;
+        }
+        default:
+        {
+            if (size < 2)
+                break;
+            const int source = next(size - 1);
+            const int count = 1 + next(qMin(size - source - 1, kChunk));
+            int destination = next(size + 1);
+            if (destination >= source && destination <= source + count)
+                destination = source + count + 1 <= size ? size : 0;
+            if (destination >= source && destination <= source + count)
+                break;
+            chunks.move(source, count, destination);
+            if (destination > source)
+                std::rotate(expected.begin() + source, expected.begin() + source + count,
+                            expected.begin() + destination);
+            else
+                std::rotate(expected.begin() + destination, expected.begin() + source,
+                            expected.begin() + source + count);
+            break;
+        }
+        }
+
+        QCOMPARE(chunks.size(), expected.size());
+        QVERIFY(chunksAreValid(chunks));
+    }
+
+    QCOMPARE(lefts(chunks), lefts(expected));
+}
+
+void TestRectChunks::write_detaches_single_chunk()
+{
+    RectChunks original = makeChunks(4 * kChunk);
+    RectChunks copy = original;
+
+    copy[kChunk + 7].left = -100;
+
+    QCOMPARE(original.at(kChunk + 7).left, kChunk + 7);
+    QCOMPARE(copy.at(kChunk + 7).left, -100);
+
+    for (int i = 0; i < original.chunkCount(); ++i)
+    {
+        const bool shared = original.chunk(i).constData() == copy.chunk(i).constData();
+        QCOMPARE(shared, i != 1);
+    }
+
+    // Дописывание в копию не трогает полные блоки оригинала
+    copy.append(makeRect(0));
+    QCOMPARE(original.size(), 4 * kChunk);
+    QCOMPARE(original.chunk(3).constData(), copy.chunk(3).constData());
+}
+
+QTEST_MAIN(TestRectChunks)
+#include "tst_rectchunks.moc"
@@ -0,0 +1,215 @@
+// tests/tst_rectformat.cpp
+#include <QtTest/QtTest>
+
+#include "rectformat.h"
+
+/**
+ * @brief Набор юнит-тестов для разбора/форматирования полей (RectFormat).
+ *
+ * @details
+ * Быстрые пути разбора обязаны давать тот же результат, что и общие
+ * парсеры Qt, на которые они заменили прежний код.
+ */
+class TestRectFormat : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Строки "#rrggbb" и результат QColor для сравнения.
+    void parseColor_hex_matches_qcolor_data();
+
+    /**
+     * @brief Быстрый путь "#rrggbb" совпадает с QColor(text).rgba().
+     */
+    void parseColor_hex_matches_qcolor();
+
+    /**
+     * @brief Имена и прочие форматы QColor разбираются через общий парсер.
+     */
+    void parseColor_falls_back_to_qcolor();
+
+    /**
+     * @brief Некорректный текст цвета отклоняется.
+     */
+    void parseColor_rejects_invalid();
+
+    /**
+     * @brief colorName() совпадает с QColor::name() (альфа игнорируется).
+     */
+    void colorName_matches_qcolor_name();
+
+    /// Текст поля, ожидаемый успех и значение.
+    void parseInt_data();
+
+    /**
+     * @brief parseInt(): пробелы, знак, границы int и переполнение.
+     */
+    void parseInt();
+
+    /// Текст поля, ожидаемый успех и стиль.
+    void parsePenStyle_data();
+
+    /**
+     * @brief parsePenStyle(): все три написания и отказ на похожих строках.
+     */
+    void parsePenStyle();
+
+    /**
+     * @brief penStyleName() и parsePenStyle() взаимно обратны на 0..Qt::MPenStyle.
+     */
+    void penStyleName_roundtrip();
+};
+
+void TestRectFormat::parseColor_hex_matches_qcolor_data()
+{
+    QTest::addColumn<QByteArray>("text");
+
+    QTest::newRow("black")      << QByteArray("#000000");
+    QTest::newRow("white")      << QByteArray("#ffffff");
+    QTest::newRow("upper")      << QByteArray("#ABCDEF");
+    QTest::newRow("mixed")      << QByteArray("#1a2B3c");
+    QTest::newRow("digits")     << QByteArray("#987654");
+    QTest::newRow("whitespace") << QByteArray("  #0f0F0f\t");
+}
+
+void TestRectFormat::parseColor_hex_matches_qcolor()
+{
+    QFETCH(QByteArray, text);
+
+    QRgb rgba = 0;
+    QVERIFY(RectFormat::parseColor(QLatin1String(text.constData(), text.size()), &rgba));
+    QCOMPARE(rgba, QColor(QString::fromLatin1(text).trimmed()).rgba());
+}
+
+void TestRectFormat::parseColor_falls_back_to_qcolor()
+{
+    QRgb rgba = 0;
+
+    QVERIFY(RectFormat::parseColor(QLatin1String("red"), &rgba));
+    QCOMPARE(rgba, QColor(Qt::red).rgba());
+
+    QVERIFY(RectFormat::parseColor(QLatin1String("#abc"), &rgba));
+    QCOMPARE(rgba, QColor("#abc").rgba());
+
+    QVERIFY(RectFormat::parseColor(QLatin1String("#80112233"), &rgba));
+    QCOMPARE(rgba, QColor("#80112233").rgba());
+}
+
+void TestRectFormat::parseColor_rejects_invalid()
+{
+    QRgb rgba = 0x12345678;
+
+    QVERIFY(!RectFormat::parseColor(QLatin1String("#12345G"), &rgba));
+    QVERIFY(!RectFormat::parseColor(QLatin1String("#12 456"), &rgba));
+    QVERIFY(!RectFormat::parseColor(QLatin1String("NOT_A_COLOR"), &rgba));
+    QVERIFY(!RectFormat::parseColor(QLatin1String(""), &rgba));
+    QCOMPARE(rgba, QRgb(0x12345678));
+}
+
+void TestRectFormat::colorName_matches_qcolor_name()
+{
+    QCOMPARE(RectFormat::colorName(qRgb(0x11, 0x22, 0x33)), QColor("#112233").name());
+    QCOMPARE(RectFormat::colorName(qRgba(0xaa, 0xbb, 0xcc, 0x10)), QString("#aabbcc"));
+}
+
+void TestRectFormat::parseInt_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("ok");
+    QTest::addColumn<int>("value");
+
+    QTest::newRow("zero")          << QByteArray("0")            << true  << 0;
+    QTest::newRow("positive")      << QByteArray("42")           << true  << 42;
+    QTest::newRow("plus sign")     << QByteArray("+5")           << true  << 5;
+    QTest::newRow("leading zeros") << QByteArray("007")          << true  << 7;
+    QTest::newRow("whitespace")    << QByteArray(" \t-17 \r")    << true  << -17;
+    QTest::newRow("int max")       << QByteArray("2147483647")   << true  << 2147483647;
+    QTest::newRow("int min")       << QByteArray("-2147483648")  << true  << int(-2147483647 - 1);
+    QTest::newRow("above max")     << QByteArray("2147483648")   << false << 0;
+    QTest::newRow("below min")     << QByteArray("-2147483649")  << false << 0;
+    QTest::newRow("huge")          << QByteArray("99999999999")  << false << 0;
+    QTest::newRow("empty")         << QByteArray("")             << false << 0;
+    QTest::newRow("blank")         << QByteArray("   ")          << false << 0;
+    QTest::newRow("sign only")     << QByteArray("-")            << false << 0;
+    QTest::newRow("inner space")   << QByteArray("1 2")          << false << 0;
+    QTest::newRow("trailing junk") << QByteArray("12a")          << false << 0;
+    QTest::newRow("hex")           << QByteArray("0x10")         << false << 0;
+}
+
+void TestRectFormat::parseInt()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(bool, ok);
+    QFETCH(int, value);
+
+    bool parsedOk = !ok;
+    const int parsed = RectFormat::parseInt(QLatin1String(text.constData(), text.size()), &parsedOk);
+    QCOMPARE(parsedOk, ok);
+    QCOMPARE(parsed, value);
+
+    // Для корректных полей результат совпадает с прежним QString::toInt().
+    if (ok)
+        QCOMPARE(parsed, QString::fromLatin1(text).trimmed().toInt());
+}
+
+void TestRectFormat::parsePenStyle_data()
+{
+    QTest::addColumn<QByteArray>("text");
+    QTest::addColumn<bool>("ok");
+    QTest::addColumn<int>("style");
+
+    QTest::newRow("NoPen")          << QByteArray("Qt::NoPen")          << true << int(Qt::NoPen);
+    QTest::newRow("SolidLine")      << QByteArray("Qt::SolidLine")      << true << int(Qt::SolidLine);
+    QTest::newRow("DashLine")       << QByteArray("Qt::DashLine")       << true << int(Qt::DashLine);
+    QTest::newRow("DotLine")        << QByteArray("Qt::DotLine")        << true << int(Qt::DotLine);
+    QTest::newRow("DashDotLine")    << QByteArray("Qt::DashDotLine")    << true << int(Qt::DashDotLine);
+    QTest::newRow("DashDotDotLine") << QByteArray("Qt::DashDotDotLine") << true << int(Qt::DashDotDotLine);
+    QTest::newRow("name trimmed")   << QByteArray(" Qt::DotLine\t")     << true << int(Qt::DotLine);
+    QTest::newRow("number")         << QByteArray("3")                  << true << int(Qt::DotLine);
+    QTest::newRow("number signed")  << QByteArray("+2")                 << true << int(Qt::DashLine);
+    QTest::newRow("number custom")  << QByteArray("6")                  << true << int(Qt::CustomDashLine);
+    QTest::newRow("wrapped")        << QByteArray("Qt::PenStyle(4)")    << true << int(Qt::DashDotLine);
+    QTest::newRow("wrapped spaces") << QByteArray("Qt::PenStyle( 2 )")  << true << int(Qt::DashLine);
+    QTest::newRow("wrapped max")    << QByteArray("Qt::PenStyle(15)")   << true << int(Qt::MPenStyle);
+
+    QTest::newRow("negative")       << QByteArray("-1")                 << false << int(Qt::SolidLine);
+    QTest::newRow("out of range")   << QByteArray("16")                 << false << int(Qt::SolidLine);
+    QTest::newRow("wrapped range")  << QByteArray("Qt::PenStyle(16)")   << false << int(Qt::SolidLine);
+    QTest::newRow("wrapped empty")  << QByteArray("Qt::PenStyle()")     << false << int(Qt::SolidLine);
+    QTest::newRow("wrapped open")   << QByteArray("Qt::PenStyle(3")     << false << int(Qt::SolidLine);
+    QTest::newRow("same length")    << QByteArray("Qt::DotLina")        << false << int(Qt::SolidLine);
+    QTest::newRow("no prefix")      << QByteArray("DotLine")            << false << int(Qt::SolidLine);
+    QTest::newRow("lowercase")      << QByteArray("qt::DotLine")        << false << int(Qt::SolidLine);
+    QTest::newRow("prefix only")    << QByteArray("Qt::")               << false << int(Qt::SolidLine);
+    QTest::newRow("too long")       << QByteArray("Qt::DashDotDotDotLine") << false << int(Qt::SolidLine);
+    QTest::newRow("empty")          << QByteArray("")                   << false << int(Qt::SolidLine);
+}
+
+void TestRectFormat::parsePenStyle()
+{
+    QFETCH(QByteArray, text);
+    QFETCH(bool, ok);
+    QFETCH(int, style);
+
+    bool parsedOk = !ok;
+    const Qt::PenStyle parsed =
+        RectFormat::parsePenStyle(QLatin1String(text.constData(), text.size()), &parsedOk);
+    QCOMPARE(parsedOk, ok);
+    QCOMPARE(int(parsed), style);
+}
+
+void TestRectFormat::penStyleName_roundtrip()
+{
+    for (int v = 0; v <= int(Qt::MPenStyle); ++v)
+    {
+        const QByteArray name = RectFormat::penStyleName(static_cast<Qt::PenStyle>(v)).toLatin1();
+
+        bool ok = false;
+        const Qt::PenStyle parsed = RectFormat::parsePenStyle(QLatin1String(name.constData(), name.size()), &ok);
+        QVERIFY2(ok, name.constData());
+        QCOMPARE(int(parsed), v);
+    }
+}
+
+QTEST_MAIN(TestRectFormat)
+#include "tst_rectformat.moc"
@@ -0,0 +1,356 @@
+// tests/tst_rectspatialindex.cpp
+#include <QtTest/QtTest>
+#include "rectspatialindex.h"
+
+#include <limits>
+
+/**
+ * @brief Набор юнит-тестов для пространственного индекса RectSpatialIndex.
+ *
+ * @details
+ * Эталон — полный перебор строк: запросы по точке, по области и k ближайших
+ * обязаны совпадать с ним на случайных данных (мелкие, огромные, пустые
+ * прямоугольники и прямоугольники с отрицательными размерами), в том числе
+ * после случайной последовательности вставок, удалений, переносов и правок
+ * геометрии, которые индекс отслеживает без перестроения.
+ */
+class TestRectSpatialIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Границы: правая/нижняя не входят, пустые прямоугольники не находятся.
+     */
+    void point_and_area_follow_qrect_borders();
+
+    /**
+     * @brief Ближайшие: по расстоянию до прямоугольника, при равенстве — по номеру строки.
+     */
+    void nearest_orders_by_distance_then_row();
+
+    /**
+     * @brief Координаты у пределов qint32 и огромные прямоугольники.
+     */
+    void extreme_coordinates();
+
+    /// Зерно генератора данных.
+    void queries_match_full_scan_data();
+
+    /**
+     * @brief На случайных данных все три запроса совпадают с полным перебором.
+     */
+    void queries_match_full_scan();
+
+    /// Зерно генератора правок.
+    void edits_keep_queries_exact_data();
+
+    /**
+     * @brief insertRows()/removeRows()/moveRows()/updateRow() сохраняют точность запросов.
+     */
+    void edits_keep_queries_exact();
+};
+
+namespace {
+
+PackedRect makeRect(int left, int top, int width, int height)
+{
+    PackedRect r;
+    r.left   = left;
+    r.top    = top;
+    r.width  = width;
+    r.height = height;
+    return r;
+}
+
+/// Линейный конгруэнтный генератор: последовательность одинакова на всех платформах.
+class Random
+{
+public:
+    explicit Random(int seed) : m_state(quint32(seed)) {}
+
+    int next(int bound)
+    {
+        m_state = m_state * 1664525u + 1013904223u;
+        return bound > 0 ? int((m_state >> 8) % quint32(bound)) : 0;
+    }
+
+    /// Прямоугольник: в основном мелкие, иногда огромные, пустые и «вывернутые».
+    PackedRect rect()
+    {
+        const int left = next(2000) - 1000;
+        const int top = next(2000) - 1000;
+        switch (next(20))
+        {
+        case 0:  return makeRect(left, top, 500 + next(1500), 500 + next(1500));
+        case 1:  return makeRect(left, top, 0, next(30));
+        case 2:  return makeRect(left, top, -1 - next(40), -1 - next(40));
+        default: return makeRect(left, top, 1 + next(40), 1 + next(40));
+        }
+    }
+
+    QPoint point()
+    {
+        return QPoint(next(2400) - 1200, next(2400) - 1200);
+    }
+
+private:
+    quint32 m_state;
+};
+
+/// Нормализованные границы строки [x1, x2) × [y1, y2).
+void bounds(const PackedRect& r, qint64& x1, qint64& y1, qint64& x2, qint64& y2)
+{
+    x1 = qMin<qint64>(r.left, qint64(r.left) + r.width);
+    x2 = qMax<qint64>(r.left, qint64(r.left) + r.width);
+    y1 = qMin<qint64>(r.top, qint64(r.top) + r.height);
+    y2 = qMax<qint64>(r.top, qint64(r.top) + r.height);
+}
+
+QVector<int> scanAt(const RectStore& rows, const QPoint& p)
+{
+    QVector<int> result;
+    for (int row = 0; row < rows.size(); ++row)
+    {
+        qint64 x1, y1, x2, y2;
+        bounds(rows.at(row), x1, y1, x2, y2);
+        if (x1 <= p.x() && p.x() < x2 && y1 <= p.y() && p.y() < y2)
+            result.append(row);
+    }
+    return result;
+}
+
+QVector<int> scanIntersecting(const RectStore& rows, const QRect& area)
+{
+    qint64 ax1, ay1, ax2, ay2;
+    bounds(makeRect(area.x(), area.y(), area.width(), area.height()), ax1, ay1, ax2, ay2);
+
+    QVector<int> result;
+    for (int row = 0; row < rows.size(); ++row)
+    {
+        qint64 x1, y1, x2, y2;
+        bounds(rows.at(row), x1, y1, x2, y2);
+        if (ax1 < ax2 && ay1 < ay2 && x1 < x2 && y1 < y2
+            && x1 < ax2 && ax1 < x2 && y1 < ay2 && ay1 < y2)
+            result.append(row);
+    }
+    return result;
+}
+
+QVector<int> scanNearest(const RectStore& rows, const QPoint& p, int k)
+{
+    QVector<QPair<double, int>> all;
+    for (int row = 0; row < rows.size(); ++row)
+    {
+        qint64 x1, y1, x2, y2;
+        bounds(rows.at(row), x1, y1, x2, y2);
+        const qint64 dx = p.x() < x1 ? x1 - p.x() : (p.x() > x2 ? p.x() - x2 : 0);
+        const qint64 dy = p.y() < y1 ? y1 - p.y() : (p.y() > y2 ? p.y() - y2 : 0);
+        all.append(qMakePair(double(dx) * double(dx) + double(dy) * double(dy), row));
+    }
+    std::sort(all.begin(), all.end());
+
+    QVector<int> result;
+    for (int i = 0; i < qMin(k, all.size()); ++i)
+        result.append(all.at(i).second);
+    return result;
+}
+
+/// Сверяет с перебором запросы в нескольких случайных местах.
+bool queriesMatch(const RectSpatialIndex& index, const RectStore& rows, Random& random, int probes)
+{
+    for (int i = 0; i < probes; ++i)
+    {
+        const QPoint p = random.point();
+        if (index.rowsAt(rows, p) != scanAt(rows, p))
+            return false;
+
+        const QRect area(p.x(), p.y(), random.next(300) - 50, random.next(300) - 50);
+        if (index.rowsIntersecting(rows, area) != scanIntersecting(rows, area))
+            return false;
+
+        const int k = 1 + random.next(20);
+        if (index.nearestRows(rows, p, k) != scanNearest(rows, p, k))
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void TestRectSpatialIndex::point_and_area_follow_qrect_borders()
+{
+    RectStore rows;
+    rows.append(makeRect(0, 0, 10, 10));     // 0: [0, 10) × [0, 10)
+    rows.append(makeRect(10, 0, 5, 5));      // 1: справа вплотную
+    rows.append(makeRect(3, 3, 0, 4));       // 2: пустой (нулевая ширина)
+    rows.append(makeRect(20, 20, -5, -5));   // 3: [15, 20) × [15, 20)
+
+    RectSpatialIndex index;
+    index.rebuild(rows);
+    QCOMPARE(index.size(), 4);
+
+    QCOMPARE(index.rowsAt(rows, QPoint(0, 0)), QVector<int>({0}));
+    QCOMPARE(index.rowsAt(rows, QPoint(9, 9)), QVector<int>({0}));
+    QCOMPARE(index.rowsAt(rows, QPoint(10, 0)), QVector<int>({1}));
+    QCOMPARE(index.rowsAt(rows, QPoint(3, 4)), QVector<int>({0}));
+    QCOMPARE(index.rowsAt(rows, QPoint(15, 15)), QVector<int>({3}));
+    QVERIFY(index.rowsAt(rows, QPoint(20, 20)).isEmpty());
+
+    QCOMPARE(index.rowsIntersecting(rows, QRect(9, 4, 2, 2)), QVector<int>({0, 1}));
+    QCOMPARE(index.rowsIntersecting(rows, QRect(-100, -100, 300, 300)), QVector<int>({0, 1, 3}));
+    QVERIFY(index.rowsIntersecting(rows, QRect(10, 5, 5, 10)).isEmpty());
+    QVERIFY(index.rowsIntersecting(rows, QRect(0, 0, 0, 10)).isEmpty());
+}
+
+void TestRectSpatialIndex::nearest_orders_by_distance_then_row()
+{
+    RectStore rows;
+    rows.append(makeRect(100, 0, 10, 10));   // 0: расстояние 100
+    rows.append(makeRect(-20, -5, 10, 10));  // 1: расстояние 10
+    rows.append(makeRect(0, 30, 5, 5));      // 2: расстояние 30
+    rows.append(makeRect(-5, -5, 10, 10));   // 3: точка внутри
+    rows.append(makeRect(10, -5, 10, 10));   // 4: расстояние 10, как у строки 1
+
+    RectSpatialIndex index;
+    index.rebuild(rows);
+
+    QCOMPARE(index.nearestRows(rows, QPoint(0, 0), 3), QVector<int>({3, 1, 4}));
+    QCOMPARE(index.nearestRows(rows, QPoint(0, 0), 10), QVector<int>({3, 1, 4, 2, 0}));
+    QVERIFY(index.nearestRows(rows, QPoint(0, 0), 0).isEmpty());
+
+    // Далеко за пределами всех строк
+    QCOMPARE(index.nearestRows(rows, QPoint(100000, 0), 1), QVector<int>({0}));
+
+    RectSpatialIndex empty;
+    QVERIFY(empty.nearestRows(RectStore(), QPoint(0, 0), 5).isEmpty());
+}
+
+void TestRectSpatialIndex::extreme_coordinates()
+{
+    const int maxInt = std::numeric_limits<qint32>::max();
+    const int minInt = std::numeric_limits<qint32>::min();
+
+    RectStore rows;
+    rows.append(makeRect(maxInt - 5, maxInt - 5, maxInt, maxInt));  // за предел qint32
+    rows.append(makeRect(minInt, minInt, 10, 10));
+    rows.append(makeRect(minInt, minInt, maxInt, maxInt));           // огромный
+    rows.append(makeRect(0, 0, 1, 1));
+
+    RectSpatialIndex index;
+    index.rebuild(rows);
+
+    QCOMPARE(index.rowsAt(rows, QPoint(maxInt, maxInt)), QVector<int>({0}));
+    QCOMPARE(index.rowsAt(rows, QPoint(minInt, minInt)), QVector<int>({1, 2}));
+    QCOMPARE(index.rowsAt(rows, QPoint(-2, -2)), QVector<int>({2}));
+    QCOMPARE(index.rowsIntersecting(rows, QRect(maxInt - 1, maxInt - 1, 1, 1)), QVector<int>({0}));
+    QCOMPARE(index.rowsIntersecting(rows, QRect(minInt, minInt, maxInt, maxInt)),
+             scanIntersecting(rows, QRect(minInt, minInt, maxInt, maxInt)));
+    QCOMPARE(index.nearestRows(rows, QPoint(maxInt, 0), 4), scanNearest(rows, QPoint(maxInt, 0), 4));
+}
+
+void TestRectSpatialIndex::queries_match_full_scan_data()
+{
+    QTest::addColumn<int>("seed");
+
+    QTest::newRow("1")  << 1;
+    QTest::newRow("7")  << 7;
+    QTest::newRow("42") << 42;
+}
+
+void TestRectSpatialIndex::queries_match_full_scan()
+{
+    QFETCH(int, seed);
+
+    Random random(seed);
+    RectStore rows;
+    for (int i = 0; i < 3000; ++i)
+        rows.append(random.rect());
+
+    RectSpatialIndex index;
+    index.rebuild(rows);
+    QCOMPARE(index.size(), rows.size());
+    QVERIFY(queriesMatch(index, rows, random, 300));
+}
+
+void TestRectSpatialIndex::edits_keep_queries_exact_data()
+{
+    QTest::addColumn<int>("seed");
+
+    QTest::newRow("3")  << 3;
+    QTest::newRow("11") << 11;
+}
+
+void TestRectSpatialIndex::edits_keep_queries_exact()
+{
+    QFETCH(int, seed);
+
+    Random random(seed);
+    RectStore rows;
+    for (int i = 0; i < 1000; ++i)
+        rows.append(random.rect());
+
+    RectSpatialIndex index;
+    index.rebuild(rows);
+
+    for (int step = 0; step < 400; ++step)
+    {
+        const int size = rows.size();
+        switch (random.next(4))
+        {
+        case 0:
+        {
+            const int row = random.next(size + 1);
+            const int count = 1 + random.next(5);
+            rows.insert(row, count, PackedRect{});
+            for (int i = row; i < row + count; ++i)
+                rows.set(i, random.rect());
+            index.insertRows(rows, row, count);
+            break;
+        }
+        case 1:
+        {
+            if (size == 0)
+                break;
+            const int row = random.next(size);
+            const int count = 1 + random.next(qMin(5, size - row));
+            index.removeRows(rows, row, count);   // до удаления: нужна геометрия
+            rows.remove(row, count);
+            break;
+        }
+        case 2:
+        {
+            if (size < 2)
+                break;
+            const int source = random.next(size - 1);
+            const int count = 1 + random.next(qMin(10, size - source - 1));
+            const int destination = random.next(2) == 0 ? random.next(source + 1)
+                                                         : source + count + 1 + random.next(size - source - count);
+            if (destination > size || (destination >= source && destination <= source + count))
+                break;
+            rows.move(source, count, destination);
+            index.moveRows(source, count, destination);
+            break;
+        }
+        default:
+        {
+            if (size == 0)
+                break;
+            const int row = random.next(size);
+            const PackedRect before = rows.at(row);
+            rows.set(row, random.rect());
+            index.updateRow(row, before, rows.at(row));
+            break;
+        }
+        }
+
+        QCOMPARE(index.size(), rows.size());
+        if (step % 20 == 0)
+            QVERIFY(queriesMatch(index, rows, random, 20));
+    }
+
+    QVERIFY(queriesMatch(index, rows, random, 200));
+}
+
+QTEST_MAIN(TestRectSpatialIndex)
+#include "tst_rectspatialindex.moc"
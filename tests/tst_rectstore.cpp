@@ -0,0 +1,317 @@
+// tests/tst_rectstore.cpp
+#include <QtTest/QtTest>
+#include "rectstore.h"
+
+/**
+ * @brief Набор юнит-тестов для хранилища строк RectStore.
+ *
+ * @details
+ * RectStore обязан вести себя одинаково во всех раскладках (Rows/Columns/Chunks),
+ * поэтому каждый тест data-driven по раскладке:
+ * - вставка/чтение/запись строк и отдельных полей;
+ * - переключение раскладки сохраняет содержимое и порядок;
+ * - удаление одного и многих диапазонов строк.
+ */
+class TestRectStore : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Строки раскладок для data-driven тестов.
+    void rows_and_fields_data();
+
+    /**
+     * @brief append/insert/at/set и доступ к полям по Column.
+     */
+    void rows_and_fields();
+
+    /// Строки раскладок для data-driven тестов.
+    void setLayout_preserves_rows_data();
+
+    /**
+     * @brief setLayout() переносит данные без потерь и меняет layout().
+     */
+    void setLayout_preserves_rows();
+
+    /**
+     * @brief toRanges(): сортировка, отбрасывание повторов/чужих номеров, слияние соседних.
+     */
+    void toRanges_sorts_dedups_and_coalesces();
+
+    /// Строки раскладок для data-driven тестов.
+    void removeRanges_matches_remove_data();
+
+    /**
+     * @brief removeRanges() за один проход = remove() по каждому диапазону с конца.
+     */
+    void removeRanges_matches_remove();
+
+    /// Строки раскладок для data-driven тестов.
+    void move_down_and_up_data();
+
+    /**
+     * @brief move() вниз и вверх = перестановка "вырезать блок, вставить перед строкой".
+     */
+    void move_down_and_up();
+
+    /// Строки раскладок для data-driven тестов.
+    void mid_and_insert_block_data();
+
+    /**
+     * @brief mid() копирует диапазон, insert() блока вставляет его из той же и другой раскладки.
+     */
+    void mid_and_insert_block();
+};
+
+namespace {
+
+using Column = RectColumns::Column;
+
+PackedRect makeRect(int i)
+{
+    PackedRect r;
+    r.penColor = qRgba(i, i + 1, i + 2, 255 - i);
+    r.penStyle = static_cast<quint8>(i % 6);
+    r.penWidth = i;
+    r.left     = -i;
+    r.top      = i * 2;
+    r.width    = i * 3;
+    r.height   = i * 4;
+    return r;
+}
+
+void compareRects(const PackedRect& a, const PackedRect& b)
+{
+    QCOMPARE(a.penColor, b.penColor);
+    QCOMPARE(a.penStyle, b.penStyle);
+    QCOMPARE(a.penWidth, b.penWidth);
+    QCOMPARE(a.left, b.left);
+    QCOMPARE(a.top, b.top);
+    QCOMPARE(a.width, b.width);
+    QCOMPARE(a.height, b.height);
+}
+
+void addLayoutRows()
+{
+    QTest::addColumn<int>("layout");
+    QTest::newRow("rows")    << static_cast<int>(RectStore::Layout::Rows);
+    QTest::newRow("columns") << static_cast<int>(RectStore::Layout::Columns);
+    QTest::newRow("chunks")  << static_cast<int>(RectStore::Layout::Chunks);
+}
+
+} // namespace
+
+void TestRectStore::rows_and_fields_data()
+{
+    addLayoutRows();
+}
+
+void TestRectStore::rows_and_fields()
+{
+    QFETCH(int, layout);
+    RectStore store(static_cast<RectStore::Layout>(layout));
+    QVERIFY(store.isEmpty());
+
+    store.append(makeRect(1));
+    store.append(makeRect(2));
+    store.insert(1, 2, PackedRect{});
+    QCOMPARE(store.size(), 4);
+
+    compareRects(store.at(0), makeRect(1));
+    compareRects(store.at(1), PackedRect{});
+    compareRects(store.at(2), PackedRect{});
+    compareRects(store.at(3), makeRect(2));
+
+    store.set(1, makeRect(7));
+    compareRects(store.at(1), makeRect(7));
+
+    store.setPenColor(2, qRgb(1, 2, 3));
+    store.setPenStyle(2, static_cast<quint8>(Qt::DotLine));
+    store.setIntValue(2, Column::Left, 42);
+    store.setIntValue(2, Column::Height, -5);
+    QCOMPARE(store.penColor(2), qRgb(1, 2, 3));
+    QCOMPARE(store.penStyle(2), static_cast<quint8>(Qt::DotLine));
+    QCOMPARE(store.intValue(2, Column::Left), 42);
+    QCOMPARE(store.intValue(2, Column::Height), -5);
+    QCOMPARE(store.at(2).width, PackedRect{}.width);
+
+    store.clear();
+    QVERIFY(store.isEmpty());
+    QCOMPARE(static_cast<int>(store.layout()), layout);
+}
+
+void TestRectStore::setLayout_preserves_rows_data()
+{
+    addLayoutRows();
+}
+
+void TestRectStore::setLayout_preserves_rows()
+{
+    QFETCH(int, layout);
+    const auto from = static_cast<RectStore::Layout>(layout);
+    const auto to = (from == RectStore::Layout::Rows) ? RectStore::Layout::Columns
+                                                      : RectStore::Layout::Rows;
+
+    RectStore store(from);
+    for (int i = 0; i < 100; ++i)
+        store.append(makeRect(i));
+
+    store.setLayout(to);
+    QCOMPARE(store.layout(), to);
+    QCOMPARE(store.size(), 100);
+    for (int i = 0; i < 100; ++i)
+        compareRects(store.at(i), makeRect(i));
+}
+
+void TestRectStore::toRanges_sorts_dedups_and_coalesces()
+{
+    const QVector<RectStore::Range> ranges =
+        RectStore::toRanges({9, 3, -1, 4, 4, 5, 12, 0, 8, 100, 11}, 12);
+
+    QCOMPARE(ranges.size(), 4);
+    QCOMPARE(ranges[0].first, 0);  QCOMPARE(ranges[0].count, 1);
+    QCOMPARE(ranges[1].first, 3);  QCOMPARE(ranges[1].count, 3);
+    QCOMPARE(ranges[2].first, 8);  QCOMPARE(ranges[2].count, 2);
+    QCOMPARE(ranges[3].first, 11); QCOMPARE(ranges[3].count, 1);
+
+    QVERIFY(RectStore::toRanges({}, 10).isEmpty());
+    QVERIFY(RectStore::toRanges({-5, 10}, 10).isEmpty());
+}
+
+void TestRectStore::removeRanges_matches_remove_data()
+{
+    addLayoutRows();
+}
+
+void TestRectStore::removeRanges_matches_remove()
+{
+    QFETCH(int, layout);
+
+    RectStore store(static_cast<RectStore::Layout>(layout));
+    for (int i = 0; i < 200; ++i)
+        store.append(makeRect(i));
+
+    QVector<int> rows;
+    for (int i = 0; i < 200; ++i)
+    {
+        if (i % 7 == 0 || i % 11 == 3 || (i >= 150 && i < 170) || i == 199)
+            rows.append(i);
+    }
+    const QVector<RectStore::Range> ranges = RectStore::toRanges(rows, store.size());
+
+    RectStore onePass = store;
+    onePass.removeRanges(ranges);
+
+    RectStore byRange = store;
+    for (int i = ranges.size() - 1; i >= 0; --i)
+        byRange.remove(ranges[i].first, ranges[i].count);
+
+    QVector<int> kept;
+    for (int i = 0; i < 200; ++i)
+    {
+        if (!rows.contains(i))
+            kept.append(i);
+    }
+
+    QCOMPARE(onePass.size(), kept.size());
+    QCOMPARE(byRange.size(), kept.size());
+    for (int i = 0; i < kept.size(); ++i)
+    {
+        compareRects(onePass.at(i), makeRect(kept[i]));
+        compareRects(byRange.at(i), makeRect(kept[i]));
+    }
+
+    // Исходное хранилище не затронуто (implicit sharing отделился)
+    QCOMPARE(store.size(), 200);
+    compareRects(store.at(199), makeRect(199));
+}
+
+void TestRectStore::move_down_and_up_data()
+{
+    addLayoutRows();
+}
+
+void TestRectStore::move_down_and_up()
+{
+    QFETCH(int, layout);
+
+    struct Case { int source; int count; int destination; };
+    const Case cases[] = {
+        {0, 1, 2},     // соседняя строка вниз
+        {2, 3, 10},    // блок в конец
+        {7, 3, 0},     // блок в начало
+        {5, 1, 4},     // соседняя строка вверх
+        {0, 9, 10},    // почти всё вниз на одну позицию
+    };
+
+    for (const Case& c : cases)
+    {
+        RectStore store(static_cast<RectStore::Layout>(layout));
+        for (int i = 0; i < 10; ++i)
+            store.append(makeRect(i));
+
+        QVector<int> expected;
+        for (int i = 0; i <= 10; ++i)
+        {
+            if (i == c.destination)
+            {
+                for (int j = c.source; j < c.source + c.count; ++j)
+                    expected.append(j);
+            }
+            if (i < 10 && (i < c.source || i >= c.source + c.count))
+                expected.append(i);
+        }
+
+        store.move(c.source, c.count, c.destination);
+
+        QCOMPARE(store.size(), 10);
+        for (int i = 0; i < 10; ++i)
+            compareRects(store.at(i), makeRect(expected[i]));
+    }
+}
+
+void TestRectStore::mid_and_insert_block_data()
+{
+    addLayoutRows();
+}
+
+void TestRectStore::mid_and_insert_block()
+{
+    QFETCH(int, layout);
+    const auto own = static_cast<RectStore::Layout>(layout);
+    const auto other = (own == RectStore::Layout::Rows) ? RectStore::Layout::Columns
+                                                        : RectStore::Layout::Rows;
+
+    RectStore store(own);
+    for (int i = 0; i < 10; ++i)
+        store.append(makeRect(i));
+
+    const RectStore block = store.mid(3, 4);
+    QCOMPARE(block.layout(), own);
+    QCOMPARE(block.size(), 4);
+    for (int i = 0; i < 4; ++i)
+        compareRects(block.at(i), makeRect(3 + i));
+    QVERIFY(store.mid(10, 0).isEmpty());
+
+    for (RectStore::Layout blockLayout : {own, other})
+    {
+        RectStore copy = block;
+        copy.setLayout(blockLayout);
+
+        RectStore target = store;
+        target.remove(3, 4);
+        target.insert(3, copy);
+
+        QCOMPARE(target.layout(), own);
+        QCOMPARE(target.size(), 10);
+        for (int i = 0; i < 10; ++i)
+            compareRects(target.at(i), makeRect(i));
+
+        target.insert(10, copy);
+        QCOMPARE(target.size(), 14);
+        compareRects(target.at(13), makeRect(6));
+    }
+}
+
+QTEST_MAIN(TestRectStore)
+#include "tst_rectstore.moc"
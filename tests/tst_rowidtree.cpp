@@ -0,0 +1,174 @@
+// tests/tst_rowidtree.cpp
+#include <QtTest/QtTest>
+#include "rowidtree.h"
+
+#include <QSet>
+
+/**
+ * @brief Набор юнит-тестов для RowIdTree.
+ *
+ * @details
+ * Эталон — QVector id в порядке строк: после любой последовательности
+ * вставок, удалений и переносов idAt() и rowOf() обязаны с ним совпадать,
+ * а id живых строк — оставаться различными.
+ */
+class TestRowIdTree : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /**
+     * @brief Без сдвигов номеров id равен номеру строки.
+     */
+    void appends_keep_identity();
+
+    /**
+     * @brief Вставка в середину, удаление и перенос на малом примере.
+     */
+    void shifts_keep_ids();
+
+    /// Зерно генератора правок.
+    void random_edits_match_vector_data();
+
+    /**
+     * @brief Случайные правки: idAt()/rowOf() совпадают с эталоном.
+     */
+    void random_edits_match_vector();
+};
+
+namespace {
+
+/// Сверяет дерево с эталоном во всех строках.
+bool matches(const RowIdTree& tree, const QVector<int>& ids)
+{
+    if (tree.size() != ids.size())
+        return false;
+
+    QSet<int> unique;
+    for (int row = 0; row < ids.size(); ++row)
+    {
+        if (tree.idAt(row) != ids.at(row) || tree.rowOf(ids.at(row)) != row)
+            return false;
+        unique.insert(ids.at(row));
+    }
+    return unique.size() == ids.size();
+}
+
+} // namespace
+
+void TestRowIdTree::appends_keep_identity()
+{
+    RowIdTree tree;
+    tree.assign(5);
+    QCOMPARE(tree.insert(5, 2), QVector<int>({5, 6}));
+    QCOMPARE(tree.remove(6, 1), QVector<int>({6}));
+    QCOMPARE(tree.size(), 6);
+    QCOMPARE(tree.idAt(3), 3);
+    QCOMPARE(tree.rowOf(5), 5);
+
+    tree.clear();
+    QCOMPARE(tree.size(), 0);
+    QCOMPARE(tree.insert(0, 1), QVector<int>({0}));
+}
+
+void TestRowIdTree::shifts_keep_ids()
+{
+    RowIdTree tree;
+    tree.assign(4);                                // 0 1 2 3
+
+    const QVector<int> added = tree.insert(1, 2);  // 0 a b 1 2 3
+    QCOMPARE(added.size(), 2);
+    QVERIFY(matches(tree, {0, added.at(0), added.at(1), 1, 2, 3}));
+
+    QCOMPARE(tree.remove(0, 2), QVector<int>({0, added.at(0)}));
+    QVERIFY(matches(tree, {added.at(1), 1, 2, 3}));
+
+    tree.move(0, 2, 4);                            // 2 3 b 1
+    QVERIFY(matches(tree, {2, 3, added.at(1), 1}));
+
+    tree.move(3, 1, 0);                            // 1 2 3 b
+    QVERIFY(matches(tree, {1, 2, 3, added.at(1)}));
+
+    // Освобождённые id переиспользуются
+    const QVector<int> reused = tree.insert(2, 2);
+    QVERIFY(matches(tree, {1, 2, reused.at(0), reused.at(1), 3, added.at(1)}));
+    QVERIFY(reused.at(0) == 0 || reused.at(0) == added.at(0));
+}
+
+void TestRowIdTree::random_edits_match_vector_data()
+{
+    QTest::addColumn<int>("seed");
+
+    QTest::newRow("1")  << 1;
+    QTest::newRow("17") << 17;
+    QTest::newRow("99") << 99;
+}
+
+void TestRowIdTree::random_edits_match_vector()
+{
+    QFETCH(int, seed);
+
+    quint32 state = quint32(seed);
+    const auto next = [&state](int bound)
+    {
+        state = state * 1664525u + 1013904223u;
+        return bound > 0 ? int((state >> 8) % quint32(bound)) : 0;
+    };
+
+    RowIdTree tree;
+    tree.assign(500);
+    QVector<int> ids;
+    for (int i = 0; i < 500; ++i)
+        ids.append(i);
+
+    for (int step = 0; step < 2000; ++step)
+    {
+        const int size = ids.size();
+        switch (next(3))
+        {
+        case 0:
+        {
+            const int row = next(size + 1);
+            const QVector<int> added = tree.insert(row, 1 + next(8));
+            for (int i = 0; i < added.size(); ++i)
+                ids.insert(row + i, added.at(i));
+            break;
+        }
+        case 1:
+        {
+            if (size == 0)
+                break;
+            const int row = next(size);
+            const int count = 1 + next(qMin(8, size - row));
+            QCOMPARE(tree.remove(row, count), ids.mid(row, count));
+            ids.remove(row, count);
+            break;
+        }
+        default:
+        {
+            if (size < 2)
+                break;
+            const int source = next(size - 1);
+            const int count = 1 + next(qMin(20, size - source - 1));
+            const int destination = next(size + 1);
+            if (destination >= source && destination <= source + count)
+                break;
+            tree.move(source, count, destination);
+
+            const QVector<int> block = ids.mid(source, count);
+            ids.remove(source, count);
+            const int at = destination > source ? destination - count : destination;
+            for (int i = 0; i < count; ++i)
+                ids.insert(at + i, block.at(i));
+            break;
+        }
+        }
+
+        if (step % 50 == 0)
+            QVERIFY(matches(tree, ids));
+    }
+    QVERIFY(matches(tree, ids));
+}
+
+QTEST_MAIN(TestRowIdTree)
+#include "tst_rowidtree.moc"
@@ -0,0 +1,267 @@
+// tests/tst_tsvindex.cpp
+#include <QtTest/QtTest>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+#include <memory>
+
+#include "tsvindex.h"
+#include "tsvreader.h"
+
+/**
+ * @brief Набор юнит-тестов для индекса смещений строк TSV (TsvIndex).
+ *
+ * @details
+ * Главный контракт: окно, прочитанное через индекс, совпадает с тем же
+ * диапазоном полного разбора файла — при любом шаге индекса, с пустыми
+ * строками, "\r\n" и BOM. Плюс жизненный цикл файла-спутника: создаётся,
+ * переиспользуется, перестраивается при изменении TSV или порче.
+ */
+class TestTsvIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    /// Шаг индекса.
+    void readRows_matches_full_parse_data();
+
+    /**
+     * @brief Любое окно через индекс = тот же диапазон полного разбора.
+     */
+    void readRows_matches_full_parse();
+
+    /**
+     * @brief Окно за концом файла усекается, начало за концом — ошибка.
+     */
+    void readRows_clamps_window_and_rejects_bad_start();
+
+    /**
+     * @brief Ошибка формата в окне: тот же текст (сквозной номер строки), что у полного разбора.
+     */
+    void readRows_error_reports_file_line_number();
+
+    /**
+     * @brief save() + load() сохраняют индекс; испорченный файл отклоняется.
+     */
+    void save_load_roundtrip_and_corruption();
+
+    /**
+     * @brief open(): спутник создаётся, переиспользуется и перестраивается при изменении TSV.
+     */
+    void open_creates_reuses_and_invalidates_sidecar();
+
+private:
+    /// Путь к TSV-файлу теста во временном каталоге.
+    QString tsvPath() const;
+
+    std::unique_ptr<QTemporaryDir> m_dir;
+};
+
+namespace {
+
+/// Число строк данных в тестовом файле.
+constexpr int kRows = 1000;
+
+/**
+ * @brief TSV из @p rows строк (Left = номер строки) с BOM, пустыми строками и "\r\n".
+ */
+QByteArray makeTsv(int rows)
+{
+    QByteArray tsv("\xEF\xBB\xBF");
+    for (int i = 0; i < rows; ++i)
+    {
+        if (i % 13 == 0)
+            tsv += "  \n";
+        if (i % 17 == 0)
+            tsv += "\r\n";
+        tsv += "#ff0000\tQt::DashLine\t1\t" + QByteArray::number(i) + "\t2\t3\t4";
+        tsv += (i % 5 == 0) ? "\r\n" : "\n";
+    }
+    tsv += "\n \n";
+    return tsv;
+}
+
+bool writeFile(const QString& path, const QByteArray& data)
+{
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+} // namespace
+
+void TestTsvIndex::init()
+{
+    m_dir.reset(new QTemporaryDir);
+    QVERIFY(m_dir->isValid());
+    QVERIFY(writeFile(tsvPath(), makeTsv(kRows)));
+}
+
+QString TestTsvIndex::tsvPath() const
+{
+    return m_dir->filePath("rects.tsv");
+}
+
+void TestTsvIndex::readRows_matches_full_parse_data()
+{
+    QTest::addColumn<int>("stride");
+
+    QTest::newRow("1")    << 1;
+    QTest::newRow("7")    << 7;
+    QTest::newRow("64")   << 64;
+    QTest::newRow("default") << TsvIndex::kDefaultStride;
+}
+
+void TestTsvIndex::readRows_matches_full_parse()
+{
+    QFETCH(int, stride);
+
+    TsvIndex index;
+    QString error;
+    QVERIFY2(index.build(tsvPath(), stride, &error), qPrintable(error));
+    QCOMPARE(index.rowCount(), qint64(kRows));
+    QCOMPARE(index.stride(), stride);
+
+    QFile file(tsvPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    for (int first = 0; first < kRows; first += 37)
+    {
+        for (int count : {1, 6, 65, 300})
+        {
+            RectStore window;
+            QVERIFY2(index.readRows(file, first, count, window, &error), qPrintable(error));
+            QCOMPARE(window.size(), qMin(count, kRows - first));
+            for (int i = 0; i < window.size(); ++i)
+                QCOMPARE(window.at(i).left, first + i);
+        }
+    }
+}
+
+void TestTsvIndex::readRows_clamps_window_and_rejects_bad_start()
+{
+    TsvIndex index;
+    QVERIFY(index.build(tsvPath(), 64));
+
+    QFile file(tsvPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    RectStore tail;
+    QVERIFY(index.readRows(file, kRows - 3, 100, tail));
+    QCOMPARE(tail.size(), 3);
+    QCOMPARE(tail.at(2).left, kRows - 1);
+
+    RectStore none;
+    QVERIFY(index.readRows(file, kRows, 10, none));
+    QVERIFY(none.isEmpty());
+
+    QString error;
+    QVERIFY(!index.readRows(file, kRows + 1, 1, none, &error));
+    QVERIFY(!error.isEmpty());
+    QVERIFY(!index.readRows(file, -1, 1, none, &error));
+}
+
+void TestTsvIndex::readRows_error_reports_file_line_number()
+{
+    QByteArray tsv = makeTsv(kRows);
+    tsv.replace("\t1\t500\t", "\t1\tx\t");
+    QVERIFY(writeFile(tsvPath(), tsv));
+
+    QFile full(tsvPath());
+    QVERIFY(full.open(QIODevice::ReadOnly));
+    RectStore all;
+    QString expected;
+    TsvReader reader(full);
+    QVERIFY(!reader.read(all, 0, &expected));
+
+    TsvIndex index;
+    QVERIFY(index.build(tsvPath(), 64));
+
+    QFile file(tsvPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    RectStore before;
+    QVERIFY(index.readRows(file, 400, 100, before));
+
+    RectStore window;
+    QString error;
+    QVERIFY(!index.readRows(file, 490, 20, window, &error));
+    QCOMPARE(error, expected);
+}
+
+void TestTsvIndex::save_load_roundtrip_and_corruption()
+{
+    TsvIndex index;
+    QVERIFY(index.build(tsvPath(), 7));
+
+    const QString indexPath = m_dir->filePath("rects.idx");
+    QString error;
+    QVERIFY2(index.save(indexPath, &error), qPrintable(error));
+
+    TsvIndex loaded;
+    QVERIFY2(loaded.load(indexPath, &error), qPrintable(error));
+    QCOMPARE(loaded.rowCount(), index.rowCount());
+    QCOMPARE(loaded.stride(), 7);
+    QVERIFY(loaded.isValidFor(tsvPath()));
+
+    QFile file(tsvPath());
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    RectStore window;
+    QVERIFY(loaded.readRows(file, 123, 50, window));
+    QCOMPARE(window.at(0).left, 123);
+
+    QFile indexFile(indexPath);
+    QVERIFY(indexFile.open(QIODevice::ReadOnly));
+    const QByteArray good = indexFile.readAll();
+    indexFile.close();
+
+    QVERIFY(writeFile(indexPath, good.left(good.size() - 1)));
+    QVERIFY(!loaded.load(indexPath, &error));
+    QVERIFY(error.contains("повреждён"));
+    QCOMPARE(loaded.stride(), 7);
+
+    QVERIFY(writeFile(indexPath, "RECTSNAP" + good.mid(8)));
+    QVERIFY(!loaded.load(indexPath, &error));
+    QVERIFY(error.contains("сигнатура"));
+}
+
+void TestTsvIndex::open_creates_reuses_and_invalidates_sidecar()
+{
+    const QString sidecar = TsvIndex::sidecarFileName(tsvPath());
+    QVERIFY(!QFileInfo::exists(sidecar));
+
+    TsvIndex index;
+    QString error;
+    QVERIFY2(index.open(tsvPath(), &error, 64), qPrintable(error));
+    QVERIFY(QFileInfo::exists(sidecar));
+    QCOMPARE(index.rowCount(), qint64(kRows));
+
+    // Актуальный спутник переиспользуется: шаг берётся из него, а не из аргумента
+    TsvIndex reused;
+    QVERIFY(reused.open(tsvPath(), &error, 5));
+    QCOMPARE(reused.stride(), 64);
+
+    // Изменение TSV (другой размер) делает спутник неактуальным
+    QVERIFY(writeFile(tsvPath(), makeTsv(kRows + 10)));
+    QVERIFY(!reused.isValidFor(tsvPath()));
+
+    TsvIndex rebuilt;
+    QVERIFY(rebuilt.open(tsvPath(), &error, 5));
+    QCOMPARE(rebuilt.stride(), 5);
+    QCOMPARE(rebuilt.rowCount(), qint64(kRows + 10));
+    QVERIFY(rebuilt.isValidFor(tsvPath()));
+
+    // Испорченный спутник тоже перестраивается
+    QVERIFY(writeFile(sidecar, "garbage"));
+    TsvIndex repaired;
+    QVERIFY(repaired.open(tsvPath(), &error));
+    QCOMPARE(repaired.rowCount(), qint64(kRows + 10));
+
+    QVERIFY(!repaired.open(m_dir->filePath("missing.tsv"), &error));
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_MAIN(TestTsvIndex)
+#include "tst_tsvindex.moc"
@@ -0,0 +1,390 @@
+// tests/tst_tsvreader.cpp
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QTemporaryFile>
+
+#include "tsvreader.h"
+
+/**
+ * @brief Набор юнит-тестов для потокового разборщика TSV (TsvReader).
+ *
+ * @details
+ * Проверяем то, что легко сломать при разборе "на байтах":
+ * - строки и поля на границе блоков чтения (маленький chunkSize);
+ * - "\r\n", UTF-8 BOM, пустые строки, последняя строка без '\n';
+ * - номер строки в сообщении об ошибке;
+ * - порционное чтение read(maxRows).
+ */
+class TestTsvReader : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Размеры блока для data-driven тестов.
+    void reads_rows_across_chunk_boundaries_data();
+
+    /**
+     * @brief Результат не зависит от размера блока чтения.
+     */
+    void reads_rows_across_chunk_boundaries();
+
+    /**
+     * @brief CRLF, BOM, пустые/пробельные строки и строка без '\n'.
+     */
+    void handles_crlf_bom_blank_lines_and_missing_final_newline();
+
+    /**
+     * @brief Ошибка содержит номер строки (пустые строки учитываются).
+     */
+    void error_reports_line_number();
+
+    /**
+     * @brief read(maxRows) читает порциями и продолжает с места остановки.
+     */
+    void read_in_batches_resumes();
+
+    /**
+     * @brief parseLine() на отдельной строке: поля, пустая строка, ошибки.
+     */
+    void parseLine_fields_blank_and_errors();
+
+    /**
+     * @brief readMapped() разбирает QFile на месте и сдвигает позицию в конец.
+     */
+    void readMapped_parses_file_in_place();
+
+    /**
+     * @brief readMapped() не трогает QBuffer — вызывающий читает потоково.
+     */
+    void readMapped_falls_back_for_buffer();
+
+    /// Число потоков для data-driven тестов параллельного разбора.
+    void parseLinesParallel_matches_serial_data();
+
+    /**
+     * @brief Параллельный разбор (мелкие блоки) даёт те же строки и в том же порядке.
+     */
+    void parseLinesParallel_matches_serial();
+
+    /**
+     * @brief Сообщается первая по порядку ошибка с точным номером строки.
+     */
+    void parseLinesParallel_reports_first_error_line();
+
+    /**
+     * @brief readBuffer() разбирает данные QBuffer на месте и сдвигает позицию в конец.
+     */
+    void readBuffer_parses_in_place();
+};
+
+namespace {
+
+const QByteArray kSample =
+    "#112233\tQt::DotLine\t5\t10\t20\t30\t40\n"
+    "#aabbcc\t2\t1\t-1\t-2\t3\t4\n"
+    "red\tQt::PenStyle(4)\t7\t0\t0\t100\t200\n";
+
+bool readAll(const QByteArray& bytes, int chunkSize, RectStore& out, QString* error)
+{
+    QByteArray copy = bytes;
+    QBuffer in(&copy);
+    if (!in.open(QIODevice::ReadOnly))
+        return false;
+    TsvReader reader(in, chunkSize);
+    const bool ok = reader.read(out, 0, error);
+    if (ok && !reader.atEnd())
+        return false;
+    return ok;
+}
+
+void checkSample(const RectStore& store)
+{
+    QCOMPARE(store.size(), 3);
+
+    const PackedRect r0 = store.at(0);
+    QCOMPARE(r0.penColor, qRgb(0x11, 0x22, 0x33));
+    QCOMPARE(r0.style(), Qt::DotLine);
+    QCOMPARE(r0.penWidth, 5);
+    QCOMPARE(r0.left, 10);
+    QCOMPARE(r0.top, 20);
+    QCOMPARE(r0.width, 30);
+    QCOMPARE(r0.height, 40);
+
+    const PackedRect r1 = store.at(1);
+    QCOMPARE(r1.penColor, qRgb(0xaa, 0xbb, 0xcc));
+    QCOMPARE(r1.style(), Qt::DashLine);
+    QCOMPARE(r1.left, -1);
+    QCOMPARE(r1.top, -2);
+
+    const PackedRect r2 = store.at(2);
+    QCOMPARE(r2.penColor, QColor(Qt::red).rgba());
+    QCOMPARE(r2.style(), Qt::DashDotLine);
+    QCOMPARE(r2.height, 200);
+}
+
+/**
+ * @brief Большой TSV: @p lines строк, каждая 10-я пустая, часть строк с "\r\n".
+ */
+QByteArray makeLines(int lines)
+{
+    QByteArray bytes;
+    for (int i = 1; i <= lines; ++i)
+    {
+        if (i % 10 == 0)
+        {
+            bytes += "\n";
+            continue;
+        }
+        bytes += "#" + QByteArray::number(0x100000 + i, 16).right(6);
+        bytes += "\t" + QByteArray::number(i % 6);
+        bytes += "\t" + QByteArray::number(i % 5);
+        bytes += "\t" + QByteArray::number(i);
+        bytes += "\t" + QByteArray::number(-i);
+        bytes += "\t" + QByteArray::number(i * 2);
+        bytes += "\t" + QByteArray::number(i * 3);
+        bytes += (i % 3 == 0) ? "\r\n" : "\n";
+    }
+    return bytes;
+}
+
+void compareStores(const RectStore& a, const RectStore& b)
+{
+    QCOMPARE(a.size(), b.size());
+    for (int row = 0; row < a.size(); ++row)
+    {
+        const PackedRect x = a.at(row);
+        const PackedRect y = b.at(row);
+        QCOMPARE(x.penColor, y.penColor);
+        QCOMPARE(x.penStyle, y.penStyle);
+        QCOMPARE(x.penWidth, y.penWidth);
+        QCOMPARE(x.left, y.left);
+        QCOMPARE(x.top, y.top);
+        QCOMPARE(x.width, y.width);
+        QCOMPARE(x.height, y.height);
+    }
+}
+
+} // namespace
+
+void TestTsvReader::reads_rows_across_chunk_boundaries_data()
+{
+    QTest::addColumn<int>("chunkSize");
+    QTest::newRow("1")       << 1;
+    QTest::newRow("7")       << 7;
+    QTest::newRow("64")      << 64;
+    QTest::newRow("default") << TsvReader::kDefaultChunkSize;
+}
+
+void TestTsvReader::reads_rows_across_chunk_boundaries()
+{
+    QFETCH(int, chunkSize);
+
+    RectStore store;
+    QString err;
+    QVERIFY2(readAll(kSample, chunkSize, store, &err), qPrintable(err));
+    checkSample(store);
+}
+
+void TestTsvReader::handles_crlf_bom_blank_lines_and_missing_final_newline()
+{
+    QByteArray bytes = "\xEF\xBB\xBF";
+    bytes += "#112233\tQt::DotLine\t5\t10\t20\t30\t40\r\n";
+    bytes += "\r\n";
+    bytes += "   \t  \n";
+    bytes += "#aabbcc\t2\t1\t-1\t-2\t3\t4\r\n";
+    bytes += "\n";
+    bytes += " red \t Qt::PenStyle(4) \t 7 \t0\t0\t100\t200";
+
+    for (int chunkSize : {2, 5, TsvReader::kDefaultChunkSize})
+    {
+        RectStore store;
+        QString err;
+        QVERIFY2(readAll(bytes, chunkSize, store, &err), qPrintable(err));
+        checkSample(store);
+    }
+}
+
+void TestTsvReader::error_reports_line_number()
+{
+    const QByteArray bytes =
+        "#112233\tQt::DotLine\t5\t10\t20\t30\t40\n"
+        "\n"
+        "#112233\tQt::DotLine\t5\tNOPE\t20\t30\t40\n";
+
+    RectStore store;
+    QString err;
+    QVERIFY(!readAll(bytes, 4, store, &err));
+    QVERIFY(err.startsWith("Строка 3:"));
+    QVERIFY(err.contains("Left"));
+    QVERIFY(err.contains("NOPE"));
+}
+
+void TestTsvReader::read_in_batches_resumes()
+{
+    QByteArray copy = kSample;
+    QBuffer in(&copy);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+    TsvReader reader(in, 16);
+
+    RectStore store;
+    QVERIFY(reader.read(store, 2));
+    QCOMPARE(store.size(), 2);
+    QCOMPARE(reader.lineNumber(), 2);
+    QVERIFY(!reader.atEnd());
+
+    QVERIFY(reader.read(store, 2));
+    QCOMPARE(store.size(), 3);
+    QVERIFY(reader.atEnd());
+    QCOMPARE(reader.bytesConsumed(), qint64(kSample.size()));
+
+    checkSample(store);
+}
+
+void TestTsvReader::parseLine_fields_blank_and_errors()
+{
+    PackedRect r;
+    QString err;
+
+    const QByteArray good = "#010203\tQt::NoPen\t0\t1\t2\t3\t4";
+    QCOMPARE(TsvReader::parseLine(good.constData(), good.constData() + good.size(), 1, r, &err),
+             TsvReader::LineStatus::Row);
+    QCOMPARE(r.penColor, qRgb(1, 2, 3));
+    QCOMPARE(r.style(), Qt::NoPen);
+    QCOMPARE(r.height, 4);
+
+    const QByteArray blank = " \t ";
+    QCOMPARE(TsvReader::parseLine(blank.constData(), blank.constData() + blank.size(), 2, r, &err),
+             TsvReader::LineStatus::Blank);
+
+    const QByteArray fewer = "#010203\tQt::NoPen\t0";
+    QCOMPARE(TsvReader::parseLine(fewer.constData(), fewer.constData() + fewer.size(), 5, r, &err),
+             TsvReader::LineStatus::Error);
+    QCOMPARE(err, QString("Строка 5: ожидалось 7 полей, получено 3"));
+
+    const QByteArray more = "#010203\tQt::NoPen\t0\t1\t2\t3\t4\t5";
+    QCOMPARE(TsvReader::parseLine(more.constData(), more.constData() + more.size(), 6, r, &err),
+             TsvReader::LineStatus::Error);
+    QCOMPARE(err, QString("Строка 6: ожидалось 7 полей, получено 8"));
+
+    const QByteArray badColor = "nocolor\tQt::NoPen\t0\t1\t2\t3\t4";
+    QCOMPARE(TsvReader::parseLine(badColor.constData(), badColor.constData() + badColor.size(), 7, r, &err),
+             TsvReader::LineStatus::Error);
+    QCOMPARE(err, QString("Строка 7: некорректный цвет 'nocolor'"));
+
+    const QByteArray overflow = "#010203\tQt::NoPen\t0\t1\t2\t3\t99999999999";
+    QCOMPARE(TsvReader::parseLine(overflow.constData(), overflow.constData() + overflow.size(), 8, r, &err),
+             TsvReader::LineStatus::Error);
+    QCOMPARE(err, QString("Строка 8: некорректное поле Height '99999999999'"));
+}
+
+void TestTsvReader::readMapped_parses_file_in_place()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("\xEF\xBB\xBF");
+    file.write(kSample);
+    QVERIFY(file.seek(0));
+
+    RectStore store;
+    bool mapped = false;
+    QString err;
+    QVERIFY2(TsvReader::readMapped(file, store, &mapped, &err), qPrintable(err));
+    QVERIFY(mapped);
+    QVERIFY(file.atEnd());
+    checkSample(store);
+}
+
+void TestTsvReader::readMapped_falls_back_for_buffer()
+{
+    QByteArray copy = kSample;
+    QBuffer in(&copy);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+
+    RectStore store;
+    bool mapped = true;
+    QVERIFY(TsvReader::readMapped(in, store, &mapped));
+    QVERIFY(!mapped);
+    QVERIFY(store.isEmpty());
+    QCOMPARE(in.pos(), qint64(0));
+
+    TsvReader reader(in);
+    QVERIFY(reader.read(store, 0));
+    checkSample(store);
+}
+
+void TestTsvReader::parseLinesParallel_matches_serial_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::newRow("2")    << 2;
+    QTest::newRow("4")    << 4;
+    QTest::newRow("16")   << 16;
+    QTest::newRow("auto") << 0;
+}
+
+void TestTsvReader::parseLinesParallel_matches_serial()
+{
+    QFETCH(int, threads);
+
+    const QByteArray bytes = makeLines(3000);
+    const char* begin = bytes.constData();
+    const char* end = begin + bytes.size();
+
+    RectStore serial;
+    QString err;
+    QVERIFY2(TsvReader::parseLines(begin, end, 1, serial, &err), qPrintable(err));
+    QCOMPARE(serial.size(), 2700);
+
+    for (int layout : {int(RectStore::Layout::Rows), int(RectStore::Layout::Columns)})
+    {
+        RectStore parallel(static_cast<RectStore::Layout>(layout));
+        QVERIFY2(TsvReader::parseLinesParallel(begin, end, parallel, threads, &err, 64), qPrintable(err));
+        compareStores(parallel, serial);
+    }
+}
+
+void TestTsvReader::parseLinesParallel_reports_first_error_line()
+{
+    QByteArray bytes = makeLines(3000);
+
+    // Порча строк 2501 и 301 (считая с 1): заменяем первый символ цвета
+    int line = 1;
+    bool lineStart = true;
+    for (int i = 0; i < bytes.size(); ++i)
+    {
+        if (lineStart && (line == 301 || line == 2501))
+            bytes[i] = '?';
+
+        lineStart = bytes.at(i) == '\n';
+        if (lineStart)
+            ++line;
+    }
+
+    RectStore store;
+    QString err;
+    QVERIFY(!TsvReader::parseLinesParallel(bytes.constData(), bytes.constData() + bytes.size(),
+                                           store, 8, &err, 64));
+    QVERIFY2(err.startsWith("Строка 301:"), qPrintable(err));
+
+    QString serialErr;
+    RectStore serial;
+    QVERIFY(!TsvReader::parseLines(bytes.constData(), bytes.constData() + bytes.size(), 1, serial, &serialErr));
+    QCOMPARE(err, serialErr);
+}
+
+void TestTsvReader::readBuffer_parses_in_place()
+{
+    QByteArray copy = QByteArray("\xEF\xBB\xBF") + kSample;
+    QBuffer in(&copy);
+    QVERIFY(in.open(QIODevice::ReadOnly));
+
+    RectStore store;
+    bool handled = false;
+    QString err;
+    QVERIFY2(TsvReader::readBuffer(in, store, &handled, &err, 4), qPrintable(err));
+    QVERIFY(handled);
+    QVERIFY(in.atEnd());
+    checkSample(store);
+}
+
+QTEST_MAIN(TestTsvReader)
+#include "tst_tsvreader.moc"
@@ -0,0 +1,226 @@
+// tests/tst_tsvwriter.cpp
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QStringList>
+#include <QTextStream>
+
+#include "rectformat.h"
+#include "tsvwriter.h"
+
+/**
+ * @brief Набор юнит-тестов для записи TSV (TsvWriter).
+ *
+ * @details
+ * Главное требование — побайтное совпадение с прежней записью через
+ * QTextStream + QStringList (эталон повторён прямо в тесте), в том числе
+ * на границах блока kBufferSize и на крайних значениях полей.
+ */
+class TestTsvWriter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    /// Раскладки хранилища.
+    void matches_legacy_writer_data();
+
+    /**
+     * @brief Результат побайтно совпадает с прежней записью (больше kBufferSize).
+     */
+    void matches_legacy_writer();
+
+    /**
+     * @brief Запись порциями даёт тот же файл, что и одним вызовом.
+     */
+    void write_in_portions_matches_single_write();
+
+    /// Число потоков, первая строка и число строк для параллельной записи.
+    void parallel_write_matches_serial_data();
+
+    /**
+     * @brief Параллельная запись побайтно совпадает с последовательной.
+     */
+    void parallel_write_matches_serial();
+
+    /**
+     * @brief formatInt()/formatColor() совпадают с QString::number()/colorName().
+     */
+    void formatters_match_qt();
+
+    /**
+     * @brief Ошибка устройства возвращает false и текст ошибки.
+     */
+    void write_error_is_reported();
+};
+
+namespace {
+
+/**
+ * @brief Эталон "до": прежний TsvWriter::write() (QTextStream + QStringList).
+ */
+QByteArray legacyWrite(const RectStore& rows)
+{
+    QByteArray bytes;
+    QBuffer out(&bytes);
+    out.open(QIODevice::WriteOnly);
+    QTextStream stream(&out);
+
+    for (int row = 0; row < rows.size(); ++row)
+    {
+        const PackedRect r = rows.at(row);
+        QStringList fields;
+        fields << RectFormat::colorName(r.penColor);
+        fields << RectFormat::penStyleName(r.style());
+        fields << QString::number(r.penWidth);
+        fields << QString::number(r.left);
+        fields << QString::number(r.top);
+        fields << QString::number(r.width);
+        fields << QString::number(r.height);
+        stream << fields.join('\t') << '\n';
+    }
+    stream.flush();
+    return bytes;
+}
+
+/**
+ * @brief @p count строк: все стили 0..Qt::MPenStyle, альфа в цвете, крайние int.
+ */
+RectStore makeRows(int count, RectStore::Layout layout)
+{
+    static const qint32 kExtremes[] = {
+        0, 1, -1, 9, 10, 99, 100, -100, 123456789, 2147483647, -2147483647 - 1,
+    };
+    constexpr int kExtremeCount = int(sizeof(kExtremes) / sizeof(kExtremes[0]));
+
+    RectStore rows(layout);
+    rows.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        PackedRect r;
+        r.penColor = (quint32(i) * 2654435761u) | (i % 2 ? 0xff000000u : 0x12000000u);
+        r.penStyle = static_cast<quint8>(i % (int(Qt::MPenStyle) + 1));
+        r.penWidth = i % 7;
+        r.left = kExtremes[i % kExtremeCount];
+        r.top = -i;
+        r.width = i * 3;
+        r.height = kExtremes[(i / 3) % kExtremeCount];
+        rows.append(r);
+    }
+    return rows;
+}
+
+QByteArray writeAll(const RectStore& rows, int portion, int threads = 1)
+{
+    QByteArray bytes;
+    QBuffer out(&bytes);
+    out.open(QIODevice::WriteOnly);
+
+    TsvWriter writer(out);
+    writer.setThreads(threads);
+    for (int first = 0; first < rows.size(); first += portion)
+    {
+        if (!writer.write(rows, first, qMin(portion, rows.size() - first)))
+            return QByteArray();
+    }
+    return bytes;
+}
+
+} // namespace
+
+void TestTsvWriter::matches_legacy_writer_data()
+{
+    QTest::addColumn<int>("layout");
+
+    QTest::newRow("rows")    << int(RectStore::Layout::Rows);
+    QTest::newRow("columns") << int(RectStore::Layout::Columns);
+}
+
+void TestTsvWriter::matches_legacy_writer()
+{
+    QFETCH(int, layout);
+
+    // ~60 байт на строку: заведомо больше одного блока kBufferSize.
+    const int count = 2 * TsvWriter::kBufferSize / 40;
+    const RectStore rows = makeRows(count, static_cast<RectStore::Layout>(layout));
+
+    const QByteArray expected = legacyWrite(rows);
+    QVERIFY(expected.size() > TsvWriter::kBufferSize);
+    QCOMPARE(writeAll(rows, rows.size()), expected);
+}
+
+void TestTsvWriter::write_in_portions_matches_single_write()
+{
+    const RectStore rows = makeRows(5000, RectStore::Layout::Rows);
+    const QByteArray whole = writeAll(rows, rows.size());
+
+    QCOMPARE(writeAll(rows, 1), whole);
+    QCOMPARE(writeAll(rows, 777), whole);
+}
+
+void TestTsvWriter::parallel_write_matches_serial_data()
+{
+    QTest::addColumn<int>("threads");
+    QTest::addColumn<int>("rows");
+    QTest::addColumn<int>("portion");
+
+    const int chunk = TsvWriter::kParallelChunkRows;
+
+    QTest::newRow("below threshold x4")   << 4 << 2 * chunk - 1     << 2 * chunk - 1;
+    QTest::newRow("exact chunks x2")      << 2 << 8 * chunk         << 8 * chunk;
+    QTest::newRow("partial chunk x3")     << 3 << 9 * chunk + 17    << 9 * chunk + 17;
+    QTest::newRow("many waves x2")        << 2 << 21 * chunk + 5    << 21 * chunk + 5;
+    QTest::newRow("auto threads")         << 0 << 7 * chunk + 1     << 7 * chunk + 1;
+    QTest::newRow("portions x4")          << 4 << 10 * chunk + 3    << 3 * chunk + 11;
+}
+
+void TestTsvWriter::parallel_write_matches_serial()
+{
+    QFETCH(int, threads);
+    QFETCH(int, rows);
+    QFETCH(int, portion);
+
+    const RectStore store = makeRows(rows, RectStore::Layout::Columns);
+    const QByteArray serial = writeAll(store, store.size());
+
+    QCOMPARE(writeAll(store, portion, threads), serial);
+}
+
+void TestTsvWriter::formatters_match_qt()
+{
+    char buf[RectFormat::kMaxIntSize + 1];
+
+    for (qint32 v : {0, 7, -7, 10, 99, 100, 65536, -65536, 2147483647, -2147483647 - 1})
+    {
+        const char* end = RectFormat::formatInt(v, buf);
+        QCOMPARE(QByteArray(buf, int(end - buf)), QString::number(v).toLatin1());
+    }
+
+    for (QRgb c : {0x00000000u, 0xffffffffu, 0x801a2b3cu, 0xff0a0b0cu})
+    {
+        const char* end = RectFormat::formatColor(c, buf);
+        QCOMPARE(int(end - buf), RectFormat::kColorNameSize);
+        QCOMPARE(QByteArray(buf, int(end - buf)), RectFormat::colorName(c).toLatin1());
+    }
+
+    for (int s = 0; s <= int(Qt::MPenStyle); ++s)
+    {
+        const Qt::PenStyle style = static_cast<Qt::PenStyle>(s);
+        QCOMPARE(QString(RectFormat::penStyleNameLatin1(style)), RectFormat::penStyleName(style));
+    }
+}
+
+void TestTsvWriter::write_error_is_reported()
+{
+    const RectStore rows = makeRows(10, RectStore::Layout::Rows);
+
+    QByteArray bytes;
+    QBuffer out(&bytes);
+    QVERIFY(out.open(QIODevice::ReadOnly));
+
+    TsvWriter writer(out);
+    QString error;
+    QVERIFY(!writer.write(rows, 0, rows.size(), &error));
+    QVERIFY(!error.isEmpty());
+}
+
+QTEST_MAIN(TestTsvWriter)
+#include "tst_tsvwriter.moc"
@@ -0,0 +1,261 @@
+#include "tsvindex.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QIODevice>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+#include "tsvreader.h"
+
+namespace {
+
+/// Сигнатура файла-спутника.
+constexpr char kMagic[] = "RECTTIDX";
+constexpr int kMagicSize = 8;
+
+/// Смещения полей заголовка.
+constexpr int kOffVersion    = 8;
+constexpr int kOffStride     = 12;
+constexpr int kOffFileSize   = 16;
+constexpr int kOffFileMTime  = 24;
+constexpr int kOffRowCount   = 32;
+constexpr int kOffEntryCount = 40;
+constexpr int kHeaderSize    = 48;
+
+/// Размер одной точки индекса.
+constexpr int kEntrySize = 16;
+
+/// Время изменения файла в миллисекундах (UTC).
+qint64 fileMTime(const QFileInfo& info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+} // namespace
+
+QString TsvIndex::sidecarFileName(const QString& tsvFileName)
+{
+    return tsvFileName + QLatin1String(".idx");
+}
+
+bool TsvIndex::open(const QString& tsvFileName, QString* error, int stride)
+{
+    const QString sidecar = sidecarFileName(tsvFileName);
+
+    TsvIndex cached;
+    if (QFileInfo::exists(sidecar) && cached.load(sidecar) && cached.isValidFor(tsvFileName))
+    {
+        *this = std::move(cached);
+        return true;
+    }
+
+    if (!build(tsvFileName, stride, error))
+        return false;
+
+    save(sidecar);
+    return true;
+}
+
+/**
+ * @details
+ * Точка индекса ставится перед каждой серией из stride строк данных:
+ * её смещение и номер строки берутся у читателя до skip(). Размер и время
+ * изменения снимаются до прохода — если файл меняется во время построения,
+ * следующий open() увидит несовпадение и перестроит индекс.
+ */
+bool TsvIndex::build(const QString& tsvFileName, int stride, QString* error)
+{
+    const QFileInfo info(tsvFileName);
+    QFile file(tsvFileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    TsvIndex result;
+    result.m_stride = qMax(1, stride);
+    result.m_fileSize = info.size();
+    result.m_fileMTime = fileMTime(info);
+
+    TsvReader reader(file);
+    for (;;)
+    {
+        Entry entry;
+        entry.offset = reader.bytesConsumed();
+        entry.lineNo = reader.lineNumber();
+
+        const int skipped = reader.skip(result.m_stride, error);
+        if (skipped < 0)
+            return false;
+        if (skipped == 0)
+            break;
+
+        result.m_entries.append(entry);
+        result.m_rowCount += skipped;
+
+        if (skipped < result.m_stride)
+            break;
+    }
+
+    *this = std::move(result);
+    return true;
+}
+
+bool TsvIndex::save(const QString& indexFileName, QString* error) const
+{
+    QByteArray data(kHeaderSize + kEntrySize * m_entries.size(), '\0');
+    char* p = data.data();
+
+    std::memcpy(p, kMagic, kMagicSize);
+    qToLittleEndian<quint32>(kVersion, p + kOffVersion);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_stride), p + kOffStride);
+    qToLittleEndian<quint64>(static_cast<quint64>(m_fileSize), p + kOffFileSize);
+    qToLittleEndian<qint64>(m_fileMTime, p + kOffFileMTime);
+    qToLittleEndian<quint64>(static_cast<quint64>(m_rowCount), p + kOffRowCount);
+    qToLittleEndian<quint64>(static_cast<quint64>(m_entries.size()), p + kOffEntryCount);
+
+    char* entry = p + kHeaderSize;
+    for (const Entry& e : m_entries)
+    {
+        qToLittleEndian<quint64>(static_cast<quint64>(e.offset), entry);
+        qToLittleEndian<quint64>(static_cast<quint64>(e.lineNo), entry + 8);
+        entry += kEntrySize;
+    }
+
+    QSaveFile file(indexFileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    if (file.write(data) != data.size() || !file.commit())
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @details
+ * Число точек должно согласовываться с числом строк и шагом, а размер файла —
+ * с числом точек: иначе спутник считается повреждённым.
+ */
+bool TsvIndex::load(const QString& indexFileName, QString* error)
+{
+    QFile file(indexFileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        if (error) *error = file.errorString();
+        return false;
+    }
+
+    const QByteArray data = file.readAll();
+    const char* p = data.constData();
+
+    if (data.size() < kHeaderSize || std::memcmp(p, kMagic, kMagicSize) != 0)
+    {
+        if (error) *error = "Неверная сигнатура файла индекса";
+        return false;
+    }
+
+    const quint32 version = qFromLittleEndian<quint32>(p + kOffVersion);
+    if (version != kVersion)
+    {
+        if (error) *error = QString("Неподдерживаемая версия индекса: %1").arg(version);
+        return false;
+    }
+
+    const quint32 stride = qFromLittleEndian<quint32>(p + kOffStride);
+    const quint64 rowCount = qFromLittleEndian<quint64>(p + kOffRowCount);
+    const quint64 entryCount = qFromLittleEndian<quint64>(p + kOffEntryCount);
+
+    if (stride == 0 || stride > quint32(std::numeric_limits<int>::max())
+        || entryCount != (rowCount + stride - 1) / stride
+        || entryCount != quint64(data.size() - kHeaderSize) / kEntrySize
+        || (data.size() - kHeaderSize) % kEntrySize != 0)
+    {
+        if (error) *error = "Файл индекса повреждён";
+        return false;
+    }
+
+    TsvIndex result;
+    result.m_stride = static_cast<int>(stride);
+    result.m_rowCount = static_cast<qint64>(rowCount);
+    result.m_fileSize = static_cast<qint64>(qFromLittleEndian<quint64>(p + kOffFileSize));
+    result.m_fileMTime = qFromLittleEndian<qint64>(p + kOffFileMTime);
+
+    result.m_entries.resize(static_cast<int>(entryCount));
+    const char* entry = p + kHeaderSize;
+    for (Entry& e : result.m_entries)
+    {
+        e.offset = static_cast<qint64>(qFromLittleEndian<quint64>(entry));
+        e.lineNo = static_cast<qint64>(qFromLittleEndian<quint64>(entry + 8));
+        entry += kEntrySize;
+    }
+
+    *this = std::move(result);
+    return true;
+}
+
+bool TsvIndex::isValidFor(const QString& tsvFileName) const
+{
+    const QFileInfo info(tsvFileName);
+    return info.exists() && info.size() == m_fileSize && fileMTime(info) == m_fileMTime;
+}
+
+qint64 TsvIndex::rowCount() const
+{
+    return m_rowCount;
+}
+
+int TsvIndex::stride() const
+{
+    return m_stride;
+}
+
+bool TsvIndex::readRows(QIODevice& in, qint64 firstRow, int count, RectStore& out, QString* error) const
+{
+    if (firstRow < 0 || firstRow > m_rowCount)
+    {
+        if (error) *error = QString("Строка %1 вне файла (строк: %2)").arg(firstRow).arg(m_rowCount);
+        return false;
+    }
+
+    count = static_cast<int>(qMin<qint64>(qMax(0, count), m_rowCount - firstRow));
+    if (count == 0)
+        return true;
+
+    const Entry& entry = m_entries.at(static_cast<int>(firstRow / m_stride));
+    if (!in.seek(entry.offset))
+    {
+        if (error) *error = QString("Не удалось перейти к смещению %1").arg(entry.offset);
+        return false;
+    }
+
+    TsvReader reader(in);
+    reader.setLineNumber(static_cast<int>(entry.lineNo));
+
+    const int skip = static_cast<int>(firstRow % m_stride);
+    const int skipped = reader.skip(skip, error);
+    if (skipped < 0)
+        return false;
+
+    const int before = out.size();
+    if (skipped == skip && !reader.read(out, count, error))
+        return false;
+
+    if (skipped != skip || out.size() - before != count)
+    {
+        if (error) *error = "TSV-файл не соответствует индексу (изменён после построения)";
+        return false;
+    }
+
+    return true;
+}
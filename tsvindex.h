@@ -0,0 +1,146 @@
+#ifndef TSVINDEX_H
+#define TSVINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+
+#include "rectstore.h"
+
+class QIODevice;
+
+/**
+ * @brief Индекс смещений строк TSV-файла для произвольного доступа.
+ *
+ * @details
+ * # Зачем
+ * Чтобы открыть строки [N, N + count) многогигабайтного TSV, не нужно
+ * разбирать всё, что перед ними: индекс хранит смещение в байтах каждой
+ * stride()-й строки данных. Чтение окна = seek() к ближайшей точке индекса,
+ * пропуск не более stride() - 1 строк без разбора (TsvReader::skip())
+ * и разбор только самих строк окна.
+ *
+ * Строки считаются так же, как их видит модель: пустые строки не являются
+ * строками данных, но входят в сквозную нумерацию (сообщения об ошибках
+ * указывают номер строки файла).
+ *
+ * # Файл-спутник
+ * Индекс сохраняется рядом с TSV (sidecarFileName(): "<файл>.idx") и
+ * привязан к размеру и времени изменения TSV: при любом несовпадении
+ * open() строит индекс заново. Все числа little-endian:
+ * | Смещение | Тип       | Поле                                            |
+ * |----------|-----------|-------------------------------------------------|
+ * | 0        | char[8]   | сигнатура "RECTTIDX"                            |
+ * | 8        | quint32   | версия формата (kVersion)                       |
+ * | 12       | quint32   | шаг индекса (stride)                            |
+ * | 16       | quint64   | размер TSV-файла                                |
+ * | 24       | qint64    | время изменения TSV (мс от эпохи, UTC)          |
+ * | 32       | quint64   | число строк данных                              |
+ * | 40       | quint64   | число точек индекса                             |
+ * | 48       | 16 x N    | точки: смещение (quint64), номер строки (quint64) |
+ *
+ * Номер строки точки — число строк файла перед ней (TsvReader::setLineNumber()).
+ * При шаге 4096 индекс 100 млн строк занимает около 400 КиБ.
+ */
+class TsvIndex
+{
+public:
+    /// Шаг индекса по умолчанию (строк данных между точками).
+    static constexpr int kDefaultStride = 4096;
+
+    /// Текущая версия формата файла-спутника.
+    static constexpr quint32 kVersion = 1;
+
+    /**
+     * @brief Имя файла-спутника для TSV-файла @p tsvFileName.
+     */
+    static QString sidecarFileName(const QString& tsvFileName);
+
+    /**
+     * @brief Загружает актуальный индекс из файла-спутника или строит и сохраняет новый.
+     *
+     * @details
+     * Неактуальный (другой размер/время изменения TSV), повреждённый или
+     * отсутствующий спутник перестраивается. Если спутник не удалось записать
+     * (например, каталог только для чтения), индекс всё равно пригоден —
+     * он просто будет построен заново при следующем open().
+     *
+     * @param tsvFileName Путь к TSV-файлу.
+     * @param error Опционально: текст ошибки.
+     * @param stride Шаг для нового индекса (у загруженного — тот, с которым он строился).
+     * @return false, если TSV не удалось прочитать.
+     */
+    bool open(const QString& tsvFileName, QString* error = nullptr, int stride = kDefaultStride);
+
+    /**
+     * @brief Строит индекс одним проходом по файлу (поля строк не разбираются).
+     *
+     * @param tsvFileName Путь к TSV-файлу.
+     * @param stride Шаг индекса (не меньше 1).
+     * @param error Опционально: текст ошибки.
+     * @return false при ошибке открытия/чтения.
+     */
+    bool build(const QString& tsvFileName, int stride = kDefaultStride, QString* error = nullptr);
+
+    /**
+     * @brief Записывает индекс в файл (через QSaveFile).
+     */
+    bool save(const QString& indexFileName, QString* error = nullptr) const;
+
+    /**
+     * @brief Читает индекс из файла.
+     *
+     * @return false при неверной сигнатуре, версии или повреждённых данных
+     *         (текущий индекс при этом не меняется).
+     */
+    bool load(const QString& indexFileName, QString* error = nullptr);
+
+    /**
+     * @brief Соответствует ли индекс текущему состоянию TSV-файла (размер и время изменения).
+     */
+    bool isValidFor(const QString& tsvFileName) const;
+
+    /**
+     * @brief Число строк данных в файле.
+     */
+    qint64 rowCount() const;
+
+    /**
+     * @brief Шаг индекса.
+     */
+    int stride() const;
+
+    /**
+     * @brief Читает строки [@p firstRow, @p firstRow + @p count) в конец @p out.
+     *
+     * @details
+     * Окно, выходящее за конец файла, усекается. Формат строк окна проверяется
+     * как в TsvReader::read(); при ошибке в @p out может остаться часть строк —
+     * вызывающий отбрасывает его целиком.
+     *
+     * @param in Тот же TSV-файл, открытый на чтение (устройство с произвольным доступом).
+     * @param firstRow Номер первой строки данных (с 0), не больше rowCount().
+     * @param count Число строк.
+     * @param out Хранилище-приёмник.
+     * @param error Опционально: текст ошибки.
+     * @return false при ошибке позиционирования, чтения, формата или если файл
+     *         короче, чем записано в индексе.
+     */
+    bool readRows(QIODevice& in, qint64 firstRow, int count, RectStore& out, QString* error = nullptr) const;
+
+private:
+    /// Точка индекса: начало stride()-й строки данных.
+    struct Entry
+    {
+        qint64 offset = 0;  ///< Смещение в байтах (может указывать на пустые строки перед ней).
+        qint64 lineNo = 0;  ///< Число строк файла перед offset.
+    };
+
+    QVector<Entry> m_entries;
+    int m_stride = kDefaultStride;
+    qint64 m_rowCount = 0;
+    qint64 m_fileSize = -1;
+    qint64 m_fileMTime = 0;
+};
+
+#endif // TSVINDEX_H
@@ -0,0 +1,565 @@
+#include "tsvreader.h"
+
+#include <QBuffer>
+#include <QFileDevice>
+#include <QIODevice>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "rectcolumns.h"
+#include "rectformat.h"
+
+namespace {
+
+using RectColumns::Column;
+using RectColumns::kColCount;
+using RectColumns::kColCountInt;
+using RectColumns::kColumns;
+
+/// UTF-8 BOM.
+constexpr char kUtf8Bom[] = "\xEF\xBB\xBF";
+constexpr int kUtf8BomSize = 3;
+
+/// Начинаются ли байты [begin, end) с UTF-8 BOM.
+bool startsWithBom(const char* begin, const char* end)
+{
+    return end - begin >= kUtf8BomSize && std::memcmp(begin, kUtf8Bom, kUtf8BomSize) == 0;
+}
+
+/**
+ * @brief Текст поля для сообщения об ошибке.
+ */
+QString fieldText(QLatin1String f)
+{
+    return QString::fromUtf8(f.data(), f.size());
+}
+
+/**
+ * @brief Блок параллельного разбора: диапазон целых строк и его результат.
+ */
+struct ParseChunk
+{
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    RectStore rows;
+    bool ok = true;
+};
+
+/**
+ * @brief Задача пула: разбирает один блок с относительной нумерацией строк.
+ *
+ * @details
+ * Текст ошибки здесь не формируется (номер строки ещё неизвестен) —
+ * фиксируется только факт ошибки и минимальный индекс упавшего блока,
+ * чтобы блоки после него не разбирались впустую.
+ */
+class ParseChunkTask final : public QRunnable
+{
+public:
+    ParseChunkTask(ParseChunk& chunk, int index, std::atomic<int>& firstFailed)
+        : m_chunk(chunk)
+        , m_index(index)
+        , m_firstFailed(firstFailed)
+    {
+    }
+
+    void run() override
+    {
+        if (m_index > m_firstFailed.load(std::memory_order_relaxed))
+            return;
+
+        m_chunk.ok = TsvReader::parseLines(m_chunk.begin, m_chunk.end, 1, m_chunk.rows, nullptr);
+        if (m_chunk.ok)
+            return;
+
+        int current = m_firstFailed.load(std::memory_order_relaxed);
+        while (m_index < current && !m_firstFailed.compare_exchange_weak(current, m_index))
+        {
+        }
+    }
+
+private:
+    ParseChunk& m_chunk;
+    int m_index;
+    std::atomic<int>& m_firstFailed;
+};
+
+} // namespace
+
+// -------------------- ctor / state --------------------
+
+TsvReader::TsvReader(QIODevice& in, int chunkSize)
+    : m_in(in)
+    , m_chunkSize(qMax(1, chunkSize))
+{
+}
+
+bool TsvReader::atEnd() const
+{
+    return m_eof && m_pos >= m_buffer.size();
+}
+
+int TsvReader::lineNumber() const
+{
+    return m_lineNo;
+}
+
+void TsvReader::setLineNumber(int lineNo)
+{
+    m_lineNo = lineNo;
+}
+
+qint64 TsvReader::bytesConsumed() const
+{
+    return m_consumed;
+}
+
+// -------------------- buffer --------------------
+
+/**
+ * @brief Дочитывание блока.
+ *
+ * @details
+ * Разобранный префикс удаляется (memmove хвоста в начало), ёмкость буфера
+ * при этом сохраняется — в установившемся режиме новых выделений нет.
+ * Строка длиннее блока просто растит буфер до нужного размера.
+ */
+bool TsvReader::fill(QString* error)
+{
+    if (m_pos > 0)
+    {
+        m_buffer.remove(0, m_pos);
+        m_pos = 0;
+    }
+
+    const int tail = m_buffer.size();
+    m_buffer.resize(tail + m_chunkSize);
+
+    const qint64 n = m_in.read(m_buffer.data() + tail, m_chunkSize);
+    if (n < 0)
+    {
+        m_buffer.resize(tail);
+        if (error) *error = "Ошибка чтения TSV-потока";
+        return false;
+    }
+
+    m_buffer.resize(tail + static_cast<int>(n));
+    if (n == 0)
+        m_eof = true;
+
+    if (!m_started)
+    {
+        m_started = true;
+        if (startsWithBom(m_buffer.constData(), m_buffer.constData() + m_buffer.size()))
+        {
+            m_pos = kUtf8BomSize;
+            m_consumed += kUtf8BomSize;
+        }
+    }
+
+    return true;
+}
+
+// -------------------- parsing --------------------
+
+bool TsvReader::read(RectStore& out, int maxRows, QString* error)
+{
+    int produced = 0;
+
+    while (maxRows <= 0 || produced < maxRows)
+    {
+        const char* data = m_buffer.constData();
+        const int size = m_buffer.size();
+        const char* lineBegin = data + m_pos;
+        const char* nl = static_cast<const char*>(
+            std::memchr(lineBegin, '\n', static_cast<std::size_t>(size - m_pos)));
+
+        const char* lineEnd = nl;
+        if (!nl)
+        {
+            if (!m_eof)
+            {
+                if (!fill(error))
+                    return false;
+                continue;
+            }
+            if (m_pos >= size)
+                break;
+
+            // Последняя строка без '\n'
+            lineEnd = data + size;
+        }
+
+        const int next = nl ? static_cast<int>(nl - data) + 1 : size;
+        m_consumed += next - m_pos;
+        m_pos = next;
+        ++m_lineNo;
+
+        const int before = out.size();
+        if (!parseLines(lineBegin, lineEnd, m_lineNo, out, error))
+            return false;
+        produced += out.size() - before;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Пропуск строк.
+ *
+ * @details
+ * Тот же обход буфера, что и в read(), но строка лишь проверяется на пустоту
+ * (тем же правилом, что в parseLine()).
+ */
+int TsvReader::skip(int rows, QString* error)
+{
+    int skipped = 0;
+
+    while (skipped < rows)
+    {
+        const char* data = m_buffer.constData();
+        const int size = m_buffer.size();
+        const char* lineBegin = data + m_pos;
+        const char* nl = static_cast<const char*>(
+            std::memchr(lineBegin, '\n', static_cast<std::size_t>(size - m_pos)));
+
+        const char* lineEnd = nl;
+        if (!nl)
+        {
+            if (!m_eof)
+            {
+                if (!fill(error))
+                    return -1;
+                continue;
+            }
+            if (m_pos >= size)
+                break;
+
+            lineEnd = data + size;
+        }
+
+        const int next = nl ? static_cast<int>(nl - data) + 1 : size;
+        m_consumed += next - m_pos;
+        m_pos = next;
+        ++m_lineNo;
+
+        if (lineEnd > lineBegin && lineEnd[-1] == '\r')
+            --lineEnd;
+        if (!QLatin1String(lineBegin, lineEnd).trimmed().isEmpty())
+            ++skipped;
+    }
+
+    return skipped;
+}
+
+bool TsvReader::parseLines(const char* begin,
+                           const char* end,
+                           int firstLineNo,
+                           RectStore& out,
+                           QString* error)
+{
+    PackedRect row;
+    int lineNo = firstLineNo;
+
+    for (const char* p = begin; p < end; ++lineNo)
+    {
+        const char* nl = static_cast<const char*>(
+            std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        const char* lineEnd = nl ? nl : end;
+        const char* next = nl ? nl + 1 : end;
+
+        if (lineEnd > p && lineEnd[-1] == '\r')
+            --lineEnd;
+
+        switch (parseLine(p, lineEnd, lineNo, row, error))
+        {
+        case LineStatus::Row:
+            out.append(row);
+            break;
+        case LineStatus::Blank:
+            break;
+        case LineStatus::Error:
+            return false;
+        }
+
+        p = next;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Параллельный разбор.
+ *
+ * @details
+ * Границы блоков: begin + size * i / n, сдвинутые за ближайший '\n' —
+ * каждый блок начинается с начала строки, поэтому блоки независимы.
+ * Номер первой строки блока нужен только для текста ошибки, поэтому
+ * '\n' перед блоком считаются лишь для упавшего блока.
+ */
+bool TsvReader::parseLinesParallel(const char* begin,
+                                   const char* end,
+                                   RectStore& out,
+                                   int threads,
+                                   QString* error,
+                                   int minChunkSize)
+{
+    if (threads <= 0)
+        threads = QThread::idealThreadCount();
+
+    const qint64 size = end - begin;
+    const qint64 chunkCount = qBound<qint64>(1, size / qMax(1, minChunkSize), qint64(qMax(1, threads)) * 4);
+    if (threads <= 1 || chunkCount <= 1)
+        return parseLines(begin, end, 1, out, error);
+
+    std::vector<ParseChunk> chunks;
+    chunks.reserve(static_cast<std::size_t>(chunkCount));
+
+    const char* chunkBegin = begin;
+    for (qint64 i = 1; i <= chunkCount && chunkBegin < end; ++i)
+    {
+        const char* chunkEnd = end;
+        if (i < chunkCount)
+        {
+            const char* target = qMax(chunkBegin, begin + size * i / chunkCount);
+            const char* nl = static_cast<const char*>(
+                std::memchr(target, '\n', static_cast<std::size_t>(end - target)));
+            chunkEnd = nl ? nl + 1 : end;
+        }
+
+        ParseChunk chunk;
+        chunk.begin = chunkBegin;
+        chunk.end = chunkEnd;
+        chunk.rows = RectStore(out.layout());
+        chunks.push_back(std::move(chunk));
+
+        chunkBegin = chunkEnd;
+    }
+
+    std::atomic<int> firstFailed { std::numeric_limits<int>::max() };
+    {
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        for (std::size_t i = 0; i < chunks.size(); ++i)
+            pool.start(new ParseChunkTask(chunks[i], static_cast<int>(i), firstFailed));
+        pool.waitForDone();
+    }
+
+    for (const ParseChunk& chunk : chunks)
+    {
+        if (chunk.ok)
+            continue;
+
+        // Повторный разбор упавшего блока с настоящим номером первой строки
+        const int firstLineNo = 1 + static_cast<int>(std::count(begin, chunk.begin, '\n'));
+        RectStore scratch(out.layout());
+        parseLines(chunk.begin, chunk.end, firstLineNo, scratch, error);
+        return false;
+    }
+
+    int total = 0;
+    for (const ParseChunk& chunk : chunks)
+        total += chunk.rows.size();
+    out.reserve(out.size() + total);
+
+    for (ParseChunk& chunk : chunks)
+    {
+        out.append(chunk.rows);
+        chunk.rows = RectStore(out.layout());
+    }
+
+    return true;
+}
+
+/**
+ * @brief Разбор отображённого файла.
+ *
+ * @details
+ * Режим открытия (в т.ч. QIODevice::Text) на отображение не влияет:
+ * "\r\n" и так обрабатывается parseLines().
+ */
+bool TsvReader::readMapped(QIODevice& in, RectStore& out, bool* mapped, QString* error, int threads)
+{
+    *mapped = false;
+
+    auto* file = qobject_cast<QFileDevice*>(&in);
+    if (!file || file->isSequential())
+        return true;
+
+    const qint64 offset = file->pos();
+    const qint64 length = file->size() - offset;
+    if (length <= 0)
+        return true;
+
+    uchar* data = file->map(offset, length);
+    if (!data)
+        return true;
+
+    *mapped = true;
+
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + length;
+    if (offset == 0 && startsWithBom(begin, end))
+        begin += kUtf8BomSize;
+
+    const bool ok = parseLinesParallel(begin, end, out, threads, error);
+
+    file->unmap(data);
+    if (ok)
+        file->seek(offset + length);
+
+    return ok;
+}
+
+bool TsvReader::readBuffer(QIODevice& in, RectStore& out, bool* handled, QString* error, int threads)
+{
+    *handled = false;
+
+    auto* buffer = qobject_cast<QBuffer*>(&in);
+    if (!buffer)
+        return true;
+
+    *handled = true;
+
+    const QByteArray& data = buffer->data();
+    const qint64 offset = qMin(buffer->pos(), qint64(data.size()));
+
+    const char* begin = data.constData() + offset;
+    const char* end = data.constData() + data.size();
+    if (offset == 0 && startsWithBom(begin, end))
+        begin += kUtf8BomSize;
+
+    const bool ok = parseLinesParallel(begin, end, out, threads, error);
+    if (ok)
+        buffer->seek(data.size());
+
+    return ok;
+}
+
+/**
+ * @brief Разбор одной строки.
+ *
+ * @details
+ * Поля режутся по '\t' (memchr) в массив представлений, затем разбираются
+ * в порядке kColumns — поэтому при нескольких ошибках сообщается о первой
+ * по порядку столбцов, как и раньше.
+ */
+TsvReader::LineStatus TsvReader::parseLine(const char* begin,
+                                           const char* end,
+                                           int lineNo,
+                                           PackedRect& out,
+                                           QString* error)
+{
+    if (QLatin1String(begin, end).trimmed().isEmpty())
+        return LineStatus::Blank;
+
+    std::array<QLatin1String, kColCount> fields;
+    int count = 0;
+
+    const char* p = begin;
+    for (;;)
+    {
+        const char* tab = static_cast<const char*>(
+            std::memchr(p, '\t', static_cast<std::size_t>(end - p)));
+        const char* fieldEnd = tab ? tab : end;
+
+        if (count < kColCountInt)
+            fields[static_cast<std::size_t>(count)] = QLatin1String(p, fieldEnd);
+        ++count;
+
+        if (!tab)
+            break;
+        p = tab + 1;
+    }
+
+    if (count != kColCountInt)
+    {
+        if (error)
+        {
+            *error = QString("Строка %1: ожидалось %2 полей, получено %3")
+                         .arg(lineNo)
+                         .arg(kColCountInt)
+                         .arg(count);
+        }
+        return LineStatus::Error;
+    }
+
+    auto parseIntField = [&](QLatin1String f, const char* fieldName, qint32& outVal) -> bool
+    {
+        bool ok = false;
+        outVal = RectFormat::parseInt(f, &ok);
+        if (!ok)
+        {
+            if (error)
+            {
+                *error = QString("Строка %1: некорректное поле %2 '%3'")
+                             .arg(lineNo)
+                             .arg(fieldName)
+                             .arg(fieldText(f));
+            }
+            return false;
+        }
+        return true;
+    };
+
+    PackedRect r;
+
+    for (std::size_t i = 0; i < kColCount; ++i)
+    {
+        const QLatin1String f = fields[i];
+        const char* header = kColumns[i].header;
+
+        switch (kColumns[i].col)
+        {
+        case Column::PenColor:
+        {
+            if (!RectFormat::parseColor(f, &r.penColor))
+            {
+                if (error) *error = QString("Строка %1: некорректный цвет '%2'").arg(lineNo).arg(fieldText(f));
+                return LineStatus::Error;
+            }
+            break;
+        }
+        case Column::PenStyle:
+        {
+            bool styleOk = false;
+            const Qt::PenStyle style = RectFormat::parsePenStyle(f, &styleOk);
+            if (!styleOk)
+            {
+                if (error) *error = QString("Строка %1: некорректный стиль пера '%2'").arg(lineNo).arg(fieldText(f));
+                return LineStatus::Error;
+            }
+            r.penStyle = static_cast<quint8>(style);
+            break;
+        }
+        case Column::PenWidth:
+            if (!parseIntField(f, header, r.penWidth)) return LineStatus::Error;
+            break;
+        case Column::Left:
+            if (!parseIntField(f, header, r.left)) return LineStatus::Error;
+            break;
+        case Column::Top:
+            if (!parseIntField(f, header, r.top)) return LineStatus::Error;
+            break;
+        case Column::Width:
+            if (!parseIntField(f, header, r.width)) return LineStatus::Error;
+            break;
+        case Column::Height:
+            if (!parseIntField(f, header, r.height)) return LineStatus::Error;
+            break;
+        case Column::Count:
+            break;
+        }
+    }
+
+    out = r;
+    return LineStatus::Row;
+}
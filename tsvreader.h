@@ -0,0 +1,243 @@
+#ifndef TSVREADER_H
+#define TSVREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QtGlobal>
+
+#include "packedrect.h"
+#include "rectstore.h"
+
+class QIODevice;
+
+/**
+ * @brief Потоковый байтовый разборщик TSV-формата MyModel.
+ *
+ * @details
+ * # Зачем
+ * Прежний loadFromTsv() читал QTextStream::readLine() (декодирование в UTF-16),
+ * затем QString::split('\t') выделял QStringList на строку и trimmed() — ещё
+ * по строке на поле. TsvReader работает прямо с байтами:
+ * - устройство читается блоками по @ref kDefaultChunkSize в один переиспользуемый буфер;
+ * - строки и поля — невладеющие представления (QLatin1String) внутри буфера;
+ * - QString создаётся только для текста сообщения об ошибке.
+ *
+ * # Семантика (совпадает с прежней)
+ * - строка = один MyRect, поля разделены '\t', порядок — RectColumns::kColumns;
+ * - строки из одних пробельных символов пропускаются, но учитываются в нумерации;
+ * - "\r\n" допускается (последний '\r' строки отбрасывается);
+ * - UTF-8 BOM в начале потока пропускается (как это делал QTextStream);
+ * - при первой ошибке разбор прекращается, сообщение содержит номер строки.
+ *
+ * Гарантия "не менять модель при ошибке" обеспечивается вызывающей стороной:
+ * строки добавляются во временное хранилище.
+ *
+ * # Отображение файла в память
+ * Для локальных файлов readMapped() отображает файл через QFileDevice::map()
+ * и разбирает байты на месте (parseLines()) — без копирования ядро -> буфер
+ * и без декодирования текста. Последовательные устройства, QBuffer и файлы,
+ * которые не удалось отобразить, читаются обычным read().
+ *
+ * # Параллельный разбор
+ * Строки независимы, поэтому лежащий в памяти фрагмент (отображённый файл,
+ * данные QBuffer) режется по границам строк на блоки, которые разбираются
+ * на пуле потоков в собственные RectStore и затем склеиваются по порядку
+ * (parseLinesParallel()). Номера строк в ошибках — те же, что при
+ * последовательном разборе.
+ */
+class TsvReader
+{
+public:
+    /// Размер блока чтения с устройства по умолчанию (1 МиБ).
+    static constexpr int kDefaultChunkSize = 1 << 20;
+
+    /// Минимальный размер блока параллельного разбора (1 МиБ).
+    static constexpr int kMinParallelChunkSize = 1 << 20;
+
+    /// Результат разбора одной строки.
+    enum class LineStatus
+    {
+        Row,    ///< Строка разобрана в PackedRect.
+        Blank,  ///< Пустая/пробельная строка — пропускается.
+        Error   ///< Ошибка формата (текст — в error).
+    };
+
+    /**
+     * @brief Создаёт читатель поверх открытого на чтение устройства.
+     *
+     * @param in Устройство ввода (QFile/QBuffer/и т.п.), должно жить дольше читателя.
+     * @param chunkSize Размер блока чтения в байтах.
+     */
+    explicit TsvReader(QIODevice& in, int chunkSize = kDefaultChunkSize);
+
+    /**
+     * @brief Разбирает очередные строки и добавляет их в @p out.
+     *
+     * @param out Хранилище-приёмник (строки добавляются в конец).
+     * @param maxRows Максимум добавляемых строк за вызов; <= 0 — до конца потока.
+     * @param error Опционально: текст ошибки.
+     * @return true при успехе; false при ошибке чтения или формата.
+     */
+    bool read(RectStore& out, int maxRows, QString* error = nullptr);
+
+    /**
+     * @brief Пропускает до @p rows строк данных без разбора полей.
+     *
+     * @details
+     * Пустые строки пропускаются, но в @p rows не засчитываются (как и в read()),
+     * номер строки продвигается. Нужен для перехода к строке внутри блока
+     * индекса (TsvIndex): формат пропущенных строк не проверяется.
+     *
+     * @return Число пропущенных строк данных (меньше @p rows — поток кончился);
+     *         -1 при ошибке чтения.
+     */
+    int skip(int rows, QString* error = nullptr);
+
+    /**
+     * @brief Задаёт номер строки, предшествующей текущей позиции устройства.
+     *
+     * @details
+     * Для чтения с середины файла: номера строк в сообщениях об ошибках
+     * остаются сквозными по файлу.
+     */
+    void setLineNumber(int lineNo);
+
+    /**
+     * @brief Поток исчерпан и все прочитанные байты разобраны.
+     */
+    bool atEnd() const;
+
+    /**
+     * @brief Номер последней разобранной строки (с 1; пустые строки тоже считаются).
+     */
+    int lineNumber() const;
+
+    /**
+     * @brief Сколько байт потока уже разобрано.
+     */
+    qint64 bytesConsumed() const;
+
+    /**
+     * @brief Разбирает одну строку TSV (без завершающего '\n').
+     *
+     * @param begin Начало строки.
+     * @param end Конец строки (не включительно).
+     * @param lineNo Номер строки для сообщения об ошибке.
+     * @param out Результат при LineStatus::Row.
+     * @param error Опционально: текст ошибки при LineStatus::Error.
+     */
+    static LineStatus parseLine(const char* begin,
+                                const char* end,
+                                int lineNo,
+                                PackedRect& out,
+                                QString* error);
+
+    /**
+     * @brief Разбирает лежащий в памяти фрагмент TSV из целых строк.
+     *
+     * @details
+     * Фрагмент режется на строки по '\n' (последняя может быть без '\n'),
+     * каждая разбирается parseLine(). BOM не пропускается — это дело вызывающего.
+     *
+     * @param begin Начало фрагмента (начало строки).
+     * @param end Конец фрагмента.
+     * @param firstLineNo Номер первой строки фрагмента (для сообщений об ошибках).
+     * @param out Хранилище-приёмник (строки добавляются в конец).
+     * @param error Опционально: текст ошибки.
+     * @return true при успехе; false при первой ошибке формата.
+     */
+    static bool parseLines(const char* begin,
+                           const char* end,
+                           int firstLineNo,
+                           RectStore& out,
+                           QString* error);
+
+    /**
+     * @brief Параллельный вариант parseLines() для фрагмента, начинающегося со строки 1.
+     *
+     * @details
+     * Фрагмент делится по '\n' примерно на равные блоки (не мельче
+     * @p minChunkSize, не больше 4 блоков на поток), блоки разбираются на
+     * локальном QThreadPool и склеиваются в @p out по порядку.
+     *
+     * Ошибка: сообщается первая по порядку строк. Блок, в котором она найдена,
+     * разбирается повторно с правильным номером первой строки, поэтому текст
+     * ошибки совпадает с последовательным разбором. Как и у parseLines(),
+     * при ошибке в @p out могут остаться уже добавленные строки.
+     *
+     * @param begin Начало фрагмента (начало строки 1, без BOM).
+     * @param end Конец фрагмента.
+     * @param out Хранилище-приёмник (строки добавляются в конец).
+     * @param threads Число потоков; <= 0 — QThread::idealThreadCount(), 1 — без пула.
+     * @param error Опционально: текст ошибки.
+     * @param minChunkSize Минимальный размер блока в байтах.
+     * @return true при успехе; false при ошибке формата.
+     */
+    static bool parseLinesParallel(const char* begin,
+                                   const char* end,
+                                   RectStore& out,
+                                   int threads,
+                                   QString* error = nullptr,
+                                   int minChunkSize = kMinParallelChunkSize);
+
+    /**
+     * @brief Загружает TSV из файла, отображённого в память.
+     *
+     * @details
+     * Отображается остаток файла от текущей позиции @p in. При успехе
+     * позиция устройства переводится в конец файла.
+     *
+     * Если @p in не QFileDevice, последовательное устройство, пустой остаток
+     * или map() не удался — в @p mapped пишется false, устройство не трогается,
+     * и вызывающий должен читать обычным путём (TsvReader::read()).
+     *
+     * @param in Открытое на чтение устройство.
+     * @param out Хранилище-приёмник.
+     * @param mapped Сюда пишется, был ли файл отображён (и разобран).
+     * @param error Опционально: текст ошибки.
+     * @param threads Число потоков разбора (см. parseLinesParallel()).
+     * @return false только при ошибке формата в отображённом файле.
+     */
+    static bool readMapped(QIODevice& in,
+                           RectStore& out,
+                           bool* mapped,
+                           QString* error = nullptr,
+                           int threads = 0);
+
+    /**
+     * @brief Разбирает данные QBuffer на месте (без копирования).
+     *
+     * @details
+     * Аналог readMapped() для QBuffer: остаток buffer() от текущей позиции
+     * разбирается parseLinesParallel(), при успехе позиция переводится в конец.
+     * Для прочих устройств в @p handled пишется false и устройство не трогается.
+     *
+     * @return false только при ошибке формата.
+     */
+    static bool readBuffer(QIODevice& in,
+                           RectStore& out,
+                           bool* handled,
+                           QString* error = nullptr,
+                           int threads = 0);
+
+private:
+    /**
+     * @brief Дочитывает очередной блок в буфер, сохраняя неразобранный хвост.
+     */
+    bool fill(QString* error);
+
+private:
+    QIODevice& m_in;
+    int m_chunkSize;
+
+    /// Буфер чтения: [m_pos, size) — ещё не разобранные байты.
+    QByteArray m_buffer;
+    int m_pos = 0;
+
+    int m_lineNo = 0;
+    qint64 m_consumed = 0;
+    bool m_eof = false;
+    bool m_started = false;
+};
+
+#endif // TSVREADER_H
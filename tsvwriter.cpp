@@ -0,0 +1,189 @@
+#include "tsvwriter.h"
+
+#include <QIODevice>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <cstring>
+
+#include "rectcolumns.h"
+#include "rectformat.h"
+
+namespace {
+
+/// Самое длинное имя стиля: "Qt::DashDotDotLine" / "Qt::PenStyle(15)".
+constexpr int kMaxPenStyleNameSize = 18;
+
+static_assert(RectFormat::kColorNameSize + kMaxPenStyleNameSize
+                  + (RectColumns::kColCountInt - 2) * RectFormat::kMaxIntSize
+                  + RectColumns::kColCountInt
+              <= TsvWriter::kMaxRowSize,
+              "kMaxRowSize меньше самой длинной строки TSV");
+
+/**
+ * @brief Задача пула: форматирует диапазон строк в собственный буфер.
+ */
+class FormatChunkTask final : public QRunnable
+{
+public:
+    FormatChunkTask(const RectStore& rows, int first, int count, QByteArray& out)
+        : m_rows(rows)
+        , m_first(first)
+        , m_count(count)
+        , m_out(out)
+    {
+    }
+
+    void run() override
+    {
+        // Уменьшение размера не освобождает память — буфер переиспользуется.
+        m_out.resize(m_count * TsvWriter::kMaxRowSize);
+
+        char* const begin = m_out.data();
+        char* p = begin;
+        const int last = m_first + m_count;
+        for (int row = m_first; row < last; ++row)
+            p = TsvWriter::formatRow(m_rows.at(row), p);
+
+        m_out.resize(int(p - begin));
+    }
+
+private:
+    const RectStore& m_rows;
+    int m_first;
+    int m_count;
+    QByteArray& m_out;
+};
+
+} // namespace
+
+TsvWriter::TsvWriter(QIODevice& out)
+    : m_out(out)
+{
+}
+
+void TsvWriter::setThreads(int threads)
+{
+    m_threads = threads;
+}
+
+int TsvWriter::threads() const
+{
+    return m_threads;
+}
+
+char* TsvWriter::formatRow(const PackedRect& r, char* out)
+{
+    out = RectFormat::formatColor(r.penColor, out);
+    *out++ = '\t';
+
+    const QLatin1String style = RectFormat::penStyleNameLatin1(r.style());
+    std::memcpy(out, style.data(), static_cast<std::size_t>(style.size()));
+    out += style.size();
+
+    for (qint32 v : {r.penWidth, r.left, r.top, r.width, r.height})
+    {
+        *out++ = '\t';
+        out = RectFormat::formatInt(v, out);
+    }
+
+    *out++ = '\n';
+    return out;
+}
+
+bool TsvWriter::write(const RectStore& rows, int first, int count, QString* error)
+{
+    const int threads = m_threads > 0 ? m_threads : QThread::idealThreadCount();
+    if (threads > 1 && count >= 2 * kParallelChunkRows)
+        return writeParallel(rows, first, count, threads, error);
+
+    return writeSerial(rows, first, count, error);
+}
+
+bool TsvWriter::writeSerial(const RectStore& rows, int first, int count, QString* error)
+{
+    if (m_buffer.size() != kBufferSize)
+        m_buffer.resize(kBufferSize);
+
+    char* const begin = m_buffer.data();
+    char* const limit = begin + kBufferSize - kMaxRowSize;
+    char* p = begin;
+
+    const int last = first + count;
+    for (int row = first; row < last; ++row)
+    {
+        if (p > limit)
+        {
+            if (!flush(begin, int(p - begin), error))
+                return false;
+            p = begin;
+        }
+        p = formatRow(rows.at(row), p);
+    }
+
+    return flush(begin, int(p - begin), error);
+}
+
+/**
+ * @details
+ * Буферы двух волн чередуются: волна k + 1 запускается на пуле в одну
+ * половину m_chunkBuffers, волна k (уже готовая) пишется из другой,
+ * затем waitForDone() дожидается волны k + 1. При ошибке записи
+ * оставшиеся задачи дорабатывают (деструктор пула их дожидается),
+ * но в устройство больше ничего не пишется.
+ */
+bool TsvWriter::writeParallel(const RectStore& rows, int first, int count, int threads, QString* error)
+{
+    const int chunkCount = (count + kParallelChunkRows - 1) / kParallelChunkRows;
+    const int wave = 2 * threads;
+    m_chunkBuffers.resize(static_cast<std::size_t>(2 * wave));
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(threads);
+
+    // Запуск волны, начинающейся с блока chunk, в половину буферов half.
+    auto startWave = [&](int chunk, int half) {
+        const int end = qMin(chunk + wave, chunkCount);
+        for (int i = chunk; i < end; ++i)
+        {
+            const int rowFirst = first + i * kParallelChunkRows;
+            const int rowCount = qMin(kParallelChunkRows, first + count - rowFirst);
+            QByteArray& buffer = m_chunkBuffers[static_cast<std::size_t>(half * wave + (i - chunk))];
+            pool.start(new FormatChunkTask(rows, rowFirst, rowCount, buffer));
+        }
+    };
+
+    startWave(0, 0);
+    pool.waitForDone();
+
+    int half = 0;
+    for (int chunk = 0; chunk < chunkCount; chunk += wave)
+    {
+        if (chunk + wave < chunkCount)
+            startWave(chunk + wave, 1 - half);
+
+        const int end = qMin(chunk + wave, chunkCount);
+        for (int i = chunk; i < end; ++i)
+        {
+            const QByteArray& buffer = m_chunkBuffers[static_cast<std::size_t>(half * wave + (i - chunk))];
+            if (!flush(buffer.constData(), buffer.size(), error))
+                return false;
+        }
+
+        pool.waitForDone();
+        half = 1 - half;
+    }
+
+    return true;
+}
+
+bool TsvWriter::flush(const char* data, int size, QString* error)
+{
+    if (size > 0 && m_out.write(data, size) != size)
+    {
+        if (error) *error = "Ошибка записи TSV-потока";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,123 @@
+#ifndef TSVWRITER_H
+#define TSVWRITER_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <vector>
+
+#include "rectstore.h"
+
+class QIODevice;
+
+/**
+ * @brief Запись строк RectStore в TSV-формат MyModel.
+ *
+ * @details
+ * Формат — обратный TsvReader: строка = один MyRect, поля через '\t'
+ * в порядке RectColumns::kColumns, цвет "#rrggbb", стиль — имя
+ * (RectFormat::penStyleName()), остальные поля — десятичные целые.
+ *
+ * Строки форматируются прямо в байтовый буфер писателя (formatRow():
+ * RectFormat::formatColor(), интернированное имя стиля, formatInt()),
+ * буфер сбрасывается в устройство крупными блоками по kBufferSize байт.
+ * QString/QTextStream на этом пути не участвуют; результат побайтно
+ * совпадает с прежней записью через QTextStream.
+ *
+ * При setThreads() != 1 крупные диапазоны форматируются параллельно
+ * (блоками по kParallelChunkRows строк в собственные буферы на пуле
+ * потоков) и пишутся в устройство строго по порядку — результат тот же,
+ * что при последовательной записи.
+ *
+ * Запись можно вести порциями (write() с диапазоном строк) — так
+ * фоновое сохранение сообщает о прогрессе и проверяет отмену между порциями.
+ * Буфер живёт в писателе и переиспользуется между вызовами.
+ */
+class TsvWriter
+{
+public:
+    /// Размер блока, которым буфер сбрасывается в устройство.
+    static constexpr int kBufferSize = 1 << 20;
+
+    /// Верхняя граница длины одной отформатированной строки (с '\n').
+    static constexpr int kMaxRowSize = 128;
+
+    /// Число строк в одном блоке параллельного форматирования.
+    static constexpr int kParallelChunkRows = 16 * 1024;
+
+    /**
+     * @brief Создаёт писатель поверх открытого на запись устройства.
+     *
+     * @param out Устройство вывода, должно жить дольше писателя.
+     */
+    explicit TsvWriter(QIODevice& out);
+
+    /**
+     * @brief Число потоков форматирования.
+     *
+     * @param threads 1 (по умолчанию) — последовательно; <= 0 — QThread::idealThreadCount().
+     */
+    void setThreads(int threads);
+
+    /**
+     * @brief Заданное число потоков форматирования.
+     */
+    int threads() const;
+
+    /**
+     * @brief Записывает строки [@p first, @p first + @p count) хранилища @p rows.
+     *
+     * @details
+     * Всё отформатированное к возврату уже передано устройству (буфер пуст).
+     *
+     * @param rows Источник строк.
+     * @param first Первая строка.
+     * @param count Число строк.
+     * @param error Опционально: текст ошибки.
+     * @return true при успехе; false при ошибке записи.
+     */
+    bool write(const RectStore& rows, int first, int count, QString* error = nullptr);
+
+    /**
+     * @brief Форматирует одну строку TSV (с завершающим '\n') в @p out.
+     *
+     * @param r Строка.
+     * @param out Не менее kMaxRowSize байт.
+     * @return Указатель за последним записанным байтом.
+     */
+    static char* formatRow(const PackedRect& r, char* out);
+
+private:
+    /**
+     * @brief Последовательная запись через m_buffer.
+     */
+    bool writeSerial(const RectStore& rows, int first, int count, QString* error);
+
+    /**
+     * @brief Параллельное форматирование блоков и запись их по порядку.
+     *
+     * @details
+     * Блоки обрабатываются волнами по 2 * threads: пока пул форматирует
+     * следующую волну, готовая пишется в устройство. Память ограничена
+     * двумя волнами буферов (m_chunkBuffers) независимо от числа строк.
+     */
+    bool writeParallel(const RectStore& rows, int first, int count, int threads, QString* error);
+
+    /**
+     * @brief Передаёт устройству @p size байт с @p data.
+     */
+    bool flush(const char* data, int size, QString* error);
+
+    QIODevice& m_out;
+
+    /// Число потоков форматирования (см. setThreads()).
+    int m_threads = 1;
+
+    /// Буфер форматирования (kBufferSize байт, выделяется при первой записи).
+    QByteArray m_buffer;
+
+    /// Буферы блоков параллельной записи (переиспользуются между волнами и вызовами).
+    std::vector<QByteArray> m_chunkBuffers;
+};
+
+#endif // TSVWRITER_H